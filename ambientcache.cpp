@@ -0,0 +1,183 @@
+#include "ambientcache.h"
+
+#include <QCryptographicHash>
+#include <QDateTime>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QSaveFile>
+#include <QStandardPaths>
+#include <algorithm>
+#include <cstring>
+
+// Entry layout: this header, then the left samples zero-padded to a
+// multiple of 4 frames, then frames right samples, all native-endian
+// float. The 32-byte header and the padding keep both sample arrays
+// 16-byte aligned in the mapping for the SIMD mix kernels.
+namespace {
+
+struct EntryHeader
+{
+    char magic[4];
+    quint32 version;
+    quint32 sampleRate;
+    quint32 reserved;
+    qint64 frames;
+    qint64 reserved2;
+};
+static_assert(sizeof(EntryHeader) == 32, "cache entry header must stay 32 bytes");
+
+constexpr char ENTRY_MAGIC[4] = { 'B', 'P', 'C', 'M' };
+constexpr quint32 ENTRY_VERSION = 2; // 1 had no padding after left
+const QString ENTRY_SUFFIX = QStringLiteral(".pcm");
+
+// Frames the left array takes, padding included
+qint64 paddedFrames(qint64 frames)
+{
+    return (frames + 3) & ~qint64(3);
+}
+
+} // namespace
+
+AmbientCache::AmbientCache(const QString &directory, qint64 maxBytes)
+    : m_directory(directory)
+    , m_maxBytes(maxBytes)
+{
+}
+
+QString AmbientCache::defaultDirectory()
+{
+    return QStandardPaths::writableLocation(QStandardPaths::AppLocalDataLocation) + "/ambient_cache";
+}
+
+void AmbientCache::setMaxBytes(qint64 maxBytes)
+{
+    m_maxBytes = std::max<qint64>(0, maxBytes);
+    evict();
+}
+
+QString AmbientCache::entryPath(const QString &filePath, int sampleRate) const
+{
+    const QFileInfo info(filePath);
+    const QString key = QString("%1\n%2\n%3\n%4")
+            .arg(info.absoluteFilePath())
+            .arg(info.size())
+            .arg(info.lastModified().toMSecsSinceEpoch())
+            .arg(sampleRate);
+    const QByteArray hash = QCryptographicHash::hash(key.toUtf8(), QCryptographicHash::Sha1).toHex();
+    return m_directory + "/" + QString::fromLatin1(hash) + ENTRY_SUFFIX;
+}
+
+std::shared_ptr<const AmbientClip> AmbientCache::map(const QString &entryPath)
+{
+    auto file = std::make_shared<QFile>(entryPath);
+    if (!file->open(QIODevice::ReadOnly)) {
+        return nullptr;
+    }
+
+    const qint64 size = file->size();
+    const uchar *data = size >= static_cast<qint64>(sizeof(EntryHeader)) ? file->map(0, size) : nullptr;
+
+    EntryHeader header;
+    if (data) {
+        memcpy(&header, data, sizeof(header));
+    }
+    const bool valid = data
+            && memcmp(header.magic, ENTRY_MAGIC, sizeof(ENTRY_MAGIC)) == 0
+            && header.version == ENTRY_VERSION
+            && header.sampleRate > 0
+            && header.frames > 0
+            && size == static_cast<qint64>(sizeof(EntryHeader))
+                       + (paddedFrames(header.frames) + header.frames) * static_cast<qint64>(sizeof(float));
+    if (!valid) {
+        // Truncated or from another version: drop it so it is rebuilt
+        file->close();
+        file->remove();
+        return nullptr;
+    }
+
+    // Refresh the LRU stamp
+    file->setFileTime(QDateTime::currentDateTime(), QFileDevice::FileModificationTime);
+
+    const float *left = reinterpret_cast<const float *>(data + sizeof(EntryHeader));
+    const float *right = left + paddedFrames(header.frames);
+    return std::make_shared<const AmbientClip>(static_cast<int>(header.sampleRate), header.frames,
+                                               left, right, std::move(file));
+}
+
+std::shared_ptr<const AmbientClip> AmbientCache::load(const QString &filePath, int sampleRate)
+{
+    const QString path = entryPath(filePath, sampleRate);
+    if (!QFile::exists(path)) {
+        return nullptr;
+    }
+    return map(path);
+}
+
+std::shared_ptr<const AmbientClip> AmbientCache::store(const QString &filePath, int sampleRate,
+                                                       const AmbientClip &clip)
+{
+    if (m_maxBytes <= 0 || clip.frames() <= 0 || !QDir().mkpath(m_directory)) {
+        return nullptr;
+    }
+
+    EntryHeader header = {};
+    memcpy(header.magic, ENTRY_MAGIC, sizeof(ENTRY_MAGIC));
+    header.version = ENTRY_VERSION;
+    header.sampleRate = static_cast<quint32>(clip.sampleRate());
+    header.frames = clip.frames();
+
+    const qint64 channelBytes = clip.frames() * static_cast<qint64>(sizeof(float));
+    const QByteArray padding((paddedFrames(clip.frames()) - clip.frames()) * sizeof(float), '\0');
+    const QString path = entryPath(filePath, sampleRate);
+
+    // QSaveFile writes a temporary and renames it, so a crash never
+    // leaves a half-written entry under the real name
+    QSaveFile out(path);
+    if (!out.open(QIODevice::WriteOnly)
+            || out.write(reinterpret_cast<const char *>(&header), sizeof(header)) != sizeof(header)
+            || out.write(reinterpret_cast<const char *>(clip.left()), channelBytes) != channelBytes
+            || out.write(padding) != padding.size()
+            || out.write(reinterpret_cast<const char *>(clip.right()), channelBytes) != channelBytes
+            || !out.commit()) {
+        return nullptr;
+    }
+
+    evict();
+    return map(path);
+}
+
+// Removes least recently used entries until the total fits; the newest
+// entry always stays, even if it alone is larger than the limit
+void AmbientCache::evict()
+{
+    const QFileInfoList entries = QDir(m_directory).entryInfoList({ "*" + ENTRY_SUFFIX }, QDir::Files, QDir::Time);
+
+    qint64 total = 0;
+    for (int i = 0; i < entries.size(); ++i) {
+        total += entries[i].size();
+        if (i > 0 && total > m_maxBytes) {
+            // Fails harmlessly where a mapped file cannot be deleted
+            // (Windows); it goes on the next eviction instead
+            if (QFile::remove(entries[i].absoluteFilePath())) {
+                total -= entries[i].size();
+            }
+        }
+    }
+}
+
+qint64 AmbientCache::totalBytes() const
+{
+    qint64 total = 0;
+    for (const QFileInfo &entry : QDir(m_directory).entryInfoList({ "*" + ENTRY_SUFFIX }, QDir::Files)) {
+        total += entry.size();
+    }
+    return total;
+}
+
+void AmbientCache::clear()
+{
+    for (const QFileInfo &entry : QDir(m_directory).entryInfoList({ "*" + ENTRY_SUFFIX }, QDir::Files)) {
+        QFile::remove(entry.absoluteFilePath());
+    }
+}
@@ -0,0 +1,58 @@
+#ifndef AMBIENTCACHE_H
+#define AMBIENTCACHE_H
+
+#include <QString>
+#include <QtGlobal>
+#include <memory>
+#include "ambientclip.h"
+
+// ============================================================
+// AMBIENT CACHE
+// ============================================================
+// Decoded ambient clips kept on disk so a layer starts by mapping a
+// file instead of spinning up a decoder. One file per source file and
+// sample rate, named by a hash of the source's path, size and mtime:
+// editing or replacing the source makes a new key, and the stale entry
+// ages out. Entries are memory-mapped, so the clip's pages are shared
+// with the page cache instead of copied onto the heap.
+//
+// The total size is bounded by evicting least recently used entries;
+// a hit refreshes the entry's mtime, which is what eviction sorts by.
+// Not thread-safe: used from the GUI thread only.
+
+class AmbientCache
+{
+public:
+    static constexpr qint64 DEFAULT_MAX_BYTES = 1024ll * 1024 * 1024;
+
+    explicit AmbientCache(const QString &directory = defaultDirectory(),
+                          qint64 maxBytes = DEFAULT_MAX_BYTES);
+
+    static QString defaultDirectory();
+
+    QString directory() const { return m_directory; }
+    qint64 maxBytes() const { return m_maxBytes; }
+    void setMaxBytes(qint64 maxBytes);
+
+    // Mapped clip for filePath decoded at sampleRate, or null on a miss
+    std::shared_ptr<const AmbientClip> load(const QString &filePath, int sampleRate);
+
+    // Writes clip as the entry for (filePath, sampleRate), evicts down
+    // to maxBytes and returns the entry mapped (null if it could not be
+    // written, e.g. disk full; the caller keeps its heap copy then)
+    std::shared_ptr<const AmbientClip> store(const QString &filePath, int sampleRate,
+                                             const AmbientClip &clip);
+
+    qint64 totalBytes() const;
+    void clear();
+
+private:
+    QString entryPath(const QString &filePath, int sampleRate) const;
+    std::shared_ptr<const AmbientClip> map(const QString &entryPath);
+    void evict();
+
+    QString m_directory;
+    qint64 m_maxBytes;
+};
+
+#endif // AMBIENTCACHE_H
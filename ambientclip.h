@@ -0,0 +1,61 @@
+#ifndef AMBIENTCLIP_H
+#define AMBIENTCLIP_H
+
+#include <QtGlobal>
+#include <memory>
+#include <vector>
+
+// ============================================================
+// AMBIENT CLIP
+// ============================================================
+// A sound file decoded to Float32 planar stereo. Immutable once
+// built, so the GUI thread and the render path share it through a
+// std::shared_ptr<const AmbientClip> without locking. The samples
+// either live in the clip's own vectors or in memory owned by
+// storage (a mapped AmbientCache file), which the clip keeps alive.
+
+class AmbientClip
+{
+public:
+    AmbientClip(int sampleRate, std::vector<float> left, std::vector<float> right)
+        : m_sampleRate(sampleRate)
+        , m_ownedLeft(std::move(left))
+        , m_ownedRight(std::move(right))
+    {
+        m_ownedRight.resize(m_ownedLeft.size());
+        m_frames = static_cast<qint64>(m_ownedLeft.size());
+        m_left = m_ownedLeft.data();
+        m_right = m_ownedRight.data();
+    }
+
+    AmbientClip(int sampleRate, qint64 frames, const float *left, const float *right,
+                std::shared_ptr<const void> storage)
+        : m_sampleRate(sampleRate)
+        , m_frames(frames)
+        , m_left(left)
+        , m_right(right)
+        , m_storage(std::move(storage))
+    {
+    }
+
+    AmbientClip(const AmbientClip &) = delete;
+    AmbientClip &operator=(const AmbientClip &) = delete;
+
+    int sampleRate() const { return m_sampleRate; }
+    qint64 frames() const { return m_frames; }
+    qint64 durationMs() const { return m_sampleRate > 0 ? frames() * 1000 / m_sampleRate : 0; }
+
+    const float *left() const { return m_left; }
+    const float *right() const { return m_right; }
+
+private:
+    int m_sampleRate;
+    qint64 m_frames = 0;
+    std::vector<float> m_ownedLeft;
+    std::vector<float> m_ownedRight;
+    const float *m_left = nullptr;
+    const float *m_right = nullptr;
+    std::shared_ptr<const void> m_storage;
+};
+
+#endif // AMBIENTCLIP_H
@@ -0,0 +1,159 @@
+#include "ambientdecoder.h"
+#include "ambientcache.h"
+
+#include <QAudioBuffer>
+#include <QMetaObject>
+#include <QUrl>
+
+AmbientDecoder::AmbientDecoder(AmbientCache *cache, QObject *parent)
+    : QObject(parent)
+    , m_decoder(new QAudioDecoder(this))
+    , m_cache(cache)
+{
+    connect(m_decoder, &QAudioDecoder::bufferReady, this, &AmbientDecoder::readBuffers);
+    connect(m_decoder, &QAudioDecoder::finished, this, &AmbientDecoder::handleFinished);
+    connect(m_decoder, QOverload<QAudioDecoder::Error>::of(&QAudioDecoder::error),
+            this, &AmbientDecoder::handleError);
+}
+
+void AmbientDecoder::start(const QString &filePath, int sampleRate)
+{
+    m_decoder->stop();
+    m_filePath = filePath;
+    m_requestedRate = sampleRate;
+    m_sampleRate = 0;
+    m_left.clear();
+    m_right.clear();
+    m_clip.reset();
+    m_cacheHit = false;
+    m_loadMs = -1;
+    m_timer.start();
+    const quint64 generation = ++m_generation;
+
+    if (m_cache) {
+        m_clip = m_cache->load(filePath, sampleRate);
+        if (m_clip) {
+            m_cacheHit = true;
+            QMetaObject::invokeMethod(this, [this, generation]() {
+                if (generation == m_generation) {
+                    finish();
+                }
+            }, Qt::QueuedConnection);
+            return;
+        }
+    }
+
+    QAudioFormat format;
+    format.setSampleRate(sampleRate);
+    format.setChannelCount(2);
+    format.setSampleFormat(QAudioFormat::Float);
+    m_decoder->setAudioFormat(format);
+    m_decoder->setSource(QUrl::fromLocalFile(filePath));
+    m_decoder->start();
+}
+
+QString AmbientDecoder::filePath() const
+{
+    return m_filePath;
+}
+
+std::shared_ptr<const AmbientClip> AmbientDecoder::clip() const
+{
+    return m_clip;
+}
+
+bool AmbientDecoder::isCacheHit() const
+{
+    return m_cacheHit;
+}
+
+qint64 AmbientDecoder::loadMs() const
+{
+    return m_loadMs;
+}
+
+// Appends frames of any channel count to planar stereo; sample is the
+// first channel's value of frame i, offset and scale map it to [-1, 1)
+template<typename T>
+static void appendFrames(const T *samples, qsizetype frames, int channels, float offset, float scale,
+                         std::vector<float> &left, std::vector<float> &right)
+{
+    const int second = channels > 1 ? 1 : 0;
+    const std::size_t start = left.size();
+    left.resize(start + frames);
+    right.resize(start + frames);
+    for (qsizetype i = 0; i < frames; ++i) {
+        const T *frame = samples + i * channels;
+        left[start + i] = (static_cast<float>(frame[0]) - offset) * scale;
+        right[start + i] = (static_cast<float>(frame[second]) - offset) * scale;
+    }
+}
+
+void AmbientDecoder::readBuffers()
+{
+    while (m_decoder->bufferAvailable()) {
+        const QAudioBuffer buffer = m_decoder->read();
+        const QAudioFormat format = buffer.format();
+        const int channels = format.channelCount();
+        const qsizetype frames = buffer.frameCount();
+        if (!buffer.isValid() || channels < 1 || frames <= 0) {
+            continue;
+        }
+        if (m_sampleRate == 0) {
+            m_sampleRate = format.sampleRate();
+        }
+
+        switch (format.sampleFormat()) {
+        case QAudioFormat::Float:
+            appendFrames(buffer.constData<float>(), frames, channels, 0.0f, 1.0f, m_left, m_right);
+            break;
+        case QAudioFormat::Int16:
+            appendFrames(buffer.constData<qint16>(), frames, channels, 0.0f, 1.0f / 32768.0f, m_left, m_right);
+            break;
+        case QAudioFormat::Int32:
+            appendFrames(buffer.constData<qint32>(), frames, channels, 0.0f, 1.0f / 2147483648.0f,
+                         m_left, m_right);
+            break;
+        case QAudioFormat::UInt8:
+            appendFrames(buffer.constData<quint8>(), frames, channels, 128.0f, 1.0f / 128.0f, m_left, m_right);
+            break;
+        default:
+            m_decoder->stop();
+            emit errorOccurred(QString("Unsupported sample format in %1").arg(m_filePath));
+            return;
+        }
+    }
+}
+
+void AmbientDecoder::handleFinished()
+{
+    readBuffers();
+    if (m_left.empty() || m_sampleRate <= 0) {
+        emit errorOccurred(QString("No audio decoded from %1").arg(m_filePath));
+        return;
+    }
+
+    m_clip = std::make_shared<const AmbientClip>(m_sampleRate, std::move(m_left), std::move(m_right));
+    m_left = {};
+    m_right = {};
+
+    // Swap the heap copy for the mapped entry when it could be written
+    if (m_cache) {
+        if (std::shared_ptr<const AmbientClip> mapped = m_cache->store(m_filePath, m_requestedRate, *m_clip)) {
+            m_clip = std::move(mapped);
+        }
+    }
+    finish();
+}
+
+void AmbientDecoder::finish()
+{
+    m_loadMs = m_timer.elapsed();
+    emit finished();
+}
+
+void AmbientDecoder::handleError(QAudioDecoder::Error error)
+{
+    Q_UNUSED(error);
+    emit errorOccurred(QString("Could not decode %1: %2").arg(m_filePath, m_decoder->errorString()));
+}
@@ -0,0 +1,67 @@
+#ifndef AMBIENTDECODER_H
+#define AMBIENTDECODER_H
+
+#include <QObject>
+#include <QAudioDecoder>
+#include <QElapsedTimer>
+#include <QString>
+#include <memory>
+#include <vector>
+#include "ambientclip.h"
+
+// ============================================================
+// AMBIENT DECODER
+// ============================================================
+// Decodes a whole sound file once into an AmbientClip, driven by the
+// event loop of the thread it lives on. The backend is asked for
+// Float32 stereo at the requested rate; whatever it delivers is
+// converted to float, mono is copied to both channels and channels
+// past the second are dropped. If the backend keeps the file's own
+// rate the clip has that rate and the mixer resamples.
+//
+// With a cache, a file decoded before is mapped from it instead (still
+// reported through finished(), on the next event loop pass), and a
+// fresh decode is written to it and handed out mapped.
+
+class AmbientCache;
+
+class AmbientDecoder : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit AmbientDecoder(AmbientCache *cache = nullptr, QObject *parent = nullptr);
+
+    void start(const QString &filePath, int sampleRate);
+    QString filePath() const;
+
+    // Valid after finished()
+    std::shared_ptr<const AmbientClip> clip() const;
+    bool isCacheHit() const;
+    qint64 loadMs() const; // start() to finished(), -1 until finished()
+
+signals:
+    void finished();
+    void errorOccurred(const QString &errorMessage);
+
+private:
+    void readBuffers();
+    void handleFinished();
+    void handleError(QAudioDecoder::Error error);
+    void finish();
+
+    QAudioDecoder *m_decoder;
+    AmbientCache *m_cache;
+    QString m_filePath;
+    int m_requestedRate = 0;
+    quint64 m_generation = 0; // Invalidates a pending cache-hit finish
+    bool m_cacheHit = false;
+    QElapsedTimer m_timer;
+    qint64 m_loadMs = -1;
+    int m_sampleRate = 0; // As delivered by the backend
+    std::vector<float> m_left;
+    std::vector<float> m_right;
+    std::shared_ptr<const AmbientClip> m_clip;
+};
+
+#endif // AMBIENTDECODER_H
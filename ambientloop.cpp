@@ -0,0 +1,115 @@
+#include "ambientloop.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+// How far before the clip's end the loop end is searched
+static constexpr int SEARCH_MS = 50;
+
+// Frames around the crossfade's midpoint compared by the correlation
+static constexpr int CORRELATION_FRAMES = 1024;
+
+AmbientLoop::AmbientLoop(const AmbientClip &clip, int crossfadeFrames)
+{
+    const qint64 frames = clip.frames();
+
+    // The seam and the search window each take at most a quarter of the
+    // clip, so very short clips still keep half of their body
+    const int crossfade = static_cast<int>(std::clamp<qint64>(crossfadeFrames, 0, frames / 4));
+    const qint64 search = std::min<qint64>(static_cast<qint64>(SEARCH_MS) * clip.sampleRate() / 1000, frames / 4);
+
+    m_start = crossfade;
+    m_end = frames;
+    if (frames < 4) {
+        return;
+    }
+
+    double correlation = 0.0;
+    if (crossfade > 0) {
+        m_end = findCorrelatedEnd(clip, crossfade, frames - search, frames, &correlation);
+    } else {
+        m_end = findMatchedEnd(clip, frames - 2 - search, frames - 2);
+    }
+
+    // Equal-power crossfade. The sine/cosine pair keeps the power of
+    // uncorrelated sides constant; sides that correlate by r add
+    // 2*r*out*in on top, so the pair is normalized by that sum (for
+    // r = 1 this becomes an equal-gain fade, as in-phase material needs)
+    const double r = std::clamp(correlation, 0.0, 1.0);
+    m_seamLeft.resize(crossfade);
+    m_seamRight.resize(crossfade);
+    const qint64 tail = m_end - crossfade;
+    for (int i = 0; i < crossfade; ++i) {
+        const double theta = (i + 0.5) / crossfade * (M_PI / 2.0);
+        const double norm = 1.0 / std::sqrt(1.0 + 2.0 * r * std::cos(theta) * std::sin(theta));
+        const float fadeOut = static_cast<float>(std::cos(theta) * norm);
+        const float fadeIn = static_cast<float>(std::sin(theta) * norm);
+        m_seamLeft[i] = clip.left()[tail + i] * fadeOut + clip.left()[i] * fadeIn;
+        m_seamRight[i] = clip.right()[tail + i] * fadeOut + clip.right()[i] * fadeIn;
+    }
+}
+
+// End in [first, last] whose outgoing tail best matches the incoming
+// head (normalized cross-correlation of the mid/mono signal around the
+// middle of the crossfade, stored in *correlation); the latest end wins
+// ties, silence included
+qint64 AmbientLoop::findCorrelatedEnd(const AmbientClip &clip, int crossfadeFrames,
+                                      qint64 first, qint64 last, double *correlation) const
+{
+    const float *left = clip.left();
+    const float *right = clip.right();
+    const int length = std::min(crossfadeFrames, CORRELATION_FRAMES);
+    const qint64 head = crossfadeFrames / 2 - length / 2;
+
+    double headEnergy = 0.0;
+    for (int i = 0; i < length; ++i) {
+        const double h = left[head + i] + right[head + i];
+        headEnergy += h * h;
+    }
+
+    qint64 bestEnd = last;
+    double bestScore = -std::numeric_limits<double>::infinity();
+    for (qint64 end = last; end >= first; --end) {
+        const qint64 tail = end - crossfadeFrames + head;
+        double dot = 0.0;
+        double tailEnergy = 0.0;
+        for (int i = 0; i < length; ++i) {
+            const double t = left[tail + i] + right[tail + i];
+            const double h = left[head + i] + right[head + i];
+            dot += t * h;
+            tailEnergy += t * t;
+        }
+        const double energy = std::sqrt(tailEnergy * headEnergy);
+        const double score = energy > 1e-12 ? dot / energy : 0.0;
+        if (score > bestScore) {
+            bestScore = score;
+            bestEnd = end;
+        }
+    }
+    *correlation = bestScore;
+    return bestEnd;
+}
+
+// End in [first, last] where the clip continues most like its first
+// frames: value and slope of both channels closest to frame 0's
+qint64 AmbientLoop::findMatchedEnd(const AmbientClip &clip, qint64 first, qint64 last) const
+{
+    const float *left = clip.left();
+    const float *right = clip.right();
+    const float slopeLeft = left[1] - left[0];
+    const float slopeRight = right[1] - right[0];
+
+    qint64 bestEnd = last;
+    float bestError = std::numeric_limits<float>::infinity();
+    for (qint64 end = last; end >= std::max<qint64>(first, 1); --end) {
+        const float error = std::fabs(left[end] - left[0]) + std::fabs(right[end] - right[0])
+                + std::fabs((left[end + 1] - left[end]) - slopeLeft)
+                + std::fabs((right[end + 1] - right[end]) - slopeRight);
+        if (error < bestError) {
+            bestError = error;
+            bestEnd = end;
+        }
+    }
+    return bestEnd;
+}
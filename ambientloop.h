@@ -0,0 +1,52 @@
+#ifndef AMBIENTLOOP_H
+#define AMBIENTLOOP_H
+
+#include <QtGlobal>
+#include <vector>
+#include "ambientclip.h"
+
+// ============================================================
+// AMBIENT LOOP
+// ============================================================
+// The loop region of a clip and its pre-rendered seam, found once per
+// clip and crossfade length so looping costs nothing per iteration.
+//
+// The loop runs [start, end) and jumps from end back to start. Its last
+// crossfadeFrames frames are the seam: an equal-power crossfade from the
+// clip's own tail into the frames just before start, so the seam ends on
+// the sample that precedes start and the jump is continuous. start is
+// crossfadeFrames, which leaves the clip's head untouched for the first
+// pass. end is searched near the clip's end for the point where tail and
+// head correlate best, so the two sides of the crossfade are in phase;
+// without a crossfade it is the point whose value and slope best match
+// the loop start (a matched zero crossing for periodic material).
+
+class AmbientLoop
+{
+public:
+    static constexpr int DEFAULT_CROSSFADE_MS = 500;
+    static constexpr int MAX_CROSSFADE_MS = 5000;
+
+    AmbientLoop(const AmbientClip &clip, int crossfadeFrames);
+
+    qint64 start() const { return m_start; }
+    qint64 end() const { return m_end; }
+    qint64 seamStart() const { return m_end - crossfadeFrames(); }
+    int crossfadeFrames() const { return static_cast<int>(m_seamLeft.size()); }
+
+    // Frame i of the seam replaces clip frame seamStart() + i
+    const float *seamLeft() const { return m_seamLeft.data(); }
+    const float *seamRight() const { return m_seamRight.data(); }
+
+private:
+    qint64 findCorrelatedEnd(const AmbientClip &clip, int crossfadeFrames, qint64 first, qint64 last,
+                             double *correlation) const;
+    qint64 findMatchedEnd(const AmbientClip &clip, qint64 first, qint64 last) const;
+
+    qint64 m_start = 0;
+    qint64 m_end = 0;
+    std::vector<float> m_seamLeft;
+    std::vector<float> m_seamRight;
+};
+
+#endif // AMBIENTLOOP_H
@@ -1,20 +1,24 @@
 #include "ambientplayer.h"
+#include "dynamicengine.h"
 
 #include <QDebug>
-#include<QAudioOutput>
 
-AmbientPlayer::AmbientPlayer(QObject *parent)
+// How often position() is polled for the dialog's progress slider
+static constexpr int POSITION_POLL_MS = 250;
+
+AmbientPlayer::AmbientPlayer(DynamicEngine *engine, int layer, QObject *parent)
     : QObject(parent)
     , m_name("Unnamed")
     , m_volume(50)
     , m_enabled(false)
     , m_autoRepeat(true)
+    , m_engine(engine)
+    , m_layer(layer)
     , m_baseVolume(50)
     , m_masterRatio(1.0f)
 {
-    m_player = new QMediaPlayer(this);
-    m_audioOutput = new QAudioOutput(this);
-    m_player->setAudioOutput(m_audioOutput);
+    m_positionTimer = new QTimer(this);
+    m_positionTimer->setInterval(POSITION_POLL_MS);
 
     m_button = new QPushButton(m_name);
     m_button->setMinimumWidth(80);
@@ -31,26 +35,69 @@ AmbientPlayer::~AmbientPlayer()
 
 void AmbientPlayer::setupConnections()
 {
-    connect(m_player, &QMediaPlayer::playbackStateChanged,
-            this, &AmbientPlayer::updateButtonState);
+    connect(m_engine, &DynamicEngine::ambientLayerStateChanged,
+            this, &AmbientPlayer::onLayerStateChanged);
+
+    connect(m_engine, &DynamicEngine::ambientLayerLoaded, this, [this](int layer, qint64 durationMs) {
+        if (layer == m_layer) {
+            emit durationChanged(durationMs);
+            pollPosition();
+        }
+    });
+
+    connect(m_positionTimer, &QTimer::timeout, this, &AmbientPlayer::pollPosition);
 
     connect(m_button, &QPushButton::clicked, this, [this]() {
-        if (m_player->playbackState() == QMediaPlayer::PlayingState) {
+        if (m_state == QMediaPlayer::PlayingState) {
             pause();
         } else {
             play();
         }
     });
+}
 
-    connect(m_player, &QMediaPlayer::errorOccurred, this, [this]() {
-        qWarning() << "AmbientPlayer error:" << m_player->errorString();
-    });
+// The engine stops a layer by itself when a non-repeating file ends or
+// the output device fails
+void AmbientPlayer::onLayerStateChanged(int layer)
+{
+    if (layer != m_layer) {
+        return;
+    }
+    if (m_state == QMediaPlayer::PlayingState && !m_engine->isAmbientLayerPlaying(m_layer)) {
+        setState(m_engine->ambientLayerPosition(m_layer) > 0 ? QMediaPlayer::PausedState
+                                                             : QMediaPlayer::StoppedState);
+    }
+    pollPosition();
+}
+
+void AmbientPlayer::pollPosition()
+{
+    const qint64 current = position();
+    if (current != m_lastPosition) {
+        m_lastPosition = current;
+        emit positionChanged(current);
+    }
+}
+
+void AmbientPlayer::setState(QMediaPlayer::PlaybackState state)
+{
+    if (m_state == state) {
+        return;
+    }
+    m_state = state;
+
+    if (m_state == QMediaPlayer::PlayingState) {
+        m_positionTimer->start();
+    } else {
+        m_positionTimer->stop();
+    }
+    updateButtonState();
 }
 
 void AmbientPlayer::updateButtonState()
 {
     QString icon;
-    switch (m_player->playbackState()) {
+    switch (m_state) {
     case QMediaPlayer::PlayingState:
         icon = " ❚❚";  // Pause symbol
         m_button->setStyleSheet("QPushButton { color: green; }");
@@ -78,9 +125,8 @@ void AmbientPlayer::updateButtonState()
 
 void AmbientPlayer::updatePlayerSettings()
 {
-    m_audioOutput->setVolume(m_volume);
-    m_player->setLoops(m_autoRepeat ? QMediaPlayer::Infinite : 1);
-
+    updateGain();
+    m_engine->setAmbientLayerLooping(m_layer, m_autoRepeat);
 
     if (!m_enabled) {
         m_button->setStyleSheet("QPushButton { color: gray; }");
@@ -89,6 +135,11 @@ void AmbientPlayer::updatePlayerSettings()
     emit needsUpdate();
 }
 
+void AmbientPlayer::updateGain()
+{
+    m_engine->setAmbientLayerGain(m_layer, m_muted ? 0.0 : m_volume / 100.0);
+}
+
 int AmbientPlayer::Volume() const
 {
     return m_baseVolume;
@@ -111,10 +162,12 @@ void AmbientPlayer::setFilePath(const QString &path)
 {
     if (m_filePath != path) {
         m_filePath = path;
+        stop();
         if (!path.isEmpty()) {
-            m_player->setSource(QUrl::fromLocalFile(path));
+            m_engine->loadAmbientLayer(m_layer, path);
         } else {
-            m_player->setSource(QUrl());  // Clear source
+            m_engine->clearAmbientLayer(m_layer);
+            emit durationChanged(0);
         }
         emit needsUpdate();
     }
@@ -126,7 +179,7 @@ void AmbientPlayer::setVolume(int volume)  // volume is 0-100
     volume = qBound(0, volume, 100);
     if (m_volume != volume) {
         m_volume = volume;
-        m_audioOutput->setVolume(m_volume / 100.0f);
+        updateGain();
         emit needsUpdate();
     }
 }
@@ -139,7 +192,15 @@ void AmbientPlayer::applyMasterVolume(float ratio)
     float linear = m_baseVolume * m_masterRatio / 100.0f;
     float perceptual = qPow(linear, 0.5f);  // Square root curve
 
-    m_audioOutput->setVolume(perceptual);
+    m_engine->setAmbientLayerGain(m_layer, m_muted ? 0.0f : perceptual);
+}
+
+void AmbientPlayer::setMuted(bool muted)
+{
+    if (m_muted != muted) {
+        m_muted = muted;
+        updateGain();
+    }
 }
 
 void AmbientPlayer::setEnabled(bool enabled)
@@ -147,8 +208,8 @@ void AmbientPlayer::setEnabled(bool enabled)
     if (m_enabled != enabled) {
         m_enabled = enabled;
 
-        if (!m_enabled && m_player->playbackState() == QMediaPlayer::PlayingState) {
-            m_player->stop();
+        if (!m_enabled && m_state == QMediaPlayer::PlayingState) {
+            stop();
         }
 
         updatePlayerSettings();  // Update button appearance
@@ -160,7 +221,7 @@ void AmbientPlayer::setAutoRepeat(bool repeat)
 {
     if (m_autoRepeat != repeat) {
         m_autoRepeat = repeat;
-        m_player->setLoops(m_autoRepeat ? QMediaPlayer::Infinite : 1);
+        m_engine->setAmbientLayerLooping(m_layer, m_autoRepeat);
         emit needsUpdate();
     }
 }
@@ -176,32 +237,49 @@ void AmbientPlayer::play()
         return;
     }
 
-    if (m_player->playbackState() == QMediaPlayer::StoppedState) {
-        if (m_player->source().isEmpty() && !m_filePath.isEmpty()) {
-            m_player->setSource(QUrl::fromLocalFile(m_filePath));
-        }
+    // Starts once decoding finishes if the file is still loading
+    m_engine->playAmbientLayer(m_layer);
+    if (m_engine->isAmbientLayerPlaying(m_layer)) {
+        setState(QMediaPlayer::PlayingState);
     }
-
-    m_player->play();
 }
 
 void AmbientPlayer::pause()
 {
-    if (m_player->playbackState() == QMediaPlayer::PlayingState) {
-        m_player->pause();
+    if (m_state == QMediaPlayer::PlayingState) {
+        m_engine->pauseAmbientLayer(m_layer);
+        setState(QMediaPlayer::PausedState);
     }
 }
 
 void AmbientPlayer::stop()
 {
-    if (m_player->playbackState() != QMediaPlayer::StoppedState) {
-        m_player->stop();
+    if (m_state != QMediaPlayer::StoppedState) {
+        m_engine->stopAmbientLayer(m_layer);
+        setState(QMediaPlayer::StoppedState);
+        pollPosition();
     }
 }
 
 QMediaPlayer::PlaybackState AmbientPlayer::playbackState() const
 {
-    return m_player->playbackState();
+    return m_state;
+}
+
+qint64 AmbientPlayer::position() const
+{
+    return m_engine->ambientLayerPosition(m_layer);
+}
+
+qint64 AmbientPlayer::duration() const
+{
+    return m_engine->ambientLayerDuration(m_layer);
+}
+
+void AmbientPlayer::setPosition(qint64 position)
+{
+    m_engine->seekAmbientLayer(m_layer, position);
+    pollPosition();
 }
 
 /*
@@ -5,16 +5,23 @@
 
 #include <QMediaPlayer>
 #include <QPushButton>
-#include<QAudioOutput>
+#include <QTimer>
+
+class DynamicEngine;
+
+// One ambient layer of the DynamicEngine mix. The engine decodes the
+// file once and mixes it into its own sink, so any number of players
+// share a single audio stream; this class keeps the button, volume and
+// state bookkeeping the dialogs work with.
 
 class AmbientPlayer : public QObject
 {
     Q_OBJECT
 
 public:
-    explicit AmbientPlayer(QObject *parent = nullptr);
+    AmbientPlayer(DynamicEngine *engine, int layer, QObject *parent = nullptr);
     ~AmbientPlayer();
-    QMediaPlayer* mediaPlayer() const { return m_player; }
+    int layer() const { return m_layer; }
     void setName(const QString &name);
     QString name() const { return m_name; }
 
@@ -36,6 +43,13 @@ public:
 
     QMediaPlayer::PlaybackState playbackState() const;
 
+    qint64 position() const;   // ms
+    qint64 duration() const;   // ms
+    void setPosition(qint64 position);
+
+    void setMuted(bool muted);
+    bool isMuted() const { return m_muted; }
+
     QPushButton* button() const { return m_button; }
 
     bool hasAudio() const { return !m_filePath.isEmpty(); }
@@ -46,9 +60,13 @@ signals:
     void nameChanged(const QString &newName);
     void stateChanged();
     void needsUpdate();  // Generic "something changed" signal
+    void positionChanged(qint64 position);
+    void durationChanged(qint64 duration);
 
 private slots:
     void updateButtonState();
+    void onLayerStateChanged(int layer);
+    void pollPosition();
 
 private:
     QString m_name;
@@ -57,13 +75,19 @@ private:
     bool m_enabled;
     bool m_autoRepeat;
 
-    QMediaPlayer* m_player;
+    DynamicEngine* m_engine;
+    int m_layer;
+    QMediaPlayer::PlaybackState m_state = QMediaPlayer::StoppedState;
+    bool m_muted = false;
+    qint64 m_lastPosition = -1;
 
     QPushButton* m_button;
+    QTimer* m_positionTimer;
 
     void setupConnections();
     void updatePlayerSettings();
-    QAudioOutput *m_audioOutput = nullptr;
+    void updateGain();
+    void setState(QMediaPlayer::PlaybackState state);
 
     int m_baseVolume;      // User's choice (0-100)
     float m_masterRatio;   // Master scaling (0.0-1.0, start at 1.0)
@@ -131,14 +131,9 @@ void AmbientPlayerDialog::setupConnections()
         connect(m_player, &AmbientPlayer::stateChanged, this, &AmbientPlayerDialog::onPlayerStateChanged);
         connect(m_player, &AmbientPlayer::needsUpdate, this, &AmbientPlayerDialog::updateUI);
 
-        QMediaPlayer* mediaPlayer = m_player->mediaPlayer();
-
-        if (mediaPlayer) {
-            connect(mediaPlayer, &QMediaPlayer::positionChanged, this, &AmbientPlayerDialog::onPositionChanged);
-            connect(mediaPlayer, &QMediaPlayer::durationChanged, this, &AmbientPlayerDialog::onDurationChanged);
-            connect(m_progressSlider, &QSlider::sliderReleased, this, &AmbientPlayerDialog::seekAudio);
-
-        }
+        connect(m_player, &AmbientPlayer::positionChanged, this, &AmbientPlayerDialog::onPositionChanged);
+        connect(m_player, &AmbientPlayer::durationChanged, this, &AmbientPlayerDialog::onDurationChanged);
+        connect(m_progressSlider, &QSlider::sliderReleased, this, &AmbientPlayerDialog::seekAudio);
     }
 
     connect(m_okButton, &QPushButton::clicked, this, [this]() {
@@ -363,9 +358,8 @@ void AmbientPlayerDialog::hideEvent(QHideEvent *event)
 void AmbientPlayerDialog::seekAudio()
 {
     int position = m_progressSlider->value();
-       QMediaPlayer* mediaPlayer = m_player->mediaPlayer();
-       if (mediaPlayer && mediaPlayer->isSeekable()) {
-           mediaPlayer->setPosition(position);
+       if (m_player->duration() > 0) {
+           m_player->setPosition(position);
        }
 }
 
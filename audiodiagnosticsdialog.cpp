@@ -0,0 +1,335 @@
+#include "audiodiagnosticsdialog.h"
+#include "renderkernels.h"
+
+#include <QDialogButtonBox>
+#include <QFile>
+#include <QFileDialog>
+#include <QFormLayout>
+#include <QHBoxLayout>
+#include <QHeaderView>
+#include <QMessageBox>
+#include <QSettings>
+#include <QSysInfo>
+#include <QTextStream>
+#include <QVBoxLayout>
+
+namespace {
+
+enum TableRow { RENDER_TIME_ROW, BUDGET_ROW, INTERVAL_ROW };
+
+constexpr double NS_TO_MS = 1e-6;
+constexpr double PERMYRIAD_TO_PERCENT = 0.01;
+
+// Counts since earlier; a reset in between restarts from zero
+quint64 countSince(quint64 total, quint64 earlier)
+{
+    return total >= earlier ? total - earlier : total;
+}
+
+// Telemetry recorded between two polls
+DynamicEngine::CallbackTelemetry telemetrySince(const DynamicEngine::CallbackTelemetry &now,
+                                                const DynamicEngine::CallbackTelemetry &earlier)
+{
+    DynamicEngine::CallbackTelemetry window = now;
+    window.renderTimeNs = now.renderTimeNs.since(earlier.renderTimeNs);
+    window.budgetPermyriad = now.budgetPermyriad.since(earlier.budgetPermyriad);
+    window.callbackIntervalNs = now.callbackIntervalNs.since(earlier.callbackIntervalNs);
+    window.lateCallbacks = countSince(now.lateCallbacks, earlier.lateCallbacks);
+    window.sinkUnderruns = countSince(now.sinkUnderruns, earlier.sinkUnderruns);
+    window.renderAheadUnderruns = countSince(now.renderAheadUnderruns, earlier.renderAheadUnderruns);
+    return window;
+}
+
+// Spread of callback intervals: p99 above the median
+double jitterMs(const DynamicEngine::CallbackTelemetry &telemetry)
+{
+    const LogHistogram::Snapshot &interval = telemetry.callbackIntervalNs;
+    return (interval.percentile(99) - interval.percentile(50)) * NS_TO_MS;
+}
+
+} // namespace
+
+AudioDiagnosticsDialog::AudioDiagnosticsDialog(DynamicEngine *engine, QWidget *parent)
+    : QDialog(parent)
+    , m_engine(engine)
+    , m_loggedAt(QDateTime::currentDateTime())
+{
+    setupUI();
+
+    m_refreshTimer.setInterval(REFRESH_MS);
+    connect(&m_refreshTimer, &QTimer::timeout, this, &AudioDiagnosticsDialog::refresh);
+    connect(&m_logTimer, &QTimer::timeout, this, &AudioDiagnosticsDialog::appendLogRow);
+
+    // Fleet machines keep logging across restarts
+    QSettings settings;
+    m_logPathEdit->setText(settings.value("diagnostics/csvPath").toString());
+    m_logIntervalSpin->setValue(settings.value("diagnostics/csvIntervalS", DEFAULT_LOG_INTERVAL_S).toInt());
+    m_logCheck->setChecked(settings.value("diagnostics/csvLogging", false).toBool()
+                           && !m_logPathEdit->text().isEmpty());
+}
+
+void AudioDiagnosticsDialog::setupUI()
+{
+    setWindowTitle("Audio Diagnostics");
+    setMinimumSize(620, 360);
+
+    QVBoxLayout *layout = new QVBoxLayout(this);
+
+    m_formatLabel = new QLabel(this);
+    layout->addWidget(m_formatLabel);
+
+    m_table = new QTableWidget(3, 6, this);
+    m_table->setHorizontalHeaderLabels({ "Count", "Mean", "p50", "p95", "p99", "Max" });
+    m_table->setVerticalHeaderLabels({ "Render time per block (ms)", "CPU budget used (%)",
+                                       "Callback interval (ms)" });
+    m_table->setEditTriggers(QAbstractItemView::NoEditTriggers);
+    m_table->setSelectionMode(QAbstractItemView::NoSelection);
+    m_table->horizontalHeader()->setSectionResizeMode(QHeaderView::Stretch);
+    m_table->verticalHeader()->setSectionResizeMode(QHeaderView::ResizeToContents);
+    for (int row = 0; row < m_table->rowCount(); ++row) {
+        for (int column = 0; column < m_table->columnCount(); ++column) {
+            QTableWidgetItem *item = new QTableWidgetItem;
+            item->setTextAlignment(Qt::AlignRight | Qt::AlignVCenter);
+            m_table->setItem(row, column, item);
+        }
+    }
+    layout->addWidget(m_table);
+
+    m_countersLabel = new QLabel(this);
+    m_countersLabel->setWordWrap(true);
+    layout->addWidget(m_countersLabel);
+
+    m_ambientLabel = new QLabel(this);
+    m_ambientLabel->setWordWrap(true);
+    layout->addWidget(m_ambientLabel);
+
+    // Periodic CSV log
+    QHBoxLayout *logLayout = new QHBoxLayout;
+    m_logCheck = new QCheckBox("Append to CSV every", this);
+    m_logIntervalSpin = new QSpinBox(this);
+    m_logIntervalSpin->setRange(1, 3600);
+    m_logIntervalSpin->setSuffix(" s");
+    m_logPathEdit = new QLineEdit(this);
+    m_logPathEdit->setPlaceholderText("CSV file");
+    QPushButton *browseButton = new QPushButton("Browse...", this);
+    logLayout->addWidget(m_logCheck);
+    logLayout->addWidget(m_logIntervalSpin);
+    logLayout->addWidget(m_logPathEdit, 1);
+    logLayout->addWidget(browseButton);
+    layout->addLayout(logLayout);
+
+    connect(m_logCheck, &QCheckBox::toggled, this, &AudioDiagnosticsDialog::onLoggingToggled);
+    connect(browseButton, &QPushButton::clicked, this, &AudioDiagnosticsDialog::onBrowseClicked);
+    connect(m_logIntervalSpin, &QSpinBox::valueChanged, this, [this](int seconds) {
+        QSettings().setValue("diagnostics/csvIntervalS", seconds);
+        if (m_logTimer.isActive()) {
+            m_logTimer.start(seconds * 1000);
+        }
+    });
+
+    QDialogButtonBox *buttonBox = new QDialogButtonBox(QDialogButtonBox::Close, this);
+    QPushButton *resetButton = buttonBox->addButton("Reset", QDialogButtonBox::ResetRole);
+    QPushButton *exportButton = buttonBox->addButton("Export CSV...", QDialogButtonBox::ActionRole);
+    connect(resetButton, &QPushButton::clicked, this, &AudioDiagnosticsDialog::onResetClicked);
+    connect(exportButton, &QPushButton::clicked, this, &AudioDiagnosticsDialog::onExportClicked);
+    connect(buttonBox, &QDialogButtonBox::rejected, this, &QDialog::reject);
+    layout->addWidget(buttonBox);
+}
+
+void AudioDiagnosticsDialog::showEvent(QShowEvent *event)
+{
+    QDialog::showEvent(event);
+    refresh();
+    m_refreshTimer.start();
+}
+
+void AudioDiagnosticsDialog::hideEvent(QHideEvent *event)
+{
+    m_refreshTimer.stop();
+    QDialog::hideEvent(event);
+}
+
+void AudioDiagnosticsDialog::refresh()
+{
+    const DynamicEngine::CallbackTelemetry telemetry = m_engine->callbackTelemetry();
+
+    m_formatLabel->setText(QString("%1 Hz, sink buffer %2 ms, render-ahead %3 ms, %4 kernels")
+                                   .arg(telemetry.sampleRate)
+                                   .arg(telemetry.sinkBufferMs, 0, 'f', 1)
+                                   .arg(telemetry.renderAheadMs, 0, 'f', 0)
+                                   .arg(RenderKernels::activeKernels().name));
+
+    setRow(RENDER_TIME_ROW, telemetry.renderTimeNs, NS_TO_MS, 3);
+    setRow(BUDGET_ROW, telemetry.budgetPermyriad, PERMYRIAD_TO_PERCENT, 1);
+    setRow(INTERVAL_ROW, telemetry.callbackIntervalNs, NS_TO_MS, 2);
+
+    m_countersLabel->setText(QString("Jitter (interval p99 - p50): %1 ms    Late callbacks: %2    "
+                                     "Blocks over budget: %3    Sink underruns: %4    "
+                                     "Render-ahead underruns: %5")
+                                     .arg(jitterMs(telemetry), 0, 'f', 2)
+                                     .arg(telemetry.lateCallbacks)
+                                     .arg(telemetry.budgetPermyriad.countAbove(DynamicEngine::FULL_BUDGET))
+                                     .arg(telemetry.sinkUnderruns)
+                                     .arg(telemetry.renderAheadUnderruns));
+
+    // Warm loads map the ambient cache, cold ones decode the file
+    QStringList loads;
+    for (int layer = 0; layer < DynamicEngine::MAX_AMBIENT_LAYERS; ++layer) {
+        const qint64 loadMs = m_engine->ambientLayerLoadMs(layer);
+        if (loadMs >= 0) {
+            loads << QString("layer %1 %2 ms (%3)")
+                             .arg(layer + 1)
+                             .arg(loadMs)
+                             .arg(m_engine->isAmbientLayerCacheHit(layer) ? "warm" : "cold");
+        }
+    }
+    m_ambientLabel->setText("Ambient load time: " + (loads.isEmpty() ? QString("no layers loaded")
+                                                                      : loads.join(", ")));
+}
+
+void AudioDiagnosticsDialog::setRow(int row, const LogHistogram::Snapshot &snapshot, double scale, int decimals)
+{
+    const double values[] = { snapshot.mean(), static_cast<double>(snapshot.percentile(50)),
+                              static_cast<double>(snapshot.percentile(95)),
+                              static_cast<double>(snapshot.percentile(99)),
+                              static_cast<double>(snapshot.max) };
+
+    m_table->item(row, 0)->setText(QString::number(snapshot.count));
+    for (int i = 0; i < 5; ++i) {
+        m_table->item(row, i + 1)->setText(snapshot.count > 0 ? QString::number(values[i] * scale, 'f', decimals)
+                                                              : QString("-"));
+    }
+}
+
+void AudioDiagnosticsDialog::onResetClicked()
+{
+    m_engine->resetCallbackTelemetry();
+    refresh();
+}
+
+// One row with everything since the last reset
+void AudioDiagnosticsDialog::onExportClicked()
+{
+    QString filePath = QFileDialog::getSaveFileName(this, "Export Audio Diagnostics",
+                                                    QString("audio-diagnostics-%1.csv")
+                                                            .arg(QSysInfo::machineHostName()),
+                                                    "CSV files (*.csv)");
+    if (filePath.isEmpty()) {
+        return;
+    }
+
+    if (!appendCsv(filePath, m_engine->callbackTelemetry(), -1.0)) {
+        QMessageBox::warning(this, "Export Failed", QString("Could not write %1").arg(filePath));
+    }
+}
+
+void AudioDiagnosticsDialog::onBrowseClicked()
+{
+    QString filePath = QFileDialog::getSaveFileName(this, "Audio Diagnostics Log", m_logPathEdit->text(),
+                                                    "CSV files (*.csv)", nullptr,
+                                                    QFileDialog::DontConfirmOverwrite);
+    if (!filePath.isEmpty()) {
+        m_logPathEdit->setText(filePath);
+    }
+}
+
+void AudioDiagnosticsDialog::onLoggingToggled(bool enabled)
+{
+    if (enabled && m_logPathEdit->text().isEmpty()) {
+        onBrowseClicked();
+        if (m_logPathEdit->text().isEmpty()) {
+            m_logCheck->setChecked(false);
+            return;
+        }
+    }
+
+    QSettings settings;
+    settings.setValue("diagnostics/csvLogging", enabled);
+    settings.setValue("diagnostics/csvPath", m_logPathEdit->text());
+    m_logPathEdit->setEnabled(!enabled);
+
+    if (enabled) {
+        m_loggedTelemetry = m_engine->callbackTelemetry();
+        m_loggedAt = QDateTime::currentDateTime();
+        m_logTimer.start(m_logIntervalSpin->value() * 1000);
+    } else {
+        m_logTimer.stop();
+    }
+}
+
+// One row covering the time since the previous row
+void AudioDiagnosticsDialog::appendLogRow()
+{
+    const DynamicEngine::CallbackTelemetry telemetry = m_engine->callbackTelemetry();
+    const QDateTime now = QDateTime::currentDateTime();
+    const double windowSeconds = m_loggedAt.msecsTo(now) / 1000.0;
+
+    if (!appendCsv(m_logPathEdit->text(), telemetrySince(telemetry, m_loggedTelemetry), windowSeconds)) {
+        m_logCheck->setChecked(false);
+        QMessageBox::warning(this, "Diagnostics Log Stopped",
+                             QString("Could not write %1").arg(m_logPathEdit->text()));
+        return;
+    }
+    m_loggedTelemetry = telemetry;
+    m_loggedAt = now;
+}
+
+QString AudioDiagnosticsDialog::csvHeader()
+{
+    return "timestamp,host,render_kernels,sample_rate,sink_buffer_ms,render_ahead_ms,window_s,"
+           "blocks,render_mean_ms,render_p50_ms,render_p99_ms,render_max_ms,"
+           "budget_mean_pct,budget_p99_pct,budget_max_pct,over_budget_blocks,"
+           "callbacks,interval_p50_ms,interval_p99_ms,interval_max_ms,jitter_ms,"
+           "late_callbacks,sink_underruns,render_ahead_underruns";
+}
+
+// Appends a row, with the header first in a new file; windowSeconds
+// below zero leaves the window empty (totals since the last reset)
+bool AudioDiagnosticsDialog::appendCsv(const QString &filePath, const DynamicEngine::CallbackTelemetry &telemetry,
+                                       double windowSeconds)
+{
+    QFile file(filePath);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Append | QIODevice::Text)) {
+        return false;
+    }
+
+    QTextStream out(&file);
+    if (file.size() == 0) {
+        out << csvHeader() << "\n";
+    }
+
+    const LogHistogram::Snapshot &render = telemetry.renderTimeNs;
+    const LogHistogram::Snapshot &budget = telemetry.budgetPermyriad;
+    const LogHistogram::Snapshot &interval = telemetry.callbackIntervalNs;
+    const auto ms = [](double ns) { return QString::number(ns * NS_TO_MS, 'f', 3); };
+    const auto percent = [](double permyriad) { return QString::number(permyriad * PERMYRIAD_TO_PERCENT, 'f', 2); };
+
+    const QStringList fields = {
+        QDateTime::currentDateTime().toString(Qt::ISODate),
+        QSysInfo::machineHostName(),
+        RenderKernels::activeKernels().name,
+        QString::number(telemetry.sampleRate),
+        QString::number(telemetry.sinkBufferMs, 'f', 1),
+        QString::number(telemetry.renderAheadMs, 'f', 0),
+        windowSeconds >= 0.0 ? QString::number(windowSeconds, 'f', 1) : QString(),
+        QString::number(render.count),
+        ms(render.mean()),
+        ms(render.percentile(50)),
+        ms(render.percentile(99)),
+        ms(render.max),
+        percent(budget.mean()),
+        percent(budget.percentile(99)),
+        percent(budget.max),
+        QString::number(budget.countAbove(DynamicEngine::FULL_BUDGET)),
+        QString::number(interval.count),
+        ms(interval.percentile(50)),
+        ms(interval.percentile(99)),
+        ms(interval.max),
+        QString::number(jitterMs(telemetry), 'f', 3),
+        QString::number(telemetry.lateCallbacks),
+        QString::number(telemetry.sinkUnderruns),
+        QString::number(telemetry.renderAheadUnderruns)
+    };
+    out << fields.join(',') << "\n";
+    return out.status() == QTextStream::Ok;
+}
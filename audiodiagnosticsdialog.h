@@ -0,0 +1,67 @@
+#ifndef AUDIODIAGNOSTICSDIALOG_H
+#define AUDIODIAGNOSTICSDIALOG_H
+
+#include "dynamicengine.h"
+
+#include <QDialog>
+#include <QCheckBox>
+#include <QDateTime>
+#include <QLabel>
+#include <QLineEdit>
+#include <QPushButton>
+#include <QSpinBox>
+#include <QTableWidget>
+#include <QTimer>
+
+// Live view of DynamicEngine's callback telemetry: render time, CPU
+// budget use and callback interval percentiles plus late callbacks and
+// underruns, and how long each ambient layer took to load. Rows can be
+// exported to CSV once or appended periodically, one row per interval,
+// to compare machines; logging keeps running while the dialog is hidden.
+
+class AudioDiagnosticsDialog : public QDialog
+{
+    Q_OBJECT
+
+public:
+    explicit AudioDiagnosticsDialog(DynamicEngine *engine, QWidget *parent = nullptr);
+
+    static constexpr int REFRESH_MS = 500;
+    static constexpr int DEFAULT_LOG_INTERVAL_S = 60;
+
+protected:
+    void showEvent(QShowEvent *event) override;
+    void hideEvent(QHideEvent *event) override;
+
+private slots:
+    void refresh();
+    void onResetClicked();
+    void onExportClicked();
+    void onBrowseClicked();
+    void onLoggingToggled(bool enabled);
+    void appendLogRow();
+
+private:
+    void setupUI();
+    void setRow(int row, const LogHistogram::Snapshot &snapshot, double scale, int decimals);
+    bool appendCsv(const QString &filePath, const DynamicEngine::CallbackTelemetry &telemetry,
+                   double windowSeconds);
+    static QString csvHeader();
+
+    DynamicEngine *m_engine;
+    QTableWidget *m_table;
+    QLabel *m_formatLabel;
+    QLabel *m_countersLabel;
+    QLabel *m_ambientLabel;
+    QCheckBox *m_logCheck;
+    QLineEdit *m_logPathEdit;
+    QSpinBox *m_logIntervalSpin;
+    QTimer m_refreshTimer;
+    QTimer m_logTimer;
+
+    // Last logged totals; each logged row covers the time since
+    DynamicEngine::CallbackTelemetry m_loggedTelemetry;
+    QDateTime m_loggedAt;
+};
+
+#endif // AUDIODIAGNOSTICSDIALOG_H
@@ -0,0 +1,578 @@
+#include "binauralengine.h"
+#include "dynamicrenderer.h"
+#include "noisegenerator.h"
+#include "renderkernels.h"
+
+#include <QByteArray>
+#include <QCoreApplication>
+#include <QRandomGenerator>
+#include <benchmark/benchmark.h>
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <vector>
+
+// ============================================================
+// RENDER PATH MICROBENCHMARKS
+// ============================================================
+// binaural_bench times the synthesis code without an audio device:
+// BinauralEngine's whole-buffer generators and loop fade, each
+// DynamicRenderer waveform and noise generator, and the full render
+// block (DynamicRenderer::render).
+// BM_ToneRenderer runs each of the 80 tone configurations through the
+// renderer it is dispatched to, the generic loop and the original
+// per-sample loop (BaselineRenderer).
+// BM_BlockStages compares the post-oscillator stages (noise mix, gain,
+// int16 conversion) run frame by frame against mixGainToInt16 from the
+// scalar and the active kernel set.
+// BM_Voices renders 1 to 128 tone voices and reports the mix's peak.
+// BM_OutputStage times the block's final conversion with and without
+// level metering; the difference against BM_ReadDataBlock is the share
+// of render time the meter costs.
+//
+// Results go to stdout as JSON unless a --benchmark_format is given,
+// so runs can be stored and compared between releases:
+//
+//   binaural_bench > bench.json
+//   binaural_bench --benchmark_filter=Noise --benchmark_format=console
+
+// Private members the benchmarks drive directly
+struct EngineBench
+{
+    static void generateAudioBuffer(BinauralEngine &engine, int durationMs)
+    {
+        engine.generateAudioBuffer(durationMs);
+    }
+
+    static void generateIsochronicBuffer(BinauralEngine &engine, int durationMs)
+    {
+        engine.generateIsochronicBuffer(durationMs);
+    }
+
+    static void applyLoopFade(BinauralEngine &engine, QByteArray &buffer, int durationMs)
+    {
+        engine.applyLoopFade(buffer, durationMs);
+    }
+};
+
+namespace {
+
+constexpr int SAMPLE_RATE = 44100;
+constexpr int BUFFER_MS = 1000;         // Whole-buffer generators
+constexpr qint64 BUFFER_FRAMES = static_cast<qint64>(SAMPLE_RATE) * BUFFER_MS / 1000;
+constexpr double OUTPUT_GAIN = 0.15;    // DynamicEngine's default volume
+
+const char *const WAVEFORM_NAMES[] = { "sine", "square", "triangle", "sawtooth" };
+const char *const NOISE_NAMES[] = { "off", "white", "pink", "brown", "grey" };
+
+// items_per_second counts frames; audio_seconds per second is the
+// multiple of real time the code runs at
+void setFrames(benchmark::State &state, qint64 framesPerIteration)
+{
+    state.SetItemsProcessed(state.iterations() * framesPerIteration);
+    state.counters["audio_seconds"] = benchmark::Counter(
+            static_cast<double>(framesPerIteration) / SAMPLE_RATE,
+            benchmark::Counter::kIsIterationInvariantRate);
+}
+
+// ============================================================
+// BINAURAL ENGINE (LEGACY WHOLE-BUFFER PATH)
+// ============================================================
+
+void BM_BinauralGenerateBuffer(benchmark::State &state)
+{
+    const auto waveform = static_cast<BinauralEngine::Waveform>(state.range(0));
+    BinauralEngine engine;
+    engine.setToneType(0);
+    engine.setWaveform(waveform);
+
+    for (auto _ : state) {
+        EngineBench::generateAudioBuffer(engine, BUFFER_MS);
+    }
+    state.SetLabel(WAVEFORM_NAMES[state.range(0)]);
+    setFrames(state, BUFFER_FRAMES);
+}
+BENCHMARK(BM_BinauralGenerateBuffer)->DenseRange(0, 3)->Unit(benchmark::kMillisecond);
+
+void BM_BinauralGenerateIsochronicBuffer(benchmark::State &state)
+{
+    const auto waveform = static_cast<BinauralEngine::Waveform>(state.range(0));
+    BinauralEngine engine;
+    engine.setToneType(1);
+    engine.setWaveform(waveform);
+
+    for (auto _ : state) {
+        EngineBench::generateIsochronicBuffer(engine, BUFFER_MS);
+    }
+    state.SetLabel(WAVEFORM_NAMES[state.range(0)]);
+    setFrames(state, BUFFER_FRAMES);
+}
+BENCHMARK(BM_BinauralGenerateIsochronicBuffer)->DenseRange(0, 3)->Unit(benchmark::kMillisecond);
+
+// The fade rewrites the buffer in place; repeating it on the same
+// buffer costs the same as on a fresh one
+void BM_BinauralApplyLoopFade(benchmark::State &state)
+{
+    BinauralEngine engine;
+    const std::vector<int16_t> samples(BUFFER_FRAMES * 2, 16384);
+    QByteArray buffer(reinterpret_cast<const char *>(samples.data()),
+                      static_cast<int>(samples.size() * sizeof(int16_t)));
+
+    for (auto _ : state) {
+        EngineBench::applyLoopFade(engine, buffer, BUFFER_MS);
+        benchmark::DoNotOptimize(buffer.data());
+    }
+    setFrames(state, BUFFER_FRAMES);
+}
+BENCHMARK(BM_BinauralApplyLoopFade)->Unit(benchmark::kMicrosecond);
+
+// ============================================================
+// DYNAMIC RENDERER (STREAMING RENDER PATH)
+// ============================================================
+
+DynamicRenderer::Parameters toneParameters(DynamicRenderer::Waveform waveform, bool isochronic,
+                                           DynamicRenderer::OscillatorMode mode, int noise)
+{
+    DynamicRenderer::Parameters params;
+    params.sampleRate = SAMPLE_RATE;
+    params.toneType = isochronic ? 1 : 0;
+    params.waveform = waveform;
+    params.oscillatorMode = mode;
+    params.pulseFrequency = 10.0;
+    params.noiseType = noise;
+    params.noiseEnabled = noise > 0;
+    return params;
+}
+
+// One render block: oscillators, gate, noise, gain and conversion
+void renderBlocks(benchmark::State &state, DynamicRenderer &renderer, bool floatOutput)
+{
+    std::vector<float> out(2 * RenderKernels::BLOCK_FRAMES); // Fits either format
+    for (auto _ : state) {
+        if (floatOutput) {
+            renderer.render(out.data(), RenderKernels::BLOCK_FRAMES);
+        } else {
+            renderer.render(reinterpret_cast<int16_t *>(out.data()), RenderKernels::BLOCK_FRAMES);
+        }
+        benchmark::DoNotOptimize(out.data());
+    }
+    setFrames(state, RenderKernels::BLOCK_FRAMES);
+}
+
+// Args: waveform, tone type (0 binaural, 1 isochronic), oscillator mode
+void BM_DynamicWaveform(benchmark::State &state)
+{
+    const auto renderer = std::make_unique<DynamicRenderer>(
+            toneParameters(static_cast<DynamicRenderer::Waveform>(state.range(0)), state.range(1) == 1,
+                           static_cast<DynamicRenderer::OscillatorMode>(state.range(2)), 0),
+            OUTPUT_GAIN);
+
+    renderBlocks(state, *renderer, false);
+    state.SetLabel(std::string(WAVEFORM_NAMES[state.range(0)])
+                   + (state.range(1) == 1 ? " isochronic" : " binaural")
+                   + (state.range(2) == DynamicRenderer::WAVETABLE_OSCILLATOR ? " wavetable" : " exact"));
+}
+BENCHMARK(BM_DynamicWaveform)
+        ->ArgsProduct({ benchmark::CreateDenseRange(0, 3, 1), { 0, 1 },
+                        { DynamicRenderer::EXACT_OSCILLATOR, DynamicRenderer::WAVETABLE_OSCILLATOR } })
+        ->Unit(benchmark::kMicrosecond);
+
+// ============================================================
+// BASELINE (ORIGINAL PER-SAMPLE LOOP)
+// ============================================================
+// DynamicEngine's readData() as it was before the block renderer:
+// radian phases, std::sin per sample, waveform and noise switched per
+// sample, QRandomGenerator noise and a qBound/int16 store per sample.
+// The tone renderers are measured against it.
+class BaselineRenderer
+{
+public:
+    explicit BaselineRenderer(const DynamicRenderer::Parameters &params, double gain)
+        : m_params(params)
+        , m_amplitude(params.amplitude * gain)
+    {
+    }
+
+    void render(int16_t *samples, int sampleCount)
+    {
+        const double leftFreq = m_params.leftFrequency;
+        const double rightFreq = m_params.rightFrequency;
+        const double sampleRate = m_params.sampleRate;
+        const double pulseFreq = m_params.pulseFrequency;
+        const bool isIsochronic = m_params.toneType == 1;
+        const bool noiseEnabled = m_params.noiseEnabled;
+        const int noiseType = m_params.noiseType;
+        const double noiseLevel = m_params.noiseLevel;
+
+        for (int i = 0; i < sampleCount; ++i) {
+            double leftSample = 0.0;
+            double rightSample = 0.0;
+
+            if (isIsochronic) {
+                const double carrierPhaseInc = (2.0 * M_PI * leftFreq) / sampleRate;
+                const double pulsePhaseInc = (2.0 * M_PI * pulseFreq) / sampleRate;
+
+                double carrier = 0.0;
+                switch (m_params.waveform) {
+                    case DynamicRenderer::SINE_WAVE: carrier = std::sin(m_phaseLeft); break;
+                    case DynamicRenderer::SQUARE_WAVE: carrier = (std::sin(m_phaseLeft) >= 0.0) ? 1.0 : -1.0; break;
+                    case DynamicRenderer::TRIANGLE_WAVE: carrier = triangleSample(m_phaseLeft); break;
+                    case DynamicRenderer::SAWTOOTH_WAVE: carrier = sawtoothSample(m_phaseLeft); break;
+                }
+
+                const bool pulseOn = (std::sin(m_phaseRight) >= 0.0);
+                const double attackSteps = 0.01 * sampleRate;
+                const double releaseSteps = 0.01 * sampleRate;
+                if (pulseOn) {
+                    if (m_pulseEnvelope < 1.0) {
+                        m_pulseEnvelope += 1.0 / attackSteps;
+                        if (m_pulseEnvelope > 1.0) m_pulseEnvelope = 1.0;
+                    }
+                } else {
+                    if (m_pulseEnvelope > 0.0) {
+                        m_pulseEnvelope -= 1.0 / releaseSteps;
+                        if (m_pulseEnvelope < 0.0) m_pulseEnvelope = 0.0;
+                    }
+                }
+
+                leftSample = carrier * m_pulseEnvelope;
+                rightSample = leftSample;
+                m_phaseLeft += carrierPhaseInc;
+                m_phaseRight += pulsePhaseInc;
+            } else {
+                const double leftPhaseInc = (2.0 * M_PI * leftFreq) / sampleRate;
+                const double rightPhaseInc = (2.0 * M_PI * rightFreq) / sampleRate;
+                leftSample = waveformSample(m_phaseLeft);
+                rightSample = waveformSample(m_phaseRight);
+                m_phaseLeft += leftPhaseInc;
+                m_phaseRight += rightPhaseInc;
+            }
+
+            if (noiseEnabled && noiseType > 0 && noiseLevel > 0.0) {
+                double noiseSample = 0.0;
+                switch (noiseType) {
+                    case 1: noiseSample = whiteNoise(); break;
+                    case 2: noiseSample = pinkNoise(); break;
+                    case 3: noiseSample = brownNoise(); break;
+                    case 4: noiseSample = greyNoise(); break;
+                    default: noiseSample = 0.0; break;
+                }
+                leftSample = (leftSample * (1.0 - noiseLevel)) + (noiseSample * noiseLevel);
+                rightSample = (rightSample * (1.0 - noiseLevel)) + (noiseSample * noiseLevel);
+            }
+
+            leftSample *= m_amplitude;
+            rightSample *= m_amplitude;
+            leftSample = qBound(-1.0, leftSample, 1.0);
+            rightSample = qBound(-1.0, rightSample, 1.0);
+            samples[2 * i] = static_cast<int16_t>(leftSample * 32767);
+            samples[2 * i + 1] = static_cast<int16_t>(rightSample * 32767);
+
+            if (m_phaseLeft > 2.0 * M_PI) m_phaseLeft -= 2.0 * M_PI;
+            if (m_phaseRight > 2.0 * M_PI) m_phaseRight -= 2.0 * M_PI;
+        }
+    }
+
+private:
+    double waveformSample(double phase) const
+    {
+        switch (m_params.waveform) {
+            case DynamicRenderer::SINE_WAVE: return std::sin(phase);
+            case DynamicRenderer::SQUARE_WAVE: return (std::sin(phase) >= 0.0) ? 1.0 : -1.0;
+            case DynamicRenderer::TRIANGLE_WAVE: return triangleSample(phase);
+            case DynamicRenderer::SAWTOOTH_WAVE: return sawtoothSample(phase);
+        }
+        return std::sin(phase);
+    }
+
+    static double triangleSample(double phase)
+    {
+        const double normalized = phase / (2.0 * M_PI);
+        return normalized < 0.5 ? 4.0 * normalized - 1.0 : 3.0 - 4.0 * normalized;
+    }
+
+    static double sawtoothSample(double phase)
+    {
+        const double normalized = phase / (2.0 * M_PI);
+        return 2.0 * (normalized - std::floor(normalized + 0.5));
+    }
+
+    static double whiteNoise()
+    {
+        return QRandomGenerator::global()->generateDouble() * 2.0 - 1.0;
+    }
+
+    // Voss-McCartney, 8 stages
+    double pinkNoise()
+    {
+        static const int numStages = 8;
+        m_pinkValues[0] = whiteNoise();
+        for (int i = 1; i < numStages; ++i) {
+            if (m_pinkIndex % (1 << i) == 0) {
+                m_pinkValues[i] = whiteNoise();
+            }
+        }
+        double runningSum = 0.0;
+        for (int i = 0; i < numStages; ++i) {
+            runningSum += m_pinkValues[i];
+        }
+        ++m_pinkIndex;
+        if (m_pinkIndex >= (1 << (numStages - 1))) {
+            m_pinkIndex = 0;
+        }
+        return qBound(-1.0, (runningSum / numStages) * 2.0, 1.0);
+    }
+
+    double greyNoise()
+    {
+        const double grey = 0.7 * m_greyPrevious + 0.3 * whiteNoise();
+        m_greyPrevious = grey;
+        m_greyMid = 0.5 * m_greyMid + 0.5 * grey;
+        return qBound(-1.0, grey - (0.15 * m_greyMid), 1.0);
+    }
+
+    double brownNoise()
+    {
+        const double step = (QRandomGenerator::global()->generateDouble() - 0.5) * 0.5;
+        m_brownState = qBound(-0.8, m_brownState + step, 0.8);
+        return m_brownState;
+    }
+
+    DynamicRenderer::Parameters m_params;
+    double m_amplitude;
+    double m_phaseLeft = 0.0;
+    double m_phaseRight = 0.0;
+    double m_pulseEnvelope = 0.0;
+    double m_pinkValues[8] = {};
+    int m_pinkIndex = 0;
+    double m_greyPrevious = 0.0;
+    double m_greyMid = 0.0;
+    double m_brownState = 0.0;
+};
+
+// Every tone renderer configuration through the renderer it is
+// dispatched to, the generic per-sample loop and the baseline. Args:
+// waveform, tone type x oscillator mode (0 binaural exact, 1 binaural
+// wavetable, 2 isochronic exact, 3 isochronic wavetable), noise type
+// (0 off), renderer (0 dispatched, 1 generic, 2 baseline; the baseline
+// has no wavetable mode and runs std::sin either way).
+void BM_ToneRenderer(benchmark::State &state)
+{
+    const bool isochronic = state.range(1) >= 2;
+    const auto mode = (state.range(1) % 2) == 1 ? DynamicRenderer::WAVETABLE_OSCILLATOR
+                                                : DynamicRenderer::EXACT_OSCILLATOR;
+    const int noise = static_cast<int>(state.range(2));
+    const int path = static_cast<int>(state.range(3));
+    const DynamicRenderer::Parameters params =
+            toneParameters(static_cast<DynamicRenderer::Waveform>(state.range(0)), isochronic, mode, noise);
+
+    if (path == 2) {
+        BaselineRenderer baseline(params, OUTPUT_GAIN);
+        std::vector<int16_t> out(2 * RenderKernels::BLOCK_FRAMES);
+        for (auto _ : state) {
+            baseline.render(out.data(), RenderKernels::BLOCK_FRAMES);
+            benchmark::DoNotOptimize(out.data());
+        }
+        setFrames(state, RenderKernels::BLOCK_FRAMES);
+    } else {
+        const auto renderer = std::make_unique<DynamicRenderer>(params, OUTPUT_GAIN);
+        renderer->setGenericTones(path == 1);
+        renderBlocks(state, *renderer, false);
+    }
+
+    const char *const PATH_NAMES[] = { " dispatched", " generic", " baseline" };
+    state.SetLabel(std::string(WAVEFORM_NAMES[state.range(0)])
+                   + (isochronic ? " isochronic" : " binaural")
+                   + (mode == DynamicRenderer::WAVETABLE_OSCILLATOR ? " wavetable " : " exact ")
+                   + NOISE_NAMES[noise] + PATH_NAMES[path]);
+}
+BENCHMARK(BM_ToneRenderer)
+        ->ArgsProduct({ benchmark::CreateDenseRange(0, 3, 1), benchmark::CreateDenseRange(0, 3, 1),
+                        benchmark::CreateDenseRange(0, 4, 1), { 0, 1, 2 } })
+        ->Unit(benchmark::kMicrosecond);
+
+// The generator alone, one block per iteration
+void BM_NoiseGenerator(benchmark::State &state)
+{
+    NoiseGenerator generator;
+    std::vector<float> out(RenderKernels::BLOCK_FRAMES);
+    const int type = static_cast<int>(state.range(0));
+
+    for (auto _ : state) {
+        generator.fill(type, out.data(), RenderKernels::BLOCK_FRAMES);
+        benchmark::DoNotOptimize(out.data());
+    }
+    state.SetLabel(NOISE_NAMES[type]);
+    setFrames(state, RenderKernels::BLOCK_FRAMES);
+}
+BENCHMARK(BM_NoiseGenerator)->DenseRange(1, 4)->Unit(benchmark::kMicrosecond);
+
+// Full block with noise mixed into a binaural sine; args: noise type
+// (0 off), output format (0 Int16, 1 Float32)
+void BM_ReadDataBlock(benchmark::State &state)
+{
+    const int noise = static_cast<int>(state.range(0));
+    const auto renderer = std::make_unique<DynamicRenderer>(
+            toneParameters(DynamicRenderer::SINE_WAVE, false, DynamicRenderer::WAVETABLE_OSCILLATOR, noise),
+            OUTPUT_GAIN);
+
+    const bool floatOutput = state.range(1) == 1;
+    renderBlocks(state, *renderer, floatOutput);
+    state.SetLabel(std::string("noise ") + NOISE_NAMES[noise] + (floatOutput ? " float32" : " int16"));
+}
+BENCHMARK(BM_ReadDataBlock)
+        ->ArgsProduct({ benchmark::CreateDenseRange(0, 4, 1), { 0, 1 } })
+        ->Unit(benchmark::kMicrosecond);
+
+// Full blocks with tone voices layered on a binaural sine at full
+// output gain; args: voice count. Voices alternate binaural and
+// isochronic over all four waveforms at the default gain, spread from
+// 100 Hz to 1 kHz. The peak counter is the largest pre-clamp sample
+// seen, so a value above 1 means the voice bus clipped.
+void BM_Voices(benchmark::State &state)
+{
+    const int count = static_cast<int>(state.range(0));
+    const auto bank = std::make_unique<DynamicRenderer::VoiceBank>();
+    for (int i = 0; i < count; ++i) {
+        DynamicRenderer::VoiceSlot &slot = bank->voices[i];
+        slot.voice.toneType = i % 2;
+        slot.voice.leftFrequency = 100.0 + 900.0 * i / DynamicRenderer::MAX_VOICES;
+        slot.voice.rightFrequency = slot.voice.leftFrequency + 4.0 + i % 8;
+        slot.voice.pulseFrequency = 4.0 + i % 8;
+        slot.voice.waveform = static_cast<DynamicRenderer::Waveform>((i / 2) % 4);
+        slot.active = true;
+        slot.serial = i + 1;
+    }
+
+    const auto renderer = std::make_unique<DynamicRenderer>(
+            toneParameters(DynamicRenderer::SINE_WAVE, false, DynamicRenderer::WAVETABLE_OSCILLATOR, 0), 1.0);
+    renderer->setVoices(bank.get());
+    renderer->setMetering(true);
+
+    std::vector<int16_t> out(2 * RenderKernels::BLOCK_FRAMES);
+    float peak = 0.0f;
+    for (auto _ : state) {
+        renderer->render(out.data(), RenderKernels::BLOCK_FRAMES);
+        benchmark::DoNotOptimize(out.data());
+        const RenderKernels::LevelSums &levels = renderer->levels();
+        peak = std::max({ peak, levels.peakLeft, levels.peakRight });
+    }
+    state.counters["peak"] = peak;
+    state.SetLabel(std::to_string(count) + (count == 1 ? " voice" : " voices"));
+    setFrames(state, RenderKernels::BLOCK_FRAMES);
+}
+BENCHMARK(BM_Voices)->Arg(1)->Arg(8)->Arg(32)->Arg(128)->Unit(benchmark::kMicrosecond);
+
+// The stages after oscillation (noise crossfade, amplitude, clamp and
+// int16 conversion) over one block, as the original render loop ran
+// them frame by frame in double and as block kernels. Args: 0 per-sample
+// loop, 1 scalar kernels, 2 active kernels.
+void BM_BlockStages(benchmark::State &state)
+{
+    std::vector<float> toneLeft(RenderKernels::BLOCK_FRAMES);
+    std::vector<float> toneRight(RenderKernels::BLOCK_FRAMES);
+    std::vector<float> noise(RenderKernels::BLOCK_FRAMES);
+    for (int i = 0; i < RenderKernels::BLOCK_FRAMES; ++i) {
+        toneLeft[i] = static_cast<float>(std::sin(2.0 * M_PI * 200.0 * i / SAMPLE_RATE));
+        toneRight[i] = static_cast<float>(std::sin(2.0 * M_PI * 207.83 * i / SAMPLE_RATE));
+    }
+    NoiseGenerator generator;
+    generator.fill(NoiseGenerator::NOISE_PINK, noise.data(), RenderKernels::BLOCK_FRAMES);
+
+    const double noiseLevel = 0.3;
+    const double amplitude = 0.5;
+    std::vector<float> left(RenderKernels::BLOCK_FRAMES);
+    std::vector<float> right(RenderKernels::BLOCK_FRAMES);
+    std::vector<int16_t> out(2 * RenderKernels::BLOCK_FRAMES);
+    const int path = static_cast<int>(state.range(0));
+    const RenderKernels::KernelSet &kernels = path == 1 ? RenderKernels::scalarKernels()
+                                                        : RenderKernels::activeKernels();
+
+    for (auto _ : state) {
+        if (path == 0) {
+            for (int i = 0; i < RenderKernels::BLOCK_FRAMES; ++i) {
+                double leftSample = toneLeft[i];
+                double rightSample = toneRight[i];
+                leftSample = leftSample * (1.0 - noiseLevel) + noise[i] * noiseLevel;
+                rightSample = rightSample * (1.0 - noiseLevel) + noise[i] * noiseLevel;
+                leftSample = qBound(-1.0, leftSample * amplitude, 1.0);
+                rightSample = qBound(-1.0, rightSample * amplitude, 1.0);
+                out[2 * i] = static_cast<int16_t>(leftSample * 32767);
+                out[2 * i + 1] = static_cast<int16_t>(rightSample * 32767);
+            }
+        } else {
+            std::copy(toneLeft.begin(), toneLeft.end(), left.begin());
+            std::copy(toneRight.begin(), toneRight.end(), right.begin());
+            kernels.mixGainToInt16(left.data(), right.data(), noise.data(), noiseLevel, 0.0f, amplitude, 0.0f,
+                                   out.data(), RenderKernels::BLOCK_FRAMES, nullptr);
+        }
+        benchmark::DoNotOptimize(out.data());
+    }
+    state.SetLabel(path == 0 ? "per-sample" : kernels.name);
+    setFrames(state, RenderKernels::BLOCK_FRAMES);
+}
+BENCHMARK(BM_BlockStages)->DenseRange(0, 2)->Unit(benchmark::kNanosecond);
+
+// The block's last step on its own; args: output format (0 Int16,
+// 1 Float32), metered (0 or 1). Renderers meter only when asked to, so
+// BM_ReadDataBlock above is the unmetered block.
+void BM_OutputStage(benchmark::State &state)
+{
+    const RenderKernels::KernelSet &kernels = RenderKernels::activeKernels();
+    std::vector<float> left(RenderKernels::BLOCK_FRAMES);
+    std::vector<float> right(RenderKernels::BLOCK_FRAMES);
+    for (int i = 0; i < RenderKernels::BLOCK_FRAMES; ++i) {
+        left[i] = 0.5f * static_cast<float>(std::sin(2.0 * M_PI * 200.0 * i / SAMPLE_RATE));
+        right[i] = 0.5f * static_cast<float>(std::sin(2.0 * M_PI * 207.83 * i / SAMPLE_RATE));
+    }
+    std::vector<float> out(2 * RenderKernels::BLOCK_FRAMES); // Fits either format
+    const bool floatOutput = state.range(0) == 1;
+    RenderKernels::LevelSums sums;
+    RenderKernels::LevelSums *levels = state.range(1) == 1 ? &sums : nullptr;
+
+    for (auto _ : state) {
+        if (floatOutput) {
+            kernels.interleaveFloat(left.data(), right.data(), out.data(), RenderKernels::BLOCK_FRAMES, levels);
+        } else {
+            kernels.convertToInt16(left.data(), right.data(), reinterpret_cast<int16_t *>(out.data()),
+                                   RenderKernels::BLOCK_FRAMES, levels);
+        }
+        benchmark::DoNotOptimize(out.data());
+        benchmark::DoNotOptimize(sums);
+    }
+    state.SetLabel(std::string(floatOutput ? "float32" : "int16") + (levels ? " metered" : ""));
+    setFrames(state, RenderKernels::BLOCK_FRAMES);
+}
+BENCHMARK(BM_OutputStage)
+        ->ArgsProduct({ { 0, 1 }, { 0, 1 } })
+        ->Unit(benchmark::kNanosecond);
+
+} // namespace
+
+int main(int argc, char **argv)
+{
+    QCoreApplication app(argc, argv);
+
+    // JSON unless the caller picked a format
+    std::vector<char *> args(argv, argv + argc);
+    bool formatGiven = false;
+    for (int i = 1; i < argc; ++i) {
+        formatGiven = formatGiven || std::strncmp(argv[i], "--benchmark_format", 18) == 0;
+    }
+    char jsonFormat[] = "--benchmark_format=json";
+    if (!formatGiven) {
+        args.push_back(jsonFormat);
+    }
+    int benchArgc = static_cast<int>(args.size());
+
+    benchmark::Initialize(&benchArgc, args.data());
+    if (benchmark::ReportUnrecognizedArguments(benchArgc, args.data())) {
+        return 2;
+    }
+    benchmark::AddCustomContext("render_kernels", RenderKernels::activeKernels().name);
+    benchmark::RunSpecifiedBenchmarks();
+    benchmark::Shutdown();
+    return 0;
+}
@@ -6,6 +6,247 @@
 #include<QTimer>
 #include<QTime>
 #include"constants.h"
+#include <algorithm>
+#include <cstring>
+
+// ============================================================
+// LOOP DEVICE
+// ============================================================
+// Plays a stereo int16 loop endlessly. The loop holds a whole number of
+// cycles of every component, so wrapping around is phase-continuous.
+class BinauralEngine::LoopDevice : public QIODevice
+{
+public:
+    explicit LoopDevice(const QByteArray &loop)
+        : m_loop(loop)
+    {
+        setOpenMode(QIODevice::ReadOnly);
+    }
+
+    bool isSequential() const override { return true; }
+
+    qint64 bytesAvailable() const override
+    {
+        return m_loop.size() + QIODevice::bytesAvailable();
+    }
+
+protected:
+    qint64 readData(char *data, qint64 maxlen) override
+    {
+        const qint64 frameBytes = 2 * sizeof(int16_t);
+        const qint64 loopSize = m_loop.size();
+        if (loopSize < frameBytes) {
+            return 0;
+        }
+
+        maxlen -= maxlen % frameBytes;
+        qint64 written = 0;
+        while (written < maxlen) {
+            const qint64 chunk = std::min(maxlen - written, loopSize - m_position);
+            std::memcpy(data + written, m_loop.constData() + m_position, chunk);
+            written += chunk;
+            m_position = (m_position + chunk) % loopSize;
+        }
+        return written;
+    }
+
+    qint64 writeData(const char *data, qint64 len) override
+    {
+        Q_UNUSED(data);
+        Q_UNUSED(len);
+        return 0;
+    }
+
+private:
+    QByteArray m_loop;
+    qint64 m_position = 0;
+};
+
+// ============================================================
+// RENDER HELPERS
+// ============================================================
+// Peak and RMS of interleaved stereo int16 frames
+static LevelMeter::Levels measureInt16Levels(const int16_t *frames, qint64 count)
+{
+    int peakLeft = 0;
+    int peakRight = 0;
+    double sumSquaresLeft = 0.0;
+    double sumSquaresRight = 0.0;
+    for (qint64 i = 0; i < count; ++i) {
+        const int left = frames[2 * i];
+        const int right = frames[2 * i + 1];
+        peakLeft = std::max(peakLeft, std::abs(left));
+        peakRight = std::max(peakRight, std::abs(right));
+        sumSquaresLeft += left * left;
+        sumSquaresRight += right * right;
+    }
+
+    LevelMeter::Levels levels;
+    if (count > 0) {
+        levels.peakLeft = peakLeft / 32767.0f;
+        levels.peakRight = peakRight / 32767.0f;
+        levels.rmsLeft = static_cast<float>(std::sqrt(sumSquaresLeft / count) / 32767.0);
+        levels.rmsRight = static_cast<float>(std::sqrt(sumSquaresRight / count) / 32767.0);
+    }
+    return levels;
+}
+
+double BinauralEngine::phaseIncrement(double hz) const
+{
+    return (2.0 * M_PI * hz) / m_sampleRate;
+}
+
+// ============================================================
+// STREAM DEVICE
+// ============================================================
+// Renders on demand in chunks of up to STREAM_CHUNK_FRAMES as the sink
+// pulls. Parameters are read once per chunk, so changes are heard at the
+// next chunk boundary with phase carried over; amplitude and the phase
+// increments ramp across the chunk to avoid a step.
+class BinauralEngine::StreamDevice : public QIODevice
+{
+public:
+    explicit StreamDevice(BinauralEngine *engine)
+        : m_engine(engine)
+        , m_leftIncrement(engine->phaseIncrement(engine->m_leftFrequency))
+        , m_rightIncrement(engine->phaseIncrement(engine->m_rightFrequency))
+        , m_pulseIncrement(engine->phaseIncrement(engine->m_pulseFrequency))
+        , m_amplitude(engine->m_amplitude)
+    {
+        setOpenMode(QIODevice::ReadOnly);
+    }
+
+    bool isSequential() const override { return true; }
+
+    qint64 bytesAvailable() const override
+    {
+        return STREAM_CHUNK_FRAMES * 2 * sizeof(int16_t) + QIODevice::bytesAvailable();
+    }
+
+protected:
+    qint64 readData(char *data, qint64 maxlen) override
+    {
+        int16_t *samples = reinterpret_cast<int16_t*>(data);
+        const qint64 frameCount = maxlen / (2 * sizeof(int16_t));
+
+        for (qint64 offset = 0; offset < frameCount; offset += STREAM_CHUNK_FRAMES) {
+            const int frames = static_cast<int>(std::min<qint64>(STREAM_CHUNK_FRAMES, frameCount - offset));
+            renderChunk(samples + 2 * offset, frames);
+        }
+        return frameCount * 2 * sizeof(int16_t);
+    }
+
+    qint64 writeData(const char *data, qint64 len) override
+    {
+        Q_UNUSED(data);
+        Q_UNUSED(len);
+        return 0;
+    }
+
+private:
+    void renderChunk(int16_t *out, int frames)
+    {
+        const qint64 changedNs = m_engine->m_parameterChangeNs.exchange(0);
+        if (changedNs > 0) {
+            m_engine->m_parameterPickupNs = m_engine->m_clock.nsecsElapsed() - changedNs;
+        }
+
+        const bool isochronic = m_engine->m_toneType == 1;
+        const Waveform waveform = m_engine->m_currentWaveform;
+        const double targetLeft = m_engine->phaseIncrement(m_engine->m_leftFrequency);
+        const double targetRight = m_engine->phaseIncrement(m_engine->m_rightFrequency);
+        const double targetPulse = m_engine->phaseIncrement(m_engine->m_pulseFrequency);
+        const double leftStep = (targetLeft - m_leftIncrement) / frames;
+        const double rightStep = (targetRight - m_rightIncrement) / frames;
+        const double pulseStep = (targetPulse - m_pulseIncrement) / frames;
+        const double targetAmplitude = m_engine->m_amplitude;
+        const double amplitudeStep = (targetAmplitude - m_amplitude) / frames;
+
+        for (int i = 0; i < frames; ++i) {
+            const double amplitude = m_amplitude + amplitudeStep * (i + 1);
+            const double leftIncrement = m_leftIncrement + leftStep * (i + 1);
+            const double rightIncrement = m_rightIncrement + rightStep * (i + 1);
+            const double pulseIncrement = m_pulseIncrement + pulseStep * (i + 1);
+
+            if (isochronic) {
+                const double pulseValue = (std::sin(m_phaseRight) >= 0.0) ? 1.0 : 0.0;
+                const double sample = m_engine->calculateSample(m_phaseLeft, waveform) * pulseValue * amplitude;
+                out[2 * i] = static_cast<int16_t>(sample * 32767);
+                out[2 * i + 1] = static_cast<int16_t>(sample * 32767);
+                m_phaseRight += pulseIncrement;
+            } else {
+                out[2 * i] = static_cast<int16_t>(m_engine->calculateSample(m_phaseLeft, waveform) * amplitude * 32767);
+                out[2 * i + 1] = static_cast<int16_t>(m_engine->calculateSample(m_phaseRight, waveform) * amplitude * 32767);
+                m_phaseRight += rightIncrement;
+            }
+            m_phaseLeft += leftIncrement;
+
+            if (m_phaseLeft >= 2.0 * M_PI) m_phaseLeft -= 2.0 * M_PI;
+            if (m_phaseRight >= 2.0 * M_PI) m_phaseRight -= 2.0 * M_PI;
+        }
+
+        m_leftIncrement = targetLeft;
+        m_rightIncrement = targetRight;
+        m_pulseIncrement = targetPulse;
+        m_amplitude = targetAmplitude;
+        m_engine->m_levelMeter.publish(measureInt16Levels(out, frames));
+    }
+
+    BinauralEngine *m_engine;
+    double m_phaseLeft = 0.0;
+    double m_phaseRight = 0.0;
+    // Values reached at the end of the last chunk, radians per sample
+    double m_leftIncrement;
+    double m_rightIncrement;
+    double m_pulseIncrement;
+    double m_amplitude;
+};
+
+// Smallest frame count in which every frequency completes a whole number
+// of cycles when each may move by up to toleranceHz. Candidates are
+// searched around multiples of the highest frequency's period. Returns 0
+// if there is none up to maxFrames.
+static qint64 findLoopFrames(const QVector<double> &frequencies, int sampleRate,
+                             double toleranceHz, qint64 maxFrames, QVector<qint64> &cycles)
+{
+    const double reference = *std::max_element(frequencies.begin(), frequencies.end());
+    if (reference <= toleranceHz) {
+        return 0;
+    }
+
+    auto fits = [&](qint64 frames) {
+        for (double hz : frequencies) {
+            const double exact = hz * frames / sampleRate;
+            const qint64 whole = qRound64(exact);
+            if (whole < 1 || std::abs(exact - whole) * sampleRate / frames > toleranceHz) {
+                return false;
+            }
+        }
+        return true;
+    };
+
+    qint64 best = 0;
+    for (qint64 k = 1;; ++k) {
+        const qint64 lo = static_cast<qint64>(std::ceil(k * sampleRate / (reference + toleranceHz)));
+        const qint64 hi = std::min(maxFrames, static_cast<qint64>(
+                std::floor(k * sampleRate / (reference - toleranceHz))));
+        if (lo > maxFrames || (best && lo >= best)) {
+            break;
+        }
+        for (qint64 frames = lo; frames <= hi && (!best || frames < best); ++frames) {
+            if (fits(frames)) {
+                best = frames;
+                break;
+            }
+        }
+    }
+
+    cycles.clear();
+    for (double hz : frequencies) {
+        cycles.append(qRound64(hz * best / sampleRate));
+    }
+    return best;
+}
 
 BinauralEngine::BinauralEngine(QObject *parent)
     : QObject(parent)
@@ -21,15 +262,24 @@ BinauralEngine::BinauralEngine(QObject *parent)
     , m_isPlaying(false)
     , m_parametersChanged(false)
     , m_sampleRate(44100)         // CD quality
+    , m_requestedSampleRate(44100)
     , m_bufferDurationMs(300000) // 5 minute buffer = 300000
     , m_pulseFrequency(7.83)
+    , m_toneType(ConstantGlobals::currentToneType)
 {
     initializeAudioFormat();
+    m_clock.start();
+
+    m_meterTimer = new QTimer(this);
+    m_meterTimer->setInterval(METER_INTERVAL_MS);
+    connect(m_meterTimer, &QTimer::timeout, this, &BinauralEngine::pollAudioLevels);
 }
 
 BinauralEngine::~BinauralEngine()
 {
     stop(); // Ensure audio is stopped
+    delete m_streamDevice;
+    delete m_loopDevice;
     delete m_audioBuffer;
     delete m_audioOutput;
 }
@@ -53,6 +303,25 @@ bool BinauralEngine::initializeAudioOutput()
         return false;
     }
 
+    // Follow the device's native rate so the sound server need not
+    // resample, falling back to the requested rate; cached buffers are
+    // regenerated when the rate changes. Samples stay Int16, the format
+    // the cached buffers hold.
+    int sampleRate = m_requestedSampleRate;
+    const int nativeRate = audioDevice.preferredFormat().sampleRate();
+    if (nativeRate != m_requestedSampleRate && nativeRate >= 8000 && nativeRate <= 192000) {
+        QAudioFormat nativeFormat = m_audioFormat;
+        nativeFormat.setSampleRate(nativeRate);
+        if (audioDevice.isFormatSupported(nativeFormat)) {
+            sampleRate = nativeRate;
+        }
+    }
+    if (sampleRate != m_sampleRate) {
+        m_sampleRate = sampleRate;
+        initializeAudioFormat();
+        m_parametersChanged = true;
+    }
+
     if (!audioDevice.isFormatSupported(m_audioFormat)) {
         emit errorOccurred("Audio format not supported by device");
         return false;
@@ -77,6 +346,32 @@ bool BinauralEngine::start()
         return false;
     }
 
+    if (m_loopMode == STREAMING_GENERATOR) {
+        delete m_streamDevice;
+        m_streamDevice = new StreamDevice(this);
+        m_parametersChanged = false;
+
+        m_audioOutput->start(m_streamDevice);
+        m_isPlaying = true;
+        m_meterTimer->start();
+        emit playbackStarted();
+        return true;
+    }
+
+    if (m_loopMode == MINIMAL_PERIOD_LOOP) {
+        if ((!m_loopDevice || m_parametersChanged) && generateMinimalLoop()) {
+            m_parametersChanged = false;
+        }
+        if (m_loopDevice && !m_parametersChanged) {
+            m_audioOutput->start(m_loopDevice);
+            m_isPlaying = true;
+            m_meterTimer->start();
+            emit playbackStarted();
+            return true;
+        }
+        // No whole-cycle loop within MAX_LOOP_SECONDS: use the fixed buffer
+    }
+
     if (!m_audioBuffer || m_parametersChanged) {
         generateAudioBuffer(m_bufferDurationMs);
 
@@ -91,10 +386,12 @@ bool BinauralEngine::start()
         m_parametersChanged = false; // Reset flag
     }
 
+    measureBufferLevels(m_audioBuffer->data());
     m_audioBuffer->seek(0);
 
     m_audioOutput->start(m_audioBuffer);
     m_isPlaying = true;
+    m_meterTimer->start();
 
 
     emit playbackStarted();
@@ -118,7 +415,12 @@ void BinauralEngine::stop()
     m_isPlaying = false;
     resetPhase();
 
+    m_meterTimer->stop();
+    m_levelMeter.clear();
+    m_audioLevels = LevelMeter::Levels();
+
     if (wasPlaying) {
+        emit audioLevelChanged(0.0);
         emit playbackStopped();
     }
 }
@@ -175,7 +477,7 @@ void BinauralEngine::setRightFrequency(double hz)
 */
 
 void BinauralEngine::setRightFrequency(double hz) {
-    if (ConstantGlobals::currentToneType == 1) {
+    if (m_toneType == 1) {
 
     } else {
         if (!validateFrequency(hz)) {
@@ -245,6 +547,28 @@ BinauralEngine::Waveform BinauralEngine::getWaveform() const
     return m_currentWaveform;
 }
 
+void BinauralEngine::setToneType(int toneType)
+{
+    if (toneType < 0 || toneType > 2) {
+        emit errorOccurred(QString("Invalid tone type: %1").arg(toneType));
+        return;
+    }
+
+    if (m_toneType != toneType) {
+        m_toneType = toneType;
+        m_parametersChanged = true;
+
+        if (m_isPlaying) {
+            updateAudioParameters();
+        }
+    }
+}
+
+int BinauralEngine::getToneType() const
+{
+    return m_toneType;
+}
+
 void BinauralEngine::setAmplitude(double amplitude)
 {
     if (!validateAmplitude(amplitude)) {
@@ -298,8 +622,12 @@ void BinauralEngine::setSampleRate(int sampleRate)
         return;
     }
 
-    m_sampleRate = sampleRate;
-    initializeAudioFormat();
+    m_requestedSampleRate = sampleRate;
+    if (sampleRate != m_sampleRate) {
+        m_sampleRate = sampleRate;
+        initializeAudioFormat();
+        m_parametersChanged = true;
+    }
 }
 
 int BinauralEngine::getSampleRate() const
@@ -309,9 +637,113 @@ int BinauralEngine::getSampleRate() const
 
 int BinauralEngine::getBufferDuration() const
 {
+    if (m_loopDevice && m_loopFrames > 0) {
+        return static_cast<int>(m_loopFrames * 1000 / m_sampleRate);
+    }
     return m_bufferDurationMs;
 }
 
+void BinauralEngine::setLoopMode(LoopMode mode)
+{
+    if (m_loopMode == mode) {
+        return;
+    }
+
+    m_loopMode = mode;
+    m_parametersChanged = true;
+
+    if (m_isPlaying) {
+        stop();
+        start();
+    }
+}
+
+BinauralEngine::LoopMode BinauralEngine::getLoopMode() const
+{
+    return m_loopMode;
+}
+
+qint64 BinauralEngine::getLoopFrames() const
+{
+    return m_loopFrames;
+}
+
+bool BinauralEngine::generateMinimalLoop()
+{
+    const bool isochronic = m_toneType == 1;
+
+    QVector<double> frequencies;
+    frequencies.append(m_leftFrequency);
+    frequencies.append(isochronic ? m_pulseFrequency : m_rightFrequency.load());
+
+    QVector<qint64> cycles;
+    const qint64 frames = findLoopFrames(frequencies, m_sampleRate, LOOP_TOLERANCE_HZ,
+                                         static_cast<qint64>(m_sampleRate) * MAX_LOOP_SECONDS,
+                                         cycles);
+
+    delete m_loopDevice;
+    m_loopDevice = nullptr;
+    m_loopFrames = frames;
+    if (frames == 0) {
+        return false;
+    }
+
+    QByteArray audioData;
+    audioData.resize(frames * 2 * sizeof(int16_t));
+    int16_t *data = reinterpret_cast<int16_t*>(audioData.data());
+
+    // Phase from the exact integer cycle position, so sample i of every
+    // pass is identical and the wrap-around cannot drift
+    const double amplitude = m_amplitude;
+    const Waveform waveform = m_currentWaveform;
+    for (qint64 i = 0; i < frames; ++i) {
+        const double first = 2.0 * M_PI * ((i * cycles[0]) % frames) / frames;
+        const double second = 2.0 * M_PI * ((i * cycles[1]) % frames) / frames;
+
+        if (isochronic) {
+            const double pulseValue = (std::sin(second) >= 0.0) ? 1.0 : 0.0;
+            const double sample = calculateSample(first, waveform) * pulseValue * amplitude;
+            data[2 * i] = static_cast<int16_t>(sample * 32767);
+            data[2 * i + 1] = static_cast<int16_t>(sample * 32767);
+        } else {
+            data[2 * i] = static_cast<int16_t>(calculateSample(first, waveform) * amplitude * 32767);
+            data[2 * i + 1] = static_cast<int16_t>(calculateSample(second, waveform) * amplitude * 32767);
+        }
+    }
+
+    measureBufferLevels(audioData);
+    m_loopDevice = new LoopDevice(audioData);
+    return true;
+}
+
+// Up to a second from the middle, clear of the fades at the seam; the
+// rest repeats it
+void BinauralEngine::measureBufferLevels(const QByteArray &audio)
+{
+    const qint64 frames = audio.size() / (2 * sizeof(int16_t));
+    const qint64 count = std::min<qint64>(frames, m_sampleRate);
+    const int16_t *data = reinterpret_cast<const int16_t*>(audio.constData());
+    m_bufferLevels = measureInt16Levels(data + 2 * ((frames - count) / 2), count);
+}
+
+LevelMeter::Levels BinauralEngine::audioLevels() const
+{
+    return m_audioLevels;
+}
+
+// The sink applies the output volume, so it scales what was rendered
+void BinauralEngine::pollAudioLevels()
+{
+    LevelMeter::Levels levels = m_loopMode == STREAMING_GENERATOR ? m_levelMeter.take() : m_bufferLevels;
+    const float volume = static_cast<float>(m_outputVolume);
+    levels.peakLeft *= volume;
+    levels.peakRight *= volume;
+    levels.rmsLeft *= volume;
+    levels.rmsRight *= volume;
+    m_audioLevels = levels;
+    emit audioLevelChanged(levels.peak());
+}
+
 double BinauralEngine::getCurrentPhaseLeft() const
 {
     return m_phaseLeft;
@@ -331,7 +763,7 @@ bool BinauralEngine::isEngineActive() const
 
 void BinauralEngine::generateAudioBuffer(int durationMs)
 {
-    if (ConstantGlobals::currentToneType == 1) {
+    if (m_toneType == 1) {
            generateIsochronicBuffer(durationMs);
            return;
        }
@@ -484,7 +916,7 @@ double BinauralEngine::calculateSineSample(double phase)
 double BinauralEngine::calculateSquareSample(double phase)
 {
 
-        if (ConstantGlobals::currentToneType == 1) {
+        if (m_toneType == 1) {
             return (std::sin(phase) >= 0.0) ? 1.0 : 0.0;  // On/Off
         } else {
             return (std::sin(phase) >= 0.0) ? 1.0 : -1.0; // Original +1/-1
@@ -519,12 +951,36 @@ void BinauralEngine::updateAudioParameters()
         return;
     }
 
+    const qint64 changedNs = m_clock.nsecsElapsed();
+
+    // The stream device reads parameters at its next chunk, after the
+    // audio already queued in the sink has played
+    if (m_loopMode == STREAMING_GENERATOR && m_streamDevice) {
+        const qint64 queuedBytes = m_audioOutput->bufferSize() - m_audioOutput->bytesFree();
+        m_parameterQueuedUs = m_audioFormat.durationForBytes(static_cast<qint32>(queuedBytes));
+        m_parametersChanged = false;
+        m_parameterChangeNs = changedNs;
+        return;
+    }
+
     bool wasPlaying = m_isPlaying;
     stop();
 
     if (wasPlaying) {
         start();
     }
+    m_parameterQueuedUs = 0;
+    m_parameterPickupNs = m_clock.nsecsElapsed() - changedNs;
+}
+
+double BinauralEngine::lastParameterLatencyMs() const
+{
+    const qint64 pickupNs = m_parameterPickupNs;
+    if (pickupNs < 0) {
+        return -1.0;
+    }
+
+    return pickupNs / 1e6 + m_parameterQueuedUs / 1000.0;
 }
 
 void BinauralEngine::resetPhase()
@@ -681,6 +1137,8 @@ void BinauralEngine::setPulseFrequency(double hz)
 
 void BinauralEngine::forceBufferRegeneration() {
     m_parametersChanged = true;  // Force buffer rebuild
+    delete m_loopDevice;
+    m_loopDevice = nullptr;
     if (m_audioBuffer) {
         delete m_audioBuffer;
         m_audioBuffer = nullptr;
@@ -7,12 +7,16 @@
 #include <QBuffer>
 #include <QIODevice>
 #include <QMediaDevices>
+#include <QElapsedTimer>
+#include <QTimer>
 #include <atomic>
 #include <cmath>
+#include "levelmeter.h"
 
 class BinauralEngine : public QObject
 {
     Q_OBJECT
+    friend struct EngineBench; // binaural_bench drives private generators directly
 
 public:
     enum Waveform {
@@ -23,6 +27,13 @@ public:
     };
     Q_ENUM(Waveform)
 
+    enum LoopMode {
+        FIXED_DURATION_LOOP = 0,  // 5 minute buffer, faded at the seam
+        MINIMAL_PERIOD_LOOP = 1,  // Shortest whole-cycle loop, seamless
+        STREAMING_GENERATOR = 2   // Rendered in chunks as the sink pulls
+    };
+    Q_ENUM(LoopMode)
+
     explicit BinauralEngine(QObject *parent = nullptr);
     ~BinauralEngine();
 
@@ -42,20 +53,46 @@ public:
     void setWaveform(Waveform type);
     Waveform getWaveform() const;
 
+    // 0=Binaural, 1=Isochronic, 2=Generator; starts as the global
+    // ConstantGlobals::currentToneType, the audio path reads only this copy
+    void setToneType(int toneType);
+    int getToneType() const;
+
     void setAmplitude(double amplitude); // Raw signal level (0.0-1.0)
     void setVolume(double volume);       // Output volume (0.0-1.0)
 
     double getAmplitude() const;
     double getVolume() const;
 
+    // start() renders at the default device's preferred rate when the
+    // device takes it, else at the setSampleRate() rate; the request is
+    // kept, so every start() negotiates from it again. getSampleRate()
+    // reports the rate the audio is generated at.
     void setSampleRate(int sampleRate);
     int getSampleRate() const;
 
     int getBufferDuration() const; // Duration in milliseconds
 
+    void setLoopMode(LoopMode mode);
+    LoopMode getLoopMode() const;
+    qint64 getLoopFrames() const; // Frames in the current minimal loop, 0 if none
+
+    // Time from the last parameter change while playing until it is
+    // audible: pick-up (next chunk, or stop/regenerate/start in the loop
+    // modes) plus audio queued in the sink when the change was made.
+    // -1 if not measured yet.
+    double lastParameterLatencyMs() const;
+
     double getCurrentPhaseLeft() const;
     double getCurrentPhaseRight() const;
 
+    // Output levels as of the last audioLevelChanged(), polled every
+    // METER_INTERVAL_MS while playing. The streaming generator meters
+    // each chunk it renders; the cached loop and buffer repeat the same
+    // audio, so they are measured once when generated.
+    LevelMeter::Levels audioLevels() const;
+    static constexpr int METER_INTERVAL_MS = 33;
+
     bool isEngineActive() const;
 
 
@@ -121,7 +158,8 @@ private:
     std::atomic<bool> m_isPlaying;
     std::atomic<bool> m_parametersChanged;
 
-    int m_sampleRate;
+    int m_sampleRate;          // Negotiated on start(), buffers are rendered at it
+    int m_requestedSampleRate; // setSampleRate()
     qint64 m_bufferDurationMs;
 
     static constexpr double MIN_FREQUENCY = 20.0;
@@ -139,12 +177,45 @@ private:
     void generateIsochronicBuffer(int durationMs);
     double getPulseFrequency() const;
     double m_pulseFrequency;
+    std::atomic<int> m_toneType;
     double calculateTriangleSample(double phase);
     double calculateSawtoothSample(double phase);
 
 public:
     void forceBufferRegeneration();
 
+private:
+    bool generateMinimalLoop();
+
+    class LoopDevice;
+    LoopDevice *m_loopDevice = nullptr;
+    LoopMode m_loopMode = STREAMING_GENERATOR;
+    qint64 m_loopFrames = 0;
+
+    // Each frequency may move by this much to make the loop close exactly
+    static constexpr double LOOP_TOLERANCE_HZ = 0.005;
+    static constexpr int MAX_LOOP_SECONDS = 60;
+
+    class StreamDevice;
+    StreamDevice *m_streamDevice = nullptr;
+    double phaseIncrement(double hz) const; // Radians per sample
+
+    // Parameter change -> pick-up timing, in m_clock nanoseconds
+    QElapsedTimer m_clock;
+    std::atomic<qint64> m_parameterChangeNs{0};
+    std::atomic<qint64> m_parameterPickupNs{-1};
+    std::atomic<qint64> m_parameterQueuedUs{0};
+
+    static constexpr int STREAM_CHUNK_FRAMES = 512;
+
+    void pollAudioLevels();
+    void measureBufferLevels(const QByteArray &audio);
+
+    LevelMeter m_levelMeter;         // Written per chunk by the stream device
+    LevelMeter::Levels m_bufferLevels; // Of the cached loop or buffer
+    LevelMeter::Levels m_audioLevels;
+    QTimer *m_meterTimer = nullptr;
+
 };
 
 #endif // BINAURALENGINE_H
@@ -0,0 +1,574 @@
+#include "commandline.h"
+#include "dynamicengine.h"
+#include "dynamicrenderer.h"
+#include "renderkernels.h"
+#include "sessionrenderer.h"
+#include "sessionstage.h"
+
+#include <QCommandLineParser>
+#include <QElapsedTimer>
+#include <QEventLoop>
+#include <QFile>
+#include <QFileInfo>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QTextStream>
+#include <QThread>
+#include <QTimer>
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <memory>
+#include <vector>
+
+#ifdef Q_OS_UNIX
+#include <sys/resource.h>
+#endif
+
+namespace {
+
+constexpr int MAX_STAGE_MINUTES = 360;
+
+// --stress: the main thread blocks for STRESS_BLOCK_MS per round; the
+// sink must keep being fed at no less than STRESS_MIN_RATE of
+// realtime meanwhile (slack for sink buffering) with no underruns
+constexpr int STRESS_BLOCK_MS = 1000;
+constexpr int STRESS_SETTLE_MS = 500;
+constexpr double STRESS_MIN_RATE = 0.75;
+
+// --bench --matrix: every output format at each of these rates
+const int MATRIX_SAMPLE_RATES[] = { 44100, 48000, 96000 };
+const QAudioFormat::SampleFormat MATRIX_FORMATS[] = { QAudioFormat::Int16, QAudioFormat::Float };
+
+// --bench --voices: extra tone voices layered on every stage
+const int BENCH_VOICE_COUNTS[] = { 1, 8, 32, 128 };
+
+// Used by --bench when no file is given: one binaural and one
+// isochronic stage, covering both specialized render loops
+const char *const DEFAULT_BENCH_SESSION =
+        "BINAURAL:200:210:SINE:1\n"
+        "ISOCHRONIC:200:10:SQUARE:1\n";
+
+// Peak resident set size in KiB, or -1 where unsupported
+qint64 peakRssKb()
+{
+#ifdef Q_OS_UNIX
+    struct rusage usage;
+    if (getrusage(RUSAGE_SELF, &usage) != 0) {
+        return -1;
+    }
+#ifdef Q_OS_MACOS
+    return usage.ru_maxrss / 1024; // Bytes on macOS
+#else
+    return usage.ru_maxrss;
+#endif
+#else
+    return -1;
+#endif
+}
+
+// A saved brainwave preset becomes a single stage
+bool stageFromPreset(const QByteArray &data, int durationMinutes, Stage &stage, QString &error)
+{
+    QJsonParseError parseError;
+    const QJsonDocument doc = QJsonDocument::fromJson(data, &parseError);
+    if (parseError.error != QJsonParseError::NoError) {
+        error = QString("JSON parse error: %1").arg(parseError.errorString());
+        return false;
+    }
+    if (!doc.isObject()) {
+        error = "Preset file is not a valid JSON object";
+        return false;
+    }
+
+    const QJsonObject json = doc.object();
+    stage.toneType = json["toneType"].toInt();
+    stage.leftFreq = json["leftFrequency"].toDouble();
+    stage.rightFreq = json["rightFrequency"].toDouble();
+    stage.waveform = json["waveform"].toInt();
+    stage.pulseFreq = json["pulseFrequency"].toDouble();
+    stage.volumePercent = json["volume"].toDouble();
+    stage.durationMinutes = durationMinutes;
+
+    // Sessions carry the carrier on both channels for isochronic tones
+    if (stage.isIsochronic()) {
+        stage.rightFreq = stage.leftFreq;
+    }
+
+    return stage.validate(MAX_STAGE_MINUTES, error);
+}
+
+bool loadStages(const QString &fileName, int durationMinutes, QVector<Stage> &stages, QString &error)
+{
+    QFile file(fileName);
+    if (!file.open(QIODevice::ReadOnly)) {
+        error = QString("Could not open %1").arg(fileName);
+        return false;
+    }
+    const QByteArray data = file.readAll();
+    file.close();
+
+    if (QFileInfo(fileName).suffix().compare("json", Qt::CaseInsensitive) == 0) {
+        Stage stage;
+        if (!stageFromPreset(data, durationMinutes, stage, error)) {
+            error = QString("%1: %2").arg(fileName, error);
+            return false;
+        }
+        stages = { stage };
+        return true;
+    }
+
+    QStringList errors;
+    stages = Stage::parseSession(QString::fromUtf8(data), MAX_STAGE_MINUTES, &errors);
+    if (!errors.isEmpty()) {
+        error = QString("%1:\n%2").arg(fileName, errors.join("\n"));
+        return false;
+    }
+    if (stages.isEmpty()) {
+        error = QString("%1: no stages").arg(fileName);
+        return false;
+    }
+    return true;
+}
+
+// Nearest-rank percentile of sorted values
+qint64 percentile(const QVector<qint64> &sorted, double p)
+{
+    const qsizetype rank = static_cast<qsizetype>(std::ceil(p / 100.0 * sorted.size()));
+    return sorted[std::clamp<qsizetype>(rank - 1, 0, sorted.size() - 1)];
+}
+
+void printStatistics(QTextStream &out, qint64 frames, double seconds, int sampleRate,
+                     QVector<qint64> blockNs)
+{
+    const double audioSeconds = static_cast<double>(frames) / sampleRate;
+    out << QString("Frames:        %1 (%2 s of audio at %3 Hz)\n")
+               .arg(frames).arg(audioSeconds, 0, 'f', 1).arg(sampleRate);
+    out << QString("Throughput:    %1 frames/s, %2x realtime\n")
+               .arg(seconds > 0.0 ? frames / seconds : 0.0, 0, 'f', 0)
+               .arg(seconds > 0.0 ? audioSeconds / seconds : 0.0, 0, 'f', 1);
+
+    if (!blockNs.isEmpty()) {
+        std::sort(blockNs.begin(), blockNs.end());
+        const double budgetMs = 1000.0 * RenderKernels::BLOCK_FRAMES / sampleRate;
+        auto ms = [](qint64 ns) { return QString::number(ns / 1e6, 'f', 4); };
+
+        out << QString("Block latency: %1 blocks of %2 frames, budget %3 ms\n")
+                   .arg(blockNs.size()).arg(RenderKernels::BLOCK_FRAMES).arg(budgetMs, 0, 'f', 2);
+        out << "               p50 " << ms(percentile(blockNs, 50.0))
+            << "  p90 " << ms(percentile(blockNs, 90.0))
+            << "  p99 " << ms(percentile(blockNs, 99.0))
+            << "  p99.9 " << ms(percentile(blockNs, 99.9))
+            << "  max " << ms(blockNs.last()) << " ms\n";
+    }
+
+    const qint64 rss = peakRssKb();
+    out << "Peak RSS:      "
+        << (rss >= 0 ? QString("%1 MiB").arg(rss / 1024.0, 0, 'f', 1) : QString("n/a")) << "\n";
+}
+
+int runRender(const QVector<Stage> &stages, const QString &outputFile, int sampleRate, int threads)
+{
+    QTextStream out(stdout);
+    QTextStream err(stderr);
+
+    SessionRenderer renderer;
+    QObject::connect(&renderer, &SessionRenderer::errorOccurred, [&err](const QString &message) {
+        err << "Error: " << message << "\n";
+        err.flush();
+    });
+    renderer.setSampleRate(sampleRate);
+    renderer.setThreadCount(threads);
+    renderer.setCollectBlockTimings(true);
+
+    if (!renderer.render(stages, outputFile)) {
+        return 1;
+    }
+
+    const SessionRenderer::Report report = renderer.report();
+    out << report.summary() << "\n";
+    out << "Output:        " << outputFile << "\n";
+    printStatistics(out, report.frames, report.seconds, report.sampleRate, report.blockNs);
+    return 0;
+}
+
+QString formatName(QAudioFormat::SampleFormat format)
+{
+    return format == QAudioFormat::Float ? QString("float32") : QString("int16");
+}
+
+struct BenchResult {
+    qint64 frames = 0;
+    double seconds = 0.0;
+    QVector<qint64> blockNs;
+};
+
+// Fills the first count slots of bank, alternating binaural and
+// isochronic through every waveform, spread over 100-1000 Hz
+void addBenchVoices(DynamicRenderer::VoiceBank &bank, int count)
+{
+    for (int i = 0; i < count; ++i) {
+        DynamicRenderer::VoiceSlot &slot = bank.voices[i];
+        slot.voice.toneType = i % 2;
+        slot.voice.leftFrequency = 100.0 + 900.0 * i / DynamicRenderer::MAX_VOICES;
+        slot.voice.rightFrequency = slot.voice.leftFrequency + 4.0 + i % 8;
+        slot.voice.pulseFrequency = 4.0 + i % 8;
+        slot.voice.waveform = static_cast<DynamicRenderer::Waveform>((i / 2) % 4);
+        slot.active = true;
+        slot.serial = i + 1;
+    }
+}
+
+// Renders up to maxSeconds of each stage on this thread, one render
+// block at a time, discarding the audio
+void benchStages(const QVector<Stage> &stages, int sampleRate, QAudioFormat::SampleFormat format,
+                 int maxSeconds, BenchResult &result, int voices = 0)
+{
+    std::vector<float> buffer(2 * RenderKernels::BLOCK_FRAMES); // Fits either format
+    const auto bank = std::make_unique<DynamicRenderer::VoiceBank>();
+    addBenchVoices(*bank, voices);
+
+    for (const Stage &stage : stages) {
+        const qint64 frames = static_cast<qint64>(std::min(stage.durationSeconds(), maxSeconds)) * sampleRate;
+
+        const auto renderer = std::make_unique<DynamicRenderer>(SessionRenderer::stageParameters(stage, sampleRate),
+                                                                stage.volumePercent / 100.0);
+        renderer->setVoices(bank.get());
+
+        QElapsedTimer stageTimer;
+        QElapsedTimer blockTimer;
+        stageTimer.start();
+        for (qint64 offset = 0; offset < frames; offset += RenderKernels::BLOCK_FRAMES) {
+            const int count = static_cast<int>(std::min<qint64>(RenderKernels::BLOCK_FRAMES, frames - offset));
+            blockTimer.start();
+            if (format == QAudioFormat::Float) {
+                renderer->render(buffer.data(), count);
+            } else {
+                renderer->render(reinterpret_cast<int16_t *>(buffer.data()), count);
+            }
+            result.blockNs.append(blockTimer.nsecsElapsed());
+        }
+        result.seconds += stageTimer.nsecsElapsed() / 1e9;
+        result.frames += frames;
+    }
+}
+
+int runBench(const QVector<Stage> &stages, int sampleRate, QAudioFormat::SampleFormat format, int maxSeconds)
+{
+    QTextStream out(stdout);
+
+    BenchResult result;
+    benchStages(stages, sampleRate, format, maxSeconds, result);
+
+    out << QString("Bench: %1 stage(s), %2 output, render kernels: %3\n")
+               .arg(stages.size()).arg(formatName(format)).arg(RenderKernels::activeKernels().name);
+    printStatistics(out, result.frames, result.seconds, sampleRate, result.blockNs);
+    return 0;
+}
+
+// One table row: the leading columns, then throughput, block latency
+// percentiles and CPU as a share of the block's playback time (the
+// budget a live callback has)
+void printBenchRow(QTextStream &out, const QString &columns, BenchResult &result, int sampleRate)
+{
+    QVector<qint64> &blockNs = result.blockNs;
+    std::sort(blockNs.begin(), blockNs.end());
+    const double budgetNs = 1e9 * result.frames / sampleRate;
+    const double cpu = budgetNs > 0.0 ? 1e9 * result.seconds / budgetNs : 0.0;
+    auto ms = [](qint64 ns) { return QString::number(ns / 1e6, 'f', 4); };
+
+    out << QString("%1%2  %3 %4 %5 %6%\n")
+               .arg(columns)
+               .arg(result.seconds > 0.0 ? result.frames / result.seconds : 0.0, 11, 'f', 0)
+               .arg(ms(percentile(blockNs, 50.0)), 8)
+               .arg(ms(percentile(blockNs, 99.0)), 8)
+               .arg(ms(blockNs.last()), 8)
+               .arg(cpu * 100.0, 9, 'f', 3);
+    out.flush();
+}
+
+void printPeakRss(QTextStream &out)
+{
+    const qint64 rss = peakRssKb();
+    out << "Peak RSS:      "
+        << (rss >= 0 ? QString("%1 MiB").arg(rss / 1024.0, 0, 'f', 1) : QString("n/a")) << "\n";
+}
+
+// CPU per block for each output format and rate
+int runBenchMatrix(const QVector<Stage> &stages, int maxSeconds)
+{
+    QTextStream out(stdout);
+    out << QString("Bench matrix: %1 stage(s), render kernels: %2\n")
+               .arg(stages.size()).arg(RenderKernels::activeKernels().name);
+    out << QString("%1%2%3  %4 %5 %6 %7\n")
+               .arg("Format", -10).arg("Rate", -9).arg("Frames/s", 11)
+               .arg("p50 ms", 8).arg("p99 ms", 8).arg("max ms", 8).arg("Mean CPU", 10);
+
+    for (int sampleRate : MATRIX_SAMPLE_RATES) {
+        for (QAudioFormat::SampleFormat format : MATRIX_FORMATS) {
+            BenchResult result;
+            benchStages(stages, sampleRate, format, maxSeconds, result);
+            printBenchRow(out, QString("%1%2").arg(formatName(format), -10).arg(sampleRate, -9),
+                          result, sampleRate);
+        }
+    }
+
+    printPeakRss(out);
+    return 0;
+}
+
+// CPU per block with 1 to MAX_VOICES extra tone voices on every stage
+int runBenchVoices(const QVector<Stage> &stages, int sampleRate, QAudioFormat::SampleFormat format,
+                   int maxSeconds)
+{
+    QTextStream out(stdout);
+    out << QString("Bench voices: %1 stage(s), %2 Hz %3 output, render kernels: %4\n")
+               .arg(stages.size()).arg(sampleRate).arg(formatName(format))
+               .arg(RenderKernels::activeKernels().name);
+    out << QString("%1%2  %3 %4 %5 %6\n")
+               .arg("Voices", -8).arg("Frames/s", 11)
+               .arg("p50 ms", 8).arg("p99 ms", 8).arg("max ms", 8).arg("Mean CPU", 10);
+
+    for (int voices : BENCH_VOICE_COUNTS) {
+        BenchResult result;
+        benchStages(stages, sampleRate, format, maxSeconds, result, voices);
+        printBenchRow(out, QString("%1").arg(voices, -8), result, sampleRate);
+    }
+
+    printPeakRss(out);
+    return 0;
+}
+
+// Runs the main event loop for ms, delivering queued engine signals
+void runEventLoop(int ms)
+{
+    QEventLoop loop;
+    QTimer::singleShot(ms, &loop, &QEventLoop::quit);
+    loop.exec();
+}
+
+// Live playback while the main thread (the GUI thread in the app) is
+// blocked, on the default output device or a NullSink
+int runStress(int sampleRate, int rounds, int lookaheadMs, DynamicEngine::OutputBackend backend,
+              const QString &outputFile)
+{
+    QTextStream out(stdout);
+    QTextStream err(stderr);
+
+    DynamicEngine engine;
+    QString engineError;
+    QObject::connect(&engine, &DynamicEngine::errorOccurred, [&engineError](const QString &message) {
+        engineError = message;
+    });
+    engine.setSampleRate(sampleRate);
+    engine.setVolume(0.1);
+    engine.setRenderAheadMs(lookaheadMs);
+    engine.setOutputBackend(backend, outputFile);
+
+    if (!engine.start()) {
+        err << "Error: " << (engineError.isEmpty() ? QString("could not start playback") : engineError) << "\n";
+        return 1;
+    }
+    runEventLoop(STRESS_SETTLE_MS);
+    // The device may have negotiated a rate other than --rate
+    const QAudioFormat format = engine.outputFormat();
+    const int outputRate = format.sampleRate();
+    const QString sinkName = backend == DynamicEngine::NULL_OUTPUT ? QString("null sink")
+            : backend == DynamicEngine::FILE_OUTPUT ? outputFile : QString("default device");
+    out << QString("Output: %1 Hz %2, latency %3 ms, %4\n")
+               .arg(outputRate).arg(formatName(format.sampleFormat()))
+               .arg(engine.outputLatencyMs(), 0, 'f', 1).arg(sinkName);
+
+    bool passed = true;
+    for (int round = 1; round <= rounds; ++round) {
+        const quint64 framesBefore = engine.framesDelivered();
+        const quint64 underrunsBefore = engine.underrunCount();
+        engine.resetRenderAheadStats();
+
+        QElapsedTimer timer;
+        timer.start();
+        QThread::msleep(STRESS_BLOCK_MS);
+        const qint64 blockedMs = timer.elapsed();
+        const quint64 delivered = engine.framesDelivered() - framesBefore;
+
+        // Let the sink's state changes arrive before counting underruns
+        runEventLoop(STRESS_SETTLE_MS);
+        const quint64 underruns = engine.underrunCount() - underrunsBefore;
+        const DynamicEngine::RenderAheadStats ahead = engine.renderAheadStats();
+
+        const double rate = delivered / (blockedMs / 1000.0 * outputRate);
+        const bool ok = engine.isPlaying() && underruns == 0 && ahead.underruns == 0
+                && rate >= STRESS_MIN_RATE;
+        out << QString("Round %1: main thread blocked %2 ms, delivered %3 frames (%4% of realtime), "
+                       "%5 sink / %6 render-ahead underrun(s), lowest lookahead %7 ms: %8\n")
+                   .arg(round).arg(blockedMs).arg(delivered).arg(rate * 100.0, 0, 'f', 0)
+                   .arg(underruns).arg(ahead.underruns)
+                   .arg(1000.0 * ahead.lowWatermarkFrames / outputRate, 0, 'f', 1)
+                   .arg(ok ? "ok" : "FAILED");
+        out.flush();
+        passed = passed && ok;
+    }
+
+    const DynamicEngine::CallbackTelemetry telemetry = engine.callbackTelemetry();
+    out << QString("Callbacks: render p99 %1 ms (%2% of budget, max %3%), interval p50 %4 ms / p99 %5 ms, "
+                   "%6 late\n")
+               .arg(telemetry.renderTimeNs.percentile(99) / 1e6, 0, 'f', 3)
+               .arg(telemetry.budgetPermyriad.percentile(99) / 100.0, 0, 'f', 1)
+               .arg(telemetry.budgetPermyriad.max / 100.0, 0, 'f', 1)
+               .arg(telemetry.callbackIntervalNs.percentile(50) / 1e6, 0, 'f', 2)
+               .arg(telemetry.callbackIntervalNs.percentile(99) / 1e6, 0, 'f', 2)
+               .arg(telemetry.lateCallbacks);
+
+    engine.stop();
+    out << (passed ? "PASS" : "FAIL") << "\n";
+    return passed ? 0 : 1;
+}
+
+} // namespace
+
+namespace CommandLine {
+
+bool isHeadlessInvocation(int argc, char **argv)
+{
+    for (int i = 1; i < argc; ++i) {
+        if (strcmp(argv[i], "--render") == 0 || strncmp(argv[i], "--render=", 9) == 0
+                || strcmp(argv[i], "--bench") == 0 || strcmp(argv[i], "--stress") == 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+int runHeadless(QCoreApplication &app)
+{
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Headless session rendering, render-path benchmarks and audio thread stress tests.");
+    parser.addHelpOption();
+    parser.addVersionOption();
+
+    const QCommandLineOption renderOption("render", "Render a session or preset file to WAV.", "file");
+    const QCommandLineOption outputOption({"o", "output"}, "WAV file written by --render or --stress --sink file.",
+                                          "file");
+    const QCommandLineOption benchOption("bench", "Benchmark the render path on [file] or a built-in session.");
+    const QCommandLineOption secondsOption("seconds", "Audio seconds benchmarked per stage (default 60).",
+                                           "seconds", "60");
+    const QCommandLineOption formatOption("format", "Output sample format for --bench: int16 or float32 (default int16).",
+                                          "format", "int16");
+    const QCommandLineOption matrixOption("matrix", "Bench every output format at 44100, 48000 and 96000 Hz.");
+    const QCommandLineOption voicesOption("voices", "Bench 1, 8, 32 and 128 extra tone voices per stage.");
+    const QCommandLineOption rateOption("rate", "Sample rate in Hz (default 44100).", "hz", "44100");
+    const QCommandLineOption threadsOption("threads", "Render threads for --render (default: one per core).",
+                                           "count", "0");
+    const QCommandLineOption stressOption("stress", "Play through the default device while blocking the main thread.");
+    const QCommandLineOption roundsOption("rounds", "Main thread blocks in --stress (default 3).", "count", "3");
+    const QCommandLineOption sinkOption("sink", "Output for --stress: device, null or file (-o, WAV) (default device).",
+                                        "sink", "device");
+    const QCommandLineOption lookaheadOption("lookahead", "Render-ahead in ms for --stress (default 40).", "ms",
+                                             QString::number(DynamicEngine::DEFAULT_RENDER_AHEAD_MS));
+    const QCommandLineOption durationOption("duration", "Stage length for a .json preset (default 10).",
+                                            "minutes", "10");
+    parser.addOptions({ renderOption, outputOption, benchOption, secondsOption,
+                        formatOption, matrixOption, voicesOption, rateOption, threadsOption, stressOption,
+                        roundsOption, sinkOption, lookaheadOption, durationOption });
+    parser.addPositionalArgument("file", "Session (.txt) or preset (.json) file for --bench.", "[file]");
+
+    parser.process(app);
+
+    QTextStream err(stderr);
+    auto usageError = [&err](const QString &message) {
+        err << "Error: " << message << "\n";
+        return 2;
+    };
+
+    const bool render = parser.isSet(renderOption);
+    const bool bench = parser.isSet(benchOption);
+    const bool stress = parser.isSet(stressOption);
+    if (int(render) + int(bench) + int(stress) != 1) {
+        return usageError("Use exactly one of --render, --bench or --stress");
+    }
+
+    bool ok;
+    const int sampleRate = parser.value(rateOption).toInt(&ok);
+    if (!ok || sampleRate < 8000 || sampleRate > 192000) {
+        return usageError("--rate must be 8000-192000");
+    }
+    const int duration = parser.value(durationOption).toInt(&ok);
+    if (!ok || duration < 1 || duration > MAX_STAGE_MINUTES) {
+        return usageError(QString("--duration must be 1-%1 minutes").arg(MAX_STAGE_MINUTES));
+    }
+
+    if (stress) {
+        const int rounds = parser.value(roundsOption).toInt(&ok);
+        if (!ok || rounds < 1) {
+            return usageError("--rounds must be at least 1");
+        }
+        const int lookahead = parser.value(lookaheadOption).toInt(&ok);
+        if (!ok || lookahead < DynamicEngine::MIN_RENDER_AHEAD_MS
+                || lookahead > DynamicEngine::MAX_RENDER_AHEAD_MS) {
+            return usageError(QString("--lookahead must be %1-%2 ms")
+                              .arg(DynamicEngine::MIN_RENDER_AHEAD_MS).arg(DynamicEngine::MAX_RENDER_AHEAD_MS));
+        }
+        const QString sink = parser.value(sinkOption);
+        DynamicEngine::OutputBackend backend;
+        if (sink == "device") {
+            backend = DynamicEngine::DEVICE_OUTPUT;
+        } else if (sink == "null") {
+            backend = DynamicEngine::NULL_OUTPUT;
+        } else if (sink == "file") {
+            backend = DynamicEngine::FILE_OUTPUT;
+            if (!parser.isSet(outputOption)) {
+                return usageError("--sink file needs an output file (-o out.wav)");
+            }
+        } else {
+            return usageError("--sink must be device, null or file");
+        }
+        return runStress(sampleRate, rounds, lookahead, backend, parser.value(outputOption));
+    }
+
+    QVector<Stage> stages;
+    QString error;
+
+    if (render) {
+        const int threads = parser.value(threadsOption).toInt(&ok);
+        if (!ok || threads < 0) {
+            return usageError("--threads must be 0 or more");
+        }
+        if (!parser.isSet(outputOption)) {
+            return usageError("--render needs an output file (-o out.wav)");
+        }
+        if (!loadStages(parser.value(renderOption), duration, stages, error)) {
+            return usageError(error);
+        }
+        return runRender(stages, parser.value(outputOption), sampleRate, threads);
+    }
+
+    const int seconds = parser.value(secondsOption).toInt(&ok);
+    if (!ok || seconds < 1) {
+        return usageError("--seconds must be at least 1");
+    }
+
+    const QStringList files = parser.positionalArguments();
+    if (files.size() > 1) {
+        return usageError("--bench takes at most one file");
+    }
+    if (files.isEmpty()) {
+        stages = Stage::parseSession(DEFAULT_BENCH_SESSION, MAX_STAGE_MINUTES);
+    } else if (!loadStages(files.first(), duration, stages, error)) {
+        return usageError(error);
+    }
+    if (parser.isSet(matrixOption)) {
+        return runBenchMatrix(stages, seconds);
+    }
+
+    const QString formatValue = parser.value(formatOption);
+    if (formatValue != "int16" && formatValue != "float32") {
+        return usageError("--format must be int16 or float32");
+    }
+    const QAudioFormat::SampleFormat format = formatValue == "float32" ? QAudioFormat::Float : QAudioFormat::Int16;
+    if (parser.isSet(voicesOption)) {
+        return runBenchVoices(stages, sampleRate, format, seconds);
+    }
+    return runBench(stages, sampleRate, format, seconds);
+}
+
+} // namespace CommandLine
@@ -0,0 +1,41 @@
+#ifndef COMMANDLINE_H
+#define COMMANDLINE_H
+
+#include <QCoreApplication>
+
+// ============================================================
+// HEADLESS COMMAND LINE
+// ============================================================
+// Scripted rendering and throughput runs without widgets or an audio
+// device, for build machines with no display and no sound card:
+//
+//   BinauralPlayer --render session.txt -o out.wav
+//   BinauralPlayer --bench [session.txt | preset.json]
+//   BinauralPlayer --stress [--sink null | --sink file -o out.wav]
+//
+// Input is a session file (SessionDialog format) or a saved brainwave
+// preset (.json), which is rendered as a single stage of --duration
+// minutes. --render and --bench print frames/sec, per-block latency
+// percentiles and peak RSS. --bench --format float32 measures the
+// Float32 output path; --bench --matrix tabulates CPU per block for
+// each output format at 44.1, 48 and 96 kHz, --bench --voices for 1,
+// 8, 32 and 128 extra tone voices.
+//
+// --stress plays through the default device while blocking the main
+// thread for a second at a time and fails if playback stalls or the
+// sink underruns. --sink null runs it on a NullSink instead, paced like
+// a device but without sound hardware; --sink file -o out.wav also
+// records what was played.
+
+namespace CommandLine {
+
+// True if argv asks for a headless mode; checked before any
+// QApplication exists so no display connection is attempted
+bool isHeadlessInvocation(int argc, char **argv);
+
+// Parses app.arguments() and runs the requested mode; returns the exit code
+int runHeadless(QCoreApplication &app);
+
+} // namespace CommandLine
+
+#endif // COMMANDLINE_H
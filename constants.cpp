@@ -1,5 +1,5 @@
 #include "constants.h"
-#include<QApplication>
+#include<QStringList>
 namespace ConstantGlobals {
 
 const QString appDirPath = QStandardPaths::writableLocation(QStandardPaths::DocumentsLocation) + "/BinauralPlayer";
@@ -6,6 +6,14 @@
 #include <QElapsedTimer>
 #include "constants.h"
 #include<QRandomGenerator>
+#include "renderkernels.h"
+#include "dynamicrenderer.h"
+#include "ambientdecoder.h"
+#include "nullsink.h"
+#include <algorithm>
+#include <cstring>
+#include <limits>
+#include <type_traits>
 
 DynamicEngine::DynamicEngine(QObject *parent)
     : QObject(parent)
@@ -16,6 +24,7 @@ DynamicEngine::DynamicEngine(QObject *parent)
     , m_amplitude(DEFAULT_AMPLITUDE)
     , m_outputVolume(DEFAULT_VOLUME)
     , m_currentWaveform(SINE_WAVE)
+    , m_oscillatorMode(WAVETABLE_OSCILLATOR)
     , m_phaseLeft(0.0)
     , m_phaseRight(0.0)
     , m_isPlaying(false)
@@ -26,11 +35,37 @@ DynamicEngine::DynamicEngine(QObject *parent)
     , m_dynamicDevice(nullptr)
 {
     initializeAudioFormat();
+    m_noiseSeed = QRandomGenerator::global()->generate64();
+    m_toneType = ConstantGlobals::currentToneType;
+    publishParameters();
+    publishEnvelope(m_outputVolume, 0, LINEAR_FADE);
+
+    const LatencySettings latency = latencySettings(m_latencyProfile);
+    m_sinkBufferMs = latency.sinkBufferMs;
+    m_renderAheadMs = latency.renderAheadMs;
+
+    m_adaptTimer = new QTimer(this);
+    m_adaptTimer->setInterval(ADAPT_INTERVAL_MS);
+    connect(m_adaptTimer, &QTimer::timeout, this, &DynamicEngine::adaptLatency);
+
+    m_meterTimer = new QTimer(this);
+    m_meterTimer->setInterval(METER_INTERVAL_MS);
+    connect(m_meterTimer, &QTimer::timeout, this, &DynamicEngine::pollAudioLevels);
+
+    m_telemetryClock.start();
 }
 
 DynamicEngine::~DynamicEngine()
 {
     stop();
+    if (m_outputRunning) {
+        stopOutput();
+    }
+    if (m_audioThread) {
+        m_audioThread->quit();
+        m_audioThread->wait();
+        delete m_audioContext;
+    }
     delete m_dynamicDevice;
     delete m_audioBuffer;
     delete m_audioOutput;
@@ -41,6 +76,7 @@ void DynamicEngine::initializeAudioFormat()
     m_audioFormat.setSampleRate(m_sampleRate);
     m_audioFormat.setChannelCount(2);
     m_audioFormat.setSampleFormat(QAudioFormat::Int16);
+    m_bytesPerFrame = m_audioFormat.bytesPerFrame();
 }
 
 bool DynamicEngine::initializeAudioOutput()
@@ -60,12 +96,12 @@ bool DynamicEngine::initializeAudioOutput()
         return false;
     }
 
-    m_audioOutput = new QAudioSink(audioDevice, m_audioFormat, this);
-       m_audioOutput->setBufferSize(32768);
-    connect(m_audioOutput, &QAudioSink::stateChanged,
-            this, &DynamicEngine::handleAudioStateChanged);
+    // No parent: the sink lives on the audio thread, the engine does not
+    m_audioOutput = new QAudioSink(audioDevice, m_audioFormat);
+    m_audioOutput->setBufferSize(m_audioFormat.bytesForDuration(static_cast<qint64>(m_sinkBufferMs) * 1000));
 
-    m_audioOutput->setVolume(m_outputVolume);
+    // Output volume is applied in the render path; the sink only mutes
+    m_audioOutput->setVolume(m_muted ? 0.0 : 1.0);
     return true;
 }
 
@@ -79,172 +115,286 @@ bool DynamicEngine::start()
     return startDynamicPlayback();
 }
 
-bool DynamicEngine::startDynamicPlayback()
+// ============================================================
+// DYNAMIC AUDIO DEVICE
+// ============================================================
+// The session's DynamicRenderer as a QIODevice, read by the render
+// thread into the render-ahead ring in the sink's sample format.
+// Unbuffered, so each read() renders exactly what it asks for. Block by
+// block it hands the renderer what the GUI thread published and
+// reports back what it rendered: levels, the output tap, the beat for
+// the sample clock, finished envelopes and ambient layer positions.
+
+class DynamicEngine::DynamicAudioDevice : public QIODevice
 {
-    if (!initializeAudioOutput()) {
-        return false;
+public:
+    DynamicAudioDevice(DynamicEngine *engine, QAudioFormat::SampleFormat format)
+        : m_engine(engine)
+        , m_renderer(takeParameters(engine), takeGain(engine))
+        , m_floatOutput(format == QAudioFormat::Float)
+        , m_session(engine->m_renderSession)
+    {
+        m_renderer.seedNoise(engine->m_noiseSeed.load());
+        m_renderer.setMetering(true);
+        setOpenMode(QIODevice::ReadOnly | QIODevice::Unbuffered);
+    }
+
+    bool isSequential() const override { return true; }
+
+    qint64 bytesAvailable() const override
+    {
+        return 4096 + QIODevice::bytesAvailable();
     }
 
-    class DynamicAudioDevice : public QIODevice {
-    public:
-        DynamicAudioDevice(DynamicEngine* engine) 
-            : m_engine(engine),
-              m_phaseLeft(0.0),
-              m_phaseRight(0.0),
-              m_pulseEnvelope(0.0),
-              m_prevPulseOn(false)   {
-            setOpenMode(QIODevice::ReadOnly);
+protected:
+    qint64 readData(char *data, qint64 maxlen) override
+    {
+        if (m_floatOutput) {
+            const int frames = static_cast<int>(maxlen / (2 * sizeof(float)));
+            renderBlocks(reinterpret_cast<float *>(data), frames);
+            return frames * 2 * sizeof(float);
         }
+        const int frames = static_cast<int>(maxlen / (2 * sizeof(int16_t)));
+        renderBlocks(reinterpret_cast<int16_t *>(data), frames);
+        return frames * 2 * sizeof(int16_t);
+    }
+
+    qint64 writeData(const char *data, qint64 len) override
+    {
+        Q_UNUSED(data);
+        Q_UNUSED(len);
+        return 0;
+    }
+
+private:
+    static const DynamicRenderer::Parameters &takeParameters(DynamicEngine *engine)
+    {
+        engine->m_parameterBuffer.update();
+        return engine->m_parameterBuffer.readBuffer();
+    }
+
+    // Start at the current volume; only envelopes published later fade
+    static double takeGain(DynamicEngine *engine)
+    {
+        engine->m_envelopeBuffer.update();
+        return engine->m_envelopeBuffer.readBuffer().target;
+    }
+
+    template<typename Sample>
+    void renderBlocks(Sample *out, int frameCount);
+    void tapBlock(const float *interleaved, int frames);
+    void publishBeat();
+
+    DynamicEngine *m_engine;
+    DynamicRenderer m_renderer;
+    const bool m_floatOutput;
+    const quint64 m_session; // Output session this device plays
+    quint64 m_sessionFrames = 0;
+    alignas(32) float m_tapFrames[2 * RenderKernels::BLOCK_FRAMES]; // Int16 output, interleaved again for the tap
+};
+
+template<typename Sample>
+void DynamicEngine::DynamicAudioDevice::renderBlocks(Sample *out, int frameCount)
+{
+    DynamicEngine *engine = m_engine;
+
+    // Apply noise reseeds/resets requested from the GUI thread
+    if (engine->m_noiseReseedPending.exchange(false)) {
+        m_renderer.seedNoise(engine->m_noiseSeed.load());
+    }
+    if (engine->m_noiseResetPending.exchange(false)) {
+        m_renderer.resetNoise();
+    }
 
-        bool isSequential() const override { return true; }
-
-          qint64 bytesAvailable() const override
-          {
-              return 4096 + QIODevice::bytesAvailable();
-          }
-        
-    protected:
-
-          qint64 readData(char* data, qint64 maxlen) override {
-              int16_t* samples = reinterpret_cast<int16_t*>(data);
-              int sampleCount = maxlen / (2 * sizeof(int16_t));
-
-              // Load engine settings
-              double leftFreq = m_engine->m_leftFrequency.load();
-              double rightFreq = m_engine->m_rightFrequency.load();
-              double amplitude = m_engine->m_amplitude.load();
-              auto waveform = m_engine->m_currentWaveform.load();
-              double sampleRate = m_engine->m_sampleRate;
-              double pulseFreq = m_engine->m_pulseFrequency;
-              bool isIsochronic = (ConstantGlobals::currentToneType == 1);
-
-              // Load noise settings once per buffer
-              bool noiseEnabled = m_engine->m_noiseEnabled.load();
-              int noiseType = m_engine->m_noiseType.load();
-              double noiseLevel = m_engine->m_noiseLevel.load();
-
-              for (int i = 0; i < sampleCount; ++i) {
-                  double leftSample = 0.0;
-                  double rightSample = 0.0;
-
-                  // ============================================================
-                  // STEP 1: GENERATE TONE
-                  // ============================================================
-                  if (isIsochronic) {
-                      double carrierPhaseInc = (2.0 * M_PI * leftFreq) / sampleRate;
-                      double pulsePhaseInc = (2.0 * M_PI * pulseFreq) / sampleRate;
-
-                      // Generate carrier waveform
-                      double carrier = 0.0;
-                      switch (waveform) {
-                          case SINE_WAVE: carrier = sin(m_phaseLeft); break;
-                          case SQUARE_WAVE: carrier = (sin(m_phaseLeft) >= 0.0) ? 1.0 : -1.0; break;
-                          case TRIANGLE_WAVE: carrier = m_engine->calculateTriangleSample(m_phaseLeft); break;
-                          case SAWTOOTH_WAVE: carrier = m_engine->calculateSawtoothSample(m_phaseLeft); break;
-                      }
-
-                      // Determine if pulse should be ON or OFF
-                      bool pulseOn = (sin(m_phaseRight) >= 0.0);
-
-                      // ============================================================
-                      // SMOOTH ENVELOPE WITH ATTACK/RELEASE (FIXES CLICKING)
-                      // ============================================================
-                      const double attackTime = 0.01;   // 10ms attack (adjustable)
-                      const double releaseTime = 0.01;  // 10ms release (adjustable)
-                      const double attackSteps = attackTime * sampleRate;
-                      const double releaseSteps = releaseTime * sampleRate;
-
-                      if (pulseOn) {
-                          // Attack: ramp up
-                          if (m_pulseEnvelope < 1.0) {
-                              m_pulseEnvelope += 1.0 / attackSteps;
-                              if (m_pulseEnvelope > 1.0) m_pulseEnvelope = 1.0;
-                          }
-                      } else {
-                          // Release: ramp down
-                          if (m_pulseEnvelope > 0.0) {
-                              m_pulseEnvelope -= 1.0 / releaseSteps;
-                              if (m_pulseEnvelope < 0.0) m_pulseEnvelope = 0.0;
-                          }
-                      }
-
-                      // Apply smooth envelope to carrier
-                      leftSample = carrier * m_pulseEnvelope;
-                      rightSample = leftSample; // Stereo identical
-
-                      // Update phases
-                      m_phaseLeft += carrierPhaseInc;
-                      m_phaseRight += pulsePhaseInc;
-                  } else {
-                      double leftPhaseInc = (2.0 * M_PI * leftFreq) / sampleRate;
-                      double rightPhaseInc = (2.0 * M_PI * rightFreq) / sampleRate;
-
-                      leftSample = m_engine->calculateSample(m_phaseLeft, waveform);
-                      rightSample = m_engine->calculateSample(m_phaseRight, waveform);
-
-                      m_phaseLeft += leftPhaseInc;
-                      m_phaseRight += rightPhaseInc;
-                  }
-
-                  // ============================================================
-                  // STEP 2: GENERATE AND MIX NOISE (UNIVERSAL)
-                  // ============================================================
-                  if (noiseEnabled && noiseType > 0 && noiseLevel > 0.0) {
-                      double noiseSample = 0.0;
-                      switch (noiseType) {
-                          case 1: noiseSample = m_engine->generateWhiteNoise(); break;
-                          case 2: noiseSample = m_engine->generatePinkNoise(); break;
-                          case 3: noiseSample = m_engine->generateBrownNoise(); break;
-                          case 4: noiseSample = m_engine->generateGreyNoise(); break;
-
-                          default: noiseSample = 0.0; break;
-                      }
-
-                      // Mix tone with noise (crossfade)
-                      leftSample = (leftSample * (1.0 - noiseLevel)) + (noiseSample * noiseLevel);
-                      rightSample = (rightSample * (1.0 - noiseLevel)) + (noiseSample * noiseLevel);
-                  }
-
-                  // ============================================================
-                  // STEP 3: APPLY AMPLITUDE AND OUTPUT
-                  // ============================================================
-                  leftSample *= amplitude;
-                  rightSample *= amplitude;
-
-                  // Clamp
-                  leftSample = qBound(-1.0, leftSample, 1.0);
-                  rightSample = qBound(-1.0, rightSample, 1.0);
-
-                  // Write to buffer
-                  samples[2 * i] = static_cast<int16_t>(leftSample * 32767);
-                  samples[2 * i + 1] = static_cast<int16_t>(rightSample * 32767);
-
-                  // Phase wrapping
-                  if (m_phaseLeft > 2.0 * M_PI) m_phaseLeft -= 2.0 * M_PI;
-                  if (m_phaseRight > 2.0 * M_PI) m_phaseRight -= 2.0 * M_PI;
-              }
-
-              return sampleCount * 2 * sizeof(int16_t);
-          }
-
-        qint64 writeData(const char* data, qint64 len) override {
-            Q_UNUSED(data);
-            Q_UNUSED(len);
-            return 0;
+    for (int offset = 0; offset < frameCount; offset += RenderKernels::BLOCK_FRAMES) {
+        const int frames = std::min(RenderKernels::BLOCK_FRAMES, frameCount - offset);
+
+        // Pick up the latest snapshots once per block
+        if (engine->m_parameterBuffer.update()) {
+            m_renderer.setParameters(engine->m_parameterBuffer.readBuffer());
+            engine->m_parameterUpdatesApplied.fetch_add(1, std::memory_order_relaxed);
         }
-        
-    private:
-        DynamicEngine* m_engine;
-        double m_phaseLeft;
-        double m_phaseRight;
-        double m_pulseEnvelope;
-        bool m_prevPulseOn;
-    };
-    
-    m_dynamicDevice = new DynamicAudioDevice(this);
-    m_audioOutput->start(m_dynamicDevice);
+        engine->m_renderedBlocks.fetch_add(1, std::memory_order_relaxed);
+        engine->m_renderedFrames.fetch_add(frames, std::memory_order_relaxed);
+        if (engine->m_envelopeBuffer.update()) {
+            m_renderer.startEnvelope(engine->m_envelopeBuffer.readBuffer());
+        }
+        engine->m_voiceBuffer.update();
+        m_renderer.setVoices(&engine->m_voiceBuffer.readBuffer());
+        engine->m_ambientBuffer.update();
+        m_renderer.setAmbient(&engine->m_ambientBuffer.readBuffer());
+
+        Sample *blockOut = out + 2 * offset;
+        m_renderer.render(blockOut, frames);
+
+        const RenderKernels::LevelSums &sums = m_renderer.levels();
+        LevelMeter::Levels levels;
+        levels.peakLeft = sums.peakLeft;
+        levels.peakRight = sums.peakRight;
+        levels.rmsLeft = std::sqrt(sums.sumSquaresLeft / frames);
+        levels.rmsRight = std::sqrt(sums.sumSquaresRight / frames);
+        engine->m_levelMeter.publish(levels);
+
+        // Picked up by pollAudioLevels(); posting an event would allocate
+        const quint64 finishedEnvelope = m_renderer.takeFinishedEnvelope();
+        if (finishedEnvelope != 0) {
+            engine->m_finishedEnvelopeId.store(finishedEnvelope, std::memory_order_release);
+        }
+        for (int i = 0; i < MAX_AMBIENT_LAYERS; ++i) {
+            const qint64 position = m_renderer.ambientPosition(i);
+            if (position >= 0) {
+                engine->m_ambientPositions[i].store(position, std::memory_order_relaxed);
+            }
+            const quint64 ended = m_renderer.takeAmbientEnd(i);
+            if (ended != 0) {
+                engine->m_ambientEnded[i].store(ended, std::memory_order_release);
+            }
+        }
+
+        if (engine->m_outputTapEnabled.load(std::memory_order_acquire)) {
+            if constexpr (std::is_same_v<Sample, float>) {
+                tapBlock(blockOut, frames);
+            } else {
+                tapBlock(nullptr, frames);
+            }
+        }
+
+        m_sessionFrames += frames;
+        publishBeat();
+    }
+}
+
+// Whole blocks or nothing, so the reader never sees a partial frame;
+// int16 output passes nullptr and the block is interleaved again here
+void DynamicEngine::DynamicAudioDevice::tapBlock(const float *interleaved, int frames)
+{
+    RingBuffer<float> &tap = *m_engine->m_outputTap;
+    if (tap.writeAvailable() < static_cast<std::size_t>(2 * frames)) {
+        m_engine->m_outputTapDrops.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+
+    if (!interleaved) {
+        RenderKernels::activeKernels().interleaveFloat(m_renderer.mixLeft(), m_renderer.mixRight(),
+                                                       m_tapFrames, frames, nullptr);
+        interleaved = m_tapFrames;
+    }
+    tap.write(interleaved, 2 * frames);
+}
+
+// The phases are the oscillators' after the block and the frequencies
+// the ones its ramp ended on
+void DynamicEngine::DynamicAudioDevice::publishBeat()
+{
+    const DynamicRenderer::Parameters &params = m_renderer.parameters();
+    BeatPoint &beat = m_engine->m_beatPoints.writeBuffer();
+    beat.frames = m_sessionFrames;
+    beat.session = m_session;
+    beat.sampleRate = params.sampleRate;
+    if (params.toneType == 1) {
+        beat.phase = m_renderer.phaseRight();
+        beat.hz = params.pulseFrequency;
+    } else {
+        const double difference = params.rightFrequency >= params.leftFrequency
+                ? m_renderer.phaseRight() - m_renderer.phaseLeft()
+                : m_renderer.phaseLeft() - m_renderer.phaseRight();
+        beat.phase = difference - std::floor(difference);
+        beat.hz = std::abs(params.rightFrequency - params.leftFrequency);
+    }
+    beat.valid = !params.silent && beat.hz > 0.0;
+    m_engine->m_beatPoints.publish();
+}
+
+// ============================================================
+// RENDER-AHEAD DEVICE
+// ============================================================
+// What the sink pulls from during playback: copies out of the ring the
+// render thread fills and never renders itself.
+
+class DynamicEngine::RenderAheadDevice : public QIODevice
+{
+public:
+    explicit RenderAheadDevice(DynamicEngine *engine)
+        : m_engine(engine)
+    {
+        setOpenMode(QIODevice::ReadOnly);
+    }
+
+    bool isSequential() const override { return true; }
+
+    // Never reports empty; readData() bridges an underrun with silence
+    qint64 bytesAvailable() const override
+    {
+        return 4096 + QIODevice::bytesAvailable();
+    }
+
+protected:
+    qint64 readData(char *data, qint64 maxlen) override;
+
+    qint64 writeData(const char *data, qint64 len) override
+    {
+        Q_UNUSED(data);
+        Q_UNUSED(len);
+        return 0;
+    }
+
+private:
+    DynamicEngine *m_engine;
+};
+
+qint64 DynamicEngine::RenderAheadDevice::readData(char *data, qint64 maxlen)
+{
+    const qint64 bytesPerFrame = m_engine->m_bytesPerFrame;
+    const qint64 frameCount = maxlen / bytesPerFrame;
+
+    // Late when the device buffer had time to drain since the last call
+    const qint64 now = m_engine->m_telemetryClock.nsecsElapsed();
+    const qint64 last = m_engine->m_lastCallbackNs.exchange(now, std::memory_order_relaxed);
+    if (last >= 0) {
+        const qint64 interval = now - last;
+        m_engine->m_callbackIntervalHistogram.record(interval);
+        const qint64 sinkFrames = m_engine->m_sinkBufferBytes.load(std::memory_order_relaxed) / bytesPerFrame;
+        if (sinkFrames > 0 && interval > sinkFrames * 1000000000ll / m_engine->m_sampleRate) {
+            m_engine->m_lateCallbacks.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+
+    const qint64 fillFrames = m_engine->renderAheadFillFrames();
+    if (fillFrames < m_engine->m_renderAheadLowWatermark.load(std::memory_order_relaxed)) {
+        m_engine->m_renderAheadLowWatermark.store(fillFrames, std::memory_order_relaxed);
+    }
+
+    // A short read is fine (the sink asks again); only an empty ring is
+    // an underrun, bridged with one block of silence
+    if (fillFrames == 0 && frameCount > 0) {
+        m_engine->m_renderAheadUnderruns.fetch_add(1, std::memory_order_relaxed);
+        m_engine->m_telemetryRenderUnderruns.fetch_add(1, std::memory_order_relaxed);
+        const qint64 silence = std::min<qint64>(frameCount, RenderKernels::BLOCK_FRAMES);
+        memset(data, 0, silence * bytesPerFrame);
+        m_engine->publishClockPoint(silence);
+        return silence * bytesPerFrame;
+    }
+
+    const qint64 frames = std::min(frameCount, fillFrames);
+    m_engine->m_renderAhead->read(data, frames * bytesPerFrame);
+    m_engine->m_framesDelivered.fetch_add(frames, std::memory_order_relaxed);
+    m_engine->m_clockRenderFrames += frames;
+    m_engine->publishClockPoint(frames);
+    return frames * bytesPerFrame;
+}
+
+bool DynamicEngine::startDynamicPlayback()
+{
     m_isPlaying = true;
-    
+    if (!updateOutputState()) {
+        m_isPlaying = false;
+        publishParameters();
+        return false;
+    }
+
+    // Unsilence the tones when the sink was already running for ambient layers
+    publishParameters();
+
     emit playbackStarted();
     return true;
 }
@@ -256,25 +406,135 @@ void DynamicEngine::stop()
 
 void DynamicEngine::stopDynamicPlayback()
 {
-    if (m_audioOutput) {
-        m_audioOutput->stop();
-    }
-    
-    if (m_dynamicDevice) {
-        m_dynamicDevice->close();
-        delete m_dynamicDevice;
-        m_dynamicDevice = nullptr;
-    }
-    
     bool wasPlaying = m_isPlaying;
     m_isPlaying = false;
+    publishParameters();
+    updateOutputState();
     resetPhase();
+
+    // A fade cut short by stopping jumps to its target
+    if (m_fading) {
+        m_fading = false;
+        emit fadeFinished(m_outputVolume);
+    }
     
     if (wasPlaying) {
         emit playbackStopped();
     }
 }
 
+bool DynamicEngine::updateOutputState()
+{
+    const bool needed = m_isPlaying || isAmbientPlaying();
+    if (needed && !m_outputRunning) {
+        return startOutput();
+    }
+    if (!needed && m_outputRunning) {
+        stopOutput();
+    }
+    return true;
+}
+
+bool DynamicEngine::startOutput()
+{
+    ensureAudioThread();
+
+    // State changes of an earlier sink may still be queued; drop them
+    const quint64 generation = ++m_sinkGeneration;
+    m_sinkBufferMs = latencySettings(m_latencyProfile).sinkBufferMs;
+
+    m_outputRunning = true;
+    if (!negotiateAudioFormat()) {
+        m_outputRunning = false;
+        return false;
+    }
+    publishParameters(); // Tones silent unless they are what started the sink
+
+    // Fill the ring to the lookahead before the sink first pulls
+    const qint64 capacityFrames = static_cast<qint64>(MAX_RENDER_AHEAD_MS) * m_sampleRate / 1000
+            + RenderKernels::BLOCK_FRAMES;
+    m_renderAhead = new RingBuffer<char>(capacityFrames * m_bytesPerFrame);
+    ++m_renderSession;
+    m_clockRenderFrames = 0;
+    m_dynamicDevice = new DynamicAudioDevice(this, m_audioFormat.sampleFormat());
+    while (topUpRenderAhead()) {
+    }
+    resetRenderAheadStats();
+
+    m_renderThreadRunning = true;
+    m_renderThread = QThread::create([this]() {
+        while (m_renderThreadRunning.load(std::memory_order_acquire)) {
+            if (!topUpRenderAhead()) {
+                // Check back a few times per lookahead
+                QThread::usleep(std::clamp(m_renderAheadMs.load() * 250, 500, 5000));
+            }
+        }
+    });
+    m_renderThread->setObjectName("DynamicEngine render");
+    m_renderThread->start(QThread::HighPriority);
+
+    m_lastCallbackNs = -1; // The gap since the last sink is no callback interval
+    bool started = false;
+    runOnAudioThread([this, generation, &started]() {
+        m_sinkDevice = new RenderAheadDevice(this);
+        started = openSink(generation);
+        if (!started) {
+            delete m_sinkDevice;
+            m_sinkDevice = nullptr;
+        }
+    });
+
+    if (!started) {
+        stopRenderAhead();
+        m_outputRunning = false;
+        restoreRequestedFormat();
+        return false;
+    }
+
+    m_seenSinkUnderruns = underrunCount();
+    m_seenRenderUnderruns = 0;
+    m_seenRenderOverruns = 0;
+    m_stableChecks = 0;
+    m_sinkStableChecks = 0;
+    m_sinkShrinkChecks = SINK_SHRINK_CHECKS;
+    if (m_adaptiveLatency) {
+        m_adaptTimer->start();
+    }
+    m_meterTimer->start();
+
+    emit latencyChanged(outputLatencyMs());
+    return true;
+}
+
+void DynamicEngine::stopOutput()
+{
+    m_adaptTimer->stop();
+    m_meterTimer->stop();
+
+    if (m_audioContext) {
+        ++m_sinkGeneration;
+        runOnAudioThread([this]() {
+            closeSink();
+
+            if (m_sinkDevice) {
+                m_sinkDevice->close();
+                delete m_sinkDevice;
+                m_sinkDevice = nullptr;
+            }
+        });
+    }
+
+    stopRenderAhead();
+    m_outputRunning = false;
+    restoreRequestedFormat();
+    emit latencyChanged(outputLatencyMs());
+
+    // Nothing plays any more; drop what the last blocks left behind
+    m_levelMeter.clear();
+    m_audioLevels = LevelMeter::Levels();
+    emit audioLevelChanged(0.0);
+}
+
 bool DynamicEngine::isPlaying() const
 {
     return m_isPlaying;
@@ -288,13 +548,14 @@ void DynamicEngine::setLeftFrequency(double hz)
     }
 
     m_leftFrequency = hz;
+    publishParameters();
     emit leftFrequencyChanged(hz);
     emit beatFrequencyChanged(getBeatFrequency());
 }
 
 void DynamicEngine::setRightFrequency(double hz)
 {
-    if (ConstantGlobals::currentToneType == 1) {
+    if (m_toneType == 1) {
     } else {
         if (!validateFrequency(hz)) {
             emit errorOccurred(QString("Invalid right frequency: %1 Hz").arg(hz));
@@ -303,6 +564,7 @@ void DynamicEngine::setRightFrequency(double hz)
     }
 
     m_rightFrequency = hz;
+    publishParameters();
     emit rightFrequencyChanged(hz);
     emit beatFrequencyChanged(getBeatFrequency());
 }
@@ -343,6 +605,7 @@ void DynamicEngine::setWaveform(Waveform type)
 {
     if (m_currentWaveform != type) {
         m_currentWaveform = type;
+        publishParameters();
         emit waveformChanged(type);
     }
 }
@@ -352,6 +615,17 @@ DynamicEngine::Waveform DynamicEngine::getWaveform() const
     return m_currentWaveform;
 }
 
+void DynamicEngine::setOscillatorMode(OscillatorMode mode)
+{
+    m_oscillatorMode = mode;
+    publishParameters();
+}
+
+DynamicEngine::OscillatorMode DynamicEngine::getOscillatorMode() const
+{
+    return m_oscillatorMode;
+}
+
 void DynamicEngine::setAmplitude(double amplitude)
 {
     if (!validateAmplitude(amplitude)) {
@@ -360,6 +634,7 @@ void DynamicEngine::setAmplitude(double amplitude)
     }
 
     m_amplitude = amplitude;
+    publishParameters();
 }
 
 void DynamicEngine::setVolume(double volume)
@@ -370,10 +645,7 @@ void DynamicEngine::setVolume(double volume)
     }
 
     m_outputVolume = volume;
-
-    if (m_audioOutput) {
-        m_audioOutput->setVolume(volume);
-    }
+    publishEnvelope(volume, framesForMs(VOLUME_RAMP_MS), LINEAR_FADE);
 
     emit volumeChanged(volume);
 }
@@ -395,13 +667,15 @@ void DynamicEngine::setSampleRate(int sampleRate)
         return;
     }
 
-    if (m_isPlaying) {
+    if (m_outputRunning) {
         emit errorOccurred("Cannot change sample rate while playing");
         return;
     }
 
+    m_requestedSampleRate = sampleRate;
     m_sampleRate = sampleRate;
     initializeAudioFormat();
+    publishParameters();
 }
 
 int DynamicEngine::getSampleRate() const
@@ -436,7 +710,7 @@ QAudioSink *DynamicEngine::audioOutput() const
 
 void DynamicEngine::setPulseFrequency(double hz)
 {
-    if (ConstantGlobals::currentToneType != 1) {
+    if (m_toneType != 1) {
             return; // Don't set pulse for non-ISO tones
         }
     if (hz < 0.1 || hz > 100.0) {
@@ -445,6 +719,65 @@ void DynamicEngine::setPulseFrequency(double hz)
     }
 
     m_pulseFrequency = hz;
+    publishParameters();
+}
+
+void DynamicEngine::setToneType(int toneType)
+{
+    if (toneType < 0 || toneType > 2) {
+        emit errorOccurred(QString("Invalid tone type: %1").arg(toneType));
+        return;
+    }
+
+    m_toneType = toneType;
+    publishParameters();
+}
+
+int DynamicEngine::getToneType() const
+{
+    return m_toneType;
+}
+
+// ============================================================
+// PARAMETER SNAPSHOTS
+// ============================================================
+
+void DynamicEngine::publishParameters()
+{
+    DynamicRenderer::Parameters &params = m_parameterBuffer.writeBuffer();
+    params.leftFrequency = m_leftFrequency;
+    params.rightFrequency = m_rightFrequency;
+    params.pulseFrequency = m_pulseFrequency;
+    params.amplitude = m_amplitude;
+    params.noiseLevel = m_noiseLevel;
+    params.noiseType = m_noiseType;
+    params.noiseEnabled = m_noiseEnabled;
+    params.waveform = static_cast<DynamicRenderer::Waveform>(m_currentWaveform.load());
+    params.oscillatorMode = static_cast<DynamicRenderer::OscillatorMode>(m_oscillatorMode.load());
+    params.toneType = m_toneType;
+    params.sampleRate = m_sampleRate;
+    params.silent = m_outputRunning && !m_isPlaying;
+    ++m_parameterVersion;
+    m_parameterBuffer.publish();
+}
+
+quint64 DynamicEngine::parameterUpdatesPublished() const
+{
+    return m_parameterVersion;
+}
+
+quint64 DynamicEngine::parameterUpdatesApplied() const
+{
+    return m_parameterUpdatesApplied.load(std::memory_order_relaxed);
+}
+
+double DynamicEngine::maxParameterUpdateRate() const
+{
+    const quint64 frames = m_renderedFrames.load(std::memory_order_relaxed);
+    if (frames == 0) {
+        return static_cast<double>(m_sampleRate) / RenderKernels::BLOCK_FRAMES;
+    }
+    return static_cast<double>(m_sampleRate) * m_renderedBlocks.load(std::memory_order_relaxed) / frames;
 }
 
 QBuffer *DynamicEngine::audioBuffer() const
@@ -542,7 +875,7 @@ void DynamicEngine::resetPhase()
     m_phaseRight = 0.0;
 }
 
-void DynamicEngine::handleAudioStateChanged(QAudio::State state)
+void DynamicEngine::handleAudioStateChanged(QAudio::State state, QAudio::Error error)
 {
     
     switch (state) {
@@ -553,9 +886,8 @@ void DynamicEngine::handleAudioStateChanged(QAudio::State state)
             break;
             
         case QAudio::StoppedState:
-            if (m_isPlaying) {
-                m_isPlaying = false;
-                emit playbackStopped();
+            if (m_outputRunning) {
+                abortOutput();
             }
             break;
             
@@ -572,9 +904,9 @@ void DynamicEngine::handleAudioStateChanged(QAudio::State state)
             break;
     }
     
-    if (m_audioOutput && m_audioOutput->error() != QAudio::NoError) {
+    if (error != QAudio::NoError) {
         QString errorMsg;
-        switch (m_audioOutput->error()) {
+        switch (error) {
             case QAudio::OpenError:
                 errorMsg = "Audio open error";
                 break;
@@ -644,6 +976,7 @@ void DynamicEngine::setNoiseType(int type)
     }
     m_noiseType = type;
     resetNoiseState();
+    publishParameters();
 }
 
 void DynamicEngine::setNoiseLevel(double level)
@@ -653,6 +986,7 @@ void DynamicEngine::setNoiseLevel(double level)
         return;
     }
     m_noiseLevel = level;
+    publishParameters();
 }
 
 void DynamicEngine::setNoiseEnabled(bool enabled)
@@ -661,6 +995,7 @@ void DynamicEngine::setNoiseEnabled(bool enabled)
     if (!enabled) {
         resetNoiseState();
     }
+    publishParameters();
 }
 
 int DynamicEngine::getNoiseType() const
@@ -682,83 +1017,1063 @@ bool DynamicEngine::isNoiseEnabled() const
 // NOISE GENERATION
 // ============================================================
 
-double DynamicEngine::generateWhiteNoise()
+void DynamicEngine::setNoiseSeed(quint64 seed)
+{
+    m_noiseSeed = seed;
+    m_noiseReseedPending = true;
+}
+
+void DynamicEngine::resetNoiseState()
+{
+    m_noiseResetPending = true;
+}
+
+// ============================================================
+// OUTPUT GAIN ENVELOPES
+// ============================================================
+
+void DynamicEngine::fadeTo(double volume, int durationMs, FadeCurve curve)
+{
+    if (volume < 0.0 || volume > 1.0) {
+        emit errorOccurred(QString("Invalid volume: %1").arg(volume));
+        return;
+    }
+
+    m_outputVolume = volume;
+
+    if (!m_isPlaying || durationMs <= 0) {
+        publishEnvelope(volume, 0, curve);
+        emit volumeChanged(volume);
+        emit fadeFinished(volume);
+        return;
+    }
+
+    m_fading = true;
+    publishEnvelope(volume, framesForMs(durationMs), curve);
+    emit volumeChanged(volume);
+}
+
+bool DynamicEngine::isFading() const
+{
+    return m_fading;
+}
+
+void DynamicEngine::publishEnvelope(double target, qint64 durationFrames, FadeCurve curve)
 {
-    return QRandomGenerator::global()->generateDouble() * 2.0 - 1.0;
+    DynamicRenderer::GainEnvelope &envelope = m_envelopeBuffer.writeBuffer();
+    envelope.target = target;
+    envelope.durationFrames = durationFrames;
+    envelope.curve = static_cast<DynamicRenderer::FadeCurve>(curve);
+    envelope.id = ++m_envelopeId;
+    m_envelopeBuffer.publish();
 }
 
+qint64 DynamicEngine::framesForMs(int ms) const
+{
+    return static_cast<qint64>(ms) * m_sampleRate / 1000;
+}
 
-double DynamicEngine::generatePinkNoise()
+void DynamicEngine::handleEnvelopeFinished(quint64 id)
 {
-    // Voss-McCartney algorithm
-    static const int numStages = 8;
-    static int index = 0;
-    static double values[numStages] = {0.0};
-    static double runningSum = 0.0;
+    // Ignore envelopes that were superseded before they completed
+    if (id != m_envelopeId || !m_fading) {
+        return;
+    }
 
-    // Generate new white noise for stage 0
-    values[0] = generateWhiteNoise();
+    m_fading = false;
+    emit fadeFinished(m_outputVolume);
+}
 
-    // For each stage, update at 2^stage intervals
-    for (int i = 1; i < numStages; ++i) {
-        if (index % (1 << i) == 0) {
-            values[i] = generateWhiteNoise();
-        }
+// ============================================================
+// AUDIO THREAD
+// ============================================================
+
+void DynamicEngine::ensureAudioThread()
+{
+    if (m_audioThread) {
+        return;
+    }
+
+    m_audioThread = new QThread(this);
+    m_audioThread->setObjectName("DynamicEngine audio");
+    m_audioContext = new QObject;
+    m_audioContext->moveToThread(m_audioThread);
+    m_audioThread->start(QThread::TimeCriticalPriority);
+}
+
+// Runs task on the audio thread and waits for it (GUI thread only)
+void DynamicEngine::runOnAudioThread(const std::function<void()> &task)
+{
+    QMetaObject::invokeMethod(m_audioContext, task, Qt::BlockingQueuedConnection);
+}
+
+void DynamicEngine::setMuted(bool muted)
+{
+    m_muted = muted;
+    if (m_audioContext) {
+        QMetaObject::invokeMethod(m_audioContext, [this, muted]() {
+            if (m_audioOutput) {
+                m_audioOutput->setVolume(muted ? 0.0 : 1.0);
+            }
+        }, Qt::QueuedConnection);
+    }
+}
+
+bool DynamicEngine::isMuted() const
+{
+    return m_muted;
+}
+
+quint64 DynamicEngine::framesDelivered() const
+{
+    return m_framesDelivered.load(std::memory_order_relaxed);
+}
+
+quint64 DynamicEngine::underrunCount() const
+{
+    return m_underrunCount.load(std::memory_order_relaxed);
+}
+
+// ============================================================
+// RENDER-AHEAD BUFFER
+// ============================================================
+
+bool DynamicEngine::topUpRenderAhead()
+{
+    const qint64 fillFrames = renderAheadFillFrames();
+    const qint64 spaceFrames = m_renderAhead->writeAvailable() / m_bytesPerFrame;
+    const qint64 targetFrames = renderAheadFrames();
+    if (fillFrames >= targetFrames || spaceFrames < RenderKernels::BLOCK_FRAMES) {
+        return false;
     }
 
-    // Sum all stages
-    runningSum = 0.0;
-    for (int i = 0; i < numStages; ++i) {
-        runningSum += values[i];
+    // Whole blocks where there is room, but never more than a quantum
+    // past the lookahead, so short lookaheads stay short
+    const qint64 frames = std::min<qint64>(RenderKernels::BLOCK_FRAMES,
+                                           std::max<qint64>(RENDER_AHEAD_QUANTUM, targetFrames - fillFrames));
+
+    // Room for a block of Float32, the widest output format
+    alignas(32) char block[2 * sizeof(float) * RenderKernels::BLOCK_FRAMES];
+    QElapsedTimer timer;
+    timer.start();
+    m_dynamicDevice->read(block, frames * m_bytesPerFrame);
+    const qint64 renderNs = timer.nsecsElapsed();
+    const qint64 blockNs = frames * 1000000000ll / m_sampleRate;
+    m_renderTimeHistogram.record(renderNs);
+    m_budgetHistogram.record(renderNs * FULL_BUDGET / blockNs);
+    if (renderNs > blockNs) {
+        m_renderAheadOverruns.fetch_add(1, std::memory_order_relaxed);
     }
 
-    // Update index
-    ++index;
-    if (index >= (1 << (numStages - 1))) {
-        index = 0;
+    m_renderAhead->write(block, frames * m_bytesPerFrame);
+    return true;
+}
+
+qint64 DynamicEngine::renderAheadFillFrames() const
+{
+    return m_renderAhead->readAvailable() / m_bytesPerFrame;
+}
+
+void DynamicEngine::stopRenderAhead()
+{
+    if (m_renderThread) {
+        m_renderThreadRunning = false;
+        m_renderThread->wait();
+        delete m_renderThread;
+        m_renderThread = nullptr;
     }
 
-    // Scale to match original amplitude
-    double pink = (runningSum / numStages) * 2.0;  // Multiply by 2 to restore volume
+    delete m_dynamicDevice;
+    m_dynamicDevice = nullptr;
+    delete m_renderAhead;
+    m_renderAhead = nullptr;
+}
+
+qint64 DynamicEngine::renderAheadFrames() const
+{
+    return static_cast<qint64>(m_renderAheadMs.load()) * m_sampleRate / 1000;
+}
+
+void DynamicEngine::setRenderAheadMs(int ms)
+{
+    m_renderAheadMs = std::clamp(ms, MIN_RENDER_AHEAD_MS, MAX_RENDER_AHEAD_MS);
+}
 
-    return qBound(-1.0, pink, 1.0);
+int DynamicEngine::renderAheadMs() const
+{
+    return m_renderAheadMs;
 }
 
+DynamicEngine::RenderAheadStats DynamicEngine::renderAheadStats() const
+{
+    RenderAheadStats stats;
+    stats.lookaheadFrames = renderAheadFrames();
+    if (m_renderAhead) {
+        stats.fillFrames = renderAheadFillFrames();
+        stats.lowWatermarkFrames = std::min(stats.fillFrames, m_renderAheadLowWatermark.load());
+    }
+    stats.underruns = m_renderAheadUnderruns;
+    stats.overruns = m_renderAheadOverruns;
+    return stats;
+}
 
-double DynamicEngine::generateGreyNoise()
+void DynamicEngine::resetRenderAheadStats()
 {
-    static double prev = 0.0;
-    double white = generateWhiteNoise();
+    m_renderAheadLowWatermark = std::numeric_limits<qint64>::max();
+    m_renderAheadUnderruns = 0;
+    m_renderAheadOverruns = 0;
+}
 
-    // Original grey (soft)
-    double grey = 0.7 * prev + 0.3 * white;
-    prev = grey;
+// ============================================================
+// CALLBACK TELEMETRY
+// ============================================================
 
+DynamicEngine::CallbackTelemetry DynamicEngine::callbackTelemetry() const
+{
+    CallbackTelemetry telemetry;
+    telemetry.sampleRate = m_sampleRate;
+    telemetry.sinkBufferMs = outputLatencyMs() - m_renderAheadMs;
+    telemetry.renderAheadMs = m_renderAheadMs;
+    telemetry.renderTimeNs = m_renderTimeHistogram.snapshot();
+    telemetry.budgetPermyriad = m_budgetHistogram.snapshot();
+    telemetry.callbackIntervalNs = m_callbackIntervalHistogram.snapshot();
+    telemetry.lateCallbacks = m_lateCallbacks;
+    telemetry.sinkUnderruns = m_telemetrySinkUnderruns;
+    telemetry.renderAheadUnderruns = m_telemetryRenderUnderruns;
+    return telemetry;
+}
 
-    // Boost lows and highs slightly, attenuate mids
-    static double midFilter = 0.0;
-    midFilter = 0.5 * midFilter + 0.5 * grey;
-    double shaped = grey - (0.15 * midFilter);  // Slight mid cut
+void DynamicEngine::resetCallbackTelemetry()
+{
+    m_renderTimeHistogram.reset();
+    m_budgetHistogram.reset();
+    m_callbackIntervalHistogram.reset();
+    m_lateCallbacks = 0;
+    m_telemetrySinkUnderruns = 0;
+    m_telemetryRenderUnderruns = 0;
+}
 
-    return qBound(-1.0, shaped, 1.0);
+void DynamicEngine::countSinkUnderrun()
+{
+    m_underrunCount.fetch_add(1, std::memory_order_relaxed);
+    m_telemetrySinkUnderruns.fetch_add(1, std::memory_order_relaxed);
 }
 
-double DynamicEngine::generateBrownNoise()
+// ============================================================
+// LEVEL METER
+// ============================================================
+
+LevelMeter::Levels DynamicEngine::audioLevels() const
 {
-    double step = (QRandomGenerator::global()->generateDouble() - 0.5) * 0.5;
-    m_brownState += step;
-    m_brownState = qBound(-0.8, m_brownState, 0.8);
-    return m_brownState;
+    return m_audioLevels;
 }
 
-void DynamicEngine::resetNoiseState()
+void DynamicEngine::pollAudioLevels()
+{
+    m_audioLevels = m_levelMeter.take();
+    emit audioLevelChanged(m_audioLevels.peak());
+
+    const quint64 finishedEnvelope = m_finishedEnvelopeId.exchange(0, std::memory_order_acquire);
+    if (finishedEnvelope != 0) {
+        handleEnvelopeFinished(finishedEnvelope);
+    }
+
+    for (int i = 0; i < MAX_AMBIENT_LAYERS; ++i) {
+        const quint64 ended = m_ambientEnded[i].exchange(0, std::memory_order_acquire);
+        if (ended != 0) {
+            handleAmbientLayerEnded(i, ended - 1);
+        }
+    }
+}
+
+// ============================================================
+// OUTPUT TAP
+// ============================================================
+
+// The ring is created here, on the first enable, so the reader must
+// start after that
+void DynamicEngine::setOutputTapEnabled(bool enabled)
+{
+    if (enabled && !m_outputTap) {
+        m_outputTap = std::make_unique<RingBuffer<float>>(2 * OUTPUT_TAP_FRAMES);
+    }
+    m_outputTapEnabled.store(enabled, std::memory_order_release);
+}
+
+bool DynamicEngine::isOutputTapEnabled() const
+{
+    return m_outputTapEnabled.load(std::memory_order_relaxed);
+}
+
+int DynamicEngine::readOutputTap(float *frames, int maxFrames)
+{
+    if (!m_outputTap) {
+        return 0;
+    }
+    // Blocks go in whole, so the fill is always a whole number of frames
+    return static_cast<int>(m_outputTap->read(frames, 2 * static_cast<std::size_t>(maxFrames)) / 2);
+}
+
+quint64 DynamicEngine::outputTapDrops() const
+{
+    return m_outputTapDrops.load(std::memory_order_relaxed);
+}
+
+// ============================================================
+// SAMPLE CLOCK
+// ============================================================
+
+// Called before the sink has taken this callback's frames, so they are
+// queued on top of what it reports
+void DynamicEngine::publishClockPoint(qint64 frames)
+{
+    m_clockFrames += frames;
+    ClockPoint &point = m_clockPoints.writeBuffer();
+    point.frames = m_clockFrames;
+    point.sinkFrames = sinkQueuedFrames() + frames;
+    point.renderFrames = m_clockRenderFrames;
+    point.session = m_renderSession;
+    point.timeNs = m_telemetryClock.nsecsElapsed();
+    point.sampleRate = m_sampleRate;
+    m_clockPoints.publish();
+}
+
+qint64 DynamicEngine::sinkQueuedFrames() const
+{
+    qint64 queuedBytes = 0;
+    if (m_audioOutput) {
+        queuedBytes = m_audioOutput->bufferSize() - m_audioOutput->bytesFree();
+    } else if (m_nullSink) {
+        queuedBytes = m_nullSink->bufferSize() - m_nullSink->bytesFree();
+    }
+    return std::max<qint64>(0, queuedBytes / m_bytesPerFrame);
+}
+
+DynamicEngine::SampleClock DynamicEngine::sampleClock()
+{
+    m_clockPoints.update();
+    m_beatPoints.update();
+    const ClockPoint &point = m_clockPoints.readBuffer();
+    const BeatPoint &beat = m_beatPoints.readBuffer();
+
+    SampleClock clock;
+    clock.sampleRate = point.sampleRate;
+    clock.running = m_outputRunning && point.timeNs >= 0;
+    if (point.timeNs >= 0) {
+        const double sinceNs = static_cast<double>(m_telemetryClock.nsecsElapsed() - point.timeNs);
+        const double heard = static_cast<double>(point.frames) - point.sinkFrames
+                + sinceNs * point.sampleRate * 1.0e-9;
+        // A stalled sink plays no further than it was given; after a stall
+        // the next callback's estimate may lie behind what was reported
+        m_sampleClockFrames = std::max(m_sampleClockFrames,
+                                       std::min(heard, static_cast<double>(point.frames)));
+    }
+    clock.frames = m_sampleClockFrames;
+
+    // The frame heard now is as far behind the last one the sink took as
+    // the clock is; carry the beat from where the renderer left it
+    if (clock.running && beat.valid && beat.session == point.session && beat.sampleRate == point.sampleRate) {
+        const double renderFrame = static_cast<double>(point.renderFrames)
+                - (static_cast<double>(point.frames) - clock.frames);
+        const double cycles = beat.phase + (renderFrame - static_cast<double>(beat.frames)) * beat.hz / beat.sampleRate;
+        clock.beatValid = true;
+        clock.beatPhase = cycles - std::floor(cycles);
+        clock.beatHz = beat.hz;
+    }
+    return clock;
+}
+
+// ============================================================
+// OUTPUT LATENCY
+// ============================================================
+
+DynamicEngine::LatencySettings DynamicEngine::latencySettings(LatencyProfile profile)
+{
+    switch (profile) {
+    case LOW_LATENCY:
+        return { 10, 10 };
+    case POWER_SAVING_LATENCY:
+        return { 400, 100 };
+    case BALANCED_LATENCY:
+    default:
+        return { 60, DEFAULT_RENDER_AHEAD_MS };
+    }
+}
+
+bool DynamicEngine::openSink(quint64 generation)
+{
+    if (m_outputBackend != DEVICE_OUTPUT) {
+        return openNullSink();
+    }
+    if (!initializeAudioOutput()) {
+        return false;
+    }
+
+    // State changes reach the GUI thread tagged with the sink's generation
+    QAudioSink *sink = m_audioOutput;
+    connect(sink, &QAudioSink::stateChanged, m_audioContext, [this, sink, generation](QAudio::State state) {
+        const QAudio::Error error = sink->error();
+        if (state == QAudio::IdleState && error == QAudio::UnderrunError) {
+            countSinkUnderrun();
+        }
+        QMetaObject::invokeMethod(this, [this, state, error, generation]() {
+            if (generation == m_sinkGeneration) {
+                handleAudioStateChanged(state, error);
+            }
+        }, Qt::QueuedConnection);
+    });
+
+    m_audioOutput->start(m_sinkDevice);
+    m_sinkBufferBytes = m_audioOutput->bufferSize();
+    return true;
+}
+
+void DynamicEngine::closeSink()
+{
+    if (m_audioOutput) {
+        m_audioOutput->stop();
+        delete m_audioOutput;
+        m_audioOutput = nullptr;
+    }
+    delete m_nullSink; // Finishes its WAV file
+    m_nullSink = nullptr;
+    m_sinkBufferBytes = 0;
+}
+
+// Reopens the sink with the current m_sinkBufferMs; the render-ahead
+// ring and its contents carry over
+bool DynamicEngine::restartSink()
+{
+    const quint64 generation = ++m_sinkGeneration;
+    m_lastCallbackNs = -1;
+
+    bool reopened = false;
+    runOnAudioThread([this, generation, &reopened]() {
+        // A NullSink resizes in place, so a file being written continues
+        if (m_nullSink) {
+            m_nullSink->setBufferMs(m_sinkBufferMs);
+            m_sinkBufferBytes = m_nullSink->bufferSize();
+            reopened = true;
+            return;
+        }
+        closeSink();
+        reopened = openSink(generation);
+    });
+
+    if (!reopened) {
+        abortOutput();
+        return false;
+    }
+
+    emit latencyChanged(outputLatencyMs());
+    return true;
+}
+
+void DynamicEngine::setLatencyProfile(LatencyProfile profile)
+{
+    m_latencyProfile = profile;
+    m_stableChecks = 0;
+    m_sinkStableChecks = 0;
+
+    const LatencySettings latency = latencySettings(profile);
+    setRenderAheadMs(latency.renderAheadMs);
+
+    if (m_sinkBufferMs != latency.sinkBufferMs) {
+        m_sinkBufferMs = latency.sinkBufferMs;
+        if (m_outputRunning) {
+            restartSink();
+            return;
+        }
+    }
+
+    emit latencyChanged(outputLatencyMs());
+}
+
+DynamicEngine::LatencyProfile DynamicEngine::getLatencyProfile() const
+{
+    return m_latencyProfile;
+}
+
+void DynamicEngine::setAdaptiveLatency(bool enabled)
+{
+    m_adaptiveLatency = enabled;
+    m_stableChecks = 0;
+    if (enabled && m_outputRunning) {
+        m_adaptTimer->start();
+    } else {
+        m_adaptTimer->stop();
+    }
+}
+
+bool DynamicEngine::isAdaptiveLatency() const
+{
+    return m_adaptiveLatency;
+}
+
+double DynamicEngine::outputLatencyMs() const
+{
+    const qint64 sinkBytes = m_sinkBufferBytes;
+    const double sinkMs = sinkBytes > 0 ? m_audioFormat.durationForBytes(sinkBytes) / 1000.0
+                                        : m_sinkBufferMs;
+    return sinkMs + m_renderAheadMs;
+}
+
+// Counts since the last check; stats reset elsewhere restart from zero
+static quint64 takeNewEvents(quint64 total, quint64 &seen)
+{
+    const quint64 fresh = total >= seen ? total - seen : total;
+    seen = total;
+    return fresh;
+}
+
+void DynamicEngine::adaptLatency()
+{
+    if (!m_outputRunning) {
+        return;
+    }
+
+    const RenderAheadStats stats = renderAheadStats();
+    const quint64 sinkUnderruns = takeNewEvents(underrunCount(), m_seenSinkUnderruns);
+    const quint64 renderUnderruns = takeNewEvents(stats.underruns, m_seenRenderUnderruns);
+    const quint64 renderOverruns = takeNewEvents(stats.overruns, m_seenRenderOverruns);
+
+    // The device ran dry: only a larger sink buffer helps. Running dry
+    // again soon after a shrink doubles the quiet spell the next shrink
+    // waits for, so a size that underruns is not retried every minute.
+    if (sinkUnderruns > 0) {
+        if (m_sinkStableChecks < m_sinkShrinkChecks && m_sinkShrunk) {
+            m_sinkShrinkChecks = std::min(m_sinkShrinkChecks * 2, MAX_SINK_SHRINK_CHECKS);
+        }
+        m_sinkStableChecks = 0;
+        m_sinkShrunk = false;
+        if (m_sinkBufferMs < MAX_SINK_BUFFER_MS) {
+            m_stableChecks = 0;
+            m_sinkBufferMs = std::min(MAX_SINK_BUFFER_MS, m_sinkBufferMs * 2);
+            restartSink();
+            return;
+        }
+    }
+
+    // Rendering fell behind or came close: more lookahead
+    if (renderUnderruns > 0 || renderOverruns > 0) {
+        m_stableChecks = 0;
+        if (m_renderAheadMs < MAX_RENDER_AHEAD_MS) {
+            setRenderAheadMs(m_renderAheadMs * 2);
+            emit latencyChanged(outputLatencyMs());
+        }
+        return;
+    }
+
+    // A long quiet spell on a grown sink buffer: halve it, down to the
+    // profile's size. Reopening the sink may click, hence the wait.
+    const int baseSinkBufferMs = latencySettings(m_latencyProfile).sinkBufferMs;
+    if (++m_sinkStableChecks >= m_sinkShrinkChecks && m_sinkBufferMs > baseSinkBufferMs) {
+        m_sinkStableChecks = 0;
+        m_sinkShrunk = true;
+        m_sinkBufferMs = std::max(baseSinkBufferMs, m_sinkBufferMs / 2);
+        restartSink();
+        return;
+    }
+
+    const int baseRenderAheadMs = latencySettings(m_latencyProfile).renderAheadMs;
+    if (++m_stableChecks >= ADAPT_STABLE_CHECKS && m_renderAheadMs > baseRenderAheadMs) {
+        m_stableChecks = 0;
+        setRenderAheadMs(std::max(baseRenderAheadMs, m_renderAheadMs * 3 / 4));
+        emit latencyChanged(outputLatencyMs());
+    }
+}
+
+// ============================================================
+// AMBIENT BUS
+// ============================================================
+
+bool DynamicEngine::checkAmbientLayer(int layer)
+{
+    if (layer < 0 || layer >= MAX_AMBIENT_LAYERS) {
+        emit errorOccurred(QString("Invalid ambient layer: %1").arg(layer));
+        return false;
+    }
+    return true;
+}
+
+void DynamicEngine::publishAmbient()
+{
+    DynamicRenderer::AmbientBus &bus = m_ambientBuffer.writeBuffer();
+    for (int i = 0; i < MAX_AMBIENT_LAYERS; ++i) {
+        bus.layers[i] = m_ambientLayers[i];
+    }
+    m_ambientBuffer.publish();
+}
+
+void DynamicEngine::loadAmbientLayer(int layer, const QString &filePath)
+{
+    if (!checkAmbientLayer(layer)) {
+        return;
+    }
+
+    if (!m_ambientCache) {
+        m_ambientCache = std::make_unique<AmbientCache>();
+    }
+
+    AmbientDecoder *&decoder = m_ambientDecoders[layer];
+    if (!decoder) {
+        decoder = new AmbientDecoder(m_ambientCache.get(), this);
+        connect(decoder, &AmbientDecoder::finished, this, [this, layer]() {
+            handleAmbientDecoded(layer);
+        });
+        connect(decoder, &AmbientDecoder::errorOccurred, this, [this, layer](const QString &message) {
+            emit errorOccurred(message);
+            emit ambientLayerStateChanged(layer);
+        });
+    }
+
+    // The old clip keeps playing until the new one is ready
+    const int rate = QMediaDevices::defaultAudioOutput().preferredFormat().sampleRate();
+    decoder->start(filePath, rate >= 8000 && rate <= 192000 ? rate : m_sampleRate);
+}
+
+void DynamicEngine::handleAmbientDecoded(int layer)
+{
+    AmbientLayerParameters &params = m_ambientLayers[layer];
+    params.clip = m_ambientDecoders[layer]->clip();
+    buildAmbientLoop(layer);
+    params.seekFrame = 0;
+    ++params.seekId;
+    m_ambientPositions[layer] = 0;
+    publishAmbient();
+
+    emit ambientLayerLoaded(layer, params.clip->durationMs());
+    if (params.playing && !updateOutputState()) {
+        params.playing = false;
+        publishAmbient();
+    }
+    emit ambientLayerStateChanged(layer);
+}
+
+void DynamicEngine::clearAmbientLayer(int layer)
+{
+    if (!checkAmbientLayer(layer)) {
+        return;
+    }
+
+    m_ambientLayers[layer].clip.reset();
+    m_ambientLayers[layer].loop.reset();
+    m_ambientLayers[layer].playing = false;
+    publishAmbient();
+    updateOutputState();
+    emit ambientLayerStateChanged(layer);
+}
+
+bool DynamicEngine::isAmbientLayerLoaded(int layer) const
+{
+    return layer >= 0 && layer < MAX_AMBIENT_LAYERS && m_ambientLayers[layer].clip;
+}
+
+void DynamicEngine::playAmbientLayer(int layer)
+{
+    if (!checkAmbientLayer(layer) || m_ambientLayers[layer].playing) {
+        return;
+    }
+
+    m_ambientLayers[layer].playing = true;
+    publishAmbient();
+    if (!updateOutputState()) {
+        m_ambientLayers[layer].playing = false;
+        publishAmbient();
+    }
+    emit ambientLayerStateChanged(layer);
+}
+
+void DynamicEngine::pauseAmbientLayer(int layer)
+{
+    if (!checkAmbientLayer(layer) || !m_ambientLayers[layer].playing) {
+        return;
+    }
+
+    m_ambientLayers[layer].playing = false;
+    publishAmbient();
+    updateOutputState();
+    emit ambientLayerStateChanged(layer);
+}
+
+void DynamicEngine::stopAmbientLayer(int layer)
+{
+    if (!checkAmbientLayer(layer)) {
+        return;
+    }
+
+    m_ambientLayers[layer].playing = false;
+    seekAmbientLayer(layer, 0);
+    updateOutputState();
+    emit ambientLayerStateChanged(layer);
+}
+
+bool DynamicEngine::isAmbientLayerPlaying(int layer) const
+{
+    return layer >= 0 && layer < MAX_AMBIENT_LAYERS && m_ambientLayers[layer].playing;
+}
+
+bool DynamicEngine::isAmbientPlaying() const
+{
+    for (const AmbientLayerParameters &layer : m_ambientLayers) {
+        if (layer.playing && layer.clip) {
+            return true;
+        }
+    }
+    return false;
+}
+
+void DynamicEngine::setAmbientLayerGain(int layer, double gain)
+{
+    if (!checkAmbientLayer(layer)) {
+        return;
+    }
+
+    m_ambientLayers[layer].gain = static_cast<float>(std::clamp(gain, 0.0, 1.0));
+    publishAmbient();
+}
+
+void DynamicEngine::setAmbientLayerLooping(int layer, bool looping)
+{
+    if (!checkAmbientLayer(layer)) {
+        return;
+    }
+
+    m_ambientLayers[layer].looping = looping;
+    publishAmbient();
+}
+
+void DynamicEngine::setAmbientCrossfadeMs(int ms)
+{
+    ms = std::clamp(ms, 0, AmbientLoop::MAX_CROSSFADE_MS);
+    if (ms == m_ambientCrossfadeMs) {
+        return;
+    }
+
+    m_ambientCrossfadeMs = ms;
+    for (int i = 0; i < MAX_AMBIENT_LAYERS; ++i) {
+        buildAmbientLoop(i);
+    }
+    publishAmbient();
+}
+
+int DynamicEngine::ambientCrossfadeMs() const
+{
+    return m_ambientCrossfadeMs;
+}
+
+// Finds the loop region and renders its seam (GUI thread, once per
+// clip and crossfade length; the render path only reads the result)
+void DynamicEngine::buildAmbientLoop(int layer)
+{
+    AmbientLayerParameters &params = m_ambientLayers[layer];
+    if (!params.clip) {
+        params.loop.reset();
+        return;
+    }
+
+    const int crossfadeFrames = static_cast<int>(
+            static_cast<qint64>(m_ambientCrossfadeMs) * params.clip->sampleRate() / 1000);
+    params.loop = std::make_shared<const AmbientLoop>(*params.clip, crossfadeFrames);
+}
+
+void DynamicEngine::seekAmbientLayer(int layer, qint64 ms)
+{
+    if (!checkAmbientLayer(layer)) {
+        return;
+    }
+
+    AmbientLayerParameters &params = m_ambientLayers[layer];
+    const int rate = params.clip ? params.clip->sampleRate() : 0;
+    params.seekFrame = std::max<qint64>(0, ms) * rate / 1000;
+    ++params.seekId;
+    m_ambientPositions[layer] = params.seekFrame;
+    publishAmbient();
+}
+
+qint64 DynamicEngine::ambientLayerPosition(int layer) const
+{
+    if (!isAmbientLayerLoaded(layer)) {
+        return 0;
+    }
+    return m_ambientPositions[layer].load(std::memory_order_relaxed) * 1000
+            / m_ambientLayers[layer].clip->sampleRate();
+}
+
+qint64 DynamicEngine::ambientLayerDuration(int layer) const
+{
+    return isAmbientLayerLoaded(layer) ? m_ambientLayers[layer].clip->durationMs() : 0;
+}
+
+qint64 DynamicEngine::ambientLayerLoadMs(int layer) const
+{
+    return isAmbientLayerLoaded(layer) ? m_ambientDecoders[layer]->loadMs() : -1;
+}
+
+bool DynamicEngine::isAmbientLayerCacheHit(int layer) const
+{
+    return isAmbientLayerLoaded(layer) && m_ambientDecoders[layer]->isCacheHit();
+}
+
+// A layer without looping ran off its end; ignored if it was moved since
+void DynamicEngine::handleAmbientLayerEnded(int layer, quint64 seekId)
+{
+    AmbientLayerParameters &params = m_ambientLayers[layer];
+    if (params.seekId != seekId || !params.playing) {
+        return;
+    }
+
+    params.playing = false;
+    seekAmbientLayer(layer, 0);
+    updateOutputState();
+    emit ambientLayerStateChanged(layer);
+}
+
+// The sink failed: tones and layers stop alike
+void DynamicEngine::abortOutput()
+{
+    for (int i = 0; i < MAX_AMBIENT_LAYERS; ++i) {
+        if (m_ambientLayers[i].playing) {
+            m_ambientLayers[i].playing = false;
+            emit ambientLayerStateChanged(i);
+        }
+    }
+    publishAmbient();
+    stop();
+}
+
+// ============================================================
+// OUTPUT FORMAT
+// ============================================================
+
+void DynamicEngine::setNativeFormat(bool enabled)
+{
+    m_nativeFormat = enabled;
+}
+
+bool DynamicEngine::isNativeFormat() const
+{
+    return m_nativeFormat;
+}
+
+QAudioFormat DynamicEngine::outputFormat() const
+{
+    return m_audioFormat;
+}
+
+bool DynamicEngine::negotiateAudioFormat()
+{
+    if (m_outputBackend != DEVICE_OUTPUT) {
+        QAudioFormat format;
+        format.setSampleRate(m_requestedSampleRate);
+        format.setChannelCount(2);
+        format.setSampleFormat(m_nativeFormat ? QAudioFormat::Float : QAudioFormat::Int16);
+        applyAudioFormat(format);
+        return true;
+    }
+
+    const QAudioDevice audioDevice = QMediaDevices::defaultAudioOutput();
+    if (audioDevice.isNull()) {
+        emit errorOccurred("No audio output device available");
+        return false;
+    }
+
+    // Most preferred first
+    struct Candidate {
+        int sampleRate;
+        QAudioFormat::SampleFormat sampleFormat;
+    };
+    QVector<Candidate> candidates;
+    const int nativeRate = audioDevice.preferredFormat().sampleRate();
+    if (m_nativeFormat && nativeRate >= 8000 && nativeRate <= 192000) {
+        candidates.append({ nativeRate, QAudioFormat::Float });
+        candidates.append({ nativeRate, QAudioFormat::Int16 });
+    }
+    candidates.append({ m_requestedSampleRate, QAudioFormat::Int16 });
+    if (m_nativeFormat) {
+        candidates.append({ m_requestedSampleRate, QAudioFormat::Float });
+    }
+
+    for (const Candidate &candidate : candidates) {
+        QAudioFormat format;
+        format.setSampleRate(candidate.sampleRate);
+        format.setChannelCount(2);
+        format.setSampleFormat(candidate.sampleFormat);
+        if (audioDevice.isFormatSupported(format)) {
+            applyAudioFormat(format);
+            return true;
+        }
+    }
+
+    emit errorOccurred("Audio format not supported by device");
+    return false;
+}
+
+void DynamicEngine::applyAudioFormat(const QAudioFormat &format)
+{
+    m_audioFormat = format;
+    m_sampleRate = format.sampleRate();
+    m_bytesPerFrame = format.bytesPerFrame();
+    publishParameters();
+}
+
+void DynamicEngine::restoreRequestedFormat()
+{
+    m_sampleRate = m_requestedSampleRate;
+    initializeAudioFormat();
+    publishParameters();
+}
+
+// ============================================================
+// OUTPUT BACKEND
+// ============================================================
+
+void DynamicEngine::setOutputBackend(OutputBackend backend, const QString &filePath)
+{
+    if (backend == FILE_OUTPUT && filePath.isEmpty()) {
+        emit errorOccurred("File output needs a file path");
+        return;
+    }
+
+    m_outputBackend = backend;
+    m_outputFilePath = backend == FILE_OUTPUT ? filePath : QString();
+}
+
+DynamicEngine::OutputBackend DynamicEngine::outputBackend() const
+{
+    return m_outputBackend;
+}
+
+bool DynamicEngine::openNullSink()
+{
+    // No parent: like the QAudioSink, it lives on the audio thread
+    m_nullSink = new NullSink(m_audioFormat, m_sinkBufferMs);
+    connect(m_nullSink, &NullSink::underrun, m_audioContext, [this]() {
+        countSinkUnderrun();
+    });
+
+    if (!m_nullSink->start(m_sinkDevice, m_outputFilePath)) {
+        emit errorOccurred(m_nullSink->errorString());
+        delete m_nullSink;
+        m_nullSink = nullptr;
+        return false;
+    }
+
+    m_sinkBufferBytes = m_nullSink->bufferSize();
+    return true;
+}
+
+// ============================================================
+// TONE VOICES
+// ============================================================
+
+bool DynamicEngine::validateVoice(const Voice &voice)
+{
+    if (voice.toneType < 0 || voice.toneType > 1) {
+        emit errorOccurred(QString("Invalid voice tone type: %1").arg(voice.toneType));
+        return false;
+    }
+    if (!validateFrequency(voice.leftFrequency)
+            || (voice.toneType == 0 && !validateFrequency(voice.rightFrequency))) {
+        emit errorOccurred(QString("Invalid voice frequency: %1/%2 Hz")
+                           .arg(voice.leftFrequency).arg(voice.rightFrequency));
+        return false;
+    }
+    if (voice.toneType == 1 && (voice.pulseFrequency < 0.1 || voice.pulseFrequency > 100.0)) {
+        emit errorOccurred(QString("Invalid voice pulse frequency: %1 Hz").arg(voice.pulseFrequency));
+        return false;
+    }
+    if (voice.waveform < SINE_WAVE || voice.waveform > SAWTOOTH_WAVE) {
+        emit errorOccurred(QString("Invalid voice waveform: %1").arg(voice.waveform));
+        return false;
+    }
+    if (!validateAmplitude(voice.gain)) {
+        emit errorOccurred(QString("Invalid voice gain: %1").arg(voice.gain));
+        return false;
+    }
+    return true;
+}
+
+void DynamicEngine::publishVoices()
+{
+    DynamicRenderer::VoiceBank &bank = m_voiceBuffer.writeBuffer();
+    for (int i = 0; i < MAX_VOICES; ++i) {
+        const Voice &voice = m_voices[i].voice;
+        DynamicRenderer::VoiceSlot &slot = bank.voices[i];
+        slot.voice.toneType = voice.toneType;
+        slot.voice.leftFrequency = voice.leftFrequency;
+        slot.voice.rightFrequency = voice.rightFrequency;
+        slot.voice.pulseFrequency = voice.pulseFrequency;
+        slot.voice.waveform = static_cast<DynamicRenderer::Waveform>(voice.waveform);
+        slot.voice.gain = voice.gain;
+        slot.active = m_voices[i].active;
+        slot.serial = m_voices[i].serial;
+    }
+    m_voiceBuffer.publish();
+}
+
+int DynamicEngine::addVoice(const Voice &voice)
+{
+    if (!validateVoice(voice)) {
+        return -1;
+    }
+
+    for (int slot = 0; slot < MAX_VOICES; ++slot) {
+        if (!m_voices[slot].active) {
+            m_voices[slot].voice = voice;
+            m_voices[slot].active = true;
+            m_voices[slot].serial = ++m_voiceSerial;
+            publishVoices();
+            return slot;
+        }
+    }
+
+    emit errorOccurred(QString("Voice pool full (%1 voices)").arg(MAX_VOICES));
+    return -1;
+}
+
+// Glides frequencies and gain to the new values; a changed tone type
+// keeps the running oscillators
+bool DynamicEngine::setVoice(int slot, const Voice &voice)
+{
+    if (slot < 0 || slot >= MAX_VOICES || !m_voices[slot].active) {
+        emit errorOccurred(QString("Invalid voice: %1").arg(slot));
+        return false;
+    }
+    if (!validateVoice(voice)) {
+        return false;
+    }
+
+    m_voices[slot].voice = voice;
+    publishVoices();
+    return true;
+}
+
+void DynamicEngine::removeVoice(int slot)
+{
+    if (slot < 0 || slot >= MAX_VOICES || !m_voices[slot].active) {
+        return;
+    }
+
+    m_voices[slot].active = false;
+    publishVoices();
+}
+
+void DynamicEngine::removeAllVoices()
+{
+    for (VoiceSlot &slot : m_voices) {
+        slot.active = false;
+    }
+    publishVoices();
+}
+
+int DynamicEngine::voiceCount() const
+{
+    return static_cast<int>(std::count_if(std::begin(m_voices), std::end(m_voices),
+                                          [](const VoiceSlot &slot) { return slot.active; }));
+}
+
+DynamicEngine::Voice DynamicEngine::voice(int slot) const
 {
-    m_pinkB0 = 0.0;
-    m_pinkB1 = 0.0;
-    m_pinkB2 = 0.0;
-    m_pinkB3 = 0.0;
-    m_pinkB4 = 0.0;
-    m_pinkB5 = 0.0;
-    m_pinkB6 = 0.0;
-    m_brownState = 0.0;
+    return (slot >= 0 && slot < MAX_VOICES) ? m_voices[slot].voice : Voice();
 }
@@ -5,10 +5,26 @@
 #include <QAudioSink>
 #include <QAudioFormat>
 #include <QBuffer>
+#include <QElapsedTimer>
 #include <QIODevice>
 #include <QMediaDevices>
+#include <QThread>
+#include <QTimer>
 #include <atomic>
 #include <cmath>
+#include <functional>
+#include <memory>
+#include "ambientcache.h"
+#include "ambientclip.h"
+#include "ambientloop.h"
+#include "dynamicrenderer.h"
+#include "levelmeter.h"
+#include "loghistogram.h"
+#include "ringbuffer.h"
+#include "triplebuffer.h"
+
+class AmbientDecoder;
+class NullSink;
 
 class DynamicEngine : public QObject
 {
@@ -23,6 +39,33 @@ public:
     };
     Q_ENUM(Waveform)
 
+    enum OscillatorMode {
+        EXACT_OSCILLATOR = 0,     // std::sin per sample
+        WAVETABLE_OSCILLATOR = 1  // Interpolated table / phasor
+    };
+    Q_ENUM(OscillatorMode)
+
+    enum FadeCurve {
+        LINEAR_FADE = 0,
+        SMOOTH_FADE = 1,      // Raised cosine (S-curve)
+        EXPONENTIAL_FADE = 2  // Equal steps in dB, -60 dB floor
+    };
+    Q_ENUM(FadeCurve)
+
+    enum LatencyProfile {
+        LOW_LATENCY = 0,          // ~20 ms, for live sweeps
+        BALANCED_LATENCY = 1,     // ~100 ms
+        POWER_SAVING_LATENCY = 2  // ~500 ms, fewest wakeups
+    };
+    Q_ENUM(LatencyProfile)
+
+    enum OutputBackend {
+        DEVICE_OUTPUT = 0, // Default audio output device
+        NULL_OUTPUT = 1,   // Paced like a device, audio discarded
+        FILE_OUTPUT = 2    // Paced like a device, audio appended to a WAV file
+    };
+    Q_ENUM(OutputBackend)
+
     explicit DynamicEngine(QObject *parent = nullptr);
     ~DynamicEngine();
 
@@ -42,6 +85,23 @@ public:
     void setWaveform(Waveform type);
     Waveform getWaveform() const;
 
+    void setOscillatorMode(OscillatorMode mode);
+    OscillatorMode getOscillatorMode() const;
+
+    void setToneType(int toneType); // 0=Binaural, 1=Isochronic, 2=Generator
+    int getToneType() const;
+
+    // Parameter hand-over statistics. The render path takes at most one
+    // snapshot per block (coalescing the rest) and ramps to it across
+    // that block. Render-ahead top-ups make blocks anywhere from
+    // RENDER_AHEAD_QUANTUM to BLOCK_FRAMES frames, so
+    // maxParameterUpdateRate() is measured: blocks rendered per second of
+    // audio so far, the highest update rate absorbed glitch-free.
+    // Before anything is rendered it is the full-block rate.
+    quint64 parameterUpdatesPublished() const;
+    quint64 parameterUpdatesApplied() const;
+    double maxParameterUpdateRate() const;
+
     void setAmplitude(double amplitude);
     void setVolume(double volume);
 
@@ -77,13 +137,17 @@ signals:
     void bufferUnderrun();
     void parametersUpdated();
     void audioLevelChanged(double peakLevel);
+    void fadeFinished(double volume);
+    void latencyChanged(double milliseconds);
+    void ambientLayerLoaded(int layer, qint64 durationMs);
+    void ambientLayerStateChanged(int layer);
 
 private slots:
-    void handleAudioStateChanged(QAudio::State state);
+    void handleAudioStateChanged(QAudio::State state, QAudio::Error error);
 
 private:
     void initializeAudioFormat();
-    bool initializeAudioOutput();
+    bool initializeAudioOutput(); // Audio thread
     void generateAudioBuffer(int durationMs = 300000); // Creates empty buffer
     double calculateSineSample(double phase);
     double calculateSquareSample(double phase);
@@ -104,6 +168,18 @@ private:
 
     bool startDynamicPlayback();
     void stopDynamicPlayback();
+    bool startOutput(); // Sink and render-ahead, for tones or ambient layers
+    void stopOutput();
+
+    // Everything the render path needs, published as one consistent set
+    void publishParameters(); // GUI thread only (single writer)
+
+    TripleBuffer<DynamicRenderer::Parameters> m_parameterBuffer;
+    quint64 m_parameterVersion = 0; // Snapshots published
+    std::atomic<quint64> m_parameterUpdatesApplied{0};
+    std::atomic<quint64> m_renderedBlocks{0}; // Snapshot pick-up points
+    std::atomic<quint64> m_renderedFrames{0};
+    int m_toneType = 0;
 
     QAudioSink *m_audioOutput;
     QBuffer *m_audioBuffer;
@@ -114,12 +190,14 @@ private:
     std::atomic<double> m_amplitude;
     std::atomic<double> m_outputVolume;
     std::atomic<Waveform> m_currentWaveform;
+    std::atomic<OscillatorMode> m_oscillatorMode;
 
     double m_phaseLeft;
     double m_phaseRight;
 
-    std::atomic<bool> m_isPlaying;
+    std::atomic<bool> m_isPlaying; // Tones
     std::atomic<bool> m_parametersChanged;
+    bool m_outputRunning = false;  // Sink, also for ambient layers alone
 
     int m_sampleRate;
     qint64 m_bufferDurationMs;
@@ -129,7 +207,7 @@ private:
     static constexpr double MAX_FREQUENCY = 20000.0;
     static constexpr double MIN_AMPLITUDE = 0.0;
     static constexpr double MAX_AMPLITUDE = 1.0;
-    static constexpr double DEFAULT_AMPLITUDE = 0.3;
+    static constexpr double DEFAULT_AMPLITUDE = DynamicRenderer::DEFAULT_AMPLITUDE;
     static constexpr double DEFAULT_VOLUME = 0.15;
 
     QIODevice* m_dynamicDevice;
@@ -146,23 +224,473 @@ private:
         double getNoiseLevel() const;
         bool isNoiseEnabled() const;
 
-    private:
-        double generateWhiteNoise();
-        double generatePinkNoise();
-        double generateBrownNoise();
-        double generateGreyNoise();
+        // Reproducible noise: reseeds the playing renderer's generator
+        // (applied on the next block); every start() begins from the
+        // seed, a random one until this is called
+        void setNoiseSeed(quint64 seed);
 
+    private:
         void resetNoiseState();
 
         std::atomic<int> m_noiseType{0};        // 0=Off, 1=White, 2=Pink, 3=Brown 4=Grey
         std::atomic<double> m_noiseLevel{0.3};  // 0.0-1.0
         std::atomic<bool> m_noiseEnabled{false};
 
-        // Pink noise filter state
-        double m_pinkB0{0.0}, m_pinkB1{0.0}, m_pinkB2{0.0};
-        double m_pinkB3{0.0}, m_pinkB4{0.0}, m_pinkB5{0.0}, m_pinkB6{0.0};
-        // Brown noise state
-        double m_brownState{0.0};
+        // Generator and filter state are touched only by the render path;
+        // GUI-side resets and reseeds are handed over through these flags
+        std::atomic<bool> m_noiseResetPending{false};
+        std::atomic<bool> m_noiseReseedPending{false};
+        std::atomic<quint64> m_noiseSeed{0};
+
+    // ============================================================
+    // OUTPUT GAIN ENVELOPES
+    // ============================================================
+    // Output volume is applied per sample in the render path (the sink
+    // itself stays at unity). setVolume() ramps over VOLUME_RAMP_MS;
+    // fadeTo() runs a longer envelope and reports completion through
+    // fadeFinished(), also when a later volume change supersedes it.
+    public:
+        void fadeTo(double volume, int durationMs, FadeCurve curve = LINEAR_FADE);
+        bool isFading() const;
+
+    private:
+        void publishEnvelope(double target, qint64 durationFrames, FadeCurve curve);
+        qint64 framesForMs(int ms) const;
+        void handleEnvelopeFinished(quint64 id);
+
+        static constexpr int VOLUME_RAMP_MS = 20;
+
+        TripleBuffer<DynamicRenderer::GainEnvelope> m_envelopeBuffer;
+        quint64 m_envelopeId = 0;
+        bool m_fading = false;
+        // Id of the last envelope the render path completed, 0 once
+        // handled; polled with the levels
+        std::atomic<quint64> m_finishedEnvelopeId{0};
+
+    // ============================================================
+    // AUDIO THREAD
+    // ============================================================
+    // The sink and its device live on a dedicated time-critical thread,
+    // so the render callback keeps running while the GUI thread blocks.
+    // start() and stop() hand over to that thread and wait for it;
+    // parameters reach the render path through the lock-free snapshots
+    // above. audioOutput() belongs to the audio thread: control it
+    // through setMuted() rather than directly.
+    public:
+        void setMuted(bool muted);
+        bool isMuted() const;
+
+        quint64 framesDelivered() const; // Audio frames handed to the sink
+        quint64 underrunCount() const;  // Sink starved while playing
+
+    private:
+        void ensureAudioThread();
+        void runOnAudioThread(const std::function<void()> &task);
+
+        QThread *m_audioThread = nullptr;
+        QObject *m_audioContext = nullptr; // Lives on m_audioThread
+        quint64 m_sinkGeneration = 0;
+        std::atomic<bool> m_muted{false};
+        std::atomic<quint64> m_framesDelivered{0};
+        std::atomic<quint64> m_underrunCount{0};
+
+    // ============================================================
+    // RENDER-AHEAD BUFFER
+    // ============================================================
+    // During playback a render thread keeps a ring buffer filled
+    // renderAheadMs() ahead of the sink, whose callback only copies out
+    // of it, so a slow block is absorbed by the lookahead instead of
+    // reaching the device. Parameter changes are heard after the
+    // lookahead. If the ring runs dry the sink gets silence and the
+    // underrun is counted.
+    public:
+        struct RenderAheadStats {
+            qint64 lookaheadFrames = 0;
+            qint64 fillFrames = 0;
+            qint64 lowWatermarkFrames = 0; // Lowest fill the sink has seen
+            quint64 underruns = 0;
+            quint64 overruns = 0;          // Chunks that took longer to render than to play
+        };
+
+        void setRenderAheadMs(int ms); // Takes effect immediately, also while playing
+        int renderAheadMs() const;
+        RenderAheadStats renderAheadStats() const;
+        void resetRenderAheadStats();   // Restarts watermark, underrun and overrun counts
+
+        static constexpr int MIN_RENDER_AHEAD_MS = 5;
+        static constexpr int MAX_RENDER_AHEAD_MS = 1000;
+        static constexpr int DEFAULT_RENDER_AHEAD_MS = 40;
+
+    private:
+        class RenderAheadDevice;
+
+        bool topUpRenderAhead(); // Renders one chunk if below the lookahead
+        qint64 renderAheadFillFrames() const;
+        void stopRenderAhead();
+        qint64 renderAheadFrames() const;
+
+        // Smallest chunk rendered to top up the ring
+        static constexpr int RENDER_AHEAD_QUANTUM = 128;
+
+        RingBuffer<char> *m_renderAhead = nullptr;    // Interleaved stereo in the output format
+        QThread *m_renderThread = nullptr;
+        QIODevice *m_sinkDevice = nullptr;            // Reads m_renderAhead
+        std::atomic<bool> m_renderThreadRunning{false};
+        std::atomic<int> m_renderAheadMs{DEFAULT_RENDER_AHEAD_MS};
+        std::atomic<qint64> m_renderAheadLowWatermark{0};
+        std::atomic<quint64> m_renderAheadUnderruns{0};
+        std::atomic<quint64> m_renderAheadOverruns{0};
+
+    // ============================================================
+    // CALLBACK TELEMETRY
+    // ============================================================
+    // How close the audio path runs to its deadlines, recorded while
+    // playing: the render thread's time per block and its share of the
+    // block's duration, and the interval between sink callbacks. A
+    // callback is late when it comes more than the sink buffer's
+    // duration after the previous one, i.e. the device buffer had time
+    // to run dry. Histograms are lock-free; poll callbackTelemetry()
+    // from the GUI thread.
+    public:
+        struct CallbackTelemetry {
+            int sampleRate = 0;
+            double sinkBufferMs = 0.0;
+            double renderAheadMs = 0.0;
+            LogHistogram::Snapshot renderTimeNs;       // Per rendered block
+            LogHistogram::Snapshot budgetPermyriad;    // Render time / block duration, 10000 = 100 %
+            LogHistogram::Snapshot callbackIntervalNs; // Between sink callbacks
+            quint64 lateCallbacks = 0;
+            quint64 sinkUnderruns = 0;
+            quint64 renderAheadUnderruns = 0;
+        };
+
+        static constexpr quint64 FULL_BUDGET = 10000; // budgetPermyriad of a block rendered in real time
+
+        CallbackTelemetry callbackTelemetry() const;
+        void resetCallbackTelemetry();
+
+    private:
+        void countSinkUnderrun(); // Audio thread
+
+        QElapsedTimer m_telemetryClock;
+        LogHistogram m_renderTimeHistogram;        // Render thread writes
+        LogHistogram m_budgetHistogram;            // Render thread writes
+        LogHistogram m_callbackIntervalHistogram;  // Audio thread writes
+        std::atomic<qint64> m_lastCallbackNs{-1};  // On m_telemetryClock, -1 before the first
+        std::atomic<quint64> m_lateCallbacks{0};
+        std::atomic<quint64> m_telemetrySinkUnderruns{0};
+        std::atomic<quint64> m_telemetryRenderUnderruns{0};
+
+    // ============================================================
+    // LEVEL METER
+    // ============================================================
+    // Per-channel peak and RMS of each rendered block, measured by the
+    // output conversion as it writes the block. The render thread hands
+    // them over through a LevelMeter; while the output runs the GUI
+    // thread polls it every METER_INTERVAL_MS and emits
+    // audioLevelChanged(). Levels lead what is heard by the render-ahead
+    // lookahead. The same poll delivers envelope completions and ambient
+    // layer ends the render path reports.
+    public:
+        LevelMeter::Levels audioLevels() const; // As of the last audioLevelChanged()
+
+        static constexpr int METER_INTERVAL_MS = 33;
+
+    private:
+        void pollAudioLevels();
+
+        LevelMeter m_levelMeter;
+        LevelMeter::Levels m_audioLevels;
+        QTimer *m_meterTimer = nullptr;
+
+    // ============================================================
+    // OUTPUT TAP
+    // ============================================================
+    // A copy of the live output for analysis off the audio path:
+    // interleaved stereo float, as mixed before conversion. While the
+    // tap is enabled the render thread copies each block into a ring if
+    // the whole block fits and otherwise drops it; it never waits for
+    // the reader. One thread at a time reads with readOutputTap().
+    public:
+        void setOutputTapEnabled(bool enabled);
+        bool isOutputTapEnabled() const;
+        int readOutputTap(float *frames, int maxFrames); // Returns frames read
+        quint64 outputTapDrops() const;                  // Blocks dropped on a full ring
+
+        static constexpr int OUTPUT_TAP_FRAMES = 1 << 16; // ~1.4 s at 48 kHz
+
+    private:
+        std::unique_ptr<RingBuffer<float>> m_outputTap; // Created on first enable, kept until destruction
+        std::atomic<bool> m_outputTapEnabled{false};
+        std::atomic<quint64> m_outputTapDrops{0};
+
+    // ============================================================
+    // SAMPLE CLOCK
+    // ============================================================
+    // Position of the frame being heard now, on the output's timeline:
+    // frames handed to the sink (silence bridging an underrun included)
+    // minus what the sink reports still queued, as of the last sink
+    // callback, advanced by the time since at the output rate but never
+    // past what the sink was given. Monotonic for the life of the engine
+    // and still while the output is stopped, so visuals can follow the
+    // audio instead of a clock of their own.
+    //
+    // The render thread publishes the beat phase with the index of the
+    // frame it was reached at; the clock carries it forward to the frame
+    // being heard. The beat is the isochronic pulse (gate open for the
+    // first half cycle) or the binaural difference, right minus left
+    // phase, in phase at 0.
+    public:
+        struct SampleClock {
+            double frames = 0.0;    // Fractional, for sub-sample phase
+            int sampleRate = 0;     // Of the output the frames were counted at
+            bool running = false;   // Output started and the sink has pulled
+            bool beatValid = false; // Tones sounding with a beat
+            double beatPhase = 0.0; // Cycles [0, 1) at frames
+            double beatHz = 0.0;
+        };
+
+        SampleClock sampleClock(); // GUI thread
+
+    private:
+        // Published by the sink callback
+        struct ClockPoint {
+            quint64 frames = 0;       // Handed to the sink, after the callback
+            qint64 sinkFrames = 0;    // Queued in the sink, these included
+            quint64 renderFrames = 0; // Read from the render-ahead ring this session
+            quint64 session = 0;
+            qint64 timeNs = -1;       // On m_telemetryClock, -1 before the first callback
+            int sampleRate = 0;
+        };
+
+        // Published by the render thread after each block
+        struct BeatPoint {
+            quint64 frames = 0; // Rendered this session, after the block
+            quint64 session = 0;
+            double phase = 0.0; // Cycles [0, 1) after the block
+            double hz = 0.0;
+            int sampleRate = 0;
+            bool valid = false;
+        };
+
+        void publishClockPoint(qint64 frames); // Audio thread
+        qint64 sinkQueuedFrames() const;        // Audio thread
+
+        quint64 m_clockFrames = 0;       // Audio thread
+        quint64 m_clockRenderFrames = 0; // Audio thread, reset with the ring
+        quint64 m_renderSession = 0;     // Set before the ring is first read
+        TripleBuffer<ClockPoint> m_clockPoints;
+        TripleBuffer<BeatPoint> m_beatPoints;
+        double m_sampleClockFrames = 0.0; // Last reported, keeps the clock monotonic
+
+    // ============================================================
+    // OUTPUT LATENCY
+    // ============================================================
+    // Latency is the sink buffer plus the render-ahead lookahead, both
+    // set by the profile. The adaptive controller doubles the sink
+    // buffer when the device underruns (restarting the sink, which is
+    // glitching already) and the lookahead on render-ahead underruns or
+    // overruns; after ADAPT_STABLE_CHECKS quiet checks it eases the
+    // lookahead back toward the profile. A grown sink buffer is halved,
+    // down to the profile's size, after SINK_SHRINK_CHECKS checks with
+    // no device underrun (a minute; the restart may click). An underrun
+    // within that spell after a shrink doubles the spell for the next
+    // one, up to MAX_SINK_SHRINK_CHECKS, so the controller does not
+    // oscillate around a size the device cannot sustain. Every start()
+    // begins at the profile's sizes.
+    public:
+        void setLatencyProfile(LatencyProfile profile);
+        LatencyProfile getLatencyProfile() const;
+        void setAdaptiveLatency(bool enabled);
+        bool isAdaptiveLatency() const;
+        double outputLatencyMs() const;
+
+    private:
+        struct LatencySettings {
+            int sinkBufferMs;
+            int renderAheadMs;
+        };
+
+        static LatencySettings latencySettings(LatencyProfile profile);
+        bool openSink(quint64 generation); // Audio thread
+        void closeSink();                  // Audio thread
+        bool restartSink();
+        void adaptLatency();
+
+        static constexpr int MAX_SINK_BUFFER_MS = 1000;
+        static constexpr int ADAPT_INTERVAL_MS = 500;
+        static constexpr int ADAPT_STABLE_CHECKS = 20;
+        static constexpr int SINK_SHRINK_CHECKS = 120;
+        static constexpr int MAX_SINK_SHRINK_CHECKS = 1920; // 16 minutes
+
+        LatencyProfile m_latencyProfile = BALANCED_LATENCY;
+        bool m_adaptiveLatency = true;
+        int m_sinkBufferMs = 0;
+        std::atomic<qint64> m_sinkBufferBytes{0}; // Granted by the device
+        QTimer *m_adaptTimer = nullptr;
+        quint64 m_seenSinkUnderruns = 0;
+        quint64 m_seenRenderUnderruns = 0;
+        quint64 m_seenRenderOverruns = 0;
+        int m_stableChecks = 0;
+        int m_sinkStableChecks = 0;                   // Since the last device underrun or sink resize
+        int m_sinkShrinkChecks = SINK_SHRINK_CHECKS;  // Quiet checks a shrink waits for
+        bool m_sinkShrunk = false;                    // The last resize was a shrink
+
+    // ============================================================
+    // OUTPUT FORMAT
+    // ============================================================
+    // start() renders at the default device's preferred rate in Float32,
+    // so the sound server neither resamples nor converts and the int16
+    // quantize step is skipped. It falls back to Int16 at that
+    // rate, then to the setSampleRate() rate in Int16 and Float32. With
+    // native format off only setSampleRate() in Int16 is tried.
+    // getSampleRate() reports the negotiated rate while playing.
+    public:
+        void setNativeFormat(bool enabled); // Takes effect on the next start()
+        bool isNativeFormat() const;
+        QAudioFormat outputFormat() const;
+
+    private:
+        bool negotiateAudioFormat();
+        void applyAudioFormat(const QAudioFormat &format);
+        void restoreRequestedFormat();
+
+        bool m_nativeFormat = true;
+        int m_requestedSampleRate = 44100;
+        int m_bytesPerFrame = 2 * sizeof(int16_t);
+
+    // ============================================================
+    // OUTPUT BACKEND
+    // ============================================================
+    // Playback normally goes to the default device. The null and file
+    // backends replace the QAudioSink with a NullSink on the audio
+    // thread, which pulls at real-time rate, so the full playback path
+    // (render thread, render-ahead ring, latency control) runs on
+    // machines without sound hardware. They render at the
+    // setSampleRate() rate, in Float32 with native format on and Int16
+    // otherwise. Underruns of the NullSink count as device underruns.
+    // Muting applies to the device only.
+    public:
+        void setOutputBackend(OutputBackend backend, const QString &filePath = QString()); // Next start()
+        OutputBackend outputBackend() const;
+
+    private:
+        bool openNullSink(); // Audio thread
+
+        OutputBackend m_outputBackend = DEVICE_OUTPUT;
+        QString m_outputFilePath;
+        NullSink *m_nullSink = nullptr; // Audio thread, replaces m_audioOutput
+
+    // ============================================================
+    // AMBIENT BUS
+    // ============================================================
+    // Up to MAX_AMBIENT_LAYERS sound files, each decoded once to PCM by
+    // AmbientDecoder, are summed into the tone output block by block
+    // with their own gain, ramped across the block. Tone volume and
+    // fades do not apply to them. The sink runs while the tones or any
+    // layer play, so everything shares one device stream; isPlaying()
+    // still refers to the tones. A clip at another rate than the
+    // output is resampled linearly while mixing. Looping layers play
+    // the clip's AmbientLoop region, whose seam is crossfaded once when
+    // the clip loads.
+    public:
+        static constexpr int MAX_AMBIENT_LAYERS = DynamicRenderer::MAX_AMBIENT_LAYERS;
+
+        void loadAmbientLayer(int layer, const QString &filePath); // Decodes asynchronously
+        void clearAmbientLayer(int layer);
+        bool isAmbientLayerLoaded(int layer) const;
+
+        void playAmbientLayer(int layer); // Starts once loaded
+        void pauseAmbientLayer(int layer);
+        void stopAmbientLayer(int layer); // Pauses and rewinds
+        bool isAmbientLayerPlaying(int layer) const;
+        bool isAmbientPlaying() const;    // Any loaded layer
+
+        void setAmbientLayerGain(int layer, double gain); // Linear, 0-1
+        void setAmbientLayerLooping(int layer, bool looping);
+
+        // Seam length for all layers; rebuilds the loaded loops
+        void setAmbientCrossfadeMs(int ms);
+        int ambientCrossfadeMs() const;
+
+        void seekAmbientLayer(int layer, qint64 ms);
+        qint64 ambientLayerPosition(int layer) const; // ms
+        qint64 ambientLayerDuration(int layer) const; // ms, 0 until loaded
+
+        // How long the layer's clip took from load to ready, -1 until
+        // loaded and again while a reload is in flight, until the new
+        // clip replaces the old one; a cache hit mapped stored PCM
+        // instead of decoding
+        qint64 ambientLayerLoadMs(int layer) const;
+        bool isAmbientLayerCacheHit(int layer) const;
+
+    private:
+        using AmbientLayerParameters = DynamicRenderer::AmbientLayer;
+
+        bool checkAmbientLayer(int layer);
+        void publishAmbient(); // GUI thread only (single writer)
+        void handleAmbientDecoded(int layer);
+        void buildAmbientLoop(int layer);
+        void handleAmbientLayerEnded(int layer, quint64 seekId);
+        bool updateOutputState(); // Starts or stops the sink as needed
+        void abortOutput();       // After a sink failure
+
+        AmbientLayerParameters m_ambientLayers[MAX_AMBIENT_LAYERS]; // GUI thread
+        AmbientDecoder *m_ambientDecoders[MAX_AMBIENT_LAYERS] = {};
+        std::unique_ptr<AmbientCache> m_ambientCache; // Created on first load
+        int m_ambientCrossfadeMs = AmbientLoop::DEFAULT_CROSSFADE_MS;
+        TripleBuffer<DynamicRenderer::AmbientBus> m_ambientBuffer;
+        std::atomic<qint64> m_ambientPositions[MAX_AMBIENT_LAYERS] = {}; // Clip frames
+        // seekId + 1 of a layer that ran off its end, 0 once handled
+        std::atomic<quint64> m_ambientEnded[MAX_AMBIENT_LAYERS] = {};
+
+    // ============================================================
+    // TONE VOICES
+    // ============================================================
+    // Extra tone pairs layered on the main one, e.g. a delta carrier
+    // under a theta beat. Each voice has its own tone type, frequencies,
+    // waveform, pulse and gain. They sound while the tones play, follow
+    // the output volume and fades, but not setAmplitude() or the noise
+    // crossfade. The pool has a fixed capacity: slots are published as
+    // one snapshot, and the render path keeps their oscillators in
+    // preallocated struct-of-arrays state advanced by
+    // RenderKernels::renderVoices, so adding or removing a voice never
+    // allocates on the audio thread. New voices fade in and removed ones
+    // fade out over one block. Each voice's gain is divided by the
+    // number of voices, so together they peak no higher than the
+    // loudest would alone.
+    public:
+        static constexpr int MAX_VOICES = DynamicRenderer::MAX_VOICES;
+
+        struct Voice {
+            int toneType = 0;              // 0=Binaural, 1=Isochronic (left frequency, pulsed)
+            double leftFrequency = 200.0;
+            double rightFrequency = 210.0;
+            double pulseFrequency = 10.0;  // Isochronic only
+            Waveform waveform = SINE_WAVE;
+            double gain = DEFAULT_AMPLITUDE;
+        };
+
+        int addVoice(const Voice &voice); // Slot, or -1 if invalid or the pool is full
+        bool setVoice(int slot, const Voice &voice);
+        void removeVoice(int slot);
+        void removeAllVoices();
+        int voiceCount() const;
+        Voice voice(int slot) const;
+
+    private:
+        struct VoiceSlot {
+            Voice voice;
+            bool active = false;
+            quint64 serial = 0; // New for every addVoice(), restarts the oscillators
+        };
+
+        bool validateVoice(const Voice &voice);
+        void publishVoices(); // GUI thread only (single writer)
+
+        VoiceSlot m_voices[MAX_VOICES]; // GUI thread
+        quint64 m_voiceSerial = 0;
+        TripleBuffer<DynamicRenderer::VoiceBank> m_voiceBuffer;
 };
 
 #endif // DYNAMICENGINE_H
@@ -0,0 +1,630 @@
+#include "dynamicrenderer.h"
+#include "wavetable.h"
+
+#include <QtMath>
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <type_traits>
+
+// Phase is in normalized cycles; UseTable = false is the exact std::sin path
+template<DynamicRenderer::Waveform Shape, bool UseTable>
+static inline float shapeSample(double cycles, const float *sineTable)
+{
+    if constexpr (Shape == DynamicRenderer::SINE_WAVE) {
+        return static_cast<float>(UseTable ? Wavetable::sine(sineTable, cycles)
+                                           : Wavetable::exactSine(cycles));
+    } else if constexpr (Shape == DynamicRenderer::SQUARE_WAVE) {
+        if constexpr (UseTable) return static_cast<float>(Wavetable::square(cycles));
+        return (Wavetable::exactSine(cycles) >= 0.0) ? 1.0f : -1.0f;
+    } else if constexpr (Shape == DynamicRenderer::TRIANGLE_WAVE) {
+        return static_cast<float>(Wavetable::triangle(cycles));
+    } else {
+        return static_cast<float>(Wavetable::sawtooth(cycles));
+    }
+}
+
+// The same shapes chosen per sample, for the generic reference renderer
+static inline float oscillatorSample(DynamicRenderer::Waveform waveform, double cycles,
+                                     const float *sineTable)
+{
+    switch (waveform) {
+        case DynamicRenderer::SINE_WAVE:
+            return sineTable ? shapeSample<DynamicRenderer::SINE_WAVE, true>(cycles, sineTable)
+                             : shapeSample<DynamicRenderer::SINE_WAVE, false>(cycles, sineTable);
+        case DynamicRenderer::SQUARE_WAVE:
+            return sineTable ? shapeSample<DynamicRenderer::SQUARE_WAVE, true>(cycles, sineTable)
+                             : shapeSample<DynamicRenderer::SQUARE_WAVE, false>(cycles, sineTable);
+        case DynamicRenderer::TRIANGLE_WAVE:
+            return shapeSample<DynamicRenderer::TRIANGLE_WAVE, true>(cycles, sineTable);
+        case DynamicRenderer::SAWTOOTH_WAVE:
+            return shapeSample<DynamicRenderer::SAWTOOTH_WAVE, true>(cycles, sineTable);
+    }
+    return 0.0f;
+}
+
+DynamicRenderer::DynamicRenderer(const Parameters &params, double gain, double phaseLeft, double phaseRight)
+    : m_kernels(RenderKernels::activeKernels())
+    , m_params(params)
+    , m_target(params)
+    , m_phaseLeft(phaseLeft)
+    , m_phaseRight(phaseRight)
+    , m_gain(gain)
+{
+    m_envelope.target = gain;
+}
+
+void DynamicRenderer::setParameters(const Parameters &params)
+{
+    m_target = params;
+}
+
+void DynamicRenderer::setVoices(const VoiceBank *bank)
+{
+    m_voiceBank = bank;
+}
+
+void DynamicRenderer::setAmbient(const AmbientBus *bus)
+{
+    m_ambientBus = bus;
+}
+
+void DynamicRenderer::seedNoise(quint64 seed)
+{
+    m_noiseGenerator.seed(seed);
+}
+
+void DynamicRenderer::resetNoise()
+{
+    m_noiseGenerator.reset();
+}
+
+void DynamicRenderer::setMetering(bool enabled)
+{
+    m_metering = enabled;
+}
+
+void DynamicRenderer::setGenericTones(bool enabled)
+{
+    m_generic = enabled;
+}
+
+quint64 DynamicRenderer::takeFinishedEnvelope()
+{
+    return std::exchange(m_finishedEnvelope, 0);
+}
+
+quint64 DynamicRenderer::takeAmbientEnd(int layer)
+{
+    return std::exchange(m_ambientVoices[layer].endReport, 0);
+}
+
+qint64 DynamicRenderer::ambientPosition(int layer) const
+{
+    const AmbientVoice &voice = m_ambientVoices[layer];
+    return voice.sounded ? static_cast<qint64>(voice.position) : -1;
+}
+
+template<bool Isochronic, DynamicRenderer::Waveform Shape, int Noise, bool UseTable>
+void DynamicRenderer::renderTone(int frames, const BlockParams &params)
+{
+    // ============================================================
+    // STEP 1: OSCILLATE
+    // ============================================================
+    double leftInc = params.leftPhaseInc;
+    double rightInc = params.rightPhaseInc;
+
+    if constexpr (Isochronic) {
+        for (int i = 0; i < frames; ++i) {
+            m_left[i] = shapeSample<Shape, UseTable>(m_phaseLeft, params.sineTable);
+            m_phaseLeft = Wavetable::advance(m_phaseLeft, leftInc);
+            leftInc += params.leftPhaseIncStep;
+        }
+
+        // ============================================================
+        // STEP 2: GATE (SMOOTH PULSE ENVELOPE, FIXES CLICKING)
+        // ============================================================
+        double pulseInc = params.pulsePhaseInc;
+        for (int i = 0; i < frames; ++i) {
+            bool pulseOn;
+            if constexpr (UseTable) {
+                pulseOn = m_phaseRight < 0.5;
+            } else {
+                pulseOn = Wavetable::exactSine(m_phaseRight) >= 0.0;
+            }
+            m_pulseEnvelope = pulseOn ? std::min(1.0, m_pulseEnvelope + params.attackStep)
+                                      : std::max(0.0, m_pulseEnvelope - params.releaseStep);
+            m_gate[i] = static_cast<float>(m_pulseEnvelope);
+            m_phaseRight = Wavetable::advance(m_phaseRight, pulseInc);
+            pulseInc += params.pulsePhaseIncStep;
+        }
+
+        m_kernels.applyGate(m_left, m_gate, frames);
+        std::memcpy(m_right, m_left, frames * sizeof(float)); // Stereo identical
+    } else {
+        for (int i = 0; i < frames; ++i) {
+            m_left[i] = shapeSample<Shape, UseTable>(m_phaseLeft, params.sineTable);
+            m_right[i] = shapeSample<Shape, UseTable>(m_phaseRight, params.sineTable);
+            m_phaseLeft = Wavetable::advance(m_phaseLeft, leftInc);
+            m_phaseRight = Wavetable::advance(m_phaseRight, rightInc);
+            leftInc += params.leftPhaseIncStep;
+            rightInc += params.rightPhaseIncStep;
+        }
+    }
+
+    // ============================================================
+    // STEP 3: GENERATE NOISE (UNIVERSAL)
+    // ============================================================
+    NoiseGenerator &noise = m_noiseGenerator;
+    if constexpr (Noise == NoiseGenerator::NOISE_WHITE) noise.fillWhite(m_noise, frames);
+    if constexpr (Noise == NoiseGenerator::NOISE_PINK) noise.fillPink(m_noise, frames);
+    if constexpr (Noise == NoiseGenerator::NOISE_BROWN) noise.fillBrown(m_noise, frames);
+    if constexpr (Noise == NoiseGenerator::NOISE_GREY) noise.fillGrey(m_noise, frames);
+}
+
+template<std::size_t Index>
+constexpr DynamicRenderer::ToneRenderer DynamicRenderer::rendererAt()
+{
+    constexpr bool useTable = (Index % OSCILLATOR_MODES) == 1;
+    constexpr int noise = static_cast<int>((Index / OSCILLATOR_MODES) % NOISE_TYPES);
+    constexpr auto shape = static_cast<Waveform>((Index / (OSCILLATOR_MODES * NOISE_TYPES)) % WAVEFORMS);
+    constexpr bool isochronic = (Index / (OSCILLATOR_MODES * NOISE_TYPES * WAVEFORMS)) == 1;
+    if constexpr (noise == NoiseGenerator::NOISE_GREY) {
+        return nullptr; // Measured no faster than renderToneGeneric()
+    } else {
+        return &DynamicRenderer::renderTone<isochronic, shape, noise, useTable>;
+    }
+}
+
+DynamicRenderer::ToneRenderer
+DynamicRenderer::selectRenderer(bool isochronic, Waveform shape, int noise, bool useTable)
+{
+    static constexpr std::array<ToneRenderer, RENDERER_COUNT> renderers =
+            makeRenderers(std::make_index_sequence<RENDERER_COUNT>{});
+
+    int index = isochronic ? 1 : 0;
+    index = index * WAVEFORMS + qBound(0, static_cast<int>(shape), WAVEFORMS - 1);
+    index = index * NOISE_TYPES + qBound(0, noise, NOISE_TYPES - 1);
+    index = index * OSCILLATOR_MODES + (useTable ? 1 : 0);
+    return renderers[index];
+}
+
+void DynamicRenderer::renderToneGeneric(int frames, const BlockParams &params, bool isochronic,
+                                        Waveform shape, int noise, bool useTable)
+{
+    const float *sineTable = useTable ? params.sineTable : nullptr;
+    double leftInc = params.leftPhaseInc;
+    double rightInc = params.rightPhaseInc;
+    double pulseInc = params.pulsePhaseInc;
+
+    for (int i = 0; i < frames; ++i) {
+        m_left[i] = oscillatorSample(shape, m_phaseLeft, sineTable);
+        m_phaseLeft = Wavetable::advance(m_phaseLeft, leftInc);
+        leftInc += params.leftPhaseIncStep;
+
+        if (isochronic) {
+            bool pulseOn = useTable ? (m_phaseRight < 0.5) : (Wavetable::exactSine(m_phaseRight) >= 0.0);
+            if (pulseOn) {
+                m_pulseEnvelope = std::min(1.0, m_pulseEnvelope + params.attackStep);
+            } else {
+                m_pulseEnvelope = std::max(0.0, m_pulseEnvelope - params.releaseStep);
+            }
+            m_left[i] = m_left[i] * static_cast<float>(m_pulseEnvelope);
+            m_right[i] = m_left[i];
+            m_phaseRight = Wavetable::advance(m_phaseRight, pulseInc);
+            pulseInc += params.pulsePhaseIncStep;
+        } else {
+            m_right[i] = oscillatorSample(shape, m_phaseRight, sineTable);
+            m_phaseRight = Wavetable::advance(m_phaseRight, rightInc);
+            rightInc += params.rightPhaseIncStep;
+        }
+    }
+
+    if (noise != NoiseGenerator::NOISE_OFF) {
+        m_noiseGenerator.fill(noise, m_noise, frames);
+    }
+}
+
+// Gain at progress (0, 1] of an envelope from start to target
+static inline double envelopeGain(double start, double target, double progress,
+                                  DynamicRenderer::FadeCurve curve)
+{
+    if (progress >= 1.0) {
+        return target;
+    }
+
+    switch (curve) {
+        case DynamicRenderer::SMOOTH_FADE:
+            return start + (target - start) * (0.5 - 0.5 * std::cos(M_PI * progress));
+        case DynamicRenderer::EXPONENTIAL_FADE: {
+            constexpr double floorGain = 0.001; // -60 dB
+            const double from = std::max(start, floorGain);
+            const double to = std::max(target, floorGain);
+            return from * std::pow(to / from, progress);
+        }
+        default:
+            return start + (target - start) * progress;
+    }
+}
+
+void DynamicRenderer::startEnvelope(const GainEnvelope &envelope)
+{
+    m_envelope = envelope;
+    m_envelopeStart = m_gain;
+    m_envelopePosition = 0;
+    m_envelopeActive = true;
+}
+
+void DynamicRenderer::renderEnvelope(int frames)
+{
+    const double length = static_cast<double>(std::max<qint64>(1, m_envelope.durationFrames));
+
+    for (int i = 0; i < frames; ++i) {
+        if (m_envelopePosition < m_envelope.durationFrames) {
+            ++m_envelopePosition;
+            m_gain = envelopeGain(m_envelopeStart, m_envelope.target,
+                                  m_envelopePosition / length, m_envelope.curve);
+        } else {
+            m_gain = m_envelope.target;
+        }
+        m_envelopeGain[i] = static_cast<float>(m_gain);
+    }
+
+    if (m_envelopePosition >= m_envelope.durationFrames) {
+        m_envelopeActive = false;
+        m_finishedEnvelope = m_envelope.id;
+    }
+}
+
+// Adds every sounding layer into m_left/m_right, ramping each layer's
+// gain across the block. A new clip or seek jumps the playhead and
+// fades in from silence; pausing fades out over the block.
+// True when mixAmbient() will leave the block untouched: no layer has
+// a clip it is playing or still fading out
+bool DynamicRenderer::ambientIdle() const
+{
+    if (!m_ambientBus) {
+        return true;
+    }
+    for (int i = 0; i < MAX_AMBIENT_LAYERS; ++i) {
+        const AmbientLayer &layer = m_ambientBus->layers[i];
+        if (layer.clip && (layer.playing || m_ambientVoices[i].gain != 0.0f)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+void DynamicRenderer::mixAmbient(int frames, double sampleRate)
+{
+    for (int i = 0; i < MAX_AMBIENT_LAYERS; ++i) {
+        AmbientVoice &voice = m_ambientVoices[i];
+        voice.sounded = false;
+        if (!m_ambientBus) {
+            continue;
+        }
+        const AmbientLayer &layer = m_ambientBus->layers[i];
+        const AmbientClip *clip = layer.clip.get();
+
+        if (clip != voice.clip || layer.seekId != voice.seekId) {
+            voice.clip = clip;
+            voice.seekId = layer.seekId;
+            voice.position = clip ? static_cast<double>(std::clamp<qint64>(layer.seekFrame, 0, clip->frames() - 1))
+                                  : 0.0;
+            voice.gain = 0.0f;
+            voice.ended = false;
+        }
+
+        const float target = (layer.playing && !voice.ended) ? layer.gain : 0.0f;
+        if (!clip || clip->frames() == 0 || (target == 0.0f && voice.gain == 0.0f)) {
+            continue;
+        }
+
+        // Looping plays [loopStart, loopEnd) with the seam standing in
+        // for the frames from seamStart on; otherwise the whole clip once
+        const AmbientLoop *loop = layer.looping ? layer.loop.get() : nullptr;
+        const qint64 clipFrames = clip->frames();
+        const qint64 loopStart = loop ? loop->start() : 0;
+        const qint64 loopEnd = loop ? loop->end() : clipFrames;
+        const qint64 seamStart = loop ? loop->seamStart() : loopEnd;
+        const float *clipLeft = clip->left();
+        const float *clipRight = clip->right();
+        const float *seamLeft = loop ? loop->seamLeft() : nullptr;
+        const float *seamRight = loop ? loop->seamRight() : nullptr;
+
+        const double step = clip->sampleRate() / sampleRate;
+        const float gainStep = (target - voice.gain) / frames;
+
+        int done = 0;
+        while (done < frames) {
+            if (voice.position >= loopEnd) {
+                if (!layer.looping) {
+                    voice.ended = true;
+                    voice.endReport = voice.seekId + 1;
+                    break;
+                }
+                voice.position = loopStart + std::fmod(voice.position - loopStart,
+                                                       static_cast<double>(loopEnd - loopStart));
+            }
+
+            const float gain = voice.gain + gainStep * done;
+            const qint64 index = static_cast<qint64>(voice.position);
+            int count;
+            if (step == 1.0) {
+                // Same rate: mix straight from the clip or the seam
+                const bool inSeam = index >= seamStart;
+                const float *left = inSeam ? seamLeft + (index - seamStart) : clipLeft + index;
+                const float *right = inSeam ? seamRight + (index - seamStart) : clipRight + index;
+                count = static_cast<int>(std::min<qint64>(frames - done, (inSeam ? loopEnd : seamStart) - index));
+                m_kernels.mixAdd(m_left + done, left, gain, gainStep, count);
+                m_kernels.mixAdd(m_right + done, right, gain, gainStep, count);
+                voice.position += count;
+            } else {
+                // Linear interpolation up to the loop end, wrapping the
+                // second tap to the loop start
+                auto sampleAt = [&](const float *clipData, const float *seamData, qint64 frame) {
+                    return frame >= seamStart ? seamData[frame - seamStart] : clipData[frame];
+                };
+                for (count = 0; done + count < frames && voice.position < loopEnd; ++count) {
+                    const qint64 a = static_cast<qint64>(voice.position);
+                    const qint64 b = a + 1 < loopEnd ? a + 1 : (layer.looping ? loopStart : a);
+                    const float frac = static_cast<float>(voice.position - a);
+                    const float leftA = sampleAt(clipLeft, seamLeft, a);
+                    const float rightA = sampleAt(clipRight, seamRight, a);
+                    m_ambientLeft[count] = leftA + (sampleAt(clipLeft, seamLeft, b) - leftA) * frac;
+                    m_ambientRight[count] = rightA + (sampleAt(clipRight, seamRight, b) - rightA) * frac;
+                    voice.position += step;
+                }
+                m_kernels.mixAdd(m_left + done, m_ambientLeft, gain, gainStep, count);
+                m_kernels.mixAdd(m_right + done, m_ambientRight, gain, gainStep, count);
+            }
+            done += count;
+        }
+
+        voice.gain = voice.ended ? 0.0f : target;
+        voice.sounded = true;
+    }
+}
+
+// Renders the sounding voices into m_voiceLeft/m_voiceRight and
+// returns how many voices that covered (0: nothing to mix). A new
+// voice restarts its oscillators and fades in over the block; a
+// removed one keeps running while it fades out.
+int DynamicRenderer::renderVoices(int frames, double sampleRate)
+{
+    if (!m_voiceBank) {
+        return 0;
+    }
+    const VoiceBank &bank = *m_voiceBank;
+    VoicePool &pool = m_voicePool;
+    const float ramp = 1.0f / frames;
+
+    // Bus headroom: voice gains are divided by the number of voices, so
+    // the sum peaks no higher than the loudest voice would alone. Voices
+    // start in phase, which rules out equal-power (1 / sqrt) scaling. A
+    // change in the count ramps with the gains.
+    int active = 0;
+    for (const VoiceSlot &slot : bank.voices) {
+        active += (slot.active && slot.voice.gain > 0.0) ? 1 : 0;
+    }
+    const double headroom = active > 1 ? 1.0 / active : 1.0;
+
+    int sounding = 0;
+    for (int i = 0; i < MAX_VOICES; ++i) {
+        const VoiceSlot &slot = bank.voices[i];
+        const Voice &voice = slot.voice;
+        const bool isochronic = voice.toneType == 1;
+
+        if (slot.active && slot.serial != pool.serial[i]) {
+            pool.serial[i] = slot.serial;
+            pool.phaseLeft[i] = 0.0f;
+            pool.phaseRight[i] = 0.0f;
+            pool.pulsePhase[i] = 0.0f;
+            pool.envelope[i] = isochronic ? 0.0f : 1.0f; // The gate opens from closed
+            pool.incLeft[i] = static_cast<float>(voice.leftFrequency / sampleRate);
+            pool.incRight[i] = static_cast<float>((isochronic ? voice.leftFrequency : voice.rightFrequency)
+                                                  / sampleRate);
+            pool.gain[i] = 0.0f;
+        }
+
+        const float targetGain = slot.active ? static_cast<float>(voice.gain * headroom) : 0.0f;
+        if (targetGain == 0.0f && pool.gain[i] == 0.0f) {
+            pool.gainStep[i] = 0.0f;
+            pool.incLeftStep[i] = 0.0f;
+            pool.incRightStep[i] = 0.0f;
+            continue;
+        }
+
+        // A removed voice holds its last frequencies while fading out
+        const float targetLeft = slot.active ? static_cast<float>(voice.leftFrequency / sampleRate)
+                                             : pool.incLeft[i];
+        const float targetRight = !slot.active ? pool.incRight[i]
+                : static_cast<float>((isochronic ? voice.leftFrequency : voice.rightFrequency) / sampleRate);
+        pool.incLeftStep[i] = (targetLeft - pool.incLeft[i]) * ramp;
+        pool.incRightStep[i] = (targetRight - pool.incRight[i]) * ramp;
+        pool.gainStep[i] = (targetGain - pool.gain[i]) * ramp;
+
+        // Binaural voices hold the pulse at 0, so their gate stays open
+        // (and reopens after a switch from isochronic)
+        pool.pulseInc[i] = isochronic ? static_cast<float>(voice.pulseFrequency / sampleRate) : 0.0f;
+        if (!isochronic) {
+            pool.pulsePhase[i] = 0.0f;
+        }
+        pool.sineMix[i] = voice.waveform == SINE_WAVE ? 1.0f : 0.0f;
+        pool.squareMix[i] = voice.waveform == SQUARE_WAVE ? 1.0f : 0.0f;
+        pool.triangleMix[i] = voice.waveform == TRIANGLE_WAVE ? 1.0f : 0.0f;
+        pool.sawtoothMix[i] = voice.waveform == SAWTOOTH_WAVE ? 1.0f : 0.0f;
+        sounding = i + 1;
+    }
+
+    if (sounding == 0) {
+        return 0;
+    }
+
+    // Silent voices inside the last lane group are rendered at zero gain
+    const int laneCount = (sounding + RenderKernels::VOICE_LANES - 1)
+            / RenderKernels::VOICE_LANES * RenderKernels::VOICE_LANES;
+    const float attackStep = static_cast<float>(1.0 / (0.01 * sampleRate));  // 10ms, as the main gate
+    const RenderKernels::VoiceLanes lanes = {
+        pool.phaseLeft, pool.phaseRight, pool.pulsePhase, pool.envelope,
+        pool.incLeft, pool.incLeftStep, pool.incRight, pool.incRightStep, pool.pulseInc,
+        pool.gain, pool.gainStep,
+        pool.sineMix, pool.squareMix, pool.triangleMix, pool.sawtoothMix,
+        attackStep, attackStep
+    };
+    m_kernels.renderVoices(lanes, laneCount, m_voiceLeft, m_voiceRight, frames);
+
+    for (int i = 0; i < laneCount; ++i) {
+        pool.incLeft[i] += pool.incLeftStep[i] * frames;
+        pool.incRight[i] += pool.incRightStep[i] * frames;
+        pool.gain[i] = bank.voices[i].active ? static_cast<float>(bank.voices[i].voice.gain * headroom) : 0.0f;
+    }
+    return sounding;
+}
+
+// Noise mix level a parameter set asks for (0 when noise is off)
+static inline double effectiveNoiseLevel(bool enabled, int type, double level)
+{
+    return (enabled && type > 0) ? level : 0.0;
+}
+
+void DynamicRenderer::render(int16_t *out, int frames)
+{
+    renderBlocks(out, frames);
+}
+
+void DynamicRenderer::render(float *out, int frames)
+{
+    renderBlocks(out, frames);
+}
+
+template<typename Sample>
+void DynamicRenderer::renderBlocks(Sample *out, int frameCount)
+{
+    for (int offset = 0; offset < frameCount; offset += RenderKernels::BLOCK_FRAMES) {
+        const int frames = std::min(RenderKernels::BLOCK_FRAMES, frameCount - offset);
+
+        // Ramp from the previous block's values to the latest parameters
+        // across this block
+        const Parameters from = m_params;
+        m_params = m_target;
+        const Parameters &to = m_params;
+
+        const double sampleRate = to.sampleRate;
+        const double ramp = 1.0 / frames;
+
+        BlockParams params;
+        params.leftPhaseInc = from.leftFrequency / sampleRate;
+        params.leftPhaseIncStep = (to.leftFrequency - from.leftFrequency) / sampleRate * ramp;
+        params.rightPhaseInc = from.rightFrequency / sampleRate;
+        params.rightPhaseIncStep = (to.rightFrequency - from.rightFrequency) / sampleRate * ramp;
+        params.pulsePhaseInc = from.pulseFrequency / sampleRate;
+        params.pulsePhaseIncStep = (to.pulseFrequency - from.pulseFrequency) / sampleRate * ramp;
+        params.attackStep = 1.0 / (0.01 * sampleRate);  // 10ms attack
+        params.releaseStep = 1.0 / (0.01 * sampleRate); // 10ms release
+        params.sineTable = Wavetable::sineTable();
+
+        // Noise fades in/out with its level; a type switch keeps the old
+        // colour only while fading out
+        const double fromNoise = effectiveNoiseLevel(from.noiseEnabled, from.noiseType, from.noiseLevel);
+        const double toNoise = effectiveNoiseLevel(to.noiseEnabled, to.noiseType, to.noiseLevel);
+        const bool mixNoise = fromNoise > 0.0 || toNoise > 0.0;
+        const int noiseType = (to.noiseEnabled && to.noiseType > 0) ? to.noiseType : from.noiseType;
+
+        // Silent tones fade over one block through the amplitude ramp
+        const bool silent = from.silent && to.silent;
+        const double fromAmplitude = from.silent ? 0.0 : from.amplitude;
+        const double toAmplitude = to.silent ? 0.0 : to.amplitude;
+
+        // STEPS 1-3: oscillate, gate and generate noise (specialized)
+        if (silent) {
+            std::fill(m_left, m_left + frames, 0.0f);
+            std::fill(m_right, m_right + frames, 0.0f);
+        } else {
+            const bool isochronic = to.toneType == 1;
+            const int noise = mixNoise ? noiseType : 0;
+            const bool useTable = to.oscillatorMode == WAVETABLE_OSCILLATOR;
+            ToneRenderer render = m_generic ? nullptr : selectRenderer(isochronic, to.waveform, noise, useTable);
+            if (render) {
+                (this->*render)(frames, params);
+            } else {
+                renderToneGeneric(frames, params, isochronic, to.waveform, noise, useTable);
+            }
+        }
+
+        // Voices sound with the tones and fade with them
+        const bool voices = !silent && renderVoices(frames, sampleRate) > 0;
+        const double fromOn = from.silent ? 0.0 : 1.0;
+        const double toOn = to.silent ? 0.0 : 1.0;
+
+        // With nothing to mix in after the gain, an int16 block takes
+        // noise mix, gain and conversion as one stage (STEP 5)
+        const bool direct = std::is_same_v<Sample, int16_t> && !m_envelopeActive && !voices && ambientIdle();
+        const float noiseLevel = static_cast<float>(fromNoise);
+        const float noiseLevelStep = static_cast<float>((toNoise - fromNoise) * ramp);
+        const float *noise = (mixNoise && !silent) ? m_noise : nullptr;
+
+        if (noise && !direct) {
+            // Mix tone with noise (crossfade)
+            m_kernels.mixNoise(m_left, noise, noiseLevel, noiseLevelStep, frames);
+            m_kernels.mixNoise(m_right, noise, noiseLevel, noiseLevelStep, frames);
+        }
+
+        // ============================================================
+        // STEP 4: APPLY AMPLITUDE AND OUTPUT GAIN
+        // ============================================================
+        if (m_envelopeActive) {
+            const float gain = static_cast<float>(fromAmplitude);
+            const float gainStep = static_cast<float>((toAmplitude - fromAmplitude) * ramp);
+            m_kernels.applyGain(m_left, gain, gainStep, frames);
+            m_kernels.applyGain(m_right, gain, gainStep, frames);
+
+            if (voices) {
+                const float on = static_cast<float>(fromOn);
+                const float onStep = static_cast<float>((toOn - fromOn) * ramp);
+                m_kernels.mixAdd(m_left, m_voiceLeft, on, onStep, frames);
+                m_kernels.mixAdd(m_right, m_voiceRight, on, onStep, frames);
+            }
+
+            renderEnvelope(frames);
+            m_kernels.applyGate(m_left, m_envelopeGain, frames);
+            m_kernels.applyGate(m_right, m_envelopeGain, frames);
+        } else if (!direct) {
+            const float gain = static_cast<float>(fromAmplitude * m_gain);
+            const float gainStep = static_cast<float>((toAmplitude - fromAmplitude) * m_gain * ramp);
+            m_kernels.applyGain(m_left, gain, gainStep, frames);
+            m_kernels.applyGain(m_right, gain, gainStep, frames);
+
+            if (voices) {
+                const float on = static_cast<float>(fromOn * m_gain);
+                const float onStep = static_cast<float>((toOn - fromOn) * m_gain * ramp);
+                m_kernels.mixAdd(m_left, m_voiceLeft, on, onStep, frames);
+                m_kernels.mixAdd(m_right, m_voiceRight, on, onStep, frames);
+            }
+        }
+
+        // ============================================================
+        // STEP 4b: MIX AMBIENT LAYERS
+        // ============================================================
+        mixAmbient(frames, sampleRate);
+
+        // ============================================================
+        // STEP 5: CLAMP, CONVERT AND INTERLEAVE
+        // ============================================================
+        // Float32 is clamped to the same [-1, 1] as int16, so both formats
+        // clip alike. Either conversion meters the block before the clamp
+        RenderKernels::LevelSums *meter = m_metering ? &m_levels : nullptr;
+        Sample *blockOut = out + 2 * offset;
+        if constexpr (std::is_same_v<Sample, float>) {
+            m_kernels.interleaveFloat(m_left, m_right, blockOut, frames, meter);
+        } else if (direct) {
+            const float gain = static_cast<float>(fromAmplitude * m_gain);
+            const float gainStep = static_cast<float>((toAmplitude - fromAmplitude) * m_gain * ramp);
+            m_kernels.mixGainToInt16(m_left, m_right, noise, noiseLevel, noiseLevelStep, gain, gainStep,
+                                     blockOut, frames, meter);
+        } else {
+            m_kernels.convertToInt16(m_left, m_right, blockOut, frames, meter);
+        }
+        m_blockFrames = frames;
+    }
+}
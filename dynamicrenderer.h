@@ -0,0 +1,287 @@
+#ifndef DYNAMICRENDERER_H
+#define DYNAMICRENDERER_H
+
+#include "ambientclip.h"
+#include "ambientloop.h"
+#include "noisegenerator.h"
+#include "renderkernels.h"
+
+#include <QtGlobal>
+#include <array>
+#include <cstdint>
+#include <memory>
+#include <utility>
+
+// ============================================================
+// DYNAMIC RENDERER
+// ============================================================
+// The tone synthesizer on its own: oscillator, isochronic gate, noise,
+// gain envelope and voice state plus the block buffers, with no QObject
+// or audio device behind it. DynamicEngine drives one per output
+// session from its render thread; SessionRenderer, the --bench path and
+// binaural_bench construct their own and call render() directly.
+//
+// render() works in blocks of RenderKernels::BLOCK_FRAMES through the
+// stages oscillate -> gate -> noise mix -> gain -> ambient mix ->
+// clamp to [-1, 1], then convert (int16_t) or interleave (float).
+// Silent parameters skip the tone stages, for a sink running for
+// ambient layers alone.
+// An int16 block with no voices, envelope or ambient layers runs noise
+// mix, gain and conversion as the single mixGainToInt16 kernel, which
+// the scalar kernels do in one pass per frame.
+//
+// Oscillate, gate and noise generation are one template per
+// (tone type, waveform, noise type, oscillator mode); the matching
+// instantiation is looked up once per block so the per-sample loops
+// carry no configuration branches. renderToneGeneric() is the same
+// stages with the configuration tested per sample. It also renders
+// the grey noise configurations, where the noise filter dominates the
+// block and binaural_bench measured the specializations no faster.
+// setGenericTones() forces it for every configuration.
+//
+// Not thread-safe: the owner feeds inputs and renders on one thread.
+
+class DynamicRenderer
+{
+public:
+    enum Waveform {
+        SINE_WAVE = 0,
+        SQUARE_WAVE = 1,
+        TRIANGLE_WAVE = 2,
+        SAWTOOTH_WAVE = 3
+    };
+
+    enum OscillatorMode {
+        EXACT_OSCILLATOR = 0,     // std::sin per sample
+        WAVETABLE_OSCILLATOR = 1  // Interpolated table / phasor
+    };
+
+    enum FadeCurve {
+        LINEAR_FADE = 0,
+        SMOOTH_FADE = 1,      // Raised cosine (S-curve)
+        EXPONENTIAL_FADE = 2  // Equal steps in dB, -60 dB floor
+    };
+
+    static constexpr double DEFAULT_AMPLITUDE = 0.3;
+    static constexpr int MAX_VOICES = 128;
+    static constexpr int MAX_AMBIENT_LAYERS = 8;
+
+    // The main tone pair
+    struct Parameters {
+        double leftFrequency = 360.0;
+        double rightFrequency = 367.83;
+        double pulseFrequency = 7.83;
+        double amplitude = DEFAULT_AMPLITUDE;
+        double noiseLevel = 0.3;
+        int noiseType = 0; // NoiseGenerator::NoiseType
+        bool noiseEnabled = false;
+        Waveform waveform = SINE_WAVE;
+        OscillatorMode oscillatorMode = WAVETABLE_OSCILLATOR;
+        int toneType = 0;  // 0=Binaural, 1=Isochronic, 2=Generator
+        int sampleRate = 44100;
+        bool silent = false; // Tones and voices muted, ambient layers still mixed
+    };
+
+    // Output gain: ramps from the gain reached so far to target
+    struct GainEnvelope {
+        double target = 0.0;
+        qint64 durationFrames = 0;
+        FadeCurve curve = LINEAR_FADE;
+        quint64 id = 0; // Reported by takeFinishedEnvelope()
+    };
+
+    struct Voice {
+        int toneType = 0;              // 0=Binaural, 1=Isochronic (left frequency, pulsed)
+        double leftFrequency = 200.0;
+        double rightFrequency = 210.0;
+        double pulseFrequency = 10.0;  // Isochronic only
+        Waveform waveform = SINE_WAVE;
+        double gain = DEFAULT_AMPLITUDE; // Divided by the number of voices
+    };
+
+    struct VoiceSlot {
+        Voice voice;
+        bool active = false;
+        quint64 serial = 0; // A new serial restarts the slot's oscillators
+    };
+
+    struct VoiceBank {
+        VoiceSlot voices[MAX_VOICES];
+    };
+
+    struct AmbientLayer {
+        std::shared_ptr<const AmbientClip> clip;
+        std::shared_ptr<const AmbientLoop> loop; // Built with the clip
+        float gain = 1.0f;
+        bool playing = false;
+        bool looping = true;
+        quint64 seekId = 0;  // Bumped to move the playhead to seekFrame
+        qint64 seekFrame = 0;
+    };
+
+    struct AmbientBus {
+        AmbientLayer layers[MAX_AMBIENT_LAYERS];
+    };
+
+    // Starts at gain with no envelope running. Phases are in cycles
+    // [0, 1); the isochronic gate starts closed either way.
+    explicit DynamicRenderer(const Parameters &params, double gain = 1.0,
+                             double phaseLeft = 0.0, double phaseRight = 0.0);
+
+    DynamicRenderer(const DynamicRenderer &) = delete;
+    DynamicRenderer &operator=(const DynamicRenderer &) = delete;
+
+    // Inputs take effect at the next block. New parameters are ramped
+    // to across it; the voice bank and ambient bus are read in place
+    // and must outlive their use (nullptr: none).
+    void setParameters(const Parameters &params);
+    void startEnvelope(const GainEnvelope &envelope);
+    void setVoices(const VoiceBank *bank);
+    void setAmbient(const AmbientBus *bus);
+    void seedNoise(quint64 seed);
+    void resetNoise(); // Clears the noise filters, keeps the sequence
+
+    void setMetering(bool enabled); // Peak/RMS of each block, see levels()
+    void setGenericTones(bool enabled);
+
+    // Interleaved stereo
+    void render(int16_t *out, int frames);
+    void render(float *out, int frames);
+
+    // State after the last rendered block
+    const Parameters &parameters() const { return m_params; }
+    double phaseLeft() const { return m_phaseLeft; }
+    double phaseRight() const { return m_phaseRight; }
+    double gain() const { return m_gain; }
+    bool isEnvelopeActive() const { return m_envelopeActive; }
+    const RenderKernels::LevelSums &levels() const { return m_levels; } // With setMetering()
+    int blockFrames() const { return m_blockFrames; }
+    const float *mixLeft() const { return m_left; }   // The block as mixed before conversion
+    const float *mixRight() const { return m_right; }
+
+    // Reports since the last call, each returned once: the id of an
+    // envelope that reached its target (0: none), seekId + 1 of a
+    // layer that ran off its end without looping (0: none)
+    quint64 takeFinishedEnvelope();
+    quint64 takeAmbientEnd(int layer);
+    // Playhead in clip frames, -1 unless the layer sounded in the last block
+    qint64 ambientPosition(int layer) const;
+
+private:
+    // Phase increments are in cycles per sample and ramp linearly by
+    // their *Step across the block
+    struct BlockParams {
+        double leftPhaseInc;
+        double leftPhaseIncStep;
+        double rightPhaseInc;
+        double rightPhaseIncStep;
+        double pulsePhaseInc;
+        double pulsePhaseIncStep;
+        double attackStep;
+        double releaseStep;
+        const float *sineTable;
+    };
+
+    using ToneRenderer = void (DynamicRenderer::*)(int frames, const BlockParams &params);
+
+    static constexpr int TONE_KINDS = 2;  // Binaural/generator, isochronic
+    static constexpr int WAVEFORMS = 4;
+    static constexpr int NOISE_TYPES = 5; // Off, white, pink, brown, grey
+    static constexpr int OSCILLATOR_MODES = 2;
+    static constexpr int RENDERER_COUNT = TONE_KINDS * WAVEFORMS * NOISE_TYPES * OSCILLATOR_MODES;
+
+    template<typename Sample>
+    void renderBlocks(Sample *out, int frameCount);
+
+    template<bool Isochronic, Waveform Shape, int Noise, bool UseTable>
+    void renderTone(int frames, const BlockParams &params);
+
+    template<std::size_t Index>
+    static constexpr ToneRenderer rendererAt();
+
+    template<std::size_t... Index>
+    static constexpr std::array<ToneRenderer, RENDERER_COUNT> makeRenderers(std::index_sequence<Index...>)
+    {
+        return {{ rendererAt<Index>()... }};
+    }
+
+    // nullptr: no specialization, use renderToneGeneric()
+    static ToneRenderer selectRenderer(bool isochronic, Waveform shape, int noise, bool useTable);
+    void renderToneGeneric(int frames, const BlockParams &params, bool isochronic, Waveform shape,
+                           int noise, bool useTable);
+
+    void renderEnvelope(int frames);
+    bool ambientIdle() const;
+    void mixAmbient(int frames, double sampleRate);
+    int renderVoices(int frames, double sampleRate);
+
+    // Render-path state of an ambient layer
+    struct AmbientVoice {
+        const AmbientClip *clip = nullptr;
+        double position = 0.0; // Clip frames
+        float gain = 0.0f;     // Reached at the end of the last block
+        quint64 seekId = 0;
+        bool ended = false;    // Ran off the end without looping
+        bool sounded = false;  // Mixed in the last block
+        quint64 endReport = 0; // seekId + 1 once ended, until taken
+    };
+
+    const RenderKernels::KernelSet &m_kernels;
+    bool m_generic = false; // Reference renderer instead of the specializations
+    bool m_metering = false;
+    Parameters m_params;    // Values reached at the end of the last block
+    Parameters m_target;    // Ramped to across the next block
+    double m_phaseLeft;
+    double m_phaseRight;
+    double m_pulseEnvelope = 0.0;
+    NoiseGenerator m_noiseGenerator;
+    const VoiceBank *m_voiceBank = nullptr;
+    const AmbientBus *m_ambientBus = nullptr;
+    AmbientVoice m_ambientVoices[MAX_AMBIENT_LAYERS];
+    RenderKernels::LevelSums m_levels = {};
+    int m_blockFrames = 0;
+
+    // Output gain envelope
+    GainEnvelope m_envelope;
+    double m_envelopeStart = 0.0;
+    qint64 m_envelopePosition = 0;
+    bool m_envelopeActive = false;
+    double m_gain;
+    quint64 m_finishedEnvelope = 0;
+
+    alignas(32) float m_left[RenderKernels::BLOCK_FRAMES];
+    alignas(32) float m_right[RenderKernels::BLOCK_FRAMES];
+    alignas(32) float m_gate[RenderKernels::BLOCK_FRAMES];
+    alignas(32) float m_noise[RenderKernels::BLOCK_FRAMES];
+    alignas(32) float m_envelopeGain[RenderKernels::BLOCK_FRAMES];
+    alignas(32) float m_ambientLeft[RenderKernels::BLOCK_FRAMES];  // Resampled clip
+    alignas(32) float m_ambientRight[RenderKernels::BLOCK_FRAMES];
+
+    // Tone voice oscillators, one array per field so renderVoices()
+    // advances VOICE_LANES voices per instruction. Increments and gains
+    // hold the values reached at the end of the last block.
+    struct VoicePool {
+        alignas(32) float phaseLeft[MAX_VOICES];
+        alignas(32) float phaseRight[MAX_VOICES];
+        alignas(32) float pulsePhase[MAX_VOICES];
+        alignas(32) float envelope[MAX_VOICES];
+        alignas(32) float incLeft[MAX_VOICES];
+        alignas(32) float incLeftStep[MAX_VOICES];
+        alignas(32) float incRight[MAX_VOICES];
+        alignas(32) float incRightStep[MAX_VOICES];
+        alignas(32) float pulseInc[MAX_VOICES];
+        alignas(32) float gain[MAX_VOICES];
+        alignas(32) float gainStep[MAX_VOICES];
+        alignas(32) float sineMix[MAX_VOICES];
+        alignas(32) float squareMix[MAX_VOICES];
+        alignas(32) float triangleMix[MAX_VOICES];
+        alignas(32) float sawtoothMix[MAX_VOICES];
+        quint64 serial[MAX_VOICES];
+    };
+
+    VoicePool m_voicePool = {};
+    alignas(32) float m_voiceLeft[RenderKernels::BLOCK_FRAMES];
+    alignas(32) float m_voiceRight[RenderKernels::BLOCK_FRAMES];
+};
+
+#endif // DYNAMICRENDERER_H
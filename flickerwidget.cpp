@@ -1,4 +1,5 @@
 #include "flickerwidget.h"
+#include "dynamicengine.h"
 
 #include <QOpenGLFunctions>
 #include <QPainter>
@@ -10,6 +11,10 @@
 #include <QMenu>
 #include <QContextMenuEvent>
 #include<QShortcut>
+#include <QScreen>
+#include <QSurfaceFormat>
+#include <algorithm>
+#include <cmath>
 
 
 static const char *VERT_SRC = R"(
@@ -24,8 +29,7 @@ void main() {
 
 static const char *FRAG_SRC = R"(
 #version 120
-uniform float     uTime;
-uniform float     uFreq;
+uniform float     uPhase;          // In cycles, [0, 1)
 uniform float     uIntensity;
 uniform int       uEnvelope;       // 0=sine 1=square 2=triangle 3=sawtooth
 uniform vec3      uOnColor;
@@ -36,7 +40,7 @@ uniform bool uFlash;
 varying vec2 vUV;
 
 void main() {
-    float phase = mod(uTime * uFreq, 1.0);
+    float phase = uPhase;
 
     float brightness;
     if (uEnvelope == 0) {
@@ -76,10 +80,12 @@ FlickerWidget::FlickerWidget(QWidget *parent)
 {
     setWindowFlags(windowFlags() | Qt::WindowStaysOnTopHint);
 
-    connect(&m_renderTimer, &QTimer::timeout, this, [this]() {
-        if (m_running) update();
-    });
-    m_renderTimer.setInterval(16);
+    // Swap interval 1 throttles each swap to a vsync; repainting from
+    // frameSwapped() then draws exactly one frame per refresh
+    QSurfaceFormat fmt = format();
+    fmt.setSwapInterval(1);
+    setFormat(fmt);
+    connect(this, &QOpenGLWidget::frameSwapped, this, &FlickerWidget::onFrameSwapped);
     setupGlobalShortcut();
 }
 
@@ -95,8 +101,19 @@ FlickerWidget::~FlickerWidget()
 void FlickerWidget::startFlicker()
 {
     m_running = true;
+    m_phase = 0.0;
+    m_refreshPeriodNs = 1.0e9 / nominalRefreshRate();
+    m_refreshMeasured = false;
+    m_lastSwapNs = -1;
+    m_frames = 0;
+    m_droppedFrames = 0;
+    m_frameTimePos = 0;
+    m_frameTimeFill = 0;
+    m_framesSinceEstimate = 0;
+    m_audioLocked = false;
+    m_beatLocked = false;
+    m_avOffsetValid = false;
     m_elapsed.restart();
-    m_renderTimer.start();
     show();
     raise();
     update();
@@ -106,7 +123,6 @@ void FlickerWidget::startFlicker()
 void FlickerWidget::stopFlicker()
 {
     m_running = false;
-    m_renderTimer.stop();
     emit flickerStopped();
 }
 
@@ -189,16 +205,14 @@ void FlickerWidget::paintGL()
         return;
     }
 
-    float t        = static_cast<float>(m_elapsed.elapsed()) / 1000.0f;
-    float phase    = std::fmod(t * static_cast<float>(m_frequency), 1.0f);
+    float phase    = static_cast<float>(m_phase);
     int   dynamicN = qMax(1, static_cast<int>(m_frequency * m_subliminalFactor));
     bool  texFrame = phase < (1.0f / static_cast<float>(dynamicN));
 
     bool  showTex  = m_hasTex && (m_subliminalMode == 1 || m_subliminalMode == 2)
                      && (m_subliminalMode == 1 ? texFrame : true);
     m_program->bind();
-    m_program->setUniformValue(m_uTime,      t);
-    m_program->setUniformValue(m_uFreq,      static_cast<float>(m_frequency));
+    m_program->setUniformValue(m_uPhase,     phase);
     m_program->setUniformValue(m_uIntensity, m_intensity);
     m_program->setUniformValue(m_uEnvelope,  static_cast<int>(m_envelope));
     m_program->setUniformValue(m_uOnColor,
@@ -246,6 +260,167 @@ void FlickerWidget::setSubliminalFactor(float newSubliminalFactor)
     m_subliminalFactor = newSubliminalFactor;
 }
 
+
+void FlickerWidget::onFrameSwapped()
+{
+    if (!m_running)
+        return;
+
+    // A swap more than one refresh after the last means the display
+    // repeated a frame; the phase still advances by every refresh so the
+    // flicker stays on its timeline
+    const qint64 now = m_elapsed.nsecsElapsed();
+    qint64 refreshes = 1;
+    if (m_lastSwapNs >= 0) {
+        const qint64 interval = now - m_lastSwapNs;
+        refreshes = qMax<qint64>(1, std::llround(interval / m_refreshPeriodNs));
+        m_droppedFrames += refreshes - 1;
+
+        m_frameTimesNs[m_frameTimePos] = interval;
+        m_frameTimePos = (m_frameTimePos + 1) % FRAME_HISTORY;
+        m_frameTimeFill = qMin(m_frameTimeFill + 1, FRAME_HISTORY);
+        if (++m_framesSinceEstimate >= REFRESH_UPDATE_FRAMES && m_frameTimeFill >= MIN_REFRESH_SAMPLES)
+            estimateRefresh();
+    }
+    m_lastSwapNs = now;
+    ++m_frames;
+
+    advancePhase(refreshes);
+    update();
+}
+
+// Sets the phase of the next frame, which appears one refresh after
+// this swap
+void FlickerWidget::advancePhase(qint64 refreshes)
+{
+    const double hz = displayedFrequency();
+    const double periodSeconds = m_refreshPeriodNs * 1.0e-9;
+
+    DynamicEngine::SampleClock clock;
+    if (m_audioEngine)
+        clock = m_audioEngine->sampleClock();
+    if (!clock.running || clock.sampleRate <= 0) {
+        m_audioLocked = false;
+        m_beatLocked = false;
+        m_avOffsetValid = false;
+        m_phase = std::fmod(m_phase + refreshes * periodSeconds * hz, 1.0);
+        return;
+    }
+
+    // The frame just swapped in shows m_phase while the sound is at
+    // the beat phase the clock reports; their difference, in time at
+    // the common frequency, is the audio-visual offset
+    const bool beatMatches = clock.beatValid && std::abs(clock.beatHz - hz) <= BEAT_MATCH_HZ;
+    if (m_beatLocked && beatMatches && clock.sampleRate == m_anchorRate && hz == m_anchorHz) {
+        double cycles = std::fmod(m_phase - clock.beatPhase, 1.0);
+        if (cycles >= 0.5)
+            cycles -= 1.0;
+        else if (cycles < -0.5)
+            cycles += 1.0;
+        const double offsetMs = cycles / hz * 1000.0;
+        m_avOffsetMs = m_avOffsetValid ? m_avOffsetMs + AV_OFFSET_SMOOTHING * (offsetMs - m_avOffsetMs)
+                                       : offsetMs;
+        m_avOffsetValid = true;
+    }
+
+    // Anchor on the sound's beat when it runs at the flicker frequency,
+    // else continue the current phase on the sample clock
+    if (!m_audioLocked || clock.sampleRate != m_anchorRate || hz != m_anchorHz || beatMatches != m_beatLocked) {
+        m_anchorFrames = clock.frames;
+        m_anchorPhase = beatMatches ? clock.beatPhase : m_phase;
+        m_anchorHz = hz;
+        m_anchorRate = clock.sampleRate;
+        m_audioLocked = true;
+        m_beatLocked = beatMatches;
+        m_avOffsetValid = false;
+    }
+
+    const double nextFrameClock = clock.frames + periodSeconds * clock.sampleRate;
+    const double cycles = (nextFrameClock - m_anchorFrames) / clock.sampleRate * hz;
+    m_phase = std::fmod(m_anchorPhase + cycles, 1.0);
+}
+
+void FlickerWidget::setAudioClock(DynamicEngine *engine)
+{
+    m_audioEngine = engine;
+    m_audioLocked = false;
+}
+
+// The median frame time is the refresh period as long as fewer than
+// half the frames are dropped
+void FlickerWidget::estimateRefresh()
+{
+    qint64 sorted[FRAME_HISTORY];
+    std::copy(m_frameTimesNs, m_frameTimesNs + m_frameTimeFill, sorted);
+    std::nth_element(sorted, sorted + m_frameTimeFill / 2, sorted + m_frameTimeFill);
+    m_refreshPeriodNs = static_cast<double>(sorted[m_frameTimeFill / 2]);
+    m_refreshMeasured = true;
+    m_framesSinceEstimate = 0;
+}
+
+double FlickerWidget::nominalRefreshRate() const
+{
+    const double hz = screen() ? screen()->refreshRate() : 0.0;
+    return hz > 0.0 ? hz : 60.0;
+}
+
+double FlickerWidget::refreshRate() const
+{
+    return m_refreshMeasured ? 1.0e9 / m_refreshPeriodNs : nominalRefreshRate();
+}
+
+double FlickerWidget::framesPerCycle() const
+{
+    return refreshRate() / m_frequency;
+}
+
+double FlickerWidget::displayedFrequency() const
+{
+    if (!m_quantize)
+        return m_frequency;
+    return refreshRate() / qMax(2.0, std::round(framesPerCycle()));
+}
+
+bool FlickerWidget::isFrequencyAccurate() const
+{
+    const double frames = framesPerCycle();
+    return frames >= 2.0 && std::abs(frames - std::round(frames)) <= FRAME_TOLERANCE;
+}
+
+void FlickerWidget::setQuantizeToRefresh(bool enabled)
+{
+    m_quantize = enabled;
+}
+
+FlickerWidget::FrameStats FlickerWidget::frameStats() const
+{
+    FrameStats stats;
+    stats.refreshHz = refreshRate();
+    stats.refreshMeasured = m_refreshMeasured;
+    stats.frames = m_frames;
+    stats.droppedFrames = m_droppedFrames;
+    stats.audioLocked = m_running && m_audioLocked;
+    stats.beatLocked = stats.audioLocked && m_beatLocked;
+    stats.avOffsetValid = stats.beatLocked && m_avOffsetValid;
+    stats.avOffsetMs = m_avOffsetMs;
+    if (m_frameTimeFill == 0)
+        return stats;
+
+    double sum = 0.0;
+    double sumSquares = 0.0;
+    qint64 longest = 0;
+    for (int i = 0; i < m_frameTimeFill; ++i) {
+        const double ms = m_frameTimesNs[i] * 1.0e-6;
+        sum += ms;
+        sumSquares += ms * ms;
+        longest = qMax(longest, m_frameTimesNs[i]);
+    }
+    stats.meanFrameMs = sum / m_frameTimeFill;
+    stats.maxFrameMs = longest * 1.0e-6;
+    stats.jitterMs = std::sqrt(qMax(0.0, sumSquares / m_frameTimeFill - stats.meanFrameMs * stats.meanFrameMs));
+    return stats;
+}
+
 void FlickerWidget::rebuildTextTexture()
 {
     if (!isValid() || width() <= 0 || height() <= 0)
@@ -317,8 +492,7 @@ void FlickerWidget::buildShader()
     if (!m_program->link())
         qWarning() << "FlickerWidget: link error:" << m_program->log();
 
-    m_uTime       = m_program->uniformLocation("uTime");
-    m_uFreq       = m_program->uniformLocation("uFreq");
+    m_uPhase      = m_program->uniformLocation("uPhase");
     m_uIntensity  = m_program->uniformLocation("uIntensity");
     m_uEnvelope   = m_program->uniformLocation("uEnvelope");
     m_uOnColor    = m_program->uniformLocation("uOnColor");
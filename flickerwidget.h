@@ -3,11 +3,12 @@
 #include <QOpenGLFunctions>
 #include <QOpenGLShaderProgram>
 #include <QElapsedTimer>
-#include <QTimer>
 #include <QColor>
 #include <QString>
 #include <QEvent>
 
+class DynamicEngine;
+
 class FlickerWidget : public QOpenGLWidget, protected QOpenGLFunctions
 {
     Q_OBJECT
@@ -20,6 +21,49 @@ public:
     bool isRunning() const { return m_running; }
     void setSubliminalFactor(float newSubliminalFactor);
 
+    // Frames are paced by the display: each swap schedules the next
+    // repaint, so the flicker advances exactly one refresh per frame.
+    struct FrameStats {
+        double  refreshHz       = 0.0;   // Measured while running, else the screen's nominal rate
+        bool    refreshMeasured = false;
+        quint64 frames          = 0;     // Presented since startFlicker()
+        quint64 droppedFrames   = 0;     // Refreshes that repeated the previous frame
+        double  meanFrameMs     = 0.0;   // Over the last FRAME_HISTORY frames
+        double  maxFrameMs      = 0.0;
+        double  jitterMs        = 0.0;   // Standard deviation of the frame time
+        bool    audioLocked     = false; // Phase follows the audio sample clock
+        bool    beatLocked      = false; // Anchored on the sound's beat, which runs at the flicker frequency
+        bool    avOffsetValid   = false; // Only while beat locked
+        double  avOffsetMs      = 0.0;   // Shown phase minus beat phase heard at the swap, smoothed;
+                                         // positive when the light leads
+    };
+    FrameStats frameStats() const;
+
+    double frequency() const { return m_frequency; }
+    double refreshRate() const;
+    double framesPerCycle() const;     // At the requested frequency
+    double displayedFrequency() const; // Requested, or quantized when locked to the refresh
+    bool   isFrequencyAccurate() const;
+
+    // Rounds the frequency to a whole number of frames per cycle, so
+    // every cycle is drawn identically instead of beating against vsync
+    void setQuantizeToRefresh(bool enabled);
+    bool quantizeToRefresh() const { return m_quantize; }
+
+    // While the engine's output runs, the phase is derived from its
+    // sample clock rather than counted in refreshes, so light and sound
+    // cannot drift apart, and starts from the sound's beat phase when the
+    // beat runs at the flicker frequency; otherwise it runs on the
+    // display clock
+    void setAudioClock(DynamicEngine *engine);
+
+    static constexpr int    FRAME_HISTORY         = 240;
+    static constexpr int    MIN_REFRESH_SAMPLES   = 30;
+    static constexpr int    REFRESH_UPDATE_FRAMES = 60;
+    static constexpr double FRAME_TOLERANCE       = 0.01; // Frames per cycle off a whole number
+    static constexpr double AV_OFFSET_SMOOTHING   = 0.05; // Per frame
+    static constexpr double BEAT_MATCH_HZ         = 0.01; // Beat and flicker taken as the same frequency
+
 public slots:
     void setFrequency(double hz);
     void setEnvelope(Envelope env);
@@ -43,10 +87,40 @@ private:
     void buildShader();
     void rebuildTextTexture();
     float computeBrightness(float phase) const;
+    void onFrameSwapped();
+    void advancePhase(qint64 refreshes);
+    void estimateRefresh();
+    double nominalRefreshRate() const;
 
     QOpenGLShaderProgram *m_program = nullptr;
     QElapsedTimer         m_elapsed;
-    QTimer                m_renderTimer;
+
+    // Frame pacing, all on the GUI thread
+    double   m_phase           = 0.0;   // Of the next frame, in cycles
+    bool     m_quantize        = false;
+    double   m_refreshPeriodNs = 1.0e9 / 60.0;
+    bool     m_refreshMeasured = false;
+    qint64   m_lastSwapNs      = -1;
+    quint64  m_frames          = 0;
+    quint64  m_droppedFrames   = 0;
+    qint64   m_frameTimesNs[FRAME_HISTORY] = {};
+    int      m_frameTimePos    = 0;
+    int      m_frameTimeFill   = 0;
+    int      m_framesSinceEstimate = 0;
+
+    // Audio lock; the phase is continued from an anchor on the sample
+    // clock, moved whenever the frequency or sample rate changes or the
+    // beat starts or stops matching. A beat-locked anchor takes the
+    // beat's phase at the anchor frame.
+    DynamicEngine *m_audioEngine = nullptr;
+    bool     m_audioLocked     = false;
+    bool     m_beatLocked      = false;
+    double   m_anchorFrames    = 0.0;
+    double   m_anchorPhase     = 0.0;
+    double   m_anchorHz        = 0.0;
+    int      m_anchorRate      = 0;
+    bool     m_avOffsetValid   = false;
+    double   m_avOffsetMs      = 0.0;
 
     bool     m_running   = false;
     double   m_frequency = 10.0;
@@ -64,8 +138,7 @@ private:
     GLuint   m_textTex    = 0;
     bool     m_hasTex     = false;
 
-    int m_uTime        = -1;
-    int m_uFreq        = -1;
+    int m_uPhase       = -1;
     int m_uIntensity   = -1;
     int m_uEnvelope    = -1;
     int m_uOnColor     = -1;
@@ -0,0 +1,80 @@
+#ifndef LEVELMETER_H
+#define LEVELMETER_H
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+
+// ============================================================
+// LEVEL METER
+// ============================================================
+// Lock-free hand-over of output levels from the render side to the
+// GUI. The four levels (linear, full scale 1.0) are packed as 16-bit
+// fixed point into one atomic word, so a reader never sees peak and RMS
+// from different blocks. publish() is called once per rendered block
+// and keeps the highest peaks since the last take(); RMS is the latest
+// block's. The GUI calls take() at display rate, which clears the peaks
+// so the next poll shows only what was played since.
+
+class LevelMeter
+{
+public:
+    struct Levels {
+        float peakLeft = 0.0f;
+        float peakRight = 0.0f;
+        float rmsLeft = 0.0f;
+        float rmsRight = 0.0f;
+
+        float peak() const { return std::max(peakLeft, peakRight); }
+    };
+
+    // Render side
+    void publish(const Levels &levels)
+    {
+        const std::uint64_t rms = pack(levels.rmsLeft) << RMS_LEFT_SHIFT
+                                | pack(levels.rmsRight) << RMS_RIGHT_SHIFT;
+        std::uint64_t previous = m_packed.load(std::memory_order_relaxed);
+        std::uint64_t next;
+        do {
+            next = rms
+                 | std::max(pack(levels.peakLeft), field(previous, PEAK_LEFT_SHIFT)) << PEAK_LEFT_SHIFT
+                 | std::max(pack(levels.peakRight), field(previous, PEAK_RIGHT_SHIFT)) << PEAK_RIGHT_SHIFT;
+        } while (!m_packed.compare_exchange_weak(previous, next, std::memory_order_relaxed));
+    }
+
+    // GUI side
+    Levels take()
+    {
+        const std::uint64_t packed = m_packed.fetch_and(RMS_MASK, std::memory_order_relaxed);
+        Levels levels;
+        levels.peakLeft = unpack(field(packed, PEAK_LEFT_SHIFT));
+        levels.peakRight = unpack(field(packed, PEAK_RIGHT_SHIFT));
+        levels.rmsLeft = unpack(field(packed, RMS_LEFT_SHIFT));
+        levels.rmsRight = unpack(field(packed, RMS_RIGHT_SHIFT));
+        return levels;
+    }
+
+    void clear() { m_packed.store(0, std::memory_order_relaxed); }
+
+private:
+    static constexpr int PEAK_LEFT_SHIFT = 0;
+    static constexpr int PEAK_RIGHT_SHIFT = 16;
+    static constexpr int RMS_LEFT_SHIFT = 32;
+    static constexpr int RMS_RIGHT_SHIFT = 48;
+    static constexpr std::uint64_t RMS_MASK = 0xFFFFFFFF00000000ull;
+    static constexpr float FULL_SCALE = 65535.0f;
+
+    // Saturates at full scale; the float path can overshoot it
+    static std::uint64_t pack(float level)
+    {
+        return static_cast<std::uint64_t>(std::clamp(level, 0.0f, 1.0f) * FULL_SCALE + 0.5f);
+    }
+
+    static float unpack(std::uint64_t value) { return value / FULL_SCALE; }
+
+    static std::uint64_t field(std::uint64_t packed, int shift) { return (packed >> shift) & 0xFFFF; }
+
+    std::atomic<std::uint64_t> m_packed{0};
+};
+
+#endif // LEVELMETER_H
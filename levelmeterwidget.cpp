@@ -0,0 +1,97 @@
+#include "levelmeterwidget.h"
+
+#include <QPainter>
+#include <algorithm>
+#include <cmath>
+
+LevelMeterWidget::LevelMeterWidget(QWidget *parent)
+    : QWidget(parent)
+{
+    setSizePolicy(QSizePolicy::Fixed, QSizePolicy::Fixed);
+    setToolTip("Output level (RMS bar, peak tick; -60 to 0 dBFS)");
+    m_clock.start();
+}
+
+QSize LevelMeterWidget::sizeHint() const
+{
+    return QSize(90, 18);
+}
+
+double LevelMeterWidget::toDb(float level)
+{
+    return level > 0.0f ? std::max(FLOOR_DB, 20.0 * std::log10(level)) : FLOOR_DB;
+}
+
+void LevelMeterWidget::updateChannel(Channel &channel, float rms, float peak, qint64 nowMs, double fallDb)
+{
+    channel.rmsDb = std::max(toDb(rms), channel.rmsDb - fallDb);
+
+    const double peakDb = toDb(peak);
+    if (peakDb >= channel.peakDb) {
+        channel.peakDb = peakDb;
+        channel.peakHeldMs = nowMs;
+    } else if (nowMs - channel.peakHeldMs > PEAK_HOLD_MS) {
+        channel.peakDb = std::max(peakDb, channel.peakDb - fallDb);
+    }
+}
+
+void LevelMeterWidget::setLevels(const LevelMeter::Levels &levels)
+{
+    const qint64 nowMs = m_clock.elapsed();
+    const double fallDb = FALL_DB_PER_S * (nowMs - m_lastUpdateMs) / 1000.0;
+    m_lastUpdateMs = nowMs;
+
+    updateChannel(m_left, levels.rmsLeft, levels.peakLeft, nowMs, fallDb);
+    updateChannel(m_right, levels.rmsRight, levels.peakRight, nowMs, fallDb);
+    update();
+}
+
+void LevelMeterWidget::clear()
+{
+    m_left = Channel();
+    m_right = Channel();
+    update();
+}
+
+void LevelMeterWidget::paintEvent(QPaintEvent *event)
+{
+    Q_UNUSED(event);
+
+    QPainter painter(this);
+    const QRect area = rect().adjusted(0, 1, -1, -2);
+    painter.fillRect(area, palette().color(QPalette::Base));
+
+    const int barHeight = std::max(1, (area.height() - 1) / 2);
+    const Channel *channels[2] = { &m_left, &m_right };
+    for (int c = 0; c < 2; ++c) {
+        const Channel &channel = *channels[c];
+        const int top = area.top() + c * (barHeight + 1);
+        auto toX = [&area](double db) {
+            return area.left() + qRound((db - FLOOR_DB) / -FLOOR_DB * area.width());
+        };
+
+        // Green up to -12 dB, amber to -3 dB, red above
+        const int rmsX = toX(channel.rmsDb);
+        const int amberX = toX(-12.0);
+        const int redX = toX(-3.0);
+        painter.fillRect(QRect(QPoint(area.left(), top), QPoint(std::min(rmsX, amberX), top + barHeight - 1)),
+                         QColor(60, 180, 75));
+        if (rmsX > amberX) {
+            painter.fillRect(QRect(QPoint(amberX, top), QPoint(std::min(rmsX, redX), top + barHeight - 1)),
+                             QColor(230, 170, 30));
+        }
+        if (rmsX > redX) {
+            painter.fillRect(QRect(QPoint(redX, top), QPoint(rmsX, top + barHeight - 1)),
+                             QColor(220, 50, 40));
+        }
+
+        if (channel.peakDb > FLOOR_DB) {
+            const int peakX = std::min(toX(channel.peakDb), area.right());
+            painter.fillRect(QRect(peakX - 1, top, 2, barHeight),
+                             channel.peakDb > -3.0 ? QColor(220, 50, 40) : palette().color(QPalette::Text));
+        }
+    }
+
+    painter.setPen(palette().color(QPalette::Mid));
+    painter.drawRect(area);
+}
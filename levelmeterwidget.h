@@ -0,0 +1,50 @@
+#ifndef LEVELMETERWIDGET_H
+#define LEVELMETERWIDGET_H
+
+#include "levelmeter.h"
+
+#include <QElapsedTimer>
+#include <QWidget>
+
+// Compact stereo level meter for a toolbar: one bar per channel on a
+// dB scale from FLOOR_DB to 0 dBFS. The bar shows RMS and falls back at
+// FALL_DB_PER_S; a tick marks the peak, held for PEAK_HOLD_MS before it
+// falls too. Fed at display rate from an engine's audioLevels().
+
+class LevelMeterWidget : public QWidget
+{
+    Q_OBJECT
+
+public:
+    explicit LevelMeterWidget(QWidget *parent = nullptr);
+
+    QSize sizeHint() const override;
+
+    static constexpr double FLOOR_DB = -60.0;
+    static constexpr double FALL_DB_PER_S = 24.0;
+    static constexpr int PEAK_HOLD_MS = 1000;
+
+public slots:
+    void setLevels(const LevelMeter::Levels &levels);
+    void clear();
+
+protected:
+    void paintEvent(QPaintEvent *event) override;
+
+private:
+    struct Channel {
+        double rmsDb = FLOOR_DB;
+        double peakDb = FLOOR_DB;
+        qint64 peakHeldMs = 0; // On m_clock
+    };
+
+    void updateChannel(Channel &channel, float rms, float peak, qint64 nowMs, double fallDb);
+    static double toDb(float level);
+
+    Channel m_left;
+    Channel m_right;
+    QElapsedTimer m_clock;
+    qint64 m_lastUpdateMs = 0;
+};
+
+#endif // LEVELMETERWIDGET_H
@@ -0,0 +1,121 @@
+#include "loghistogram.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <QtAlgorithms>
+
+int LogHistogram::bucketIndex(quint64 value)
+{
+    if (value < SUB_BUCKETS) {
+        return static_cast<int>(value);
+    }
+    // Power of two, then the SUB_BUCKET_BITS bits below the leading one
+    const int msb = 63 - static_cast<int>(qCountLeadingZeroBits(value));
+    const int sub = static_cast<int>(value >> (msb - SUB_BUCKET_BITS)) & (SUB_BUCKETS - 1);
+    return (msb - SUB_BUCKET_BITS + 1) * SUB_BUCKETS + sub;
+}
+
+quint64 LogHistogram::bucketLowerBound(int index)
+{
+    if (index < SUB_BUCKETS) {
+        return static_cast<quint64>(index);
+    }
+    const int group = index / SUB_BUCKETS;
+    const int sub = index % SUB_BUCKETS;
+    return static_cast<quint64>(SUB_BUCKETS + sub) << (group - 1);
+}
+
+quint64 LogHistogram::bucketUpperBound(int index)
+{
+    if (index + 1 >= BUCKETS) {
+        return std::numeric_limits<quint64>::max();
+    }
+    return bucketLowerBound(index + 1) - 1;
+}
+
+void LogHistogram::record(quint64 value)
+{
+    m_buckets[bucketIndex(value)].fetch_add(1, std::memory_order_relaxed);
+    m_sum.fetch_add(value, std::memory_order_relaxed);
+    if (value > m_max.load(std::memory_order_relaxed)) {
+        m_max.store(value, std::memory_order_relaxed); // Single writer
+    }
+    m_count.fetch_add(1, std::memory_order_release);
+}
+
+void LogHistogram::reset()
+{
+    m_count.store(0, std::memory_order_relaxed);
+    m_sum.store(0, std::memory_order_relaxed);
+    m_max.store(0, std::memory_order_relaxed);
+    for (auto &bucket : m_buckets) {
+        bucket.store(0, std::memory_order_relaxed);
+    }
+}
+
+LogHistogram::Snapshot LogHistogram::snapshot() const
+{
+    Snapshot snapshot;
+    snapshot.count = m_count.load(std::memory_order_acquire);
+    snapshot.sum = m_sum.load(std::memory_order_relaxed);
+    snapshot.max = m_max.load(std::memory_order_relaxed);
+    for (int i = 0; i < BUCKETS; ++i) {
+        snapshot.buckets[i] = m_buckets[i].load(std::memory_order_relaxed);
+    }
+    return snapshot;
+}
+
+double LogHistogram::Snapshot::mean() const
+{
+    return count > 0 ? static_cast<double>(sum) / count : 0.0;
+}
+
+quint64 LogHistogram::Snapshot::percentile(double p) const
+{
+    quint64 total = 0;
+    for (quint64 bucket : buckets) {
+        total += bucket;
+    }
+    if (total == 0) {
+        return 0;
+    }
+
+    const quint64 rank = std::max<quint64>(1, static_cast<quint64>(std::ceil(std::clamp(p, 0.0, 100.0) / 100.0 * total)));
+    quint64 seen = 0;
+    for (int i = 0; i < BUCKETS; ++i) {
+        seen += buckets[i];
+        if (seen >= rank) {
+            return std::min(bucketUpperBound(i), max);
+        }
+    }
+    return max;
+}
+
+quint64 LogHistogram::Snapshot::countAbove(quint64 value) const
+{
+    quint64 above = 0;
+    for (int i = bucketIndex(value) + 1; i < BUCKETS; ++i) {
+        above += buckets[i];
+    }
+    return above;
+}
+
+LogHistogram::Snapshot LogHistogram::Snapshot::since(const Snapshot &earlier) const
+{
+    // Reset in between: everything here is new
+    if (earlier.count > count) {
+        return *this;
+    }
+
+    Snapshot delta;
+    delta.count = count - earlier.count;
+    delta.sum = sum - earlier.sum;
+    for (int i = 0; i < BUCKETS; ++i) {
+        delta.buckets[i] = buckets[i] >= earlier.buckets[i] ? buckets[i] - earlier.buckets[i] : buckets[i];
+        if (delta.buckets[i] > 0) {
+            delta.max = std::min(bucketUpperBound(i), max);
+        }
+    }
+    return delta;
+}
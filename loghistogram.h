@@ -0,0 +1,59 @@
+#ifndef LOGHISTOGRAM_H
+#define LOGHISTOGRAM_H
+
+#include <QtGlobal>
+#include <array>
+#include <atomic>
+
+// ============================================================
+// LOG HISTOGRAM
+// ============================================================
+// Lock-free histogram of non-negative integers for timing data that
+// is recorded on the audio or render thread and read from the GUI.
+// Buckets are logarithmic with SUB_BUCKETS steps per power of two, so
+// every recorded value lands in a bucket at most 25% wider than it and
+// the whole 64-bit range fits in a fixed array: recording is one index
+// computation and a few relaxed atomic adds, with no allocation.
+//
+// One thread records; any thread may take a snapshot. A snapshot taken
+// while a value is being recorded can miss that value in some fields,
+// which is harmless for statistics.
+
+class LogHistogram
+{
+public:
+    static constexpr int SUB_BUCKET_BITS = 2;
+    static constexpr int SUB_BUCKETS = 1 << SUB_BUCKET_BITS;
+    static constexpr int BUCKETS = (64 - SUB_BUCKET_BITS + 1) * SUB_BUCKETS;
+
+    struct Snapshot {
+        std::array<quint64, BUCKETS> buckets = {};
+        quint64 count = 0;
+        quint64 sum = 0;
+        quint64 max = 0;
+
+        double mean() const;
+        quint64 percentile(double p) const; // Upper bound of the bucket holding it, p in [0, 100]
+        quint64 countAbove(quint64 value) const; // Values in buckets wholly above value
+
+        // What was recorded between earlier and this snapshot; max is
+        // the upper bound of the highest bucket that changed
+        Snapshot since(const Snapshot &earlier) const;
+    };
+
+    void record(quint64 value);
+    void reset();
+    Snapshot snapshot() const;
+
+    static int bucketIndex(quint64 value);
+    static quint64 bucketLowerBound(int index);
+    static quint64 bucketUpperBound(int index); // Largest value in the bucket
+
+private:
+    std::array<std::atomic<quint64>, BUCKETS> m_buckets = {};
+    std::atomic<quint64> m_count{0};
+    std::atomic<quint64> m_sum{0};
+    std::atomic<quint64> m_max{0};
+};
+
+#endif // LOGHISTOGRAM_H
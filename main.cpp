@@ -1,5 +1,6 @@
 #include "mainwindow.h"
 #include"constants.h"
+#include "commandline.h"
 #include <QApplication>
 #include<QDir>
 #include<QTimer>
@@ -22,6 +23,12 @@ int main(int argc, char *argv[])
     QApplication::setOrganizationName("Alamahant");
     QApplication::setApplicationVersion("1.7.0");
 
+    // --render / --bench run without widgets or an audio device
+    if (CommandLine::isHeadlessInvocation(argc, argv)) {
+        QCoreApplication app(argc, argv);
+        return CommandLine::runHeadless(app);
+    }
+
     QApplication a(argc, argv);
 
 #ifndef FLATPAK_BUILD
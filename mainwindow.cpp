@@ -3,6 +3,7 @@
 #include "constants.h"
 #include "donationdialog.h"
 #include "helpmenudialog.h"
+#include <QActionGroup>
 #include <QApplication>
 #include <QAudioOutput>
 #include <QAudioSink>
@@ -108,7 +109,6 @@ MainWindow::MainWindow(QWidget *parent)
     copyUserFiles();
     bool unlimited = settings.value("binaural/unlimitedDuration", false).toBool();
     m_sessionManagerDialog->setUnlimitedDuration(unlimited);
-    m_fadeTimer.setInterval(50);
 
     setupVideoPlayer();
 
@@ -412,6 +412,9 @@ QToolBar *MainWindow::createBinauralToolbar() {
     m_binauralVolumeInput->setEnabled(false);
     toolbar->addWidget(m_binauralVolumeInput);
 
+    m_levelMeter = new LevelMeterWidget(toolbar);
+    toolbar->addWidget(m_levelMeter);
+
     toolbar->addSeparator();
 
     return toolbar;
@@ -504,6 +507,11 @@ QToolBar *MainWindow::createBinauralToolbarExt() {
     m_binauralStopButton->setEnabled(false);
     toolbar->addWidget(m_binauralStopButton);
 
+    m_latencyLabel = new QLabel(toolbar);
+    m_latencyLabel->setToolTip("Output latency (device buffer + render-ahead).\n"
+                               "Change it under Settings > Output Latency");
+    toolbar->addWidget(m_latencyLabel);
+
     //noise controls
     toolbar->addSeparator();
     noiseEnableBtn = new QPushButton(this);
@@ -1106,6 +1114,17 @@ void MainWindow::setupConnections() {
             &MainWindow::onBinauralPlaybackStopped);
     connect(m_binauralEngine, &DynamicEngine::errorOccurred, this,
             &MainWindow::onBinauralError);
+    connect(m_binauralEngine, &DynamicEngine::latencyChanged, this, [this](double ms) {
+        m_latencyLabel->setText(QString("%1 ms").arg(qRound(ms)));
+    });
+    m_latencyLabel->setText(QString("%1 ms").arg(qRound(m_binauralEngine->outputLatencyMs())));
+    connect(m_binauralEngine, &DynamicEngine::audioLevelChanged, this, [this]() {
+        if (m_binauralEngine->isPlaying() || m_binauralEngine->isAmbientPlaying()) {
+            m_levelMeter->setLevels(m_binauralEngine->audioLevels());
+        } else {
+            m_levelMeter->clear();
+        }
+    });
 
     connect(savePresetAction, &QAction::triggered, this,
             &MainWindow::onSavePresetClicked);
@@ -1138,39 +1157,27 @@ void MainWindow::setupConnections() {
         m_sessionManagerDialog->setUnlimitedDuration(checked);
     });
 
-    connect(&m_fadeTimer, &QTimer::timeout, this, [this]() {
+    connect(m_sessionManagerDialog, &SessionDialog::fadeRequested, this,
+            [this](double targetVolume) {
+        if (m_binauralEngine->getVolume() * 100 == targetVolume)
+            return;
+
         if (m_sessionManagerDialog) {
             m_sessionManagerDialog->pauseButton()->setDisabled(true);
             m_sessionManagerDialog->stopButton()->setDisabled(true);
         }
-
-        m_fadeSteps++;
-
-        double progress = m_fadeSteps / 100.0;
-        double vol =
-                m_fadeStartVolume + (m_fadeTargetVolume - m_fadeStartVolume) * progress;
-        m_binauralVolumeInput->setValue(vol);
-
-        if (m_fadeSteps >= 100) {
-            m_fadeTimer.stop();
-            m_binauralVolumeInput->setValue(m_fadeTargetVolume);
-            if (m_sessionManagerDialog) {
-                m_sessionManagerDialog->pauseButton()->setEnabled(true);
-                m_sessionManagerDialog->stopButton()->setEnabled(true);
-            }
-        }
+        m_binauralEngine->fadeTo(targetVolume / 100.0, SESSION_FADE_MS);
     });
 
-    connect(m_sessionManagerDialog, &SessionDialog::fadeRequested, this,
-            [this](double targetVolume) {
-        m_fadeStartVolume = m_binauralEngine->getVolume() * 100;
-
-        if (m_fadeStartVolume == targetVolume)
-            return;
-
-        m_fadeTargetVolume = targetVolume;
-        m_fadeSteps = 0;
-        m_fadeTimer.start();
+    connect(m_binauralEngine, &DynamicEngine::fadeFinished, this, [this](double volume) {
+        {
+            QSignalBlocker blocker(m_binauralVolumeInput);
+            m_binauralVolumeInput->setValue(volume * 100);
+        }
+        if (m_sessionManagerDialog) {
+            m_sessionManagerDialog->pauseButton()->setEnabled(true);
+            m_sessionManagerDialog->stopButton()->setEnabled(true);
+        }
     });
 
     connect(m_sessionManagerDialog, &SessionDialog::pauseRequested, this, [this] {
@@ -2109,6 +2116,7 @@ void MainWindow::onToneTypeComboIndexChanged(int index) {
 
     case BINAURAL:
         ConstantGlobals::currentToneType = 0; // Set to 0
+        m_binauralEngine->setToneType(0);
         m_rightFreqInput->setEnabled(true);
         m_leftFreqInput->setValue(360.00);
         m_rightFreqInput->setValue(367.83);
@@ -2118,6 +2126,7 @@ void MainWindow::onToneTypeComboIndexChanged(int index) {
         break;
     case ISOCHRONIC:
         ConstantGlobals::currentToneType = 1; // Set to 0
+        m_binauralEngine->setToneType(1);
         m_leftFreqInput->setValue(360.00);
         m_pulseFreqLabel->setValue(7.83);
         m_rightFreqInput->setDisabled(true);
@@ -2129,6 +2138,7 @@ void MainWindow::onToneTypeComboIndexChanged(int index) {
 
     case GENERATOR:
         ConstantGlobals::currentToneType = 2; // Set to 0
+        m_binauralEngine->setToneType(2);
         m_leftFreqInput->setValue(360.00);
         m_rightFreqInput->setValue(360.00);
         m_rightFreqInput->setEnabled(true);
@@ -2149,13 +2159,12 @@ void MainWindow::onMuteButtonClicked() {
     mutePlayingAmbientPlayers(checked);
     m_audioOutput->setMuted(checked);
 
-    QAudioSink *binauralOutput =
-            m_binauralEngine ? m_binauralEngine->audioOutput() : nullptr;
+    if (m_binauralEngine) {
+        m_binauralEngine->setMuted(checked);
+    }
     if (checked) {
 
-        if (binauralOutput) {
-            binEngineVolume = binauralOutput->volume();
-            binauralOutput->setVolume(0);
+        if (m_binauralEngine) {
             m_binauralStopButton->setDisabled(true);
         }
         volumeIcon->setIcon(QIcon(":/icons/volume-x.svg"));
@@ -2168,8 +2177,7 @@ void MainWindow::onMuteButtonClicked() {
         m_stopMusicButton->setEnabled(true);
         m_masterStopButton->setEnabled(true);
 
-        if (binauralOutput) {
-            binauralOutput->setVolume(binEngineVolume);
+        if (m_binauralEngine && m_binauralEngine->isPlaying()) {
             m_binauralStopButton->setEnabled(true);
         }
     }
@@ -2802,6 +2810,7 @@ void MainWindow::onLoadPresetClicked() {
     }
 
     ConstantGlobals::currentToneType = preset.toneType;
+    m_binauralEngine->setToneType(preset.toneType);
     toneTypeCombo->setCurrentIndex(preset.toneType);
     m_leftFreqInput->setValue(preset.leftFrequency);
     m_rightFreqInput->setValue(preset.rightFrequency);
@@ -3406,6 +3415,25 @@ void MainWindow::setupMenus() {
         toggleTheme(enableDark);
     });
     viewMenu->addAction(enableDarkThemeAction);
+    viewMenu->addSeparator();
+
+    m_diagnosticsDialog = new AudioDiagnosticsDialog(m_binauralEngine, this);
+    QAction *diagnosticsAction = viewMenu->addAction("Audio Diagnostics...");
+    diagnosticsAction->setToolTip("Render time, callback timing and underruns of the binaural "
+                                  "engine, with CSV export");
+    connect(diagnosticsAction, &QAction::triggered, this, [this] {
+        m_diagnosticsDialog->show();
+        m_diagnosticsDialog->raise();
+    });
+
+    m_analyzerDialog = new OutputAnalyzerDialog(m_binauralEngine, this);
+    QAction *analyzerAction = viewMenu->addAction("Output Analyzer...");
+    analyzerAction->setToolTip("Live spectrum of the binaural engine's output with the "
+                               "measured tones and interaural beat");
+    connect(analyzerAction, &QAction::triggered, this, [this] {
+        m_analyzerDialog->show();
+        m_analyzerDialog->raise();
+    });
 
     QMenu *settingsMenu = menuBar()->addMenu("&Settings");
     QAction *factoryResetAction = new QAction("Factory Reset", settingsMenu);
@@ -3439,6 +3467,87 @@ void MainWindow::setupMenus() {
 
     settingsMenu->addAction(unlimitedDurationAction);
 
+    QAction *exactOscillatorAction = new QAction("Exact Oscillator (std::sin)", settingsMenu);
+    exactOscillatorAction->setCheckable(true);
+    exactOscillatorAction->setToolTip("Compute tones with std::sin per sample instead of the "
+                                      "interpolated wavetable (higher CPU use)");
+    bool exactOscillator = settings.value("binaural/exactOscillator", false).toBool();
+    exactOscillatorAction->setChecked(exactOscillator);
+    m_binauralEngine->setOscillatorMode(exactOscillator ? DynamicEngine::EXACT_OSCILLATOR
+                                                        : DynamicEngine::WAVETABLE_OSCILLATOR);
+    connect(exactOscillatorAction, &QAction::toggled, this, [this](bool checked) {
+        m_binauralEngine->setOscillatorMode(checked ? DynamicEngine::EXACT_OSCILLATOR
+                                                    : DynamicEngine::WAVETABLE_OSCILLATOR);
+        settings.setValue("binaural/exactOscillator", checked);
+    });
+    settingsMenu->addAction(exactOscillatorAction);
+
+    QMenu *latencyMenu = settingsMenu->addMenu("Output Latency");
+    QActionGroup *latencyGroup = new QActionGroup(latencyMenu);
+    const QList<QPair<QString, DynamicEngine::LatencyProfile>> latencyProfiles = {
+        { "Low (~20 ms)", DynamicEngine::LOW_LATENCY },
+        { "Balanced (~100 ms)", DynamicEngine::BALANCED_LATENCY },
+        { "Power Saving (~500 ms)", DynamicEngine::POWER_SAVING_LATENCY }
+    };
+    int latencyProfile = settings.value("binaural/latencyProfile",
+                                        int(DynamicEngine::BALANCED_LATENCY)).toInt();
+    for (const auto &profile : latencyProfiles) {
+        QAction *action = latencyMenu->addAction(profile.first);
+        action->setCheckable(true);
+        action->setChecked(profile.second == latencyProfile);
+        latencyGroup->addAction(action);
+        connect(action, &QAction::triggered, this, [this, profile] {
+            m_binauralEngine->setLatencyProfile(profile.second);
+            settings.setValue("binaural/latencyProfile", int(profile.second));
+        });
+        if (profile.second == latencyProfile) {
+            m_binauralEngine->setLatencyProfile(profile.second);
+        }
+    }
+    latencyMenu->addSeparator();
+
+    QAction *adaptiveLatencyAction = latencyMenu->addAction("Adaptive");
+    adaptiveLatencyAction->setCheckable(true);
+    adaptiveLatencyAction->setToolTip("Raise latency after dropouts and lower it again once "
+                                      "playback is stable");
+    bool adaptiveLatency = settings.value("binaural/adaptiveLatency", true).toBool();
+    adaptiveLatencyAction->setChecked(adaptiveLatency);
+    m_binauralEngine->setAdaptiveLatency(adaptiveLatency);
+    connect(adaptiveLatencyAction, &QAction::toggled, this, [this](bool checked) {
+        m_binauralEngine->setAdaptiveLatency(checked);
+        settings.setValue("binaural/adaptiveLatency", checked);
+    });
+
+    QAction *nativeFormatAction = new QAction("Device-Native Format", settingsMenu);
+    nativeFormatAction->setCheckable(true);
+    nativeFormatAction->setToolTip("Play at the device's own sample rate in 32-bit float, so the "
+                                   "system does not resample (applies on next play)");
+    bool nativeFormat = settings.value("binaural/nativeFormat", true).toBool();
+    nativeFormatAction->setChecked(nativeFormat);
+    m_binauralEngine->setNativeFormat(nativeFormat);
+    connect(nativeFormatAction, &QAction::toggled, this, [this](bool checked) {
+        m_binauralEngine->setNativeFormat(checked);
+        settings.setValue("binaural/nativeFormat", checked);
+    });
+    settingsMenu->addAction(nativeFormatAction);
+
+    QAction *loopCrossfadeAction = new QAction("Ambient Loop Crossfade...", settingsMenu);
+    loopCrossfadeAction->setToolTip("Length of the crossfade where repeating ambient sounds "
+                                    "wrap around (0 = matched hard splice)");
+    m_binauralEngine->setAmbientCrossfadeMs(
+                settings.value("ambient/loopCrossfadeMs", AmbientLoop::DEFAULT_CROSSFADE_MS).toInt());
+    connect(loopCrossfadeAction, &QAction::triggered, this, [this] {
+        bool ok = false;
+        int ms = QInputDialog::getInt(this, "Ambient Loop Crossfade", "Crossfade (ms):",
+                                      m_binauralEngine->ambientCrossfadeMs(), 0,
+                                      AmbientLoop::MAX_CROSSFADE_MS, 50, &ok);
+        if (ok) {
+            m_binauralEngine->setAmbientCrossfadeMs(ms);
+            settings.setValue("ambient/loopCrossfadeMs", ms);
+        }
+    });
+    settingsMenu->addAction(loopCrossfadeAction);
+
     QMenu *presetsMenu = menuBar()->addMenu("&Presets");
 
     presetsMenu->addAction(savePresetAction);
@@ -4236,7 +4345,7 @@ void MainWindow::setupAmbientPlayers() {
     for (int i = 1; i <= 5; i++) {
         QString key = QString("player%1").arg(i);
 
-        AmbientPlayer *player = new AmbientPlayer(this);
+        AmbientPlayer *player = new AmbientPlayer(m_binauralEngine, i - 1, this);
         player->setName(QString("Player %1").arg(i));
 
         m_ambientPlayers[key] = player;
@@ -4290,15 +4399,13 @@ void MainWindow::onMasterPlayClicked() {
         if (!player->isEnabled())
             continue;
 
-        QMediaPlayer *mediaPlayer = player->mediaPlayer();
-        if (mediaPlayer &&
-                mediaPlayer->playbackState() != QMediaPlayer::PlayingState) {
-            mediaPlayer->play(); // ensure actual playback
+        if (player->playbackState() != QMediaPlayer::PlayingState) {
+            player->play(); // ensure actual playback
         }
 
         if (m_playerDialogs.contains(key)) {
             AmbientPlayerDialog *dlg = m_playerDialogs[key];
-            dlg->state = mediaPlayer->playbackState(); // sync dialog state
+            dlg->state = player->playbackState(); // sync dialog state
         }
     }
 }
@@ -4320,15 +4427,13 @@ void MainWindow::onMasterPauseClicked() {
         if (!player->isEnabled())
             continue;
 
-        QMediaPlayer *mediaPlayer = player->mediaPlayer();
-        if (mediaPlayer &&
-                mediaPlayer->playbackState() == QMediaPlayer::PlayingState) {
-            mediaPlayer->pause(); // pause actual playback
+        if (player->playbackState() == QMediaPlayer::PlayingState) {
+            player->pause(); // pause actual playback
         }
 
         if (m_playerDialogs.contains(key)) {
             AmbientPlayerDialog *dlg = m_playerDialogs[key];
-            dlg->state = mediaPlayer->playbackState(); // should be PausedState now
+            dlg->state = player->playbackState(); // should be PausedState now
         }
     }
 }
@@ -4350,15 +4455,13 @@ void MainWindow::onMasterStopClicked() {
         if (!player->isEnabled())
             continue;
 
-        QMediaPlayer *mediaPlayer = player->mediaPlayer();
-        if (mediaPlayer &&
-                mediaPlayer->playbackState() != QMediaPlayer::StoppedState) {
-            mediaPlayer->stop(); // stop actual playback
+        if (player->playbackState() != QMediaPlayer::StoppedState) {
+            player->stop(); // stop actual playback
         }
 
         if (m_playerDialogs.contains(key)) {
             AmbientPlayerDialog *dlg = m_playerDialogs[key];
-            dlg->state = mediaPlayer->playbackState(); // should be StoppedState now
+            dlg->state = player->playbackState(); // should be StoppedState now
         }
     }
 }
@@ -4635,12 +4738,9 @@ void MainWindow::mutePlayingAmbientPlayers(bool needMute) {
     for (auto it = m_ambientPlayers.begin(); it != m_ambientPlayers.end(); ++it) {
         AmbientPlayer *ambientPlayer = it.value();
 
-        if (ambientPlayer && ambientPlayer->mediaPlayer()) {
-            QMediaPlayer *mediaPlayer = ambientPlayer->mediaPlayer();
-
-            if (mediaPlayer->playbackState() == QMediaPlayer::PlayingState) {
-                mediaPlayer->audioOutput()->setMuted(needMute);
-            }
+        if (ambientPlayer &&
+                ambientPlayer->playbackState() == QMediaPlayer::PlayingState) {
+            ambientPlayer->setMuted(needMute);
         }
     }
 }
@@ -5501,6 +5601,7 @@ void MainWindow::setupFlickerWindow() {
             if (!m_flickerWidget) {
                 m_flickerWidget = new FlickerWidget(m_flickerContainer);
                 m_flickerWidget->setAttribute(Qt::WA_TranslucentBackground);
+                m_flickerWidget->setAudioClock(m_binauralEngine);
 
                 connect(m_flickerWidget, &FlickerWidget::toggleFullscreenRequested,
                         this, &MainWindow::toggleFlickerFullscreen);
@@ -36,6 +36,9 @@
 #include<QProcess>
 #include"radionicsconsole.h"
 #include"rssnotificationdialog.h"
+#include"audiodiagnosticsdialog.h"
+#include"outputanalyzerdialog.h"
+#include"levelmeterwidget.h"
 
 class MainWindow : public QMainWindow
 {
@@ -81,8 +84,10 @@ private:
     QLabel *isoPulseLabel;
     QComboBox *m_waveformCombo;
     QDoubleSpinBox *m_binauralVolumeInput;
+    LevelMeterWidget *m_levelMeter;
     QPushButton *m_binauralPlayButton;
     QPushButton *m_binauralStopButton;
+    QLabel *m_latencyLabel;
 
     QToolBar *m_natureToolbar;
     QPushButton *m_naturePowerButton;
@@ -181,7 +186,6 @@ private:
     QComboBox *toneTypeCombo = nullptr;
     QStandardItemModel *model;
     QStandardItem *squareWaveItem;
-    qreal binEngineVolume = 1.0;
     void playRandomTrack();
     bool isShuffle = false;
 private:
@@ -326,10 +330,7 @@ private slots:
     void onSessionStarted(int totalSeconds);
     void onSessionEnded();
 private:
-    QTimer m_fadeTimer;
-    double m_fadeStartVolume;
-    double m_fadeTargetVolume;
-    int m_fadeSteps;
+    static constexpr int SESSION_FADE_MS = 5000;
     double targetVolume = 0.0;
     QLabel *durationLabel;
     int currentStageIndex;
@@ -455,6 +456,9 @@ private:
     RssNotificationDialog* rssDialog = nullptr;
     QAction *rssAction;
     QAction* loadSessionAction;
+    //diagnostics
+    AudioDiagnosticsDialog *m_diagnosticsDialog = nullptr;
+    OutputAnalyzerDialog *m_analyzerDialog = nullptr;
 
 };
 #endif // MAINWINDOW_H
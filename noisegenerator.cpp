@@ -0,0 +1,166 @@
+#include "noisegenerator.h"
+
+#include <algorithm>
+
+static inline uint64_t rotl(uint64_t x, int k)
+{
+    return (x << k) | (x >> (64 - k));
+}
+
+static inline uint64_t splitMix64(uint64_t &state)
+{
+    uint64_t z = (state += 0x9E3779B97F4A7C15ull);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+    return z ^ (z >> 31);
+}
+
+NoiseGenerator::NoiseGenerator(uint64_t seed)
+{
+    this->seed(seed);
+}
+
+void NoiseGenerator::seed(uint64_t seed)
+{
+    uint64_t state = seed;
+    for (int lane = 0; lane < LANES; ++lane) {
+        m_s0[lane] = splitMix64(state);
+        m_s1[lane] = splitMix64(state);
+        m_s2[lane] = splitMix64(state);
+        m_s3[lane] = splitMix64(state);
+    }
+    reset();
+}
+
+void NoiseGenerator::reset()
+{
+    std::fill(m_pinkValues, m_pinkValues + PINK_STAGES, 0.0);
+    m_pinkSum = 0.0;
+    m_pinkIndex = 0;
+    m_brownState = 0.0;
+    m_greyPrev = 0.0;
+    m_greyMid = 0.0;
+}
+
+double NoiseGenerator::nextWhite()
+{
+    const uint64_t result = m_s0[0] + m_s3[0];
+    const uint64_t t = m_s1[0] << 17;
+    m_s2[0] ^= m_s0[0];
+    m_s3[0] ^= m_s1[0];
+    m_s1[0] ^= m_s2[0];
+    m_s0[0] ^= m_s3[0];
+    m_s2[0] ^= t;
+    m_s3[0] = rotl(m_s3[0], 45);
+    return static_cast<double>(result >> 11) * (2.0 / 9007199254740992.0) - 1.0;
+}
+
+void NoiseGenerator::fillWhite(float *out, int count)
+{
+    // xoshiro256+ on four independent lanes; the top 24 bits map exactly to a float
+    uint64_t s0[LANES], s1[LANES], s2[LANES], s3[LANES];
+    std::copy(m_s0, m_s0 + LANES, s0);
+    std::copy(m_s1, m_s1 + LANES, s1);
+    std::copy(m_s2, m_s2 + LANES, s2);
+    std::copy(m_s3, m_s3 + LANES, s3);
+
+    int i = 0;
+    for (; i + LANES <= count; i += LANES) {
+        for (int lane = 0; lane < LANES; ++lane) {
+            const uint64_t result = s0[lane] + s3[lane];
+            const uint64_t t = s1[lane] << 17;
+            s2[lane] ^= s0[lane];
+            s3[lane] ^= s1[lane];
+            s1[lane] ^= s2[lane];
+            s0[lane] ^= s3[lane];
+            s2[lane] ^= t;
+            s3[lane] = rotl(s3[lane], 45);
+            out[i + lane] = static_cast<float>(static_cast<int32_t>(result >> 40))
+                            * (2.0f / 16777216.0f) - 1.0f;
+        }
+    }
+
+    std::copy(s0, s0 + LANES, m_s0);
+    std::copy(s1, s1 + LANES, m_s1);
+    std::copy(s2, s2 + LANES, m_s2);
+    std::copy(s3, s3 + LANES, m_s3);
+
+    for (; i < count; ++i) {
+        out[i] = static_cast<float>(nextWhite());
+    }
+}
+
+void NoiseGenerator::fillPink(float *out, int count)
+{
+    // Voss-McCartney: stage 0 refreshes every sample, stage n every 2^n samples
+    for (int offset = 0; offset < count; offset += SCRATCH_SIZE) {
+        const int n = std::min(SCRATCH_SIZE, count - offset);
+        fillWhite(m_scratch, n);
+
+        for (int i = 0; i < n; ++i) {
+            const double white = m_scratch[i];
+            m_pinkSum += white - m_pinkValues[0];
+            m_pinkValues[0] = white;
+
+            for (int stage = 1; stage < PINK_STAGES && (m_pinkIndex & ((1 << stage) - 1)) == 0; ++stage) {
+                const double value = nextWhite();
+                m_pinkSum += value - m_pinkValues[stage];
+                m_pinkValues[stage] = value;
+            }
+
+            // Every stage was just refreshed: drop accumulated rounding
+            if (m_pinkIndex == 0) {
+                m_pinkSum = 0.0;
+                for (int stage = 0; stage < PINK_STAGES; ++stage) {
+                    m_pinkSum += m_pinkValues[stage];
+                }
+            }
+
+            m_pinkIndex = (m_pinkIndex + 1) & ((1 << (PINK_STAGES - 1)) - 1);
+
+            // Scale to match original amplitude
+            const double pink = (m_pinkSum / PINK_STAGES) * 2.0;
+            out[offset + i] = static_cast<float>(std::clamp(pink, -1.0, 1.0));
+        }
+    }
+}
+
+void NoiseGenerator::fillBrown(float *out, int count)
+{
+    for (int offset = 0; offset < count; offset += SCRATCH_SIZE) {
+        const int n = std::min(SCRATCH_SIZE, count - offset);
+        fillWhite(m_scratch, n);
+
+        for (int i = 0; i < n; ++i) {
+            m_brownState = std::clamp(m_brownState + m_scratch[i] * 0.25, -0.8, 0.8);
+            out[offset + i] = static_cast<float>(m_brownState);
+        }
+    }
+}
+
+void NoiseGenerator::fillGrey(float *out, int count)
+{
+    for (int offset = 0; offset < count; offset += SCRATCH_SIZE) {
+        const int n = std::min(SCRATCH_SIZE, count - offset);
+        fillWhite(m_scratch, n);
+
+        for (int i = 0; i < n; ++i) {
+            // Soft grey, then a slight mid cut to lift lows and highs
+            m_greyPrev = 0.7 * m_greyPrev + 0.3 * m_scratch[i];
+            m_greyMid = 0.5 * m_greyMid + 0.5 * m_greyPrev;
+            const double shaped = m_greyPrev - (0.15 * m_greyMid);
+            out[offset + i] = static_cast<float>(std::clamp(shaped, -1.0, 1.0));
+        }
+    }
+}
+
+void NoiseGenerator::fill(int type, float *out, int count)
+{
+    switch (type) {
+        case NOISE_WHITE: fillWhite(out, count); break;
+        case NOISE_PINK: fillPink(out, count); break;
+        case NOISE_BROWN: fillBrown(out, count); break;
+        case NOISE_GREY: fillGrey(out, count); break;
+        default: std::fill(out, out + count, 0.0f); break;
+    }
+}
@@ -0,0 +1,68 @@
+#ifndef NOISEGENERATOR_H
+#define NOISEGENERATOR_H
+
+#include <cstdint>
+
+// ============================================================
+// NOISE GENERATOR
+// ============================================================
+// Per-renderer noise source for the render path. Randomness comes from
+// four interleaved xoshiro256+ streams kept in struct-of-arrays form so
+// a block fill advances all lanes in one vectorizable pass. All filter
+// memory (pink stages, brown walk, grey smoothing) is instance state,
+// so two renderers never share it. Not thread-safe: owned by the thread
+// that renders.
+
+class NoiseGenerator
+{
+public:
+    enum NoiseType {
+        NOISE_OFF = 0,
+        NOISE_WHITE = 1,
+        NOISE_PINK = 2,
+        NOISE_BROWN = 3,
+        NOISE_GREY = 4
+    };
+
+    explicit NoiseGenerator(uint64_t seed = 0x9E3779B97F4A7C15ull);
+
+    // Reseeds the random streams and clears filter state
+    void seed(uint64_t seed);
+    // Clears filter state only
+    void reset();
+
+    // Uniform samples in [-1, 1)
+    void fillWhite(float *out, int count);
+    void fillPink(float *out, int count);
+    void fillBrown(float *out, int count);
+    void fillGrey(float *out, int count);
+    void fill(int type, float *out, int count);
+
+private:
+    static constexpr int LANES = 4;
+    static constexpr int PINK_STAGES = 8;
+    static constexpr int SCRATCH_SIZE = 256;
+
+    double nextWhite();
+
+    uint64_t m_s0[LANES];
+    uint64_t m_s1[LANES];
+    uint64_t m_s2[LANES];
+    uint64_t m_s3[LANES];
+
+    // Pink noise (Voss-McCartney) state
+    double m_pinkValues[PINK_STAGES];
+    double m_pinkSum;
+    int m_pinkIndex;
+
+    // Brown noise state
+    double m_brownState;
+
+    // Grey noise state
+    double m_greyPrev;
+    double m_greyMid;
+
+    alignas(32) float m_scratch[SCRATCH_SIZE];
+};
+
+#endif // NOISEGENERATOR_H
@@ -0,0 +1,169 @@
+#include "nullsink.h"
+
+#include <QtEndian>
+#include <algorithm>
+#include <cstring>
+
+NullSink::NullSink(const QAudioFormat &format, int bufferMs, QObject *parent)
+    : QObject(parent)
+    , m_format(format)
+{
+    setBufferMs(bufferMs);
+    m_timer.setTimerType(Qt::PreciseTimer);
+    m_timer.setInterval(PERIOD_MS);
+    connect(&m_timer, &QTimer::timeout, this, &NullSink::pull);
+}
+
+NullSink::~NullSink()
+{
+    stop();
+}
+
+void NullSink::setBufferMs(int bufferMs)
+{
+    m_bufferFrames = std::max<qint64>(1, static_cast<qint64>(bufferMs) * m_format.sampleRate() / 1000);
+    if (m_source) {
+        m_buffer.resize(bufferSize());
+    }
+}
+
+qint64 NullSink::bufferSize() const
+{
+    return m_bufferFrames * m_format.bytesPerFrame();
+}
+
+qint64 NullSink::bytesFree() const
+{
+    if (!m_source) {
+        return bufferSize();
+    }
+    const qint64 played = m_clock.nsecsElapsed() * m_format.sampleRate() / 1000000000ll;
+    const qint64 queued = std::clamp<qint64>(m_framesQueued - played, 0, m_bufferFrames);
+    return (m_bufferFrames - queued) * m_format.bytesPerFrame();
+}
+
+bool NullSink::start(QIODevice *source, const QString &filePath)
+{
+    stop();
+
+    if (!filePath.isEmpty()) {
+        m_file.setFileName(filePath);
+        if (!m_file.open(QIODevice::WriteOnly | QIODevice::Truncate) || !writeHeader(0)) {
+            m_error = QString("Could not open %1 for writing").arg(filePath);
+            m_file.close();
+            return false;
+        }
+    }
+
+    m_source = source;
+    m_framesPulled = 0;
+    m_framesQueued = 0;
+    m_dataBytes = 0;
+    m_underruns = 0;
+    m_error.clear();
+    m_buffer.resize(bufferSize());
+    m_clock.start();
+    pull(); // Fill the buffer before the clock has run
+    m_timer.start();
+    return true;
+}
+
+void NullSink::stop()
+{
+    m_timer.stop();
+    m_source = nullptr;
+
+    if (m_file.isOpen()) {
+        // Sizes were left at 0 while the file grew
+        writeHeader(m_dataBytes);
+        m_file.close();
+    }
+}
+
+// Keeps m_bufferFrames queued ahead of the clock, as a device's buffer
+void NullSink::pull()
+{
+    if (!m_source) {
+        return;
+    }
+
+    const int bytesPerFrame = m_format.bytesPerFrame();
+    const qint64 played = m_clock.nsecsElapsed() * m_format.sampleRate() / 1000000000ll;
+
+    // The buffer ran dry while this thread was held up: that time was
+    // silence on a device
+    if (played > m_framesQueued) {
+        writeSilence(played - m_framesQueued);
+        m_framesQueued = played;
+        ++m_underruns;
+        emit underrun();
+    }
+
+    qint64 wanted = played + m_bufferFrames - m_framesQueued;
+    while (wanted > 0) {
+        const qint64 chunk = std::min<qint64>(wanted, m_buffer.size() / bytesPerFrame);
+        const qint64 bytes = m_source->read(m_buffer.data(), chunk * bytesPerFrame);
+        const qint64 frames = bytes / bytesPerFrame;
+        if (frames <= 0) {
+            break;
+        }
+        if (m_file.isOpen()) {
+            m_file.write(m_buffer.constData(), frames * bytesPerFrame);
+            m_dataBytes += frames * bytesPerFrame;
+        }
+        m_framesPulled += frames;
+        m_framesQueued += frames;
+        wanted -= frames;
+    }
+}
+
+void NullSink::writeSilence(qint64 frames)
+{
+    if (!m_file.isOpen()) {
+        return;
+    }
+
+    std::memset(m_buffer.data(), 0, m_buffer.size());
+    const qint64 bytesPerFrame = m_format.bytesPerFrame();
+    while (frames > 0) {
+        const qint64 chunk = std::min<qint64>(frames, m_buffer.size() / bytesPerFrame);
+        m_file.write(m_buffer.constData(), chunk * bytesPerFrame);
+        m_dataBytes += chunk * bytesPerFrame;
+        frames -= chunk;
+    }
+}
+
+// 44-byte header, PCM for Int16 and IEEE float for Float32; rewritten
+// with the final sizes by stop()
+bool NullSink::writeHeader(qint64 dataBytes)
+{
+    const bool isFloat = m_format.sampleFormat() == QAudioFormat::Float;
+    const quint16 channels = static_cast<quint16>(m_format.channelCount());
+    const quint16 blockAlign = static_cast<quint16>(m_format.bytesPerFrame());
+    const quint32 dataSize = static_cast<quint32>(std::min<qint64>(dataBytes, 0xFFFFFFFFll - 36));
+
+    QByteArray header(44, '\0');
+    char *h = header.data();
+    auto put16 = [h](int offset, quint16 value) { qToLittleEndian(value, h + offset); };
+    auto put32 = [h](int offset, quint32 value) { qToLittleEndian(value, h + offset); };
+
+    memcpy(h, "RIFF", 4);
+    put32(4, 36 + dataSize);
+    memcpy(h + 8, "WAVE", 4);
+    memcpy(h + 12, "fmt ", 4);
+    put32(16, 16);                                       // fmt chunk size
+    put16(20, isFloat ? 3 : 1);                          // IEEE float or PCM
+    put16(22, channels);
+    put32(24, m_format.sampleRate());
+    put32(28, m_format.sampleRate() * blockAlign);       // Byte rate
+    put16(32, blockAlign);
+    put16(34, static_cast<quint16>(m_format.bytesPerSample() * 8));
+    memcpy(h + 36, "data", 4);
+    put32(40, dataSize);
+
+    const qint64 position = m_file.pos();
+    if (!m_file.seek(0) || m_file.write(header) != header.size()) {
+        return false;
+    }
+    return dataBytes == 0 || m_file.seek(position);
+}
@@ -0,0 +1,71 @@
+#ifndef NULLSINK_H
+#define NULLSINK_H
+
+#include <QAudioFormat>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QIODevice>
+#include <QObject>
+#include <QString>
+#include <QTimer>
+
+// ============================================================
+// NULL SINK
+// ============================================================
+// Stands in for QAudioSink on machines without sound hardware. It
+// pulls from the source device at the format's real-time rate, driven
+// by a precise timer on the thread it lives on, and discards the audio
+// or appends it to a WAV file, so continuous playback (render thread,
+// render-ahead ring, parameter hand-over) can be soak-tested on build
+// machines.
+//
+// Like a device, it keeps bufferMs of audio queued ahead of the clock:
+// when its thread stalls for longer than that, the missed time is
+// skipped (silence in the file) and underrun() is emitted, as a device
+// would run dry.
+
+class NullSink : public QObject
+{
+    Q_OBJECT
+
+public:
+    static constexpr int PERIOD_MS = 5;
+
+    NullSink(const QAudioFormat &format, int bufferMs, QObject *parent = nullptr);
+    ~NullSink() override;
+
+    // Starts pulling from source; an empty filePath discards the audio
+    bool start(QIODevice *source, const QString &filePath = QString());
+    void stop(); // Finishes the WAV file
+
+    void setBufferMs(int bufferMs); // Also while running
+
+    QString errorString() const { return m_error; }
+    qint64 bufferSize() const; // Bytes, as QAudioSink::bufferSize()
+    qint64 bytesFree() const;  // Buffer not queued now, as QAudioSink::bytesFree()
+    qint64 framesPulled() const { return m_framesPulled; }
+    quint64 underrunCount() const { return m_underruns; }
+
+signals:
+    void underrun();
+
+private:
+    void pull();
+    bool writeHeader(qint64 dataBytes);
+    void writeSilence(qint64 frames);
+
+    QAudioFormat m_format;
+    qint64 m_bufferFrames;
+    QIODevice *m_source = nullptr;
+    QFile m_file;
+    QTimer m_timer;
+    QElapsedTimer m_clock;
+    qint64 m_framesPulled = 0;  // From the source
+    qint64 m_framesQueued = 0;  // Pulled plus skipped, on the clock's timeline
+    qint64 m_dataBytes = 0;
+    quint64 m_underruns = 0;
+    QByteArray m_buffer;
+    QString m_error;
+};
+
+#endif // NULLSINK_H
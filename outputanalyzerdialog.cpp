@@ -0,0 +1,357 @@
+#include "outputanalyzerdialog.h"
+
+#include <QDialogButtonBox>
+#include <QElapsedTimer>
+#include <QFormLayout>
+#include <QHBoxLayout>
+#include <QPainter>
+#include <QPainterPath>
+#include <QSettings>
+#include <QVBoxLayout>
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+namespace {
+
+constexpr int FFT_SIZES[] = { 1024, 2048, 4096, 8192, 16384 };
+constexpr int UPDATE_RATES_HZ[] = { 5, 10, 15, 30 };
+constexpr int DRAIN_FRAMES = 4096; // Tap frames per read on the worker
+
+constexpr double MIN_DISPLAY_HZ = 20.0;
+constexpr double MAX_DISPLAY_HZ = 20000.0;
+constexpr double MIN_DISPLAY_DB = -120.0;
+
+} // namespace
+
+// ============================================================
+// SPECTRUM VIEW
+// ============================================================
+// Both channels' spectra on a log-frequency axis. Where several bins
+// share a pixel column the loudest is drawn.
+
+class SpectrumView : public QWidget
+{
+public:
+    explicit SpectrumView(QWidget *parent = nullptr)
+        : QWidget(parent)
+    {
+        setMinimumSize(480, 220);
+        setSizePolicy(QSizePolicy::Expanding, QSizePolicy::Expanding);
+    }
+
+    void setResult(const SpectrumAnalyzer::Result &result)
+    {
+        m_result = result;
+        update();
+    }
+
+protected:
+    void paintEvent(QPaintEvent *event) override
+    {
+        Q_UNUSED(event);
+
+        QPainter painter(this);
+        painter.setRenderHint(QPainter::Antialiasing);
+        const QRectF plot = QRectF(rect()).adjusted(36, 8, -8, -20);
+        painter.fillRect(rect(), palette().color(QPalette::Base));
+
+        const double maxHz = m_result.sampleRate > 0
+                ? std::min(MAX_DISPLAY_HZ, m_result.sampleRate / 2.0) : MAX_DISPLAY_HZ;
+        const double logSpan = std::log10(maxHz / MIN_DISPLAY_HZ);
+        auto toX = [&](double hz) {
+            return plot.left() + std::log10(hz / MIN_DISPLAY_HZ) / logSpan * plot.width();
+        };
+        auto toY = [&](double db) {
+            return plot.top() + std::clamp(db / MIN_DISPLAY_DB, 0.0, 1.0) * plot.height();
+        };
+
+        // Grid: decades and 1-2-5 steps, every 20 dB
+        painter.setPen(palette().color(QPalette::Mid));
+        painter.setFont(QFont(font().family(), 7));
+        for (double decade = 10.0; decade < maxHz; decade *= 10.0) {
+            for (double step : { 1.0, 2.0, 5.0 }) {
+                const double hz = decade * step;
+                if (hz < MIN_DISPLAY_HZ || hz > maxHz) {
+                    continue;
+                }
+                const double x = toX(hz);
+                painter.drawLine(QPointF(x, plot.top()), QPointF(x, plot.bottom()));
+                const QString label = hz >= 1000.0 ? QString("%1k").arg(hz / 1000.0) : QString::number(hz);
+                painter.drawText(QRectF(x - 20, plot.bottom() + 2, 40, 16), Qt::AlignHCenter | Qt::AlignTop, label);
+            }
+        }
+        for (double db = 0.0; db >= MIN_DISPLAY_DB; db -= 20.0) {
+            const double y = toY(db);
+            painter.drawLine(QPointF(plot.left(), y), QPointF(plot.right(), y));
+            painter.drawText(QRectF(0, y - 8, plot.left() - 4, 16), Qt::AlignRight | Qt::AlignVCenter,
+                             QString::number(db));
+        }
+
+        if (m_result.fftSize > 0) {
+            drawChannel(painter, m_result.leftDb, QColor(40, 120, 220), toX, toY, maxHz);
+            drawChannel(painter, m_result.rightDb, QColor(220, 80, 60), toX, toY, maxHz);
+        }
+
+        painter.setPen(QColor(40, 120, 220));
+        painter.drawText(plot.adjusted(0, 2, -6, 0), Qt::AlignRight | Qt::AlignTop, "Left");
+        painter.setPen(QColor(220, 80, 60));
+        painter.drawText(plot.adjusted(0, 16, -6, 0), Qt::AlignRight | Qt::AlignTop, "Right");
+    }
+
+private:
+    template<typename ToX, typename ToY>
+    void drawChannel(QPainter &painter, const std::vector<float> &db, const QColor &color,
+                     ToX toX, ToY toY, double maxHz) const
+    {
+        const double binHz = static_cast<double>(m_result.sampleRate) / m_result.fftSize;
+        QPainterPath path;
+        int column = -1;
+        double loudest = MIN_DISPLAY_DB;
+        double columnX = 0.0;
+        for (int k = std::max(1, static_cast<int>(std::ceil(MIN_DISPLAY_HZ / binHz)));
+             k < static_cast<int>(db.size()) && k * binHz <= maxHz; ++k) {
+            const double x = toX(k * binHz);
+            if (static_cast<int>(x) != column) {
+                if (column >= 0) {
+                    const QPointF point(columnX, toY(loudest));
+                    path.elementCount() == 0 ? path.moveTo(point) : path.lineTo(point);
+                }
+                column = static_cast<int>(x);
+                columnX = x;
+                loudest = db[k];
+            } else {
+                loudest = std::max<double>(loudest, db[k]);
+            }
+        }
+        if (column >= 0) {
+            const QPointF point(columnX, toY(loudest));
+            path.elementCount() == 0 ? path.moveTo(point) : path.lineTo(point);
+        }
+        painter.setPen(QPen(color, 1.2));
+        painter.drawPath(path);
+    }
+
+    SpectrumAnalyzer::Result m_result;
+};
+
+// ============================================================
+// DIALOG
+// ============================================================
+
+OutputAnalyzerDialog::OutputAnalyzerDialog(DynamicEngine *engine, QWidget *parent)
+    : QDialog(parent)
+    , m_engine(engine)
+{
+    setupUI();
+
+    QSettings settings;
+    const int fftSize = settings.value("analyzer/fftSize", DEFAULT_FFT_SIZE).toInt();
+    const int updateHz = settings.value("analyzer/updateHz", DEFAULT_UPDATE_HZ).toInt();
+    m_fftSizeCombo->setCurrentIndex(std::max(0, m_fftSizeCombo->findData(fftSize)));
+    m_updateRateCombo->setCurrentIndex(std::max(0, m_updateRateCombo->findData(updateHz)));
+
+    connect(&m_refreshTimer, &QTimer::timeout, this, &OutputAnalyzerDialog::refresh);
+    connect(m_fftSizeCombo, &QComboBox::currentIndexChanged, this, &OutputAnalyzerDialog::onSettingsChanged);
+    connect(m_updateRateCombo, &QComboBox::currentIndexChanged, this, &OutputAnalyzerDialog::onSettingsChanged);
+    onSettingsChanged();
+}
+
+OutputAnalyzerDialog::~OutputAnalyzerDialog()
+{
+    stopWorker();
+}
+
+void OutputAnalyzerDialog::setupUI()
+{
+    setWindowTitle("Output Analyzer");
+    setMinimumSize(640, 420);
+
+    QVBoxLayout *layout = new QVBoxLayout(this);
+
+    m_view = new SpectrumView(this);
+    layout->addWidget(m_view, 1);
+
+    QHBoxLayout *settingsLayout = new QHBoxLayout;
+    m_fftSizeCombo = new QComboBox(this);
+    for (int size : FFT_SIZES) {
+        m_fftSizeCombo->addItem(QString::number(size), size);
+    }
+    m_fftSizeCombo->setToolTip("Larger sizes resolve closer tones but respond slower and cost more CPU");
+    m_updateRateCombo = new QComboBox(this);
+    for (int hz : UPDATE_RATES_HZ) {
+        m_updateRateCombo->addItem(QString("%1 Hz").arg(hz), hz);
+    }
+    settingsLayout->addWidget(new QLabel("FFT size:", this));
+    settingsLayout->addWidget(m_fftSizeCombo);
+    settingsLayout->addSpacing(12);
+    settingsLayout->addWidget(new QLabel("Update rate:", this));
+    settingsLayout->addWidget(m_updateRateCombo);
+    settingsLayout->addStretch();
+    layout->addLayout(settingsLayout);
+
+    QFormLayout *readings = new QFormLayout;
+    m_tonesLabel = new QLabel(this);
+    m_beatLabel = new QLabel(this);
+    readings->addRow("Strongest tones:", m_tonesLabel);
+    readings->addRow("Interaural beat:", m_beatLabel);
+    layout->addLayout(readings);
+
+    m_statusLabel = new QLabel(this);
+    m_statusLabel->setWordWrap(true);
+    layout->addWidget(m_statusLabel);
+
+    QDialogButtonBox *buttonBox = new QDialogButtonBox(QDialogButtonBox::Close, this);
+    connect(buttonBox, &QDialogButtonBox::rejected, this, &QDialog::reject);
+    layout->addWidget(buttonBox);
+}
+
+void OutputAnalyzerDialog::showEvent(QShowEvent *event)
+{
+    QDialog::showEvent(event);
+    m_sampleRate = m_engine->getSampleRate();
+    startWorker();
+    m_refreshTimer.start();
+}
+
+void OutputAnalyzerDialog::hideEvent(QHideEvent *event)
+{
+    m_refreshTimer.stop();
+    stopWorker();
+    QDialog::hideEvent(event);
+}
+
+void OutputAnalyzerDialog::onSettingsChanged()
+{
+    const int fftSize = m_fftSizeCombo->currentData().toInt();
+    const int updateHz = m_updateRateCombo->currentData().toInt();
+    m_fftSize = fftSize;
+    m_updateHz = updateHz;
+    m_refreshTimer.setInterval(1000 / updateHz);
+
+    QSettings settings;
+    settings.setValue("analyzer/fftSize", fftSize);
+    settings.setValue("analyzer/updateHz", updateHz);
+}
+
+// ============================================================
+// WORKER
+// ============================================================
+// The tap is enabled before the worker starts, which creates its ring,
+// and disabled after the worker has stopped reading it.
+
+void OutputAnalyzerDialog::startWorker()
+{
+    if (m_worker) {
+        return;
+    }
+    m_engine->setOutputTapEnabled(true);
+    m_workerRunning = true;
+    m_worker = QThread::create([this]() { runWorker(); });
+    m_worker->setObjectName("Output analyzer");
+    m_worker->start(QThread::LowPriority);
+}
+
+void OutputAnalyzerDialog::stopWorker()
+{
+    if (!m_worker) {
+        return;
+    }
+    m_workerRunning.store(false, std::memory_order_release);
+    m_worker->wait();
+    delete m_worker;
+    m_worker = nullptr;
+    m_engine->setOutputTapEnabled(false);
+}
+
+void OutputAnalyzerDialog::runWorker()
+{
+    SpectrumAnalyzer analyzer;
+    std::vector<float> frames(2 * DRAIN_FRAMES);
+    QElapsedTimer clock;
+    clock.start();
+
+    // Whatever an earlier run left in the tap is stale
+    while (m_engine->readOutputTap(frames.data(), DRAIN_FRAMES) > 0) {
+    }
+
+    while (m_workerRunning.load(std::memory_order_acquire)) {
+        const qint64 startNs = clock.nsecsElapsed();
+        const qint64 intervalNs = 1000000000LL / m_updateHz.load(std::memory_order_relaxed);
+
+        const int sampleRate = m_sampleRate.load(std::memory_order_relaxed);
+        const int fftSize = m_fftSize.load(std::memory_order_relaxed);
+        if (sampleRate > 0 && (sampleRate != analyzer.sampleRate() || fftSize != analyzer.fftSize())) {
+            analyzer.configure(sampleRate, fftSize);
+        }
+
+        int count;
+        while ((count = m_engine->readOutputTap(frames.data(), DRAIN_FRAMES)) > 0) {
+            analyzer.process(frames.data(), count);
+        }
+
+        Analysis &analysis = m_analyses.writeBuffer();
+        analyzer.analyze(analysis.result);
+        const qint64 elapsedNs = clock.nsecsElapsed() - startNs;
+        analysis.cpuPercent = 100.0 * elapsedNs / intervalNs;
+        m_analyses.publish();
+
+        if (elapsedNs < intervalNs) {
+            QThread::usleep(static_cast<unsigned long>((intervalNs - elapsedNs) / 1000));
+        }
+    }
+}
+
+// ============================================================
+// DISPLAY
+// ============================================================
+
+void OutputAnalyzerDialog::refresh()
+{
+    m_sampleRate = m_engine->getSampleRate();
+
+    const bool playing = m_engine->isPlaying() || m_engine->isAmbientPlaying();
+    if (!m_analyses.update()) {
+        if (!playing) {
+            m_statusLabel->setText("Output stopped; showing the last audio analysed.");
+        }
+        return;
+    }
+    const Analysis &analysis = m_analyses.readBuffer();
+    const SpectrumAnalyzer::Result &result = analysis.result;
+    m_view->setResult(result);
+
+    m_tonesLabel->setText(QString("Left %1 Hz, right %2 Hz (set %3 / %4 Hz)")
+                          .arg(result.leftPeakHz, 0, 'f', 1)
+                          .arg(result.rightPeakHz, 0, 'f', 1)
+                          .arg(m_engine->getLeftFrequency(), 0, 'f', 2)
+                          .arg(m_engine->getRightFrequency(), 0, 'f', 2));
+
+    // The correlation tracks any common envelope, so isochronic output
+    // reads as its pulse rate
+    const QString expected = m_engine->getToneType() == 1
+            ? QString("isochronic: reads the pulse rate")
+            : QString("set %1 Hz").arg(m_engine->getBeatFrequency(), 0, 'f', 2);
+    if (result.beatSeconds < result.beatWindowSeconds) {
+        m_beatLabel->setText(QString("measuring, %1 of %2 s (%3)")
+                             .arg(result.beatSeconds, 0, 'f', 1)
+                             .arg(result.beatWindowSeconds, 0, 'f', 1)
+                             .arg(expected));
+    } else if (result.beatHz > 0.0) {
+        m_beatLabel->setText(QString("%1 Hz over the last %2 s (%3)")
+                             .arg(result.beatHz, 0, 'f', 2)
+                             .arg(result.beatWindowSeconds, 0, 'f', 1)
+                             .arg(expected));
+    } else {
+        m_beatLabel->setText(QString("none detected (%1)").arg(expected));
+    }
+
+    const double binHz = result.fftSize > 0 ? static_cast<double>(result.sampleRate) / result.fftSize : 0.0;
+    const double windowMs = result.sampleRate > 0 ? 1000.0 * result.fftSize / result.sampleRate : 0.0;
+    m_statusLabel->setText(QString("%1%2 Hz bins, %3 ms window; analyzer CPU %4%; %5 tap blocks dropped")
+                           .arg(playing ? "" : "Output stopped. ")
+                           .arg(binHz, 0, 'f', 1)
+                           .arg(windowMs, 0, 'f', 0)
+                           .arg(analysis.cpuPercent, 0, 'f', 1)
+                           .arg(m_engine->outputTapDrops()));
+}
@@ -0,0 +1,72 @@
+#ifndef OUTPUTANALYZERDIALOG_H
+#define OUTPUTANALYZERDIALOG_H
+
+#include "dynamicengine.h"
+#include "spectrumanalyzer.h"
+#include "triplebuffer.h"
+
+#include <QComboBox>
+#include <QDialog>
+#include <QLabel>
+#include <QThread>
+#include <QTimer>
+#include <atomic>
+
+class SpectrumView;
+
+// Spectrum and interaural beat of what DynamicEngine actually plays,
+// from its output tap. A worker thread drains the tap and runs the
+// SpectrumAnalyzer at the chosen update rate; the GUI only draws the
+// latest result. FFT size and update rate bound the worker's CPU use,
+// which the dialog shows. The tap and worker run only while the dialog
+// is visible.
+
+class OutputAnalyzerDialog : public QDialog
+{
+    Q_OBJECT
+
+public:
+    explicit OutputAnalyzerDialog(DynamicEngine *engine, QWidget *parent = nullptr);
+    ~OutputAnalyzerDialog() override;
+
+    static constexpr int DEFAULT_FFT_SIZE = 4096;
+    static constexpr int DEFAULT_UPDATE_HZ = 15;
+
+protected:
+    void showEvent(QShowEvent *event) override;
+    void hideEvent(QHideEvent *event) override;
+
+private slots:
+    void refresh();
+    void onSettingsChanged();
+
+private:
+    // Published by the worker thread
+    struct Analysis {
+        SpectrumAnalyzer::Result result;
+        double cpuPercent = 0.0; // Analysis time over the update interval
+    };
+
+    void setupUI();
+    void startWorker();
+    void stopWorker();
+    void runWorker(); // Worker thread
+
+    DynamicEngine *m_engine;
+    SpectrumView *m_view;
+    QComboBox *m_fftSizeCombo;
+    QComboBox *m_updateRateCombo;
+    QLabel *m_tonesLabel;
+    QLabel *m_beatLabel;
+    QLabel *m_statusLabel;
+    QTimer m_refreshTimer;
+
+    QThread *m_worker = nullptr;
+    std::atomic<bool> m_workerRunning{false};
+    std::atomic<int> m_sampleRate{0};   // Set by the GUI, read by the worker
+    std::atomic<int> m_fftSize{DEFAULT_FFT_SIZE};
+    std::atomic<int> m_updateHz{DEFAULT_UPDATE_HZ};
+    TripleBuffer<Analysis> m_analyses;
+};
+
+#endif // OUTPUTANALYZERDIALOG_H
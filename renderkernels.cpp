@@ -0,0 +1,1347 @@
+#include "renderkernels.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define RENDERKERNELS_X86 1
+#include <immintrin.h>
+#if defined(__GNUC__)
+#define RENDERKERNELS_AVX2 1
+#endif
+#endif
+
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+#define RENDERKERNELS_NEON 1
+#include <arm_neon.h>
+#endif
+
+namespace RenderKernels {
+
+// ============================================================
+// SCALAR REFERENCE
+// ============================================================
+
+static void applyGateScalar(float *buffer, const float *gate, int count)
+{
+    for (int i = 0; i < count; ++i) {
+        buffer[i] = buffer[i] * gate[i];
+    }
+}
+
+// Ramped stages evaluate value + step * i from the block start so that
+// vector lanes and scalar tails compute exactly the same factors
+
+static void mixNoiseRange(float *buffer, const float *noise, float level, float levelStep,
+                          int begin, int end)
+{
+    for (int i = begin; i < end; ++i) {
+        const float mix = level + levelStep * static_cast<float>(i);
+        buffer[i] = buffer[i] * (1.0f - mix) + noise[i] * mix;
+    }
+}
+
+static void mixNoiseScalar(float *buffer, const float *noise, float level, float levelStep, int count)
+{
+    mixNoiseRange(buffer, noise, level, levelStep, 0, count);
+}
+
+static void applyGainRange(float *buffer, float gain, float gainStep, int begin, int end)
+{
+    for (int i = begin; i < end; ++i) {
+        buffer[i] = buffer[i] * (gain + gainStep * static_cast<float>(i));
+    }
+}
+
+static void applyGainScalar(float *buffer, float gain, float gainStep, int count)
+{
+    applyGainRange(buffer, gain, gainStep, 0, count);
+}
+
+static void mixAddRange(float *buffer, const float *source, float gain, float gainStep,
+                        int begin, int end)
+{
+    for (int i = begin; i < end; ++i) {
+        buffer[i] = buffer[i] + source[i] * (gain + gainStep * static_cast<float>(i));
+    }
+}
+
+static void mixAddScalar(float *buffer, const float *source, float gain, float gainStep, int count)
+{
+    mixAddRange(buffer, source, gain, gainStep, 0, count);
+}
+
+static inline float clampSample(float sample)
+{
+    return std::min(std::max(sample, -1.0f), 1.0f);
+}
+
+static inline int16_t toInt16(float sample)
+{
+    return static_cast<int16_t>(static_cast<int32_t>(clampSample(sample) * 32767.0f));
+}
+
+static void convertFramesScalar(const float *left, const float *right, int16_t *out, int count)
+{
+    for (int i = 0; i < count; ++i) {
+        out[2 * i] = toInt16(left[i]);
+        out[2 * i + 1] = toInt16(right[i]);
+    }
+}
+
+static void interleaveFramesScalar(const float *left, const float *right, float *out, int count)
+{
+    for (int i = 0; i < count; ++i) {
+        out[2 * i] = clampSample(left[i]);
+        out[2 * i + 1] = clampSample(right[i]);
+    }
+}
+
+// ============================================================
+// VOICE POOL
+// ============================================================
+// Every variant runs the same per-lane float operations in the same
+// order, so a lane's output does not depend on the vector width.
+
+// Frames per pass over the lanes; the pass's partial sums stay on the stack
+constexpr int VOICE_CHUNK = 64;
+
+constexpr float VOICE_TWO_PI = 6.28318530717958647692f;
+constexpr float SINE_C3 = -1.0f / 6.0f;
+constexpr float SINE_C5 = 1.0f / 120.0f;
+constexpr float SINE_C7 = -1.0f / 5040.0f;
+constexpr float SINE_C9 = 1.0f / 362880.0f;
+
+// sin(2 pi phase) = -sin(2 pi x) with x = phase - 0.5 in [-0.5, 0.5),
+// folded into [-0.25, 0.25] by sin(pi - t) = sin(t); Taylor to t^9
+static inline float voiceSineScalar(float phase)
+{
+    float x = phase - 0.5f;
+    const float half = x < 0.0f ? -0.5f : 0.5f;
+    const float magnitude = x < 0.0f ? -x : x;
+    x = magnitude > 0.25f ? half - x : x;
+    const float t = x * VOICE_TWO_PI;
+    const float t2 = t * t;
+    float poly = SINE_C9;
+    poly = poly * t2 + SINE_C7;
+    poly = poly * t2 + SINE_C5;
+    poly = poly * t2 + SINE_C3;
+    poly = poly * t2 + 1.0f;
+    return -(poly * t);
+}
+
+static inline float voiceShapeScalar(const VoiceLanes &lanes, int lane, float phase)
+{
+    const bool low = phase < 0.5f;
+    const float square = low ? 1.0f : -1.0f;
+    const float triangle = low ? 4.0f * phase - 1.0f : 3.0f - 4.0f * phase;
+    const float sawtooth = low ? 2.0f * phase : 2.0f * (phase - 1.0f);
+    const float shape = lanes.sineMix[lane] * voiceSineScalar(phase) + lanes.squareMix[lane] * square;
+    return (shape + lanes.triangleMix[lane] * triangle) + lanes.sawtoothMix[lane] * sawtooth;
+}
+
+static inline float wrapPhase(float phase)
+{
+    return phase >= 1.0f ? phase - 1.0f : phase;
+}
+
+static inline float reduceLanes(const float *sums)
+{
+    return ((sums[0] + sums[4]) + (sums[2] + sums[6])) + ((sums[1] + sums[5]) + (sums[3] + sums[7]));
+}
+
+static void renderVoicesScalar(const VoiceLanes &lanes, int laneCount, float *left, float *right, int count)
+{
+    for (int chunk = 0; chunk < count; chunk += VOICE_CHUNK) {
+        const int frames = std::min(VOICE_CHUNK, count - chunk);
+        float sumLeft[VOICE_CHUNK][VOICE_LANES] = {};
+        float sumRight[VOICE_CHUNK][VOICE_LANES] = {};
+
+        for (int lane = 0; lane < laneCount; ++lane) {
+            const int slot = lane % VOICE_LANES;
+            float phaseLeft = lanes.phaseLeft[lane];
+            float phaseRight = lanes.phaseRight[lane];
+            float pulse = lanes.pulsePhase[lane];
+            float envelope = lanes.envelope[lane];
+
+            for (int i = 0; i < frames; ++i) {
+                const float n = static_cast<float>(chunk + i);
+                envelope = pulse < 0.5f ? std::min(envelope + lanes.attackStep, 1.0f)
+                                        : std::max(envelope - lanes.releaseStep, 0.0f);
+                const float amplitude = (lanes.gain[lane] + lanes.gainStep[lane] * n) * envelope;
+                sumLeft[i][slot] = sumLeft[i][slot] + amplitude * voiceShapeScalar(lanes, lane, phaseLeft);
+                sumRight[i][slot] = sumRight[i][slot] + amplitude * voiceShapeScalar(lanes, lane, phaseRight);
+                phaseLeft = wrapPhase(phaseLeft + (lanes.incLeft[lane] + lanes.incLeftStep[lane] * n));
+                phaseRight = wrapPhase(phaseRight + (lanes.incRight[lane] + lanes.incRightStep[lane] * n));
+                pulse = wrapPhase(pulse + lanes.pulseInc[lane]);
+            }
+
+            lanes.phaseLeft[lane] = phaseLeft;
+            lanes.phaseRight[lane] = phaseRight;
+            lanes.pulsePhase[lane] = pulse;
+            lanes.envelope[lane] = envelope;
+        }
+
+        for (int i = 0; i < frames; ++i) {
+            left[chunk + i] = reduceLanes(sumLeft[i]);
+            right[chunk + i] = reduceLanes(sumRight[i]);
+        }
+    }
+}
+
+// ============================================================
+// LEVEL METER
+// ============================================================
+// Metering rides along the output stages: each sample costs a
+// multiply, an add and a max on top of a store-bound loop. Maxima are
+// exact in any order; sums of squares follow the partials layout, so
+// every variant adds the same values in the same order.
+
+static void measureLevelRange(const float *buffer, int begin, int end, float &maxSquare, float *partials)
+{
+    for (int i = begin; i < end; ++i) {
+        const float square = buffer[i] * buffer[i];
+        maxSquare = std::max(maxSquare, square);
+        partials[i % LEVEL_PARTIALS] += square;
+    }
+}
+
+static inline float reducePartials(const float *partials)
+{
+    return reduceLanes(partials) + reduceLanes(partials + VOICE_LANES);
+}
+
+// Meters the frames from begin on, then fills in levels
+static void finishLevels(const float *left, const float *right, int begin, int count,
+                         float maxSquareLeft, float maxSquareRight,
+                         float *partialsLeft, float *partialsRight, LevelSums &levels)
+{
+    measureLevelRange(left, begin, count, maxSquareLeft, partialsLeft);
+    measureLevelRange(right, begin, count, maxSquareRight, partialsRight);
+    levels.peakLeft = std::sqrt(maxSquareLeft);
+    levels.peakRight = std::sqrt(maxSquareRight);
+    levels.sumSquaresLeft = reducePartials(partialsLeft);
+    levels.sumSquaresRight = reducePartials(partialsRight);
+}
+
+static void convertToInt16Scalar(const float *left, const float *right, int16_t *out, int count, LevelSums *levels)
+{
+    convertFramesScalar(left, right, out, count);
+    if (levels) {
+        float partialsLeft[LEVEL_PARTIALS] = {};
+        float partialsRight[LEVEL_PARTIALS] = {};
+        finishLevels(left, right, 0, count, 0.0f, 0.0f, partialsLeft, partialsRight, *levels);
+    }
+}
+
+// One pass per frame: without the vector width to amortize them over,
+// separate passes cost more in loads and stores than the arithmetic.
+// Instantiated per noise/metering/ramp so the loop carries no
+// branches; without a ramp, value + 0 * i is value and is hoisted.
+template<bool Noise, bool Metered, bool Ramped>
+static void mixGainToInt16Frames(float *left, float *right, const float *noise, float level, float levelStep,
+                                 float gain, float gainStep, int16_t *out, int count, LevelSums *levels)
+{
+    float maxSquareLeft = 0.0f;
+    float maxSquareRight = 0.0f;
+    float partialsLeft[LEVEL_PARTIALS] = {};
+    float partialsRight[LEVEL_PARTIALS] = {};
+
+    for (int i = 0; i < count; ++i) {
+        const float n = static_cast<float>(i);
+        float sampleLeft = left[i];
+        float sampleRight = right[i];
+        if constexpr (Noise) {
+            const float mix = Ramped ? level + levelStep * n : level;
+            sampleLeft = sampleLeft * (1.0f - mix) + noise[i] * mix;
+            sampleRight = sampleRight * (1.0f - mix) + noise[i] * mix;
+        }
+        const float factor = Ramped ? gain + gainStep * n : gain;
+        sampleLeft = sampleLeft * factor;
+        sampleRight = sampleRight * factor;
+        left[i] = sampleLeft;
+        right[i] = sampleRight;
+        out[2 * i] = toInt16(sampleLeft);
+        out[2 * i + 1] = toInt16(sampleRight);
+
+        if constexpr (Metered) {
+            const float squareLeft = sampleLeft * sampleLeft;
+            const float squareRight = sampleRight * sampleRight;
+            maxSquareLeft = std::max(maxSquareLeft, squareLeft);
+            maxSquareRight = std::max(maxSquareRight, squareRight);
+            partialsLeft[i % LEVEL_PARTIALS] += squareLeft;
+            partialsRight[i % LEVEL_PARTIALS] += squareRight;
+        }
+    }
+
+    if constexpr (Metered) {
+        finishLevels(left, right, count, count, maxSquareLeft, maxSquareRight,
+                     partialsLeft, partialsRight, *levels);
+    }
+}
+
+template<bool Noise, bool Metered>
+static void mixGainToInt16Ramp(float *left, float *right, const float *noise, float level, float levelStep,
+                               float gain, float gainStep, int16_t *out, int count, LevelSums *levels)
+{
+    if (levelStep != 0.0f || gainStep != 0.0f) {
+        mixGainToInt16Frames<Noise, Metered, true>(left, right, noise, level, levelStep, gain, gainStep,
+                                                   out, count, levels);
+    } else {
+        mixGainToInt16Frames<Noise, Metered, false>(left, right, noise, level, levelStep, gain, gainStep,
+                                                    out, count, levels);
+    }
+}
+
+static void mixGainToInt16Scalar(float *left, float *right, const float *noise, float level, float levelStep,
+                                 float gain, float gainStep, int16_t *out, int count, LevelSums *levels)
+{
+    if (noise) {
+        if (levels) {
+            mixGainToInt16Ramp<true, true>(left, right, noise, level, levelStep, gain, gainStep, out, count, levels);
+        } else {
+            mixGainToInt16Ramp<true, false>(left, right, noise, level, levelStep, gain, gainStep, out, count, levels);
+        }
+    } else if (levels) {
+        mixGainToInt16Ramp<false, true>(left, right, noise, level, levelStep, gain, gainStep, out, count, levels);
+    } else {
+        mixGainToInt16Ramp<false, false>(left, right, noise, level, levelStep, gain, gainStep, out, count, levels);
+    }
+}
+
+static void interleaveFloatScalar(const float *left, const float *right, float *out, int count, LevelSums *levels)
+{
+    interleaveFramesScalar(left, right, out, count);
+    if (levels) {
+        float partialsLeft[LEVEL_PARTIALS] = {};
+        float partialsRight[LEVEL_PARTIALS] = {};
+        finishLevels(left, right, 0, count, 0.0f, 0.0f, partialsLeft, partialsRight, *levels);
+    }
+}
+
+// Vector variants keep their separate passes
+template<void (*MixNoise)(float *, const float *, float, float, int),
+         void (*ApplyGain)(float *, float, float, int),
+         void (*ConvertToInt16)(const float *, const float *, int16_t *, int, LevelSums *)>
+static void mixGainToInt16Staged(float *left, float *right, const float *noise, float level, float levelStep,
+                                 float gain, float gainStep, int16_t *out, int count, LevelSums *levels)
+{
+    if (noise) {
+        MixNoise(left, noise, level, levelStep, count);
+        MixNoise(right, noise, level, levelStep, count);
+    }
+    ApplyGain(left, gain, gainStep, count);
+    ApplyGain(right, gain, gainStep, count);
+    ConvertToInt16(left, right, out, count, levels);
+}
+
+// ============================================================
+// SSE2
+// ============================================================
+#ifdef RENDERKERNELS_X86
+
+static void applyGateSse2(float *buffer, const float *gate, int count)
+{
+    int i = 0;
+    for (; i + 4 <= count; i += 4) {
+        _mm_storeu_ps(buffer + i, _mm_mul_ps(_mm_loadu_ps(buffer + i), _mm_loadu_ps(gate + i)));
+    }
+    applyGateScalar(buffer + i, gate + i, count - i);
+}
+
+static inline __m128 rampSse2(__m128 start, __m128 step, int i)
+{
+    const __m128 index = _mm_cvtepi32_ps(_mm_add_epi32(_mm_set1_epi32(i), _mm_setr_epi32(0, 1, 2, 3)));
+    return _mm_add_ps(start, _mm_mul_ps(step, index));
+}
+
+static void mixNoiseSse2(float *buffer, const float *noise, float level, float levelStep, int count)
+{
+    const __m128 start = _mm_set1_ps(level);
+    const __m128 step = _mm_set1_ps(levelStep);
+    const __m128 one = _mm_set1_ps(1.0f);
+    int i = 0;
+    for (; i + 4 <= count; i += 4) {
+        const __m128 mix = rampSse2(start, step, i);
+        __m128 tone = _mm_mul_ps(_mm_loadu_ps(buffer + i), _mm_sub_ps(one, mix));
+        __m128 n = _mm_mul_ps(_mm_loadu_ps(noise + i), mix);
+        _mm_storeu_ps(buffer + i, _mm_add_ps(tone, n));
+    }
+    mixNoiseRange(buffer, noise, level, levelStep, i, count);
+}
+
+static void applyGainSse2(float *buffer, float gain, float gainStep, int count)
+{
+    const __m128 start = _mm_set1_ps(gain);
+    const __m128 step = _mm_set1_ps(gainStep);
+    int i = 0;
+    for (; i + 4 <= count; i += 4) {
+        _mm_storeu_ps(buffer + i, _mm_mul_ps(_mm_loadu_ps(buffer + i), rampSse2(start, step, i)));
+    }
+    applyGainRange(buffer, gain, gainStep, i, count);
+}
+
+static void mixAddSse2(float *buffer, const float *source, float gain, float gainStep, int count)
+{
+    const __m128 start = _mm_set1_ps(gain);
+    const __m128 step = _mm_set1_ps(gainStep);
+    int i = 0;
+    for (; i + 4 <= count; i += 4) {
+        const __m128 scaled = _mm_mul_ps(_mm_loadu_ps(source + i), rampSse2(start, step, i));
+        _mm_storeu_ps(buffer + i, _mm_add_ps(_mm_loadu_ps(buffer + i), scaled));
+    }
+    mixAddRange(buffer, source, gain, gainStep, i, count);
+}
+
+static inline __m128i toInt32Sse2(__m128 x)
+{
+    const __m128 lo = _mm_set1_ps(-1.0f);
+    const __m128 hi = _mm_set1_ps(1.0f);
+    const __m128 scale = _mm_set1_ps(32767.0f);
+    return _mm_cvttps_epi32(_mm_mul_ps(_mm_min_ps(_mm_max_ps(x, lo), hi), scale));
+}
+
+// Eight frames, from two vectors per channel
+static inline void storeInt16Sse2(__m128 left0, __m128 left1, __m128 right0, __m128 right1, int16_t *out)
+{
+    __m128i l = _mm_packs_epi32(toInt32Sse2(left0), toInt32Sse2(left1));
+    __m128i r = _mm_packs_epi32(toInt32Sse2(right0), toInt32Sse2(right1));
+    _mm_storeu_si128(reinterpret_cast<__m128i *>(out), _mm_unpacklo_epi16(l, r));
+    _mm_storeu_si128(reinterpret_cast<__m128i *>(out + 8), _mm_unpackhi_epi16(l, r));
+}
+
+static inline __m128 clampSse2(__m128 x)
+{
+    return _mm_min_ps(_mm_max_ps(x, _mm_set1_ps(-1.0f)), _mm_set1_ps(1.0f));
+}
+
+// Clamped to [-1, 1]
+static inline void storeInterleavedSse2(__m128 left, __m128 right, float *out)
+{
+    left = clampSse2(left);
+    right = clampSse2(right);
+    _mm_storeu_ps(out, _mm_unpacklo_ps(left, right));
+    _mm_storeu_ps(out + 4, _mm_unpackhi_ps(left, right));
+}
+
+// One channel's sums of squares: four accumulators of four partials
+struct LevelAccumulatorSse2 {
+    __m128 sum0, sum1, sum2, sum3;
+    __m128 maxSquare;
+};
+
+static inline LevelAccumulatorSse2 levelAccumulatorSse2()
+{
+    const __m128 zero = _mm_setzero_ps();
+    return { zero, zero, zero, zero, zero };
+}
+
+// One LEVEL_PARTIALS stretch of a channel
+static inline void meterStretchSse2(__m128 x0, __m128 x1, __m128 x2, __m128 x3, LevelAccumulatorSse2 &acc)
+{
+    const __m128 s0 = _mm_mul_ps(x0, x0);
+    const __m128 s1 = _mm_mul_ps(x1, x1);
+    const __m128 s2 = _mm_mul_ps(x2, x2);
+    const __m128 s3 = _mm_mul_ps(x3, x3);
+    acc.sum0 = _mm_add_ps(acc.sum0, s0);
+    acc.sum1 = _mm_add_ps(acc.sum1, s1);
+    acc.sum2 = _mm_add_ps(acc.sum2, s2);
+    acc.sum3 = _mm_add_ps(acc.sum3, s3);
+    acc.maxSquare = _mm_max_ps(acc.maxSquare, _mm_max_ps(_mm_max_ps(s0, s1), _mm_max_ps(s2, s3)));
+}
+
+// Stores the partials and returns the largest square
+static inline float storeLevelSse2(const LevelAccumulatorSse2 &acc, float *partials)
+{
+    _mm_storeu_ps(partials, acc.sum0);
+    _mm_storeu_ps(partials + 4, acc.sum1);
+    _mm_storeu_ps(partials + 8, acc.sum2);
+    _mm_storeu_ps(partials + 12, acc.sum3);
+    alignas(16) float lanes[4];
+    _mm_store_ps(lanes, acc.maxSquare);
+    return std::max(std::max(lanes[0], lanes[1]), std::max(lanes[2], lanes[3]));
+}
+
+static void convertToInt16Sse2(const float *left, const float *right, int16_t *out, int count, LevelSums *levels)
+{
+    LevelAccumulatorSse2 accLeft = levelAccumulatorSse2();
+    LevelAccumulatorSse2 accRight = levelAccumulatorSse2();
+    int i = 0;
+    for (; i + LEVEL_PARTIALS <= count; i += LEVEL_PARTIALS) {
+        const __m128 l0 = _mm_loadu_ps(left + i);
+        const __m128 l1 = _mm_loadu_ps(left + i + 4);
+        const __m128 l2 = _mm_loadu_ps(left + i + 8);
+        const __m128 l3 = _mm_loadu_ps(left + i + 12);
+        const __m128 r0 = _mm_loadu_ps(right + i);
+        const __m128 r1 = _mm_loadu_ps(right + i + 4);
+        const __m128 r2 = _mm_loadu_ps(right + i + 8);
+        const __m128 r3 = _mm_loadu_ps(right + i + 12);
+        storeInt16Sse2(l0, l1, r0, r1, out + 2 * i);
+        storeInt16Sse2(l2, l3, r2, r3, out + 2 * i + 16);
+        if (levels) {
+            meterStretchSse2(l0, l1, l2, l3, accLeft);
+            meterStretchSse2(r0, r1, r2, r3, accRight);
+        }
+    }
+    convertFramesScalar(left + i, right + i, out + 2 * i, count - i);
+
+    if (levels) {
+        float partialsLeft[LEVEL_PARTIALS];
+        float partialsRight[LEVEL_PARTIALS];
+        const float maxLeft = storeLevelSse2(accLeft, partialsLeft);
+        const float maxRight = storeLevelSse2(accRight, partialsRight);
+        finishLevels(left, right, i, count, maxLeft, maxRight, partialsLeft, partialsRight, *levels);
+    }
+}
+
+static void interleaveFloatSse2(const float *left, const float *right, float *out, int count, LevelSums *levels)
+{
+    LevelAccumulatorSse2 accLeft = levelAccumulatorSse2();
+    LevelAccumulatorSse2 accRight = levelAccumulatorSse2();
+    int i = 0;
+    for (; i + LEVEL_PARTIALS <= count; i += LEVEL_PARTIALS) {
+        const __m128 l0 = _mm_loadu_ps(left + i);
+        const __m128 l1 = _mm_loadu_ps(left + i + 4);
+        const __m128 l2 = _mm_loadu_ps(left + i + 8);
+        const __m128 l3 = _mm_loadu_ps(left + i + 12);
+        const __m128 r0 = _mm_loadu_ps(right + i);
+        const __m128 r1 = _mm_loadu_ps(right + i + 4);
+        const __m128 r2 = _mm_loadu_ps(right + i + 8);
+        const __m128 r3 = _mm_loadu_ps(right + i + 12);
+        storeInterleavedSse2(l0, r0, out + 2 * i);
+        storeInterleavedSse2(l1, r1, out + 2 * i + 8);
+        storeInterleavedSse2(l2, r2, out + 2 * i + 16);
+        storeInterleavedSse2(l3, r3, out + 2 * i + 24);
+        if (levels) {
+            meterStretchSse2(l0, l1, l2, l3, accLeft);
+            meterStretchSse2(r0, r1, r2, r3, accRight);
+        }
+    }
+    interleaveFramesScalar(left + i, right + i, out + 2 * i, count - i);
+
+    if (levels) {
+        float partialsLeft[LEVEL_PARTIALS];
+        float partialsRight[LEVEL_PARTIALS];
+        const float maxLeft = storeLevelSse2(accLeft, partialsLeft);
+        const float maxRight = storeLevelSse2(accRight, partialsRight);
+        finishLevels(left, right, i, count, maxLeft, maxRight, partialsLeft, partialsRight, *levels);
+    }
+}
+
+// Per-lane selects without SSE4.1's blendv
+static inline __m128 selectSse2(__m128 mask, __m128 a, __m128 b)
+{
+    return _mm_or_ps(_mm_and_ps(mask, a), _mm_andnot_ps(mask, b));
+}
+
+static inline __m128 voiceSineSse2(__m128 phase)
+{
+    const __m128 signMask = _mm_set1_ps(-0.0f);
+    __m128 x = _mm_sub_ps(phase, _mm_set1_ps(0.5f));
+    const __m128 half = _mm_or_ps(_mm_set1_ps(0.5f), _mm_and_ps(x, signMask));
+    const __m128 magnitude = _mm_andnot_ps(signMask, x);
+    x = selectSse2(_mm_cmpgt_ps(magnitude, _mm_set1_ps(0.25f)), _mm_sub_ps(half, x), x);
+    const __m128 t = _mm_mul_ps(x, _mm_set1_ps(VOICE_TWO_PI));
+    const __m128 t2 = _mm_mul_ps(t, t);
+    __m128 poly = _mm_set1_ps(SINE_C9);
+    poly = _mm_add_ps(_mm_mul_ps(poly, t2), _mm_set1_ps(SINE_C7));
+    poly = _mm_add_ps(_mm_mul_ps(poly, t2), _mm_set1_ps(SINE_C5));
+    poly = _mm_add_ps(_mm_mul_ps(poly, t2), _mm_set1_ps(SINE_C3));
+    poly = _mm_add_ps(_mm_mul_ps(poly, t2), _mm_set1_ps(1.0f));
+    return _mm_xor_ps(_mm_mul_ps(poly, t), signMask);
+}
+
+struct VoiceMixSse2 {
+    __m128 sine, square, triangle, sawtooth;
+};
+
+static inline __m128 voiceShapeSse2(const VoiceMixSse2 &mix, __m128 phase)
+{
+    const __m128 one = _mm_set1_ps(1.0f);
+    const __m128 two = _mm_set1_ps(2.0f);
+    const __m128 four = _mm_set1_ps(4.0f);
+    const __m128 low = _mm_cmplt_ps(phase, _mm_set1_ps(0.5f));
+    const __m128 square = selectSse2(low, one, _mm_set1_ps(-1.0f));
+    const __m128 triangle = selectSse2(low, _mm_sub_ps(_mm_mul_ps(four, phase), one),
+                                       _mm_sub_ps(_mm_set1_ps(3.0f), _mm_mul_ps(four, phase)));
+    const __m128 sawtooth = selectSse2(low, _mm_mul_ps(two, phase), _mm_mul_ps(two, _mm_sub_ps(phase, one)));
+    const __m128 shape = _mm_add_ps(_mm_mul_ps(mix.sine, voiceSineSse2(phase)), _mm_mul_ps(mix.square, square));
+    return _mm_add_ps(_mm_add_ps(shape, _mm_mul_ps(mix.triangle, triangle)), _mm_mul_ps(mix.sawtooth, sawtooth));
+}
+
+static inline __m128 wrapPhaseSse2(__m128 phase)
+{
+    const __m128 one = _mm_set1_ps(1.0f);
+    return selectSse2(_mm_cmpge_ps(phase, one), _mm_sub_ps(phase, one), phase);
+}
+
+// Four lanes starting at lane; their partial sums go to sums[i * VOICE_LANES + slot]
+static void renderVoiceQuadSse2(const VoiceLanes &lanes, int lane, int chunk, int frames,
+                                float *sumLeft, float *sumRight)
+{
+    const int slot = lane % VOICE_LANES;
+    __m128 phaseLeft = _mm_load_ps(lanes.phaseLeft + lane);
+    __m128 phaseRight = _mm_load_ps(lanes.phaseRight + lane);
+    __m128 pulse = _mm_load_ps(lanes.pulsePhase + lane);
+    __m128 envelope = _mm_load_ps(lanes.envelope + lane);
+    const __m128 incLeft = _mm_load_ps(lanes.incLeft + lane);
+    const __m128 incLeftStep = _mm_load_ps(lanes.incLeftStep + lane);
+    const __m128 incRight = _mm_load_ps(lanes.incRight + lane);
+    const __m128 incRightStep = _mm_load_ps(lanes.incRightStep + lane);
+    const __m128 pulseInc = _mm_load_ps(lanes.pulseInc + lane);
+    const __m128 gain = _mm_load_ps(lanes.gain + lane);
+    const __m128 gainStep = _mm_load_ps(lanes.gainStep + lane);
+    const VoiceMixSse2 mix = { _mm_load_ps(lanes.sineMix + lane), _mm_load_ps(lanes.squareMix + lane),
+                               _mm_load_ps(lanes.triangleMix + lane), _mm_load_ps(lanes.sawtoothMix + lane) };
+    const __m128 attack = _mm_set1_ps(lanes.attackStep);
+    const __m128 release = _mm_set1_ps(lanes.releaseStep);
+    const __m128 half = _mm_set1_ps(0.5f);
+
+    for (int i = 0; i < frames; ++i) {
+        const __m128 n = _mm_set1_ps(static_cast<float>(chunk + i));
+        envelope = selectSse2(_mm_cmplt_ps(pulse, half),
+                              _mm_min_ps(_mm_add_ps(envelope, attack), _mm_set1_ps(1.0f)),
+                              _mm_max_ps(_mm_sub_ps(envelope, release), _mm_setzero_ps()));
+        const __m128 amplitude = _mm_mul_ps(_mm_add_ps(gain, _mm_mul_ps(gainStep, n)), envelope);
+        float *outLeft = sumLeft + i * VOICE_LANES + slot;
+        float *outRight = sumRight + i * VOICE_LANES + slot;
+        _mm_storeu_ps(outLeft, _mm_add_ps(_mm_loadu_ps(outLeft), _mm_mul_ps(amplitude, voiceShapeSse2(mix, phaseLeft))));
+        _mm_storeu_ps(outRight, _mm_add_ps(_mm_loadu_ps(outRight), _mm_mul_ps(amplitude, voiceShapeSse2(mix, phaseRight))));
+        phaseLeft = wrapPhaseSse2(_mm_add_ps(phaseLeft, _mm_add_ps(incLeft, _mm_mul_ps(incLeftStep, n))));
+        phaseRight = wrapPhaseSse2(_mm_add_ps(phaseRight, _mm_add_ps(incRight, _mm_mul_ps(incRightStep, n))));
+        pulse = wrapPhaseSse2(_mm_add_ps(pulse, pulseInc));
+    }
+
+    _mm_store_ps(lanes.phaseLeft + lane, phaseLeft);
+    _mm_store_ps(lanes.phaseRight + lane, phaseRight);
+    _mm_store_ps(lanes.pulsePhase + lane, pulse);
+    _mm_store_ps(lanes.envelope + lane, envelope);
+}
+
+static inline float reduceLanesSse2(const float *sums)
+{
+    const __m128 v = _mm_add_ps(_mm_loadu_ps(sums), _mm_loadu_ps(sums + 4));
+    const __m128 w = _mm_add_ps(v, _mm_movehl_ps(v, v));
+    return _mm_cvtss_f32(_mm_add_ss(w, _mm_shuffle_ps(w, w, 1)));
+}
+
+static void renderVoicesSse2(const VoiceLanes &lanes, int laneCount, float *left, float *right, int count)
+{
+    for (int chunk = 0; chunk < count; chunk += VOICE_CHUNK) {
+        const int frames = std::min(VOICE_CHUNK, count - chunk);
+        alignas(16) float sumLeft[VOICE_CHUNK * VOICE_LANES] = {};
+        alignas(16) float sumRight[VOICE_CHUNK * VOICE_LANES] = {};
+
+        for (int lane = 0; lane < laneCount; lane += 4) {
+            renderVoiceQuadSse2(lanes, lane, chunk, frames, sumLeft, sumRight);
+        }
+        for (int i = 0; i < frames; ++i) {
+            left[chunk + i] = reduceLanesSse2(sumLeft + i * VOICE_LANES);
+            right[chunk + i] = reduceLanesSse2(sumRight + i * VOICE_LANES);
+        }
+    }
+}
+
+#endif // RENDERKERNELS_X86
+
+// ============================================================
+// AVX2
+// ============================================================
+#ifdef RENDERKERNELS_AVX2
+
+__attribute__((target("avx2")))
+static void applyGateAvx2(float *buffer, const float *gate, int count)
+{
+    int i = 0;
+    for (; i + 8 <= count; i += 8) {
+        _mm256_storeu_ps(buffer + i, _mm256_mul_ps(_mm256_loadu_ps(buffer + i),
+                                                   _mm256_loadu_ps(gate + i)));
+    }
+    applyGateScalar(buffer + i, gate + i, count - i);
+}
+
+__attribute__((target("avx2")))
+static inline __m256 rampAvx2(__m256 start, __m256 step, int i)
+{
+    const __m256i lanes = _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+    const __m256 index = _mm256_cvtepi32_ps(_mm256_add_epi32(_mm256_set1_epi32(i), lanes));
+    return _mm256_add_ps(start, _mm256_mul_ps(step, index));
+}
+
+__attribute__((target("avx2")))
+static void mixNoiseAvx2(float *buffer, const float *noise, float level, float levelStep, int count)
+{
+    const __m256 start = _mm256_set1_ps(level);
+    const __m256 step = _mm256_set1_ps(levelStep);
+    const __m256 one = _mm256_set1_ps(1.0f);
+    int i = 0;
+    for (; i + 8 <= count; i += 8) {
+        const __m256 mix = rampAvx2(start, step, i);
+        __m256 tone = _mm256_mul_ps(_mm256_loadu_ps(buffer + i), _mm256_sub_ps(one, mix));
+        __m256 n = _mm256_mul_ps(_mm256_loadu_ps(noise + i), mix);
+        _mm256_storeu_ps(buffer + i, _mm256_add_ps(tone, n));
+    }
+    mixNoiseRange(buffer, noise, level, levelStep, i, count);
+}
+
+__attribute__((target("avx2")))
+static void applyGainAvx2(float *buffer, float gain, float gainStep, int count)
+{
+    const __m256 start = _mm256_set1_ps(gain);
+    const __m256 step = _mm256_set1_ps(gainStep);
+    int i = 0;
+    for (; i + 8 <= count; i += 8) {
+        _mm256_storeu_ps(buffer + i, _mm256_mul_ps(_mm256_loadu_ps(buffer + i),
+                                                   rampAvx2(start, step, i)));
+    }
+    applyGainRange(buffer, gain, gainStep, i, count);
+}
+
+__attribute__((target("avx2")))
+static void mixAddAvx2(float *buffer, const float *source, float gain, float gainStep, int count)
+{
+    const __m256 start = _mm256_set1_ps(gain);
+    const __m256 step = _mm256_set1_ps(gainStep);
+    int i = 0;
+    for (; i + 8 <= count; i += 8) {
+        const __m256 scaled = _mm256_mul_ps(_mm256_loadu_ps(source + i), rampAvx2(start, step, i));
+        _mm256_storeu_ps(buffer + i, _mm256_add_ps(_mm256_loadu_ps(buffer + i), scaled));
+    }
+    mixAddRange(buffer, source, gain, gainStep, i, count);
+}
+
+__attribute__((target("avx2")))
+static inline __m256i toInt32Avx2(__m256 samples)
+{
+    const __m256 lo = _mm256_set1_ps(-1.0f);
+    const __m256 hi = _mm256_set1_ps(1.0f);
+    const __m256 scale = _mm256_set1_ps(32767.0f);
+    __m256 x = _mm256_min_ps(_mm256_max_ps(samples, lo), hi);
+    return _mm256_cvttps_epi32(_mm256_mul_ps(x, scale));
+}
+
+// Sixteen frames, from two vectors per channel. Pack and unpack work
+// per 128-bit lane; packing frames 0-7 with 8-15 puts 0-3, 8-11 in the
+// low lane and 4-7, 12-15 in the high one, so the unpacks come out in
+// frame order without a permute
+__attribute__((target("avx2")))
+static inline void storeInt16Avx2(__m256 left0, __m256 left1, __m256 right0, __m256 right1, int16_t *out)
+{
+    const __m256i l = _mm256_packs_epi32(toInt32Avx2(left0), toInt32Avx2(left1));
+    const __m256i r = _mm256_packs_epi32(toInt32Avx2(right0), toInt32Avx2(right1));
+    _mm256_storeu_si256(reinterpret_cast<__m256i *>(out), _mm256_unpacklo_epi16(l, r));
+    _mm256_storeu_si256(reinterpret_cast<__m256i *>(out + 16), _mm256_unpackhi_epi16(l, r));
+}
+
+__attribute__((target("avx2")))
+static inline __m256 clampAvx2(__m256 x)
+{
+    return _mm256_min_ps(_mm256_max_ps(x, _mm256_set1_ps(-1.0f)), _mm256_set1_ps(1.0f));
+}
+
+// Clamped to [-1, 1]
+__attribute__((target("avx2")))
+static inline void storeInterleavedAvx2(__m256 left, __m256 right, float *out)
+{
+    left = clampAvx2(left);
+    right = clampAvx2(right);
+    // Unpack works per 128-bit lane; the permutes restore frame order
+    const __m256 lo = _mm256_unpacklo_ps(left, right);
+    const __m256 hi = _mm256_unpackhi_ps(left, right);
+    _mm256_storeu_ps(out, _mm256_permute2f128_ps(lo, hi, 0x20));
+    _mm256_storeu_ps(out + 8, _mm256_permute2f128_ps(lo, hi, 0x31));
+}
+
+// One channel's sums of squares: two accumulators of eight partials
+struct LevelAccumulatorAvx2 {
+    __m256 sum0, sum1;
+    __m256 maxSquare;
+};
+
+// One LEVEL_PARTIALS stretch of a channel
+__attribute__((target("avx2")))
+static inline void meterStretchAvx2(__m256 x0, __m256 x1, LevelAccumulatorAvx2 &acc)
+{
+    const __m256 s0 = _mm256_mul_ps(x0, x0);
+    const __m256 s1 = _mm256_mul_ps(x1, x1);
+    acc.sum0 = _mm256_add_ps(acc.sum0, s0);
+    acc.sum1 = _mm256_add_ps(acc.sum1, s1);
+    acc.maxSquare = _mm256_max_ps(acc.maxSquare, _mm256_max_ps(s0, s1));
+}
+
+// Stores the partials and returns the largest square
+__attribute__((target("avx2")))
+static inline float storeLevelAvx2(const LevelAccumulatorAvx2 &acc, float *partials)
+{
+    _mm256_storeu_ps(partials, acc.sum0);
+    _mm256_storeu_ps(partials + 8, acc.sum1);
+    alignas(32) float lanes[8];
+    _mm256_store_ps(lanes, acc.maxSquare);
+    return *std::max_element(lanes, lanes + 8);
+}
+
+__attribute__((target("avx2")))
+static void convertToInt16Avx2(const float *left, const float *right, int16_t *out, int count, LevelSums *levels)
+{
+    const __m256 zero = _mm256_setzero_ps();
+    LevelAccumulatorAvx2 accLeft = { zero, zero, zero };
+    LevelAccumulatorAvx2 accRight = accLeft;
+    int i = 0;
+    for (; i + LEVEL_PARTIALS <= count; i += LEVEL_PARTIALS) {
+        const __m256 l0 = _mm256_loadu_ps(left + i);
+        const __m256 l1 = _mm256_loadu_ps(left + i + 8);
+        const __m256 r0 = _mm256_loadu_ps(right + i);
+        const __m256 r1 = _mm256_loadu_ps(right + i + 8);
+        storeInt16Avx2(l0, l1, r0, r1, out + 2 * i);
+        if (levels) {
+            meterStretchAvx2(l0, l1, accLeft);
+            meterStretchAvx2(r0, r1, accRight);
+        }
+    }
+    convertFramesScalar(left + i, right + i, out + 2 * i, count - i);
+
+    if (levels) {
+        float partialsLeft[LEVEL_PARTIALS];
+        float partialsRight[LEVEL_PARTIALS];
+        const float maxLeft = storeLevelAvx2(accLeft, partialsLeft);
+        const float maxRight = storeLevelAvx2(accRight, partialsRight);
+        finishLevels(left, right, i, count, maxLeft, maxRight, partialsLeft, partialsRight, *levels);
+    }
+}
+
+__attribute__((target("avx2")))
+static void interleaveFloatAvx2(const float *left, const float *right, float *out, int count, LevelSums *levels)
+{
+    const __m256 zero = _mm256_setzero_ps();
+    LevelAccumulatorAvx2 accLeft = { zero, zero, zero };
+    LevelAccumulatorAvx2 accRight = accLeft;
+    int i = 0;
+    for (; i + LEVEL_PARTIALS <= count; i += LEVEL_PARTIALS) {
+        const __m256 l0 = _mm256_loadu_ps(left + i);
+        const __m256 l1 = _mm256_loadu_ps(left + i + 8);
+        const __m256 r0 = _mm256_loadu_ps(right + i);
+        const __m256 r1 = _mm256_loadu_ps(right + i + 8);
+        storeInterleavedAvx2(l0, r0, out + 2 * i);
+        storeInterleavedAvx2(l1, r1, out + 2 * i + 16);
+        if (levels) {
+            meterStretchAvx2(l0, l1, accLeft);
+            meterStretchAvx2(r0, r1, accRight);
+        }
+    }
+    interleaveFramesScalar(left + i, right + i, out + 2 * i, count - i);
+
+    if (levels) {
+        float partialsLeft[LEVEL_PARTIALS];
+        float partialsRight[LEVEL_PARTIALS];
+        const float maxLeft = storeLevelAvx2(accLeft, partialsLeft);
+        const float maxRight = storeLevelAvx2(accRight, partialsRight);
+        finishLevels(left, right, i, count, maxLeft, maxRight, partialsLeft, partialsRight, *levels);
+    }
+}
+
+__attribute__((target("avx2")))
+static inline __m256 voiceSineAvx2(__m256 phase)
+{
+    const __m256 signMask = _mm256_set1_ps(-0.0f);
+    __m256 x = _mm256_sub_ps(phase, _mm256_set1_ps(0.5f));
+    const __m256 half = _mm256_or_ps(_mm256_set1_ps(0.5f), _mm256_and_ps(x, signMask));
+    const __m256 magnitude = _mm256_andnot_ps(signMask, x);
+    x = _mm256_blendv_ps(x, _mm256_sub_ps(half, x), _mm256_cmp_ps(magnitude, _mm256_set1_ps(0.25f), _CMP_GT_OQ));
+    const __m256 t = _mm256_mul_ps(x, _mm256_set1_ps(VOICE_TWO_PI));
+    const __m256 t2 = _mm256_mul_ps(t, t);
+    __m256 poly = _mm256_set1_ps(SINE_C9);
+    poly = _mm256_add_ps(_mm256_mul_ps(poly, t2), _mm256_set1_ps(SINE_C7));
+    poly = _mm256_add_ps(_mm256_mul_ps(poly, t2), _mm256_set1_ps(SINE_C5));
+    poly = _mm256_add_ps(_mm256_mul_ps(poly, t2), _mm256_set1_ps(SINE_C3));
+    poly = _mm256_add_ps(_mm256_mul_ps(poly, t2), _mm256_set1_ps(1.0f));
+    return _mm256_xor_ps(_mm256_mul_ps(poly, t), signMask);
+}
+
+struct VoiceMixAvx2 {
+    __m256 sine, square, triangle, sawtooth;
+};
+
+__attribute__((target("avx2")))
+static inline __m256 voiceShapeAvx2(const VoiceMixAvx2 &mix, __m256 phase)
+{
+    const __m256 one = _mm256_set1_ps(1.0f);
+    const __m256 two = _mm256_set1_ps(2.0f);
+    const __m256 four = _mm256_set1_ps(4.0f);
+    const __m256 low = _mm256_cmp_ps(phase, _mm256_set1_ps(0.5f), _CMP_LT_OQ);
+    const __m256 square = _mm256_blendv_ps(_mm256_set1_ps(-1.0f), one, low);
+    const __m256 triangle = _mm256_blendv_ps(_mm256_sub_ps(_mm256_set1_ps(3.0f), _mm256_mul_ps(four, phase)),
+                                             _mm256_sub_ps(_mm256_mul_ps(four, phase), one), low);
+    const __m256 sawtooth = _mm256_blendv_ps(_mm256_mul_ps(two, _mm256_sub_ps(phase, one)),
+                                             _mm256_mul_ps(two, phase), low);
+    const __m256 shape = _mm256_add_ps(_mm256_mul_ps(mix.sine, voiceSineAvx2(phase)),
+                                       _mm256_mul_ps(mix.square, square));
+    return _mm256_add_ps(_mm256_add_ps(shape, _mm256_mul_ps(mix.triangle, triangle)),
+                         _mm256_mul_ps(mix.sawtooth, sawtooth));
+}
+
+__attribute__((target("avx2")))
+static inline __m256 wrapPhaseAvx2(__m256 phase)
+{
+    const __m256 one = _mm256_set1_ps(1.0f);
+    return _mm256_blendv_ps(phase, _mm256_sub_ps(phase, one), _mm256_cmp_ps(phase, one, _CMP_GE_OQ));
+}
+
+__attribute__((target("avx2")))
+static inline float reduceLanesAvx2(const float *sums)
+{
+    const __m128 v = _mm_add_ps(_mm_load_ps(sums), _mm_load_ps(sums + 4));
+    const __m128 w = _mm_add_ps(v, _mm_movehl_ps(v, v));
+    return _mm_cvtss_f32(_mm_add_ss(w, _mm_shuffle_ps(w, w, 1)));
+}
+
+__attribute__((target("avx2")))
+static void renderVoicesAvx2(const VoiceLanes &lanes, int laneCount, float *left, float *right, int count)
+{
+    const __m256 attack = _mm256_set1_ps(lanes.attackStep);
+    const __m256 release = _mm256_set1_ps(lanes.releaseStep);
+    const __m256 half = _mm256_set1_ps(0.5f);
+
+    for (int chunk = 0; chunk < count; chunk += VOICE_CHUNK) {
+        const int frames = std::min(VOICE_CHUNK, count - chunk);
+        alignas(32) float sumLeft[VOICE_CHUNK * VOICE_LANES] = {};
+        alignas(32) float sumRight[VOICE_CHUNK * VOICE_LANES] = {};
+
+        for (int lane = 0; lane < laneCount; lane += VOICE_LANES) {
+            __m256 phaseLeft = _mm256_load_ps(lanes.phaseLeft + lane);
+            __m256 phaseRight = _mm256_load_ps(lanes.phaseRight + lane);
+            __m256 pulse = _mm256_load_ps(lanes.pulsePhase + lane);
+            __m256 envelope = _mm256_load_ps(lanes.envelope + lane);
+            const __m256 incLeft = _mm256_load_ps(lanes.incLeft + lane);
+            const __m256 incLeftStep = _mm256_load_ps(lanes.incLeftStep + lane);
+            const __m256 incRight = _mm256_load_ps(lanes.incRight + lane);
+            const __m256 incRightStep = _mm256_load_ps(lanes.incRightStep + lane);
+            const __m256 pulseInc = _mm256_load_ps(lanes.pulseInc + lane);
+            const __m256 gain = _mm256_load_ps(lanes.gain + lane);
+            const __m256 gainStep = _mm256_load_ps(lanes.gainStep + lane);
+            const VoiceMixAvx2 mix = { _mm256_load_ps(lanes.sineMix + lane), _mm256_load_ps(lanes.squareMix + lane),
+                                       _mm256_load_ps(lanes.triangleMix + lane),
+                                       _mm256_load_ps(lanes.sawtoothMix + lane) };
+
+            for (int i = 0; i < frames; ++i) {
+                const __m256 n = _mm256_set1_ps(static_cast<float>(chunk + i));
+                envelope = _mm256_blendv_ps(_mm256_max_ps(_mm256_sub_ps(envelope, release), _mm256_setzero_ps()),
+                                            _mm256_min_ps(_mm256_add_ps(envelope, attack), _mm256_set1_ps(1.0f)),
+                                            _mm256_cmp_ps(pulse, half, _CMP_LT_OQ));
+                const __m256 amplitude = _mm256_mul_ps(_mm256_add_ps(gain, _mm256_mul_ps(gainStep, n)), envelope);
+                float *outLeft = sumLeft + i * VOICE_LANES;
+                float *outRight = sumRight + i * VOICE_LANES;
+                _mm256_store_ps(outLeft, _mm256_add_ps(_mm256_load_ps(outLeft),
+                                                       _mm256_mul_ps(amplitude, voiceShapeAvx2(mix, phaseLeft))));
+                _mm256_store_ps(outRight, _mm256_add_ps(_mm256_load_ps(outRight),
+                                                        _mm256_mul_ps(amplitude, voiceShapeAvx2(mix, phaseRight))));
+                phaseLeft = wrapPhaseAvx2(_mm256_add_ps(phaseLeft,
+                                                        _mm256_add_ps(incLeft, _mm256_mul_ps(incLeftStep, n))));
+                phaseRight = wrapPhaseAvx2(_mm256_add_ps(phaseRight,
+                                                         _mm256_add_ps(incRight, _mm256_mul_ps(incRightStep, n))));
+                pulse = wrapPhaseAvx2(_mm256_add_ps(pulse, pulseInc));
+            }
+
+            _mm256_store_ps(lanes.phaseLeft + lane, phaseLeft);
+            _mm256_store_ps(lanes.phaseRight + lane, phaseRight);
+            _mm256_store_ps(lanes.pulsePhase + lane, pulse);
+            _mm256_store_ps(lanes.envelope + lane, envelope);
+        }
+
+        for (int i = 0; i < frames; ++i) {
+            left[chunk + i] = reduceLanesAvx2(sumLeft + i * VOICE_LANES);
+            right[chunk + i] = reduceLanesAvx2(sumRight + i * VOICE_LANES);
+        }
+    }
+}
+
+#endif // RENDERKERNELS_AVX2
+
+// ============================================================
+// NEON
+// ============================================================
+#ifdef RENDERKERNELS_NEON
+
+static void applyGateNeon(float *buffer, const float *gate, int count)
+{
+    int i = 0;
+    for (; i + 4 <= count; i += 4) {
+        vst1q_f32(buffer + i, vmulq_f32(vld1q_f32(buffer + i), vld1q_f32(gate + i)));
+    }
+    applyGateScalar(buffer + i, gate + i, count - i);
+}
+
+static inline float32x4_t rampNeon(float32x4_t start, float32x4_t step, int i)
+{
+    static const int32_t lanes[4] = {0, 1, 2, 3};
+    const float32x4_t index = vcvtq_f32_s32(vaddq_s32(vdupq_n_s32(i), vld1q_s32(lanes)));
+    return vaddq_f32(start, vmulq_f32(step, index));
+}
+
+static void mixNoiseNeon(float *buffer, const float *noise, float level, float levelStep, int count)
+{
+    const float32x4_t start = vdupq_n_f32(level);
+    const float32x4_t step = vdupq_n_f32(levelStep);
+    const float32x4_t one = vdupq_n_f32(1.0f);
+    int i = 0;
+    for (; i + 4 <= count; i += 4) {
+        const float32x4_t mix = rampNeon(start, step, i);
+        float32x4_t tone = vmulq_f32(vld1q_f32(buffer + i), vsubq_f32(one, mix));
+        float32x4_t n = vmulq_f32(vld1q_f32(noise + i), mix);
+        vst1q_f32(buffer + i, vaddq_f32(tone, n));
+    }
+    mixNoiseRange(buffer, noise, level, levelStep, i, count);
+}
+
+static void applyGainNeon(float *buffer, float gain, float gainStep, int count)
+{
+    const float32x4_t start = vdupq_n_f32(gain);
+    const float32x4_t step = vdupq_n_f32(gainStep);
+    int i = 0;
+    for (; i + 4 <= count; i += 4) {
+        vst1q_f32(buffer + i, vmulq_f32(vld1q_f32(buffer + i), rampNeon(start, step, i)));
+    }
+    applyGainRange(buffer, gain, gainStep, i, count);
+}
+
+static void mixAddNeon(float *buffer, const float *source, float gain, float gainStep, int count)
+{
+    const float32x4_t start = vdupq_n_f32(gain);
+    const float32x4_t step = vdupq_n_f32(gainStep);
+    int i = 0;
+    for (; i + 4 <= count; i += 4) {
+        const float32x4_t scaled = vmulq_f32(vld1q_f32(source + i), rampNeon(start, step, i));
+        vst1q_f32(buffer + i, vaddq_f32(vld1q_f32(buffer + i), scaled));
+    }
+    mixAddRange(buffer, source, gain, gainStep, i, count);
+}
+
+static inline int16x4_t toInt16Neon(float32x4_t samples)
+{
+    float32x4_t x = vminq_f32(vmaxq_f32(samples, vdupq_n_f32(-1.0f)), vdupq_n_f32(1.0f));
+    return vqmovn_s32(vcvtq_s32_f32(vmulq_f32(x, vdupq_n_f32(32767.0f))));
+}
+
+// Four frames
+static inline void storeInt16Neon(float32x4_t left, float32x4_t right, int16_t *out)
+{
+    int16x4x2_t frames;
+    frames.val[0] = toInt16Neon(left);
+    frames.val[1] = toInt16Neon(right);
+    vst2_s16(out, frames);
+}
+
+// Clamped to [-1, 1]
+static inline void storeInterleavedNeon(float32x4_t left, float32x4_t right, float *out)
+{
+    const float32x4_t lo = vdupq_n_f32(-1.0f);
+    const float32x4_t hi = vdupq_n_f32(1.0f);
+    float32x4x2_t frames;
+    frames.val[0] = vminq_f32(vmaxq_f32(left, lo), hi);
+    frames.val[1] = vminq_f32(vmaxq_f32(right, lo), hi);
+    vst2q_f32(out, frames);
+}
+
+// One channel's sums of squares: four accumulators of four partials
+struct LevelAccumulatorNeon {
+    float32x4_t sum0, sum1, sum2, sum3;
+    float32x4_t maxSquare;
+};
+
+static inline LevelAccumulatorNeon levelAccumulatorNeon()
+{
+    const float32x4_t zero = vdupq_n_f32(0.0f);
+    return { zero, zero, zero, zero, zero };
+}
+
+// One LEVEL_PARTIALS stretch of a channel
+static inline void meterStretchNeon(float32x4_t x0, float32x4_t x1, float32x4_t x2, float32x4_t x3,
+                                    LevelAccumulatorNeon &acc)
+{
+    const float32x4_t s0 = vmulq_f32(x0, x0);
+    const float32x4_t s1 = vmulq_f32(x1, x1);
+    const float32x4_t s2 = vmulq_f32(x2, x2);
+    const float32x4_t s3 = vmulq_f32(x3, x3);
+    acc.sum0 = vaddq_f32(acc.sum0, s0);
+    acc.sum1 = vaddq_f32(acc.sum1, s1);
+    acc.sum2 = vaddq_f32(acc.sum2, s2);
+    acc.sum3 = vaddq_f32(acc.sum3, s3);
+    acc.maxSquare = vmaxq_f32(acc.maxSquare, vmaxq_f32(vmaxq_f32(s0, s1), vmaxq_f32(s2, s3)));
+}
+
+// Stores the partials and returns the largest square
+static inline float storeLevelNeon(const LevelAccumulatorNeon &acc, float *partials)
+{
+    vst1q_f32(partials, acc.sum0);
+    vst1q_f32(partials + 4, acc.sum1);
+    vst1q_f32(partials + 8, acc.sum2);
+    vst1q_f32(partials + 12, acc.sum3);
+    float lanes[4];
+    vst1q_f32(lanes, acc.maxSquare);
+    return std::max(std::max(lanes[0], lanes[1]), std::max(lanes[2], lanes[3]));
+}
+
+static void convertToInt16Neon(const float *left, const float *right, int16_t *out, int count, LevelSums *levels)
+{
+    LevelAccumulatorNeon accLeft = levelAccumulatorNeon();
+    LevelAccumulatorNeon accRight = levelAccumulatorNeon();
+    int i = 0;
+    for (; i + LEVEL_PARTIALS <= count; i += LEVEL_PARTIALS) {
+        const float32x4_t l0 = vld1q_f32(left + i);
+        const float32x4_t l1 = vld1q_f32(left + i + 4);
+        const float32x4_t l2 = vld1q_f32(left + i + 8);
+        const float32x4_t l3 = vld1q_f32(left + i + 12);
+        const float32x4_t r0 = vld1q_f32(right + i);
+        const float32x4_t r1 = vld1q_f32(right + i + 4);
+        const float32x4_t r2 = vld1q_f32(right + i + 8);
+        const float32x4_t r3 = vld1q_f32(right + i + 12);
+        storeInt16Neon(l0, r0, out + 2 * i);
+        storeInt16Neon(l1, r1, out + 2 * i + 8);
+        storeInt16Neon(l2, r2, out + 2 * i + 16);
+        storeInt16Neon(l3, r3, out + 2 * i + 24);
+        if (levels) {
+            meterStretchNeon(l0, l1, l2, l3, accLeft);
+            meterStretchNeon(r0, r1, r2, r3, accRight);
+        }
+    }
+    convertFramesScalar(left + i, right + i, out + 2 * i, count - i);
+
+    if (levels) {
+        float partialsLeft[LEVEL_PARTIALS];
+        float partialsRight[LEVEL_PARTIALS];
+        const float maxLeft = storeLevelNeon(accLeft, partialsLeft);
+        const float maxRight = storeLevelNeon(accRight, partialsRight);
+        finishLevels(left, right, i, count, maxLeft, maxRight, partialsLeft, partialsRight, *levels);
+    }
+}
+
+static void interleaveFloatNeon(const float *left, const float *right, float *out, int count, LevelSums *levels)
+{
+    LevelAccumulatorNeon accLeft = levelAccumulatorNeon();
+    LevelAccumulatorNeon accRight = levelAccumulatorNeon();
+    int i = 0;
+    for (; i + LEVEL_PARTIALS <= count; i += LEVEL_PARTIALS) {
+        const float32x4_t l0 = vld1q_f32(left + i);
+        const float32x4_t l1 = vld1q_f32(left + i + 4);
+        const float32x4_t l2 = vld1q_f32(left + i + 8);
+        const float32x4_t l3 = vld1q_f32(left + i + 12);
+        const float32x4_t r0 = vld1q_f32(right + i);
+        const float32x4_t r1 = vld1q_f32(right + i + 4);
+        const float32x4_t r2 = vld1q_f32(right + i + 8);
+        const float32x4_t r3 = vld1q_f32(right + i + 12);
+        storeInterleavedNeon(l0, r0, out + 2 * i);
+        storeInterleavedNeon(l1, r1, out + 2 * i + 8);
+        storeInterleavedNeon(l2, r2, out + 2 * i + 16);
+        storeInterleavedNeon(l3, r3, out + 2 * i + 24);
+        if (levels) {
+            meterStretchNeon(l0, l1, l2, l3, accLeft);
+            meterStretchNeon(r0, r1, r2, r3, accRight);
+        }
+    }
+    interleaveFramesScalar(left + i, right + i, out + 2 * i, count - i);
+
+    if (levels) {
+        float partialsLeft[LEVEL_PARTIALS];
+        float partialsRight[LEVEL_PARTIALS];
+        const float maxLeft = storeLevelNeon(accLeft, partialsLeft);
+        const float maxRight = storeLevelNeon(accRight, partialsRight);
+        finishLevels(left, right, i, count, maxLeft, maxRight, partialsLeft, partialsRight, *levels);
+    }
+}
+
+static inline float32x4_t voiceSineNeon(float32x4_t phase)
+{
+    const uint32x4_t signMask = vdupq_n_u32(0x80000000u);
+    float32x4_t x = vsubq_f32(phase, vdupq_n_f32(0.5f));
+    const uint32x4_t bits = vreinterpretq_u32_f32(x);
+    const float32x4_t half = vreinterpretq_f32_u32(vorrq_u32(vreinterpretq_u32_f32(vdupq_n_f32(0.5f)),
+                                                             vandq_u32(bits, signMask)));
+    const float32x4_t magnitude = vreinterpretq_f32_u32(vbicq_u32(bits, signMask));
+    x = vbslq_f32(vcgtq_f32(magnitude, vdupq_n_f32(0.25f)), vsubq_f32(half, x), x);
+    const float32x4_t t = vmulq_f32(x, vdupq_n_f32(VOICE_TWO_PI));
+    const float32x4_t t2 = vmulq_f32(t, t);
+    float32x4_t poly = vdupq_n_f32(SINE_C9);
+    poly = vaddq_f32(vmulq_f32(poly, t2), vdupq_n_f32(SINE_C7));
+    poly = vaddq_f32(vmulq_f32(poly, t2), vdupq_n_f32(SINE_C5));
+    poly = vaddq_f32(vmulq_f32(poly, t2), vdupq_n_f32(SINE_C3));
+    poly = vaddq_f32(vmulq_f32(poly, t2), vdupq_n_f32(1.0f));
+    return vreinterpretq_f32_u32(veorq_u32(vreinterpretq_u32_f32(vmulq_f32(poly, t)), signMask));
+}
+
+struct VoiceMixNeon {
+    float32x4_t sine, square, triangle, sawtooth;
+};
+
+static inline float32x4_t voiceShapeNeon(const VoiceMixNeon &mix, float32x4_t phase)
+{
+    const float32x4_t one = vdupq_n_f32(1.0f);
+    const float32x4_t two = vdupq_n_f32(2.0f);
+    const float32x4_t four = vdupq_n_f32(4.0f);
+    const uint32x4_t low = vcltq_f32(phase, vdupq_n_f32(0.5f));
+    const float32x4_t square = vbslq_f32(low, one, vdupq_n_f32(-1.0f));
+    const float32x4_t triangle = vbslq_f32(low, vsubq_f32(vmulq_f32(four, phase), one),
+                                           vsubq_f32(vdupq_n_f32(3.0f), vmulq_f32(four, phase)));
+    const float32x4_t sawtooth = vbslq_f32(low, vmulq_f32(two, phase), vmulq_f32(two, vsubq_f32(phase, one)));
+    const float32x4_t shape = vaddq_f32(vmulq_f32(mix.sine, voiceSineNeon(phase)), vmulq_f32(mix.square, square));
+    return vaddq_f32(vaddq_f32(shape, vmulq_f32(mix.triangle, triangle)), vmulq_f32(mix.sawtooth, sawtooth));
+}
+
+static inline float32x4_t wrapPhaseNeon(float32x4_t phase)
+{
+    const float32x4_t one = vdupq_n_f32(1.0f);
+    return vbslq_f32(vcgeq_f32(phase, one), vsubq_f32(phase, one), phase);
+}
+
+// Four lanes starting at lane; their partial sums go to sums[i * VOICE_LANES + slot]
+static void renderVoiceQuadNeon(const VoiceLanes &lanes, int lane, int chunk, int frames,
+                                float *sumLeft, float *sumRight)
+{
+    const int slot = lane % VOICE_LANES;
+    float32x4_t phaseLeft = vld1q_f32(lanes.phaseLeft + lane);
+    float32x4_t phaseRight = vld1q_f32(lanes.phaseRight + lane);
+    float32x4_t pulse = vld1q_f32(lanes.pulsePhase + lane);
+    float32x4_t envelope = vld1q_f32(lanes.envelope + lane);
+    const float32x4_t incLeft = vld1q_f32(lanes.incLeft + lane);
+    const float32x4_t incLeftStep = vld1q_f32(lanes.incLeftStep + lane);
+    const float32x4_t incRight = vld1q_f32(lanes.incRight + lane);
+    const float32x4_t incRightStep = vld1q_f32(lanes.incRightStep + lane);
+    const float32x4_t pulseInc = vld1q_f32(lanes.pulseInc + lane);
+    const float32x4_t gain = vld1q_f32(lanes.gain + lane);
+    const float32x4_t gainStep = vld1q_f32(lanes.gainStep + lane);
+    const VoiceMixNeon mix = { vld1q_f32(lanes.sineMix + lane), vld1q_f32(lanes.squareMix + lane),
+                               vld1q_f32(lanes.triangleMix + lane), vld1q_f32(lanes.sawtoothMix + lane) };
+    const float32x4_t attack = vdupq_n_f32(lanes.attackStep);
+    const float32x4_t release = vdupq_n_f32(lanes.releaseStep);
+    const float32x4_t half = vdupq_n_f32(0.5f);
+
+    for (int i = 0; i < frames; ++i) {
+        const float32x4_t n = vdupq_n_f32(static_cast<float>(chunk + i));
+        envelope = vbslq_f32(vcltq_f32(pulse, half),
+                             vminq_f32(vaddq_f32(envelope, attack), vdupq_n_f32(1.0f)),
+                             vmaxq_f32(vsubq_f32(envelope, release), vdupq_n_f32(0.0f)));
+        const float32x4_t amplitude = vmulq_f32(vaddq_f32(gain, vmulq_f32(gainStep, n)), envelope);
+        float *outLeft = sumLeft + i * VOICE_LANES + slot;
+        float *outRight = sumRight + i * VOICE_LANES + slot;
+        vst1q_f32(outLeft, vaddq_f32(vld1q_f32(outLeft), vmulq_f32(amplitude, voiceShapeNeon(mix, phaseLeft))));
+        vst1q_f32(outRight, vaddq_f32(vld1q_f32(outRight), vmulq_f32(amplitude, voiceShapeNeon(mix, phaseRight))));
+        phaseLeft = wrapPhaseNeon(vaddq_f32(phaseLeft, vaddq_f32(incLeft, vmulq_f32(incLeftStep, n))));
+        phaseRight = wrapPhaseNeon(vaddq_f32(phaseRight, vaddq_f32(incRight, vmulq_f32(incRightStep, n))));
+        pulse = wrapPhaseNeon(vaddq_f32(pulse, pulseInc));
+    }
+
+    vst1q_f32(lanes.phaseLeft + lane, phaseLeft);
+    vst1q_f32(lanes.phaseRight + lane, phaseRight);
+    vst1q_f32(lanes.pulsePhase + lane, pulse);
+    vst1q_f32(lanes.envelope + lane, envelope);
+}
+
+static inline float reduceLanesNeon(const float *sums)
+{
+    const float32x4_t v = vaddq_f32(vld1q_f32(sums), vld1q_f32(sums + 4));
+    const float32x2_t w = vadd_f32(vget_low_f32(v), vget_high_f32(v));
+    return vget_lane_f32(w, 0) + vget_lane_f32(w, 1);
+}
+
+static void renderVoicesNeon(const VoiceLanes &lanes, int laneCount, float *left, float *right, int count)
+{
+    for (int chunk = 0; chunk < count; chunk += VOICE_CHUNK) {
+        const int frames = std::min(VOICE_CHUNK, count - chunk);
+        alignas(16) float sumLeft[VOICE_CHUNK * VOICE_LANES] = {};
+        alignas(16) float sumRight[VOICE_CHUNK * VOICE_LANES] = {};
+
+        for (int lane = 0; lane < laneCount; lane += 4) {
+            renderVoiceQuadNeon(lanes, lane, chunk, frames, sumLeft, sumRight);
+        }
+        for (int i = 0; i < frames; ++i) {
+            left[chunk + i] = reduceLanesNeon(sumLeft + i * VOICE_LANES);
+            right[chunk + i] = reduceLanesNeon(sumRight + i * VOICE_LANES);
+        }
+    }
+}
+
+#endif // RENDERKERNELS_NEON
+
+// ============================================================
+// DISPATCH
+// ============================================================
+
+static const KernelSet s_scalar = {
+    "scalar", applyGateScalar, mixNoiseScalar, applyGainScalar, mixAddScalar, convertToInt16Scalar,
+    mixGainToInt16Scalar, interleaveFloatScalar, renderVoicesScalar
+};
+
+#ifdef RENDERKERNELS_X86
+static const KernelSet s_sse2 = {
+    "sse2", applyGateSse2, mixNoiseSse2, applyGainSse2, mixAddSse2, convertToInt16Sse2,
+    mixGainToInt16Staged<mixNoiseSse2, applyGainSse2, convertToInt16Sse2>, interleaveFloatSse2, renderVoicesSse2
+};
+#endif
+
+#ifdef RENDERKERNELS_AVX2
+static const KernelSet s_avx2 = {
+    "avx2", applyGateAvx2, mixNoiseAvx2, applyGainAvx2, mixAddAvx2, convertToInt16Avx2,
+    mixGainToInt16Staged<mixNoiseAvx2, applyGainAvx2, convertToInt16Avx2>, interleaveFloatAvx2, renderVoicesAvx2
+};
+#endif
+
+#ifdef RENDERKERNELS_NEON
+static const KernelSet s_neon = {
+    "neon", applyGateNeon, mixNoiseNeon, applyGainNeon, mixAddNeon, convertToInt16Neon,
+    mixGainToInt16Staged<mixNoiseNeon, applyGainNeon, convertToInt16Neon>, interleaveFloatNeon, renderVoicesNeon
+};
+#endif
+
+static const KernelSet &selectKernels()
+{
+    const char *forced = std::getenv("BINAURAL_KERNELS");
+    if (forced && std::strcmp(forced, "scalar") == 0) {
+        return s_scalar;
+    }
+
+#ifdef RENDERKERNELS_AVX2
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) {
+        return s_avx2;
+    }
+#endif
+#ifdef RENDERKERNELS_X86
+    return s_sse2;
+#endif
+#ifdef RENDERKERNELS_NEON
+    return s_neon;
+#endif
+    return s_scalar;
+}
+
+const KernelSet &scalarKernels()
+{
+    return s_scalar;
+}
+
+int availableKernels(const KernelSet *sets[MAX_KERNEL_SETS])
+{
+    int count = 0;
+    sets[count++] = &s_scalar;
+#ifdef RENDERKERNELS_X86
+    sets[count++] = &s_sse2;
+#endif
+#ifdef RENDERKERNELS_AVX2
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) {
+        sets[count++] = &s_avx2;
+    }
+#endif
+#ifdef RENDERKERNELS_NEON
+    sets[count++] = &s_neon;
+#endif
+    return count;
+}
+
+const KernelSet &activeKernels()
+{
+    static const KernelSet &kernels = selectKernels();
+    return kernels;
+}
+
+} // namespace RenderKernels
@@ -0,0 +1,122 @@
+#ifndef RENDERKERNELS_H
+#define RENDERKERNELS_H
+
+#include <cstdint>
+
+// ============================================================
+// BLOCK RENDER KERNELS
+// ============================================================
+// Stateless per-block stages used by the dynamic render path:
+//   oscillate -> gate -> noise mix -> voice pool -> gain -> ambient mix
+//   -> clamp, then convert or interleave, with level metering
+// The main tone's oscillation and gate are sequential (phase and
+// envelope state) and stay in the engine; the voice pool instead runs
+// VOICE_LANES oscillators side by side, one per vector lane. The stages
+// below have a
+// scalar reference plus SSE2/AVX2/NEON variants picked once at startup.
+// Vector variants use the same operation order as the scalar code and
+// renderkernels.cpp is built with -ffp-contract=off, so every variant
+// produces bit-identical output.
+
+namespace RenderKernels {
+
+constexpr int BLOCK_FRAMES = 1024;
+
+// Voices are processed in groups of this many, one per vector lane
+constexpr int VOICE_LANES = 8;
+
+// Oscillator bank in struct-of-arrays form. Every array holds laneCount
+// entries and is 32-byte aligned; the first four are advanced in place.
+// Shapes are evaluated in float: sine by a folded 9th-order polynomial
+// (error below 4e-6), the others as in Wavetable. Each lane outputs
+//   (gain + gainStep * i) * envelope * shape(phase)
+// where shape mixes the four waveforms by their (normally one-hot)
+// weights and envelope follows the isochronic gate: rising by
+// attackStep while pulsePhase < 0.5, falling by releaseStep otherwise
+// (a lane with pulseInc 0 and pulsePhase 0 stays fully open).
+struct VoiceLanes {
+    float *phaseLeft;            // Cycles [0, 1)
+    float *phaseRight;
+    float *pulsePhase;
+    float *envelope;             // [0, 1]
+    const float *incLeft;        // Cycles per sample, ramping by *Step per sample
+    const float *incLeftStep;
+    const float *incRight;
+    const float *incRightStep;
+    const float *pulseInc;
+    const float *gain;
+    const float *gainStep;
+    const float *sineMix;
+    const float *squareMix;
+    const float *triangleMix;
+    const float *sawtoothMix;
+    float attackStep;
+    float releaseStep;
+};
+
+// Partial sums a block's sum of squares is accumulated in, so vector
+// variants keep independent accumulators and still add in scalar order
+constexpr int LEVEL_PARTIALS = 2 * VOICE_LANES;
+
+// Peak magnitude and sum of squares of one block, per channel, taken
+// before the output clamp
+struct LevelSums {
+    float peakLeft;
+    float peakRight;
+    float sumSquaresLeft;
+    float sumSquaresRight;
+};
+
+struct KernelSet {
+    const char *name;
+
+    // buffer[i] *= gate[i]
+    void (*applyGate)(float *buffer, const float *gate, int count);
+
+    // mix = level + levelStep * i; buffer[i] = buffer[i] * (1 - mix) + noise[i] * mix
+    void (*mixNoise)(float *buffer, const float *noise, float level, float levelStep, int count);
+
+    // buffer[i] *= gain + gainStep * i (gainStep = 0 for a constant gain)
+    void (*applyGain)(float *buffer, float gain, float gainStep, int count);
+
+    // buffer[i] += source[i] * (gain + gainStep * i)
+    void (*mixAdd)(float *buffer, const float *source, float gain, float gainStep, int count);
+
+    // The output stages also meter their input into levels (skipped if
+    // null), riding on the store-bound loop: peak = sqrt(max x^2), and
+    // frame i's x^2 goes into partial i % LEVEL_PARTIALS, reduced
+    // pairwise at the end
+
+    // Clamp to [-1, 1], scale by 32767, truncate and interleave L/R
+    void (*convertToInt16)(const float *left, const float *right, int16_t *out, int count, LevelSums *levels);
+
+    // mixNoise (skipped if noise is null) and applyGain on both
+    // channels, then convertToInt16, for a block with nothing mixed in
+    // between. The mixed block is also left in left/right. The scalar
+    // variant runs the stages frame by frame in one pass.
+    void (*mixGainToInt16)(float *left, float *right, const float *noise, float level, float levelStep,
+                           float gain, float gainStep, int16_t *out, int count, LevelSums *levels);
+
+    // Clamp to [-1, 1] and interleave L/R, for Float32 output
+    void (*interleaveFloat)(const float *left, const float *right, float *out, int count, LevelSums *levels);
+
+    // left[i] / right[i] = sum of all lanes' outputs for frame i (laneCount
+    // a multiple of VOICE_LANES); per frame the lanes are first summed
+    // group by group into VOICE_LANES partial sums, then reduced pairwise
+    void (*renderVoices)(const VoiceLanes &lanes, int laneCount, float *left, float *right, int count);
+};
+
+const KernelSet &scalarKernels();
+
+// Every set this build and CPU can run, the scalar reference first;
+// returns how many were written to sets
+constexpr int MAX_KERNEL_SETS = 4;
+int availableKernels(const KernelSet *sets[MAX_KERNEL_SETS]);
+
+// Best set for this CPU, chosen on first use. Setting the environment
+// variable BINAURAL_KERNELS=scalar forces the reference kernels.
+const KernelSet &activeKernels();
+
+} // namespace RenderKernels
+
+#endif // RENDERKERNELS_H
@@ -0,0 +1,290 @@
+#include "renderkernels.h"
+
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <initializer_list>
+
+// ============================================================
+// RENDER KERNEL CHECK
+// ============================================================
+// Runs every kernel of every KernelSet this CPU supports on the same
+// inputs as the scalar reference and compares the results byte for
+// byte, including the level sums and the voice state advanced in
+// place. The scalar set's one-pass mixGainToInt16 is compared against
+// its own separate stages. Counts cover whole vectors, partial tails and single frames;
+// samples go beyond [-1, 1] so the output clamp is exercised. Prints
+// each mismatch and exits non-zero if any set differs, so it runs as a
+// ctest:
+//
+//   renderkernels_check
+
+namespace {
+
+using RenderKernels::BLOCK_FRAMES;
+using RenderKernels::KernelSet;
+using RenderKernels::LevelSums;
+using RenderKernels::VoiceLanes;
+
+constexpr int COUNTS[] = { 1, 3, 4, 7, 8, 15, 16, 17, 31, 33, 63, 64, 65, 255, 1000, BLOCK_FRAMES };
+constexpr int LANE_COUNTS[] = { RenderKernels::VOICE_LANES, 3 * RenderKernels::VOICE_LANES, 128 };
+constexpr int MAX_LANES = 128;
+
+// Deterministic, so a failure reproduces
+class Random
+{
+public:
+    float next(float low, float high)
+    {
+        m_state = m_state * 6364136223846793005ull + 1442695040888963407ull;
+        const float unit = static_cast<float>(m_state >> 40) / static_cast<float>(1ull << 24);
+        return low + (high - low) * unit;
+    }
+
+private:
+    std::uint64_t m_state = 0x853c49e6748fea9bull;
+};
+
+struct Block {
+    alignas(32) float left[BLOCK_FRAMES];
+    alignas(32) float right[BLOCK_FRAMES];
+    alignas(32) float gate[BLOCK_FRAMES];
+    alignas(32) float noise[BLOCK_FRAMES];
+    float gain;
+    float gainStep;
+};
+
+void fill(float *buffer, int count, float low, float high, Random &random)
+{
+    for (int i = 0; i < count; ++i) {
+        buffer[i] = random.next(low, high);
+    }
+}
+
+Block makeBlock(int count, Random &random)
+{
+    Block block = {};
+    fill(block.left, count, -1.5f, 1.5f, random);
+    fill(block.right, count, -1.5f, 1.5f, random);
+    fill(block.gate, count, 0.0f, 1.0f, random);
+    fill(block.noise, count, -1.0f, 1.0f, random);
+    block.gain = random.next(0.0f, 1.0f);
+    block.gainStep = random.next(-1.0f, 1.0f) / count;
+    return block;
+}
+
+bool same(const void *a, const void *b, std::size_t bytes, const KernelSet &set, const char *kernel, int count)
+{
+    if (std::memcmp(a, b, bytes) == 0) {
+        return true;
+    }
+    std::printf("MISMATCH %s %s count %d\n", set.name, kernel, count);
+    return false;
+}
+
+// The block stages, each on a fresh copy of the same input
+bool checkBlockKernels(const KernelSet &set, const KernelSet &scalar, Random &random)
+{
+    bool ok = true;
+    for (int count : COUNTS) {
+        const Block input = makeBlock(count, random);
+
+        Block expected = input;
+        Block actual = input;
+        scalar.applyGate(expected.left, expected.gate, count);
+        set.applyGate(actual.left, actual.gate, count);
+        ok &= same(expected.left, actual.left, sizeof(expected.left), set, "applyGate", count);
+
+        expected = input;
+        actual = input;
+        scalar.mixNoise(expected.left, expected.noise, expected.gain, expected.gainStep, count);
+        set.mixNoise(actual.left, actual.noise, actual.gain, actual.gainStep, count);
+        ok &= same(expected.left, actual.left, sizeof(expected.left), set, "mixNoise", count);
+
+        expected = input;
+        actual = input;
+        scalar.applyGain(expected.left, expected.gain, expected.gainStep, count);
+        set.applyGain(actual.left, actual.gain, actual.gainStep, count);
+        ok &= same(expected.left, actual.left, sizeof(expected.left), set, "applyGain", count);
+
+        expected = input;
+        actual = input;
+        scalar.mixAdd(expected.left, expected.right, expected.gain, expected.gainStep, count);
+        set.mixAdd(actual.left, actual.right, actual.gain, actual.gainStep, count);
+        ok &= same(expected.left, actual.left, sizeof(expected.left), set, "mixAdd", count);
+
+        for (const bool metered : { false, true }) {
+            alignas(32) int16_t expectedInt16[2 * BLOCK_FRAMES] = {};
+            alignas(32) int16_t actualInt16[2 * BLOCK_FRAMES] = {};
+            LevelSums expectedLevels = {};
+            LevelSums actualLevels = {};
+            scalar.convertToInt16(input.left, input.right, expectedInt16, count,
+                                  metered ? &expectedLevels : nullptr);
+            set.convertToInt16(input.left, input.right, actualInt16, count, metered ? &actualLevels : nullptr);
+            ok &= same(expectedInt16, actualInt16, sizeof(expectedInt16), set, "convertToInt16", count);
+            ok &= same(&expectedLevels, &actualLevels, sizeof(LevelSums), set, "convertToInt16 levels", count);
+
+            alignas(32) float expectedFloat[2 * BLOCK_FRAMES] = {};
+            alignas(32) float actualFloat[2 * BLOCK_FRAMES] = {};
+            expectedLevels = {};
+            actualLevels = {};
+            scalar.interleaveFloat(input.left, input.right, expectedFloat, count,
+                                   metered ? &expectedLevels : nullptr);
+            set.interleaveFloat(input.left, input.right, actualFloat, count, metered ? &actualLevels : nullptr);
+            ok &= same(expectedFloat, actualFloat, sizeof(expectedFloat), set, "interleaveFloat", count);
+            ok &= same(&expectedLevels, &actualLevels, sizeof(LevelSums), set, "interleaveFloat levels", count);
+        }
+    }
+    return ok;
+}
+
+// The combined noise/gain/convert stage against the scalar stages run
+// one after another; checked for the scalar set too, whose one-pass
+// loop must match its own separate passes
+bool checkMixGainToInt16(const KernelSet &set, const KernelSet &scalar, Random &random)
+{
+    bool ok = true;
+    for (int count : COUNTS) {
+        const Block input = makeBlock(count, random);
+        const float level = random.next(0.0f, 1.0f);
+        const float rampedLevelStep = random.next(-1.0f, 1.0f) / count;
+
+        for (const int variant : { 0, 1, 2, 3, 4, 5, 6, 7 }) {
+            const bool withNoise = variant & 1;
+            const bool metered = variant & 2;
+            const bool ramped = variant & 4;
+            const float levelStep = ramped ? rampedLevelStep : 0.0f;
+            Block expected = input;
+            Block actual = input;
+            if (!ramped) {
+                expected.gainStep = 0.0f;
+                actual.gainStep = 0.0f;
+            }
+            alignas(32) int16_t expectedInt16[2 * BLOCK_FRAMES] = {};
+            alignas(32) int16_t actualInt16[2 * BLOCK_FRAMES] = {};
+            LevelSums expectedLevels = {};
+            LevelSums actualLevels = {};
+
+            if (withNoise) {
+                scalar.mixNoise(expected.left, expected.noise, level, levelStep, count);
+                scalar.mixNoise(expected.right, expected.noise, level, levelStep, count);
+            }
+            scalar.applyGain(expected.left, expected.gain, expected.gainStep, count);
+            scalar.applyGain(expected.right, expected.gain, expected.gainStep, count);
+            scalar.convertToInt16(expected.left, expected.right, expectedInt16, count,
+                                  metered ? &expectedLevels : nullptr);
+
+            set.mixGainToInt16(actual.left, actual.right, withNoise ? actual.noise : nullptr, level,
+                               levelStep, actual.gain, actual.gainStep, actualInt16, count,
+                               metered ? &actualLevels : nullptr);
+
+            ok &= same(expectedInt16, actualInt16, sizeof(expectedInt16), set, "mixGainToInt16", count);
+            ok &= same(&expectedLevels, &actualLevels, sizeof(LevelSums), set, "mixGainToInt16 levels", count);
+            ok &= same(expected.left, actual.left, sizeof(expected.left), set, "mixGainToInt16 left", count);
+            ok &= same(expected.right, actual.right, sizeof(expected.right), set, "mixGainToInt16 right", count);
+        }
+    }
+    return ok;
+}
+
+// Voice pool state, one array per VoiceLanes field
+struct Voices {
+    alignas(32) float phaseLeft[MAX_LANES];
+    alignas(32) float phaseRight[MAX_LANES];
+    alignas(32) float pulsePhase[MAX_LANES];
+    alignas(32) float envelope[MAX_LANES];
+    alignas(32) float incLeft[MAX_LANES];
+    alignas(32) float incLeftStep[MAX_LANES];
+    alignas(32) float incRight[MAX_LANES];
+    alignas(32) float incRightStep[MAX_LANES];
+    alignas(32) float pulseInc[MAX_LANES];
+    alignas(32) float gain[MAX_LANES];
+    alignas(32) float gainStep[MAX_LANES];
+    alignas(32) float sineMix[MAX_LANES];
+    alignas(32) float squareMix[MAX_LANES];
+    alignas(32) float triangleMix[MAX_LANES];
+    alignas(32) float sawtoothMix[MAX_LANES];
+
+    VoiceLanes lanes()
+    {
+        return { phaseLeft, phaseRight, pulsePhase, envelope, incLeft, incLeftStep, incRight, incRightStep,
+                 pulseInc, gain, gainStep, sineMix, squareMix, triangleMix, sawtoothMix,
+                 1.0f / 441.0f, 1.0f / 441.0f };
+    }
+};
+
+// Every lane gets one waveform; a third are isochronic
+Voices makeVoices(Random &random)
+{
+    Voices voices = {};
+    for (int i = 0; i < MAX_LANES; ++i) {
+        voices.phaseLeft[i] = random.next(0.0f, 1.0f);
+        voices.phaseRight[i] = random.next(0.0f, 1.0f);
+        voices.incLeft[i] = random.next(20.0f, 2000.0f) / 44100.0f;
+        voices.incRight[i] = random.next(20.0f, 2000.0f) / 44100.0f;
+        voices.incLeftStep[i] = random.next(-1.0f, 1.0f) * 1.0e-7f;
+        voices.incRightStep[i] = random.next(-1.0f, 1.0f) * 1.0e-7f;
+        voices.gain[i] = random.next(0.0f, 0.5f);
+        voices.gainStep[i] = random.next(-1.0f, 1.0f) * 1.0e-4f;
+        if (i % 3 == 0) {
+            voices.pulsePhase[i] = random.next(0.0f, 1.0f);
+            voices.pulseInc[i] = random.next(1.0f, 40.0f) / 44100.0f;
+            voices.envelope[i] = random.next(0.0f, 1.0f);
+        } else {
+            voices.envelope[i] = 1.0f;
+        }
+        float *mixes[] = { voices.sineMix, voices.squareMix, voices.triangleMix, voices.sawtoothMix };
+        mixes[i % 4][i] = 1.0f;
+    }
+    return voices;
+}
+
+bool checkVoices(const KernelSet &set, const KernelSet &scalar, Random &random)
+{
+    bool ok = true;
+    for (int laneCount : LANE_COUNTS) {
+        for (int count : COUNTS) {
+            const Voices input = makeVoices(random);
+            Voices expected = input;
+            Voices actual = input;
+            alignas(32) float expectedLeft[BLOCK_FRAMES] = {};
+            alignas(32) float expectedRight[BLOCK_FRAMES] = {};
+            alignas(32) float actualLeft[BLOCK_FRAMES] = {};
+            alignas(32) float actualRight[BLOCK_FRAMES] = {};
+
+            scalar.renderVoices(expected.lanes(), laneCount, expectedLeft, expectedRight, count);
+            set.renderVoices(actual.lanes(), laneCount, actualLeft, actualRight, count);
+            ok &= same(expectedLeft, actualLeft, sizeof(expectedLeft), set, "renderVoices left", count);
+            ok &= same(expectedRight, actualRight, sizeof(expectedRight), set, "renderVoices right", count);
+            ok &= same(&expected, &actual, sizeof(Voices), set, "renderVoices state", count);
+        }
+    }
+    return ok;
+}
+
+} // namespace
+
+int main()
+{
+    const KernelSet *sets[RenderKernels::MAX_KERNEL_SETS];
+    const int count = RenderKernels::availableKernels(sets);
+    const KernelSet &scalar = RenderKernels::scalarKernels();
+
+    bool ok = true;
+    for (int i = 0; i < count; ++i) {
+        Random random;
+        if (sets[i] == &scalar) {
+            const bool scalarOk = checkMixGainToInt16(scalar, scalar, random);
+            std::printf("scalar: %s\n", scalarOk ? "one-pass stage identical to separate stages"
+                                                  : "one-pass stage differs from separate stages");
+            ok &= scalarOk;
+            continue;
+        }
+        bool setOk = checkBlockKernels(*sets[i], scalar, random);
+        setOk &= checkMixGainToInt16(*sets[i], scalar, random);
+        setOk &= checkVoices(*sets[i], scalar, random);
+        std::printf("%s: %s\n", sets[i]->name, setOk ? "identical to scalar" : "differs from scalar");
+        ok &= setOk;
+    }
+    return ok ? 0 : 1;
+}
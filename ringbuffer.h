@@ -0,0 +1,91 @@
+#ifndef RINGBUFFER_H
+#define RINGBUFFER_H
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstring>
+#include <vector>
+
+// ============================================================
+// RING BUFFER
+// ============================================================
+// Lock-free single-producer / single-consumer FIFO of trivially
+// copyable values. The producer calls write(), the consumer read();
+// neither ever blocks, and each transfers as much as fits or is
+// available. Capacity is rounded up to a power of two. The fill level
+// can be read from any thread (it is exact only on the two ends).
+
+template<typename T>
+class RingBuffer
+{
+public:
+    explicit RingBuffer(std::size_t minimumCapacity)
+    {
+        std::size_t capacity = 1;
+        while (capacity < minimumCapacity) {
+            capacity <<= 1;
+        }
+        m_buffer.resize(capacity);
+        m_mask = capacity - 1;
+    }
+
+    RingBuffer(const RingBuffer &) = delete;
+    RingBuffer &operator=(const RingBuffer &) = delete;
+
+    std::size_t capacity() const { return m_mask + 1; }
+
+    // The read position is loaded first: both only grow and write never
+    // passes read + capacity, so a third thread sees 0..capacity, not a
+    // wrapped difference
+    std::size_t readAvailable() const
+    {
+        const std::size_t read = m_readPos.load(std::memory_order_acquire);
+        const std::size_t write = m_writePos.load(std::memory_order_acquire);
+        return std::min(write - read, capacity());
+    }
+
+    // Producer side
+    std::size_t writeAvailable() const { return capacity() - readAvailable(); }
+
+    std::size_t write(const T *data, std::size_t count)
+    {
+        const std::size_t write = m_writePos.load(std::memory_order_relaxed);
+        const std::size_t read = m_readPos.load(std::memory_order_acquire);
+        count = std::min(count, capacity() - (write - read));
+
+        const std::size_t start = write & m_mask;
+        const std::size_t first = std::min(count, capacity() - start);
+        memcpy(m_buffer.data() + start, data, first * sizeof(T));
+        memcpy(m_buffer.data(), data + first, (count - first) * sizeof(T));
+
+        m_writePos.store(write + count, std::memory_order_release);
+        return count;
+    }
+
+    // Consumer side
+    std::size_t read(T *data, std::size_t count)
+    {
+        const std::size_t read = m_readPos.load(std::memory_order_relaxed);
+        const std::size_t write = m_writePos.load(std::memory_order_acquire);
+        count = std::min(count, write - read);
+
+        const std::size_t start = read & m_mask;
+        const std::size_t first = std::min(count, capacity() - start);
+        memcpy(data, m_buffer.data() + start, first * sizeof(T));
+        memcpy(data + first, m_buffer.data(), (count - first) * sizeof(T));
+
+        m_readPos.store(read + count, std::memory_order_release);
+        return count;
+    }
+
+private:
+    std::vector<T> m_buffer;
+    std::size_t m_mask = 0;
+
+    // Separate cache lines so the two ends do not false-share
+    alignas(64) std::atomic<std::size_t> m_writePos {0};
+    alignas(64) std::atomic<std::size_t> m_readPos {0};
+};
+
+#endif // RINGBUFFER_H
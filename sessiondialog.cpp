@@ -12,6 +12,8 @@
 #include <QtMath>
 #include"constants.h"
 #include<QFileInfo>
+#include <QThread>
+#include "sessionrenderer.h"
 
 SessionDialog::SessionDialog(QWidget *parent)
     : QDialog(parent)
@@ -23,6 +25,7 @@ SessionDialog::SessionDialog(QWidget *parent)
     , m_loadButton(nullptr)
     , m_saveButton(nullptr)
     , m_clearButton(nullptr)
+    , m_renderButton(nullptr)
     , m_playButton(nullptr)
     , m_pauseButton(nullptr)
     , m_stopButton(nullptr)
@@ -158,6 +161,7 @@ void SessionDialog::setupUI()
     m_loadButton = new QPushButton("&Load Session...", this);
     m_saveButton = new QPushButton("&Save Session...", this);
     m_clearButton = new QPushButton("C&lear All", this);
+    m_renderButton = new QPushButton("&Render to WAV...", this);
     m_playButton = new QPushButton("▶ &Play", this);
     m_pauseButton = new QPushButton("⏸ &Pause", this);
     m_stopButton = new QPushButton("■ &Stop", this);
@@ -176,6 +180,7 @@ void SessionDialog::setupUI()
     fileButtonLayout->addWidget(m_loadButton);
     fileButtonLayout->addWidget(m_saveButton);
     fileButtonLayout->addWidget(m_clearButton);
+    fileButtonLayout->addWidget(m_renderButton);
     fileButtonLayout->addStretch();
     mainLayout->addLayout(fileButtonLayout);
 
@@ -201,6 +206,7 @@ void SessionDialog::setupConnections()
     connect(m_loadButton, &QPushButton::clicked, this, &SessionDialog::onLoadClicked);
     connect(m_saveButton, &QPushButton::clicked, this, &SessionDialog::onSaveClicked);
     connect(m_clearButton, &QPushButton::clicked, this, &SessionDialog::onClearClicked);
+    connect(m_renderButton, &QPushButton::clicked, this, &SessionDialog::onRenderClicked);
     connect(m_playButton, &QPushButton::clicked, this, &SessionDialog::onPlayClicked);
     connect(m_pauseButton, &QPushButton::clicked, this, &SessionDialog::onPauseClicked);
     connect(m_stopButton, &QPushButton::clicked, this, &SessionDialog::onStopClicked);
@@ -269,157 +275,13 @@ bool SessionDialog::parseStagesFromText()
 
 Stage SessionDialog::parseLine(const QString &line, bool &ok, QString &error)
 {
-    Stage stage;
-    ok = false;
-    error.clear();
-
-    QStringList parts = line.split(':');
-
-    if (parts.size() != 5 && parts.size() != 6) {
-        error = QString("Need 5 or 6 parts separated by ':' (got %1)").arg(parts.size());
-        return stage;
-    }
-
-    QString typeStr = parts[0].trimmed().toUpper();
-    if (typeStr == "BINAURAL") {
-        stage.toneType = 0;
-    } else if (typeStr == "ISOCHRONIC") {
-        stage.toneType = 1;
-    } else if (typeStr == "GENERATOR") {
-        stage.toneType = 2;
-    } else {
-        error = "Invalid type. Use: BINAURAL, ISOCHRONIC, or GENERATOR";
-        return stage;
-    }
-
-    bool leftFreqOk;
-    stage.leftFreq = parts[1].trimmed().toDouble(&leftFreqOk);
-    if (!leftFreqOk) {
-        error = "Invalid left/carrier frequency";
-        return stage;
-    }
-
-    bool rightFreqOk;
-    double parsedRight = parts[2].trimmed().toDouble(&rightFreqOk);
-    if (!rightFreqOk) {
-        error = "Invalid frequency number";
-        return stage;
-    }
-
-    if (stage.toneType == 1) { // ISOCHRONIC
-        stage.rightFreq = stage.leftFreq; // Right channel = left (carrier)
-        stage.pulseFreq = parsedRight;    // Pulse = parsed "right" field
-    } else {
-        stage.rightFreq = parsedRight;    // Right channel frequency
-        stage.pulseFreq = 7.83;           // Default pulse frequency
-    }
-
-    QString waveStr = parts[3].trimmed().toUpper();
-    if (waveStr == "SINE") {
-        stage.waveform = 0;
-    } else if (waveStr == "SQUARE") {
-        stage.waveform = 1;
-    } else if (waveStr == "TRIANGLE") {
-        stage.waveform = 2;
-    } else if (waveStr == "SAWTOOTH") {
-        stage.waveform = 3;
-    } else {
-        error = "Invalid waveform. Use: SINE, SQUARE, TRIANGLE, SAWTOOTH";
-        return stage;
-    }
-
-    bool timeOk1;
-    stage.durationMinutes = parts[4].trimmed().toInt(&timeOk1);
-    if (!timeOk1) {
-        error = "Invalid duration number";
-        return stage;
-    }
-
-    if (parts.size() == 6) {
-        bool volumeOk;
-        stage.volumePercent = parts[5].trimmed().toDouble(&volumeOk);
-        if (!volumeOk) {
-            error = "Invalid volume number";
-            return stage;
-        }
-        if (stage.volumePercent < 0.0 || stage.volumePercent > 100.0) {
-            error = "Volume must be 0-100%";
-            return stage;
-        }
-    } else {
-        stage.volumePercent = 15.0;
-    }
-
-    ok = true;
-    return stage;
+    return Stage::fromLine(line, ok, error);
 }
 
 bool SessionDialog::validateStage(const Stage &stage, int lineNum, QString &error)
 {
-    if (stage.leftFreq < 20.0 || stage.leftFreq > 20000.0) {
-        error = "Carrier/left frequency must be 20-20000 Hz";
-        return false;
-    }
-
-    if (stage.toneType == 0) { // BINAURAL
-        if (stage.rightFreq < 20.0 || stage.rightFreq > 20000.0) {
-            error = "Right frequency must be 20-20000 Hz";
-            return false;
-        }
-
-
-        if (stage.rightFreq == stage.leftFreq) {
-            error = "BINAURAL requires different values for right and left frequencies";
-            return false;
-        }
-
-
-    } else if (stage.toneType == 1) { // ISOCHRONIC
-        if (qAbs(stage.rightFreq - stage.leftFreq) != 0) {
-            error = "ISOCHRONIC carrier mismatch (right should equal left)";
-            return false;
-        }
-        if (stage.pulseFreq < 0.1 || stage.pulseFreq > 100.0) {
-            error = "ISOCHRONIC pulse must be 0.1-100 Hz";
-            return false;
-        }
-
-    } else if (stage.toneType == 2) { // GENERATOR
-
-        /*
-        if (qAbs(stage.rightFreq - stage.leftFreq) > 0.1) {
-            error = "GENERATOR requires left = right frequency";
-            return false;
-        }
-        */
-        if (stage.rightFreq < 20.0 || stage.rightFreq > 20000.0) {
-            error = "Right frequency must be 20-20000 Hz";
-            return false;
-        }
-        if (stage.leftFreq < 20.0 || stage.leftFreq > 20000.0) {
-            error = "Left frequency must be 20-20000 Hz";
-            return false;
-        }
-
-    }
-
-    if (stage.durationMinutes < 1) {
-        error = "Duration must be at least 1 minute";
-        return false;
-    }
-
-    int maxMinutes = m_unlimitedDuration ? 360 : 45;
-    if (stage.durationMinutes > maxMinutes) {
-        error = QString("Duration exceeds maximum (%1 min)").arg(maxMinutes);
-        return false;
-    }
-
-    if (stage.volumePercent < 0.0 || stage.volumePercent > 100.0) {
-        error = "Volume must be 0-100%";
-        return false;
-    }
-
-    return true;
+    Q_UNUSED(lineNum);
+    return stage.validate(m_unlimitedDuration ? 360 : 45, error);
 }
 
 
@@ -498,6 +360,55 @@ void SessionDialog::onSaveClicked()
     m_statusLabel->setText(QString("✓ Session saved to: %1").arg(QFileInfo(fileName).fileName()));
 }
 
+void SessionDialog::onRenderClicked()
+{
+    if (!parseStagesFromText()) {
+        return;
+    }
+
+    QString fileName = QFileDialog::getSaveFileName(
+        this,
+        "Render Session",
+        ConstantGlobals::sessionsFilePath + "/Session.wav",
+        "WAV Audio (*.wav)"
+    );
+
+    if (fileName.isEmpty()) return;
+
+    if (!fileName.endsWith(".wav", Qt::CaseInsensitive)) {
+        fileName += ".wav";
+    }
+
+    // Render on a worker thread; the renderer's signals arrive queued
+    SessionRenderer *renderer = new SessionRenderer();
+    connect(renderer, &SessionRenderer::progressChanged, this, [this](double fraction) {
+        m_statusLabel->setText(QString("Rendering... %1%").arg(qRound(fraction * 100)));
+    });
+    connect(renderer, &SessionRenderer::errorOccurred, this, [this](const QString &error) {
+        QMessageBox::warning(this, "Render Error", error);
+    });
+
+    const QVector<Stage> stages = m_stages;
+    QThread *thread = QThread::create([renderer, stages, fileName]() {
+        renderer->render(stages, fileName);
+    });
+    connect(thread, &QThread::finished, this, [this, renderer, thread]() {
+        const SessionRenderer::Report report = renderer->report();
+        m_rendering = false;
+        updateUIFromState();
+        if (report.frames > 0) {
+            m_statusLabel->setText("✓ " + report.summary());
+        }
+        renderer->deleteLater();
+        thread->deleteLater();
+    });
+
+    m_rendering = true;
+    updateUIFromState();
+    m_statusLabel->setText("Rendering...");
+    thread->start();
+}
+
 void SessionDialog::onClearClicked()
 {
     if (m_sessionActive) {
@@ -698,6 +609,7 @@ void SessionDialog::updateUIFromState()
     m_loadButton->setEnabled(!m_sessionActive);
     m_saveButton->setEnabled(!m_sessionActive);
     m_clearButton->setEnabled(true); // Always enabled
+    m_renderButton->setEnabled(!m_sessionActive && !m_rendering);
 
     m_playButton->setEnabled(hasStages && !m_sessionActive);
     m_pauseButton->setEnabled(m_sessionActive);
@@ -8,23 +8,11 @@
 #include <QTimer>
 #include <QVector>
 #include <QString>
+#include "sessionstage.h"
 
 class QVBoxLayout;
 class QHBoxLayout;
 
-struct Stage {
-    int toneType;          // 0=BINAURAL, 1=ISOCHRONIC, 2=GENERATOR
-    double leftFreq;
-    double rightFreq;
-    int waveform;          // 0=SINE, 1=SQUARE, 2=TRIANGLE, 3=SAWTOOTH
-    int durationMinutes;
-    double pulseFreq;
-    double volumePercent;
-    int durationSeconds() const { return durationMinutes * 60; }
-    double beatFreq() const { return rightFreq - leftFreq; }
-    bool isIsochronic() const { return toneType == 1; }
-};
-
 class SessionDialog : public QDialog
 {
     Q_OBJECT
@@ -64,6 +52,7 @@ private slots:
 public slots:
     void onLoadClicked();
     void onSaveClicked();
+    void onRenderClicked();
 private:
     QTextEdit *m_textEdit;
     QLabel *m_statusLabel;
@@ -73,6 +62,7 @@ private:
     QPushButton *m_loadButton;
     QPushButton *m_saveButton;
     QPushButton *m_clearButton;
+    QPushButton *m_renderButton;
     QPushButton *m_playButton;
     QPushButton *m_pauseButton;
     QPushButton *m_stopButton;
@@ -85,6 +75,7 @@ private:
     bool m_sessionActive;
     bool m_paused;
     bool m_unlimitedDuration;  // Added
+    bool m_rendering = false;
 
     QTimer *m_stageTimer;
 
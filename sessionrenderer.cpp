@@ -0,0 +1,313 @@
+#include "sessionrenderer.h"
+#include "renderkernels.h"
+
+#include <QElapsedTimer>
+#include <QFile>
+#include <QFileInfo>
+#include <QThread>
+#include <QtEndian>
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <memory>
+#include <thread>
+#include <vector>
+
+// Canonical 44-byte PCM WAV header for 16-bit stereo
+static QByteArray wavHeader(int sampleRate, quint32 dataBytes)
+{
+    QByteArray header(44, '\0');
+    char *h = header.data();
+
+    auto put16 = [h](int offset, quint16 value) { qToLittleEndian(value, h + offset); };
+    auto put32 = [h](int offset, quint32 value) { qToLittleEndian(value, h + offset); };
+
+    memcpy(h, "RIFF", 4);
+    put32(4, 36 + dataBytes);
+    memcpy(h + 8, "WAVE", 4);
+    memcpy(h + 12, "fmt ", 4);
+    put32(16, 16);                  // fmt chunk size
+    put16(20, 1);                   // PCM
+    put16(22, 2);                   // Channels
+    put32(24, sampleRate);
+    put32(28, sampleRate * 2 * 2);  // Byte rate
+    put16(32, 2 * 2);               // Block align
+    put16(34, 16);                  // Bits per sample
+    memcpy(h + 36, "data", 4);
+    put32(40, dataBytes);
+    return header;
+}
+
+// Fractional part in [0, 1)
+static double wrapCycles(double cycles)
+{
+    return cycles - std::floor(cycles);
+}
+
+// ============================================================
+// REPORT
+// ============================================================
+
+double SessionRenderer::Report::audioSeconds() const
+{
+    return sampleRate > 0 ? static_cast<double>(frames) / sampleRate : 0.0;
+}
+
+double SessionRenderer::Report::realtimeFactor() const
+{
+    return seconds > 0.0 ? audioSeconds() / seconds : 0.0;
+}
+
+QString SessionRenderer::Report::summary() const
+{
+    return QString("%1-minute session rendered in %2 s at %3× realtime (%4 threads)")
+            .arg(audioSeconds() / 60.0, 0, 'f', 1)
+            .arg(seconds, 0, 'f', 2)
+            .arg(realtimeFactor(), 0, 'f', 0)
+            .arg(threads);
+}
+
+// ============================================================
+// RENDERER
+// ============================================================
+
+SessionRenderer::SessionRenderer(QObject *parent)
+    : QObject(parent)
+{
+}
+
+void SessionRenderer::setSampleRate(int sampleRate)
+{
+    if (sampleRate < 8000 || sampleRate > 192000) {
+        emit errorOccurred(QString("Invalid sample rate: %1").arg(sampleRate));
+        return;
+    }
+    m_sampleRate = sampleRate;
+}
+
+int SessionRenderer::sampleRate() const
+{
+    return m_sampleRate;
+}
+
+void SessionRenderer::setThreadCount(int threads)
+{
+    m_threadCount = std::max(0, threads);
+}
+
+int SessionRenderer::threadCount() const
+{
+    return m_threadCount > 0 ? m_threadCount : std::max(1, QThread::idealThreadCount());
+}
+
+void SessionRenderer::setCollectBlockTimings(bool collect)
+{
+    m_collectBlockTimings = collect;
+}
+
+SessionRenderer::Report SessionRenderer::report() const
+{
+    return m_report;
+}
+
+DynamicRenderer::Parameters SessionRenderer::stageParameters(const Stage &stage, int sampleRate)
+{
+    DynamicRenderer::Parameters params;
+    params.toneType = stage.toneType;
+    params.waveform = static_cast<DynamicRenderer::Waveform>(stage.waveform);
+    params.leftFrequency = stage.leftFreq;
+    params.rightFrequency = stage.rightFreq;
+    if (stage.isIsochronic()) {
+        params.pulseFrequency = stage.pulseFreq;
+    }
+    params.sampleRate = sampleRate;
+    return params;
+}
+
+QVector<SessionRenderer::Segment> SessionRenderer::planSegments(const QVector<Stage> &stages) const
+{
+    QVector<Segment> segments;
+    const qint64 segmentFrames = static_cast<qint64>(SEGMENT_SECONDS) * m_sampleRate;
+    const qint64 prerollFrames = static_cast<qint64>(PREROLL_MS) * m_sampleRate / 1000;
+
+    // Phase carried across stages, in cycles
+    double stagePhaseLeft = 0.0;
+    double stagePhaseRight = 0.0;
+
+    for (int s = 0; s < stages.size(); ++s) {
+        const Stage &stage = stages[s];
+        const qint64 stageFrames = static_cast<qint64>(stage.durationSeconds()) * m_sampleRate;
+        const qint64 fadeFrames = std::min(static_cast<qint64>(SESSION_FADE_SECONDS) * m_sampleRate,
+                                           stageFrames / 2);
+        const double volume = stage.volumePercent / 100.0;
+
+        // Right phase slot carries the pulse for isochronic stages
+        const double leftHz = stage.leftFreq;
+        const double rightHz = stage.isIsochronic() ? stage.pulseFreq : stage.rightFreq;
+
+        auto volumeAt = [&](qint64 frame) {
+            if (frame < fadeFrames) {
+                return volume * frame / fadeFrames;
+            }
+            if (frame > stageFrames - fadeFrames) {
+                return volume * (stageFrames - frame) / fadeFrames;
+            }
+            return volume;
+        };
+
+        // Fade in, hold, fade out; each cut into segments
+        const qint64 breakpoints[] = { 0, fadeFrames, stageFrames - fadeFrames, stageFrames };
+        for (int region = 0; region < 3; ++region) {
+            for (qint64 start = breakpoints[region]; start < breakpoints[region + 1]; start += segmentFrames) {
+                const qint64 end = std::min(start + segmentFrames, breakpoints[region + 1]);
+
+                Segment segment;
+                segment.stage = s;
+                segment.frames = end - start;
+                segment.prerollFrames = (stage.isIsochronic() && start >= prerollFrames) ? prerollFrames : 0;
+
+                const double origin = static_cast<double>(start - segment.prerollFrames) / m_sampleRate;
+                segment.phaseLeft = wrapCycles(stagePhaseLeft + leftHz * origin);
+                segment.phaseRight = wrapCycles(stagePhaseRight + rightHz * origin);
+                segment.startVolume = volumeAt(start);
+                segment.endVolume = volumeAt(end);
+                segments.append(segment);
+            }
+        }
+
+        const double stageSeconds = static_cast<double>(stageFrames) / m_sampleRate;
+        stagePhaseLeft = wrapCycles(stagePhaseLeft + leftHz * stageSeconds);
+        stagePhaseRight = wrapCycles(stagePhaseRight + rightHz * stageSeconds);
+    }
+
+    return segments;
+}
+
+void SessionRenderer::renderSegment(const Stage &stage, const Segment &segment, int16_t *out,
+                                    QVector<qint64> *blockNs) const
+{
+    // ~45 KB of oscillator and block state, kept off the thread's stack
+    const auto renderer = std::make_unique<DynamicRenderer>(stageParameters(stage, m_sampleRate),
+                                                            segment.startVolume,
+                                                            segment.phaseLeft, segment.phaseRight);
+
+    if (segment.prerollFrames > 0) {
+        std::vector<int16_t> preroll(2 * segment.prerollFrames);
+        renderer->render(preroll.data(), static_cast<int>(segment.prerollFrames));
+    }
+
+    if (segment.endVolume != segment.startVolume) {
+        DynamicRenderer::GainEnvelope fade;
+        fade.target = segment.endVolume;
+        fade.durationFrames = segment.frames;
+        renderer->startEnvelope(fade);
+    }
+
+    if (!blockNs) {
+        renderer->render(out, static_cast<int>(segment.frames));
+    } else {
+        QElapsedTimer timer;
+        for (qint64 offset = 0; offset < segment.frames; offset += RenderKernels::BLOCK_FRAMES) {
+            const int frames = static_cast<int>(std::min<qint64>(RenderKernels::BLOCK_FRAMES,
+                                                                 segment.frames - offset));
+            timer.start();
+            renderer->render(out + 2 * offset, frames);
+            blockNs->append(timer.nsecsElapsed());
+        }
+    }
+}
+
+bool SessionRenderer::render(const QVector<Stage> &stages, const QString &fileName)
+{
+    m_report = Report();
+
+    if (stages.isEmpty()) {
+        emit errorOccurred("No stages to render");
+        return false;
+    }
+
+    // The writer has no other encoder; don't leave WAV data under another extension
+    if (QFileInfo(fileName).suffix().compare("wav", Qt::CaseInsensitive) != 0) {
+        emit errorOccurred(QString("Sessions render to .wav files only: %1").arg(fileName));
+        return false;
+    }
+
+    const QVector<Segment> segments = planSegments(stages);
+
+    qint64 totalFrames = 0;
+    qint64 maxSegmentFrames = 0;
+    for (const Segment &segment : segments) {
+        totalFrames += segment.frames;
+        maxSegmentFrames = std::max(maxSegmentFrames, segment.frames);
+    }
+
+    const qint64 dataBytes = totalFrames * 2 * sizeof(int16_t);
+    if (dataBytes > 0xFFFFFFFFll - 36) {
+        emit errorOccurred("Session is too long for a WAV file (4 GB limit)");
+        return false;
+    }
+
+    QFile file(fileName);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+        emit errorOccurred(QString("Could not open %1 for writing").arg(fileName));
+        return false;
+    }
+    file.write(wavHeader(m_sampleRate, static_cast<quint32>(dataBytes)));
+
+    QElapsedTimer timer;
+    timer.start();
+
+    const int threads = threadCount();
+    std::vector<std::vector<int16_t>> buffers(threads, std::vector<int16_t>(2 * maxSegmentFrames));
+    std::vector<QVector<qint64>> timings(threads);
+
+    qint64 framesWritten = 0;
+    for (int first = 0; first < segments.size(); first += threads) {
+        const int count = std::min<int>(threads, segments.size() - first);
+
+        std::vector<std::thread> workers;
+        workers.reserve(count);
+        for (int i = 0; i < count; ++i) {
+            const Segment &segment = segments[first + i];
+            int16_t *out = buffers[i].data();
+            QVector<qint64> *blockNs = m_collectBlockTimings ? &timings[i] : nullptr;
+            workers.emplace_back([this, &stages, &segment, out, blockNs]() {
+                renderSegment(stages[segment.stage], segment, out, blockNs);
+            });
+        }
+        for (std::thread &worker : workers) {
+            worker.join();
+        }
+        for (int i = 0; i < count && m_collectBlockTimings; ++i) {
+            m_report.blockNs.append(timings[i]);
+            timings[i].clear();
+        }
+
+        for (int i = 0; i < count; ++i) {
+            const Segment &segment = segments[first + i];
+            int16_t *samples = buffers[i].data();
+            if constexpr (Q_BYTE_ORDER == Q_BIG_ENDIAN) {
+                for (qint64 n = 0; n < 2 * segment.frames; ++n) {
+                    samples[n] = qToLittleEndian(samples[n]);
+                }
+            }
+
+            const qint64 bytes = segment.frames * 2 * sizeof(int16_t);
+            if (file.write(reinterpret_cast<const char *>(samples), bytes) != bytes) {
+                emit errorOccurred(QString("Write error: %1").arg(file.errorString()));
+                return false;
+            }
+            framesWritten += segment.frames;
+        }
+
+        emit progressChanged(static_cast<double>(framesWritten) / totalFrames);
+    }
+
+    file.close();
+
+    m_report.frames = totalFrames;
+    m_report.sampleRate = m_sampleRate;
+    m_report.threads = threads;
+    m_report.seconds = timer.nsecsElapsed() / 1e9;
+    return true;
+}
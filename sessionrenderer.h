@@ -0,0 +1,89 @@
+#ifndef SESSIONRENDERER_H
+#define SESSIONRENDERER_H
+
+#include <QObject>
+#include <QString>
+#include <QVector>
+#include "dynamicrenderer.h"
+#include "sessionstage.h"
+
+// ============================================================
+// SESSION RENDERER
+// ============================================================
+// Renders a parsed session to a 16-bit stereo WAV file faster than
+// realtime, through the DynamicRenderer that DynamicEngine plays live.
+// Each stage fades in over its first and out over its last
+// SESSION_FADE_SECONDS, as SessionDialog does live.
+//
+// The timeline is cut into segments of at most SEGMENT_SECONDS. A
+// segment's starting phases are computed from the stages before it, so
+// segments render independently on all cores and stitch without phase
+// jumps. Only one window of segments (one per thread) is held in memory
+// at a time and written out in order.
+
+class SessionRenderer : public QObject
+{
+    Q_OBJECT
+
+public:
+    struct Report {
+        qint64 frames = 0;
+        int sampleRate = 0;
+        int threads = 0;
+        double seconds = 0.0;
+        QVector<qint64> blockNs; // Per render block, if collected
+
+        double audioSeconds() const;
+        double realtimeFactor() const;
+        QString summary() const;
+    };
+
+    explicit SessionRenderer(QObject *parent = nullptr);
+
+    void setSampleRate(int sampleRate);
+    int sampleRate() const;
+
+    void setThreadCount(int threads); // 0 = one per core
+    int threadCount() const;
+
+    // Time every render block into Report::blockNs
+    void setCollectBlockTimings(bool collect);
+
+    // Blocking; call from a worker thread when used from the GUI
+    bool render(const QVector<Stage> &stages, const QString &fileName);
+
+    Report report() const;
+
+    // Tone type, waveform and frequencies of a stage (not its volume)
+    static DynamicRenderer::Parameters stageParameters(const Stage &stage, int sampleRate);
+
+signals:
+    void progressChanged(double fraction);
+    void errorOccurred(const QString &errorMessage);
+
+private:
+    struct Segment {
+        int stage;
+        qint64 frames;
+        qint64 prerollFrames;  // Rendered and discarded to settle the isochronic gate
+        double phaseLeft;      // Cycles at the start of the preroll
+        double phaseRight;
+        double startVolume;
+        double endVolume;      // Linear fade across the segment
+    };
+
+    QVector<Segment> planSegments(const QVector<Stage> &stages) const;
+    void renderSegment(const Stage &stage, const Segment &segment, int16_t *out,
+                       QVector<qint64> *blockNs) const;
+
+    static constexpr int SEGMENT_SECONDS = 10;
+    static constexpr int SESSION_FADE_SECONDS = 5;
+    static constexpr int PREROLL_MS = 30;
+
+    int m_sampleRate = 44100;
+    int m_threadCount = 0;
+    bool m_collectBlockTimings = false;
+    Report m_report;
+};
+
+#endif // SESSIONRENDERER_H
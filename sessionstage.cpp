@@ -0,0 +1,181 @@
+#include "sessionstage.h"
+
+#include <QtMath>
+
+Stage Stage::fromLine(const QString &line, bool &ok, QString &error)
+{
+    Stage stage;
+    ok = false;
+    error.clear();
+
+    QStringList parts = line.split(':');
+
+    if (parts.size() != 5 && parts.size() != 6) {
+        error = QString("Need 5 or 6 parts separated by ':' (got %1)").arg(parts.size());
+        return stage;
+    }
+
+    QString typeStr = parts[0].trimmed().toUpper();
+    if (typeStr == "BINAURAL") {
+        stage.toneType = 0;
+    } else if (typeStr == "ISOCHRONIC") {
+        stage.toneType = 1;
+    } else if (typeStr == "GENERATOR") {
+        stage.toneType = 2;
+    } else {
+        error = "Invalid type. Use: BINAURAL, ISOCHRONIC, or GENERATOR";
+        return stage;
+    }
+
+    bool leftFreqOk;
+    stage.leftFreq = parts[1].trimmed().toDouble(&leftFreqOk);
+    if (!leftFreqOk) {
+        error = "Invalid left/carrier frequency";
+        return stage;
+    }
+
+    bool rightFreqOk;
+    double parsedRight = parts[2].trimmed().toDouble(&rightFreqOk);
+    if (!rightFreqOk) {
+        error = "Invalid frequency number";
+        return stage;
+    }
+
+    if (stage.toneType == 1) { // ISOCHRONIC
+        stage.rightFreq = stage.leftFreq; // Right channel = left (carrier)
+        stage.pulseFreq = parsedRight;    // Pulse = parsed "right" field
+    } else {
+        stage.rightFreq = parsedRight;    // Right channel frequency
+        stage.pulseFreq = 7.83;           // Default pulse frequency
+    }
+
+    QString waveStr = parts[3].trimmed().toUpper();
+    if (waveStr == "SINE") {
+        stage.waveform = 0;
+    } else if (waveStr == "SQUARE") {
+        stage.waveform = 1;
+    } else if (waveStr == "TRIANGLE") {
+        stage.waveform = 2;
+    } else if (waveStr == "SAWTOOTH") {
+        stage.waveform = 3;
+    } else {
+        error = "Invalid waveform. Use: SINE, SQUARE, TRIANGLE, SAWTOOTH";
+        return stage;
+    }
+
+    bool timeOk1;
+    stage.durationMinutes = parts[4].trimmed().toInt(&timeOk1);
+    if (!timeOk1) {
+        error = "Invalid duration number";
+        return stage;
+    }
+
+    if (parts.size() == 6) {
+        bool volumeOk;
+        stage.volumePercent = parts[5].trimmed().toDouble(&volumeOk);
+        if (!volumeOk) {
+            error = "Invalid volume number";
+            return stage;
+        }
+        if (stage.volumePercent < 0.0 || stage.volumePercent > 100.0) {
+            error = "Volume must be 0-100%";
+            return stage;
+        }
+    } else {
+        stage.volumePercent = 15.0;
+    }
+
+    ok = true;
+    return stage;
+}
+
+bool Stage::validate(int maxMinutes, QString &error) const
+{
+    if (leftFreq < 20.0 || leftFreq > 20000.0) {
+        error = "Carrier/left frequency must be 20-20000 Hz";
+        return false;
+    }
+
+    if (toneType == 0) { // BINAURAL
+        if (rightFreq < 20.0 || rightFreq > 20000.0) {
+            error = "Right frequency must be 20-20000 Hz";
+            return false;
+        }
+
+
+        if (rightFreq == leftFreq) {
+            error = "BINAURAL requires different values for right and left frequencies";
+            return false;
+        }
+
+
+    } else if (toneType == 1) { // ISOCHRONIC
+        if (qAbs(rightFreq - leftFreq) != 0) {
+            error = "ISOCHRONIC carrier mismatch (right should equal left)";
+            return false;
+        }
+        if (pulseFreq < 0.1 || pulseFreq > 100.0) {
+            error = "ISOCHRONIC pulse must be 0.1-100 Hz";
+            return false;
+        }
+
+    } else if (toneType == 2) { // GENERATOR
+
+        /*
+        if (qAbs(rightFreq - leftFreq) > 0.1) {
+            error = "GENERATOR requires left = right frequency";
+            return false;
+        }
+        */
+        if (rightFreq < 20.0 || rightFreq > 20000.0) {
+            error = "Right frequency must be 20-20000 Hz";
+            return false;
+        }
+        if (leftFreq < 20.0 || leftFreq > 20000.0) {
+            error = "Left frequency must be 20-20000 Hz";
+            return false;
+        }
+
+    }
+
+    if (durationMinutes < 1) {
+        error = "Duration must be at least 1 minute";
+        return false;
+    }
+
+    if (durationMinutes > maxMinutes) {
+        error = QString("Duration exceeds maximum (%1 min)").arg(maxMinutes);
+        return false;
+    }
+
+    if (volumePercent < 0.0 || volumePercent > 100.0) {
+        error = "Volume must be 0-100%";
+        return false;
+    }
+
+    return true;
+}
+
+QVector<Stage> Stage::parseSession(const QString &text, int maxMinutes, QStringList *errors)
+{
+    QVector<Stage> stages;
+    const QStringList lines = text.split('\n', Qt::SkipEmptyParts);
+
+    for (int i = 0; i < lines.size(); ++i) {
+        const QString line = lines[i].trimmed();
+        if (line.isEmpty() || line.startsWith('#')) {
+            continue;
+        }
+
+        bool ok;
+        QString error;
+        const Stage stage = fromLine(line, ok, error);
+        if (ok && stage.validate(maxMinutes, error)) {
+            stages.append(stage);
+        } else if (errors) {
+            errors->append(QString("Line %1: %2").arg(i + 1).arg(error));
+        }
+    }
+
+    return stages;
+}
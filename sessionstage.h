@@ -0,0 +1,31 @@
+#ifndef SESSIONSTAGE_H
+#define SESSIONSTAGE_H
+
+#include <QString>
+#include <QStringList>
+#include <QVector>
+
+// One line of a session file:
+//   TYPE:LEFT:RIGHT_OR_PULSE:WAVEFORM:MINUTES[:VOLUME]
+struct Stage {
+    int toneType;          // 0=BINAURAL, 1=ISOCHRONIC, 2=GENERATOR
+    double leftFreq;
+    double rightFreq;
+    int waveform;          // 0=SINE, 1=SQUARE, 2=TRIANGLE, 3=SAWTOOTH
+    int durationMinutes;
+    double pulseFreq;
+    double volumePercent;
+    int durationSeconds() const { return durationMinutes * 60; }
+    double beatFreq() const { return rightFreq - leftFreq; }
+    bool isIsochronic() const { return toneType == 1; }
+
+    static Stage fromLine(const QString &line, bool &ok, QString &error);
+    bool validate(int maxMinutes, QString &error) const;
+
+    // Parses a whole session text; blank and '#' lines are skipped and
+    // invalid lines reported in errors (if given) as "Line N: ..."
+    static QVector<Stage> parseSession(const QString &text, int maxMinutes,
+                                       QStringList *errors = nullptr);
+};
+
+#endif // SESSIONSTAGE_H
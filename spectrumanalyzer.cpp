@@ -0,0 +1,281 @@
+#include "spectrumanalyzer.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace {
+
+constexpr double TWO_PI = 6.283185307179586;
+
+// 4th-order Butterworth as two biquads
+constexpr double BUTTERWORTH_Q[2] = { 0.5411961001461970, 1.3065629648763766 };
+
+// Level of a bin from its squared magnitude; std::abs would go through
+// hypot(), several times slower
+float powerDb(std::complex<float> bin, float scale)
+{
+    const float power = std::norm(bin) * scale * scale;
+    return power > 0.0f ? std::max(static_cast<float>(SpectrumAnalyzer::FLOOR_DB), 10.0f * std::log10(power))
+                        : static_cast<float>(SpectrumAnalyzer::FLOOR_DB);
+}
+
+// Periodic Hann window; returns the sum of its weights
+float makeHann(std::vector<float> &window, int size)
+{
+    window.resize(size);
+    double sum = 0.0;
+    for (int i = 0; i < size; ++i) {
+        window[i] = static_cast<float>(0.5 - 0.5 * std::cos(TWO_PI * i / size));
+        sum += window[i];
+    }
+    return static_cast<float>(sum);
+}
+
+} // namespace
+
+// ============================================================
+// FFT
+// ============================================================
+
+void SpectrumAnalyzer::Fft::setSize(int size)
+{
+    if (size == m_size) {
+        return;
+    }
+    m_size = size;
+
+    int bits = 0;
+    while ((1 << bits) < size) {
+        ++bits;
+    }
+    m_bitReverse.resize(size);
+    for (int i = 0; i < size; ++i) {
+        int reversed = 0;
+        for (int b = 0; b < bits; ++b) {
+            reversed |= ((i >> b) & 1) << (bits - 1 - b);
+        }
+        m_bitReverse[i] = reversed;
+    }
+
+    m_twiddles.resize(size / 2);
+    for (int k = 0; k < size / 2; ++k) {
+        const double angle = -TWO_PI * k / size;
+        m_twiddles[k] = { static_cast<float>(std::cos(angle)), static_cast<float>(std::sin(angle)) };
+    }
+}
+
+void SpectrumAnalyzer::Fft::transform(std::complex<float> *data) const
+{
+    for (int i = 0; i < m_size; ++i) {
+        if (i < m_bitReverse[i]) {
+            std::swap(data[i], data[m_bitReverse[i]]);
+        }
+    }
+
+    // Butterflies on the interleaved floats: std::complex's operator*
+    // checks for NaN on every multiply
+    float *values = reinterpret_cast<float *>(data);
+    const float *twiddles = reinterpret_cast<const float *>(m_twiddles.data());
+    for (int length = 2; length <= m_size; length <<= 1) {
+        const int half = length / 2;
+        const int stride = m_size / length;
+        for (int start = 0; start < m_size; start += length) {
+            float *even = values + 2 * start;
+            float *odd = even + 2 * half;
+            for (int j = 0; j < half; ++j) {
+                const float wRe = twiddles[2 * j * stride];
+                const float wIm = twiddles[2 * j * stride + 1];
+                const float tRe = odd[2 * j] * wRe - odd[2 * j + 1] * wIm;
+                const float tIm = odd[2 * j] * wIm + odd[2 * j + 1] * wRe;
+                const float eRe = even[2 * j];
+                const float eIm = even[2 * j + 1];
+                even[2 * j] = eRe + tRe;
+                even[2 * j + 1] = eIm + tIm;
+                odd[2 * j] = eRe - tRe;
+                odd[2 * j + 1] = eIm - tIm;
+            }
+        }
+    }
+}
+
+// ============================================================
+// BIQUAD
+// ============================================================
+
+void SpectrumAnalyzer::Biquad::setLowPass(double cutoffHz, double sampleRate, double q)
+{
+    const double w0 = TWO_PI * cutoffHz / sampleRate;
+    const double alpha = std::sin(w0) / (2.0 * q);
+    const double cosW0 = std::cos(w0);
+    const double a0 = 1.0 + alpha;
+    b0 = (1.0 - cosW0) / 2.0 / a0;
+    b1 = (1.0 - cosW0) / a0;
+    b2 = b0;
+    a1 = -2.0 * cosW0 / a0;
+    a2 = (1.0 - alpha) / a0;
+    x1 = x2 = y1 = y2 = 0.0;
+}
+
+double SpectrumAnalyzer::Biquad::process(double x)
+{
+    const double y = b0 * x + b1 * x1 + b2 * x2 - a1 * y1 - a2 * y2;
+    x2 = x1;
+    x1 = x;
+    y2 = y1;
+    y1 = y;
+    return y;
+}
+
+// ============================================================
+// ANALYZER
+// ============================================================
+
+SpectrumAnalyzer::SpectrumAnalyzer()
+{
+    configure(48000, 4096);
+}
+
+void SpectrumAnalyzer::configure(int sampleRate, int fftSize)
+{
+    m_sampleRate = sampleRate;
+    m_fftSize = std::clamp(fftSize, MIN_FFT_SIZE, MAX_FFT_SIZE);
+
+    m_historyLeft.assign(m_fftSize, 0.0f);
+    m_historyRight.assign(m_fftSize, 0.0f);
+    m_historyPos = 0;
+    m_fft.setSize(m_fftSize);
+    m_windowGain = makeHann(m_window, m_fftSize) / 2.0f;
+    m_spectrum.resize(m_fftSize);
+
+    m_beatDecimation = std::max(1, static_cast<int>(std::lround(sampleRate / BEAT_RATE_HZ)));
+    m_beatRate = static_cast<double>(sampleRate) / m_beatDecimation;
+    for (int i = 0; i < 2; ++i) {
+        m_beatFilter[i].setLowPass(BEAT_CUTOFF_HZ, sampleRate, BUTTERWORTH_Q[i]);
+    }
+    m_beatPhase = 0;
+    m_beatHistory.assign(BEAT_HISTORY, 0.0f);
+    m_beatPos = 0;
+    m_beatFill = 0;
+    m_beatFft.setSize(BEAT_HISTORY);
+    makeHann(m_beatWindow, BEAT_HISTORY);
+    m_beatSpectrum.resize(BEAT_HISTORY);
+    m_beatPower.resize(BEAT_HISTORY / 2 + 1);
+}
+
+void SpectrumAnalyzer::process(const float *frames, int count)
+{
+    for (int i = 0; i < count; ++i) {
+        const float left = frames[2 * i];
+        const float right = frames[2 * i + 1];
+
+        m_historyLeft[m_historyPos] = left;
+        m_historyRight[m_historyPos] = right;
+        m_historyPos = (m_historyPos + 1) & (m_fftSize - 1);
+
+        const double product = m_beatFilter[1].process(m_beatFilter[0].process(static_cast<double>(left) * right));
+        if (++m_beatPhase == m_beatDecimation) {
+            m_beatPhase = 0;
+            m_beatHistory[m_beatPos] = static_cast<float>(product);
+            m_beatPos = (m_beatPos + 1) % BEAT_HISTORY;
+            m_beatFill = std::min(m_beatFill + 1, BEAT_HISTORY);
+        }
+    }
+}
+
+// Fractional bin of the peak at bin, from a parabola through it and its
+// neighbours (in dB)
+double SpectrumAnalyzer::interpolatePeak(const float *magnitudes, int bin, int bins)
+{
+    if (bin <= 0 || bin >= bins - 1) {
+        return bin;
+    }
+    const double a = magnitudes[bin - 1];
+    const double b = magnitudes[bin];
+    const double c = magnitudes[bin + 1];
+    const double curvature = a - 2.0 * b + c;
+    return curvature < 0.0 ? bin + 0.5 * (a - c) / curvature : bin;
+}
+
+void SpectrumAnalyzer::analyze(Result &result)
+{
+    const int bins = m_fftSize / 2 + 1;
+    result.sampleRate = m_sampleRate;
+    result.fftSize = m_fftSize;
+    result.leftDb.resize(bins);
+    result.rightDb.resize(bins);
+
+    // Both channels in one complex transform: left real, right imaginary
+    for (int n = 0; n < m_fftSize; ++n) {
+        const int index = (m_historyPos + n) & (m_fftSize - 1);
+        m_spectrum[n] = { m_historyLeft[index] * m_window[n], m_historyRight[index] * m_window[n] };
+    }
+    m_fft.transform(m_spectrum.data());
+
+    // Z(k) = L(k) + i R(k), and L, R are spectra of real signals
+    const float scale = 0.5f / m_windowGain;
+    for (int k = 0; k < bins; ++k) {
+        const std::complex<float> z = m_spectrum[k];
+        const std::complex<float> mirror = std::conj(m_spectrum[(m_fftSize - k) & (m_fftSize - 1)]);
+        result.leftDb[k] = powerDb(z + mirror, scale);
+        result.rightDb[k] = powerDb(z - mirror, scale);
+    }
+
+    const int firstBin = std::min(bins - 1, static_cast<int>(std::ceil(MIN_TONE_HZ * m_fftSize / m_sampleRate)));
+    const double binHz = static_cast<double>(m_sampleRate) / m_fftSize;
+    const int leftBin = static_cast<int>(std::max_element(result.leftDb.begin() + firstBin, result.leftDb.end())
+                                         - result.leftDb.begin());
+    const int rightBin = static_cast<int>(std::max_element(result.rightDb.begin() + firstBin, result.rightDb.end())
+                                          - result.rightDb.begin());
+    result.leftPeakHz = interpolatePeak(result.leftDb.data(), leftBin, bins) * binHz;
+    result.rightPeakHz = interpolatePeak(result.rightDb.data(), rightBin, bins) * binHz;
+
+    analyzeBeat(result);
+}
+
+void SpectrumAnalyzer::analyzeBeat(Result &result)
+{
+    result.beatHz = 0.0;
+    result.beatSeconds = m_beatFill / m_beatRate;
+    result.beatWindowSeconds = BEAT_HISTORY / m_beatRate;
+    if (m_beatFill < BEAT_HISTORY) {
+        return;
+    }
+
+    // Oldest first, without the DC the correlation of the tones' phases leaves
+    double mean = 0.0;
+    for (float value : m_beatHistory) {
+        mean += value;
+    }
+    mean /= BEAT_HISTORY;
+    for (int n = 0; n < BEAT_HISTORY; ++n) {
+        const float value = m_beatHistory[(m_beatPos + n) % BEAT_HISTORY];
+        m_beatSpectrum[n] = { static_cast<float>((value - mean) * m_beatWindow[n]), 0.0f };
+    }
+    m_beatFft.transform(m_beatSpectrum.data());
+
+    const int bins = BEAT_HISTORY / 2 + 1;
+    for (int k = 0; k < bins; ++k) {
+        m_beatPower[k] = powerDb(m_beatSpectrum[k], 1.0f);
+    }
+
+    const double binHz = m_beatRate / BEAT_HISTORY;
+    const int first = std::max(1, static_cast<int>(std::ceil(MIN_BEAT_HZ / binHz)));
+    const int last = std::min(bins - 2, static_cast<int>(std::min(MAX_BEAT_HZ, 0.45 * m_beatRate) / binHz));
+    if (last <= first) {
+        return;
+    }
+
+    const auto begin = m_beatPower.begin() + first;
+    const auto end = m_beatPower.begin() + last + 1;
+    const int peak = static_cast<int>(std::max_element(begin, end) - m_beatPower.begin());
+
+    // A clear beat stands out from the band; noise alone does not
+    std::vector<float> band(begin, end);
+    std::nth_element(band.begin(), band.begin() + band.size() / 2, band.end());
+    const double prominenceDb = m_beatPower[peak] - band[band.size() / 2];
+    if (prominenceDb < 10.0 * std::log10(BEAT_PROMINENCE)) {
+        return;
+    }
+
+    result.beatHz = interpolatePeak(m_beatPower.data(), peak, bins) * binHz;
+}
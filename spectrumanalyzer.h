@@ -0,0 +1,114 @@
+#ifndef SPECTRUMANALYZER_H
+#define SPECTRUMANALYZER_H
+
+#include <complex>
+#include <vector>
+
+// ============================================================
+// SPECTRUM ANALYZER
+// ============================================================
+// Analysis of interleaved stereo output, for checking what the engine
+// actually plays. process() takes every frame in order; analyze() then
+// reports the Hann-windowed spectrum of the latest FFT-size frames per
+// channel, each channel's strongest tone, and the interaural beat.
+//
+// The beat comes from the short-time cross-correlation of the two
+// channels: for tones at fL and fR the product left * right holds a
+// component at |fL - fR| and one at fL + fR. Low-passing and decimating
+// the product keeps the first; its spectrum over the last few seconds
+// peaks at the beat, independently of the FFT size used for display.
+//
+// Not thread-safe; one thread calls everything.
+
+class SpectrumAnalyzer
+{
+public:
+    struct Result {
+        int sampleRate = 0;
+        int fftSize = 0;
+        std::vector<float> leftDb;  // fftSize / 2 + 1 bins, dBFS (full-scale sine = 0)
+        std::vector<float> rightDb;
+        double leftPeakHz = 0.0;    // Strongest component above MIN_TONE_HZ
+        double rightPeakHz = 0.0;
+        double beatHz = 0.0;        // 0 while measuring or when there is no clear beat
+        double beatSeconds = 0.0;   // Output collected towards the estimate, up to beatWindowSeconds
+        double beatWindowSeconds = 0.0;
+    };
+
+    static constexpr int MIN_FFT_SIZE = 512;
+    static constexpr int MAX_FFT_SIZE = 16384;
+    static constexpr double MIN_TONE_HZ = 20.0;
+    static constexpr double FLOOR_DB = -140.0;
+
+    static constexpr double BEAT_RATE_HZ = 250.0;  // Decimated product rate
+    static constexpr double BEAT_CUTOFF_HZ = 80.0;
+    static constexpr int BEAT_HISTORY = 1024;      // ~4 s at BEAT_RATE_HZ
+    static constexpr double MIN_BEAT_HZ = 0.5;
+    static constexpr double MAX_BEAT_HZ = 60.0;
+    static constexpr double BEAT_PROMINENCE = 30.0; // Peak power over the median bin
+
+    SpectrumAnalyzer();
+
+    // fftSize is a power of two in [MIN_FFT_SIZE, MAX_FFT_SIZE]; clears
+    // all history
+    void configure(int sampleRate, int fftSize);
+    int sampleRate() const { return m_sampleRate; }
+    int fftSize() const { return m_fftSize; }
+
+    void process(const float *frames, int count);
+    void analyze(Result &result);
+
+private:
+    // In-place radix-2 FFT over tables built for one size
+    class Fft
+    {
+    public:
+        void setSize(int size);
+        void transform(std::complex<float> *data) const;
+
+    private:
+        int m_size = 0;
+        std::vector<int> m_bitReverse;
+        std::vector<std::complex<float>> m_twiddles;
+    };
+
+    // Direct form I, Butterworth low-pass
+    struct Biquad {
+        double b0 = 1.0, b1 = 0.0, b2 = 0.0, a1 = 0.0, a2 = 0.0;
+        double x1 = 0.0, x2 = 0.0, y1 = 0.0, y2 = 0.0;
+
+        void setLowPass(double cutoffHz, double sampleRate, double q);
+        double process(double x);
+    };
+
+    void analyzeBeat(Result &result);
+    static double interpolatePeak(const float *magnitudes, int bin, int bins);
+
+    int m_sampleRate = 0;
+    int m_fftSize = 0;
+
+    // Latest m_fftSize frames, as a ring
+    std::vector<float> m_historyLeft;
+    std::vector<float> m_historyRight;
+    int m_historyPos = 0; // Oldest frame, next to be overwritten
+
+    Fft m_fft;
+    std::vector<float> m_window;
+    float m_windowGain = 1.0f;
+    std::vector<std::complex<float>> m_spectrum;
+
+    // Cross-correlation path
+    Biquad m_beatFilter[2];
+    int m_beatDecimation = 1;
+    int m_beatPhase = 0;
+    double m_beatRate = BEAT_RATE_HZ;
+    std::vector<float> m_beatHistory; // Ring of BEAT_HISTORY decimated values
+    int m_beatPos = 0;
+    int m_beatFill = 0;
+    Fft m_beatFft;
+    std::vector<float> m_beatWindow;
+    std::vector<std::complex<float>> m_beatSpectrum;
+    std::vector<float> m_beatPower;
+};
+
+#endif // SPECTRUMANALYZER_H
@@ -0,0 +1,55 @@
+#ifndef TRIPLEBUFFER_H
+#define TRIPLEBUFFER_H
+
+#include <atomic>
+
+// ============================================================
+// TRIPLE BUFFER
+// ============================================================
+// Lock-free single-writer / single-reader hand-over of a value. The
+// writer fills writeBuffer() and publishes it; the reader calls update()
+// and, if it returns true, sees the latest complete value in
+// readBuffer(). Neither side ever blocks or sees a torn value;
+// intermediate publishes the reader did not pick up are coalesced.
+
+template<typename T>
+class TripleBuffer
+{
+public:
+    TripleBuffer() = default;
+    TripleBuffer(const TripleBuffer &) = delete;
+    TripleBuffer &operator=(const TripleBuffer &) = delete;
+
+    // Writer side
+    T &writeBuffer() { return m_buffers[m_writeIndex]; }
+
+    void publish()
+    {
+        const int previous = m_middle.exchange(m_writeIndex | DIRTY_BIT, std::memory_order_acq_rel);
+        m_writeIndex = previous & INDEX_MASK;
+    }
+
+    // Reader side
+    bool update()
+    {
+        if (!(m_middle.load(std::memory_order_relaxed) & DIRTY_BIT)) {
+            return false;
+        }
+        const int previous = m_middle.exchange(m_readIndex, std::memory_order_acq_rel);
+        m_readIndex = previous & INDEX_MASK;
+        return true;
+    }
+
+    const T &readBuffer() const { return m_buffers[m_readIndex]; }
+
+private:
+    static constexpr int INDEX_MASK = 0x3;
+    static constexpr int DIRTY_BIT = 0x4;
+
+    T m_buffers[3] {};
+    int m_writeIndex = 0;
+    std::atomic<int> m_middle {1};
+    int m_readIndex = 2;
+};
+
+#endif // TRIPLEBUFFER_H
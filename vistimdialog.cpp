@@ -17,6 +17,7 @@
 #include <QMessageBox>
 #include <QFrame>
 #include <QtMath>
+#include <cmath>
 #include "constants.h"
 
 
@@ -52,13 +53,21 @@ VisStimDialog::VisStimDialog(FlickerWidget *flicker, QWidget *parent)
         connect(m_flicker, &FlickerWidget::flickerStopped, this, [this]() {
             m_startStopBtn->setText("▶  Start");
             m_running = false;
+            m_statsTimer.stop();
+            updateTimingInfo();
         });
 
         connect(m_flicker, &FlickerWidget::flickerStarted, this, [this]() {
             m_startStopBtn->setText("■  Stop");
             m_running = true;
+            m_statsTimer.start();
+            updateTimingInfo();
         });
     }
+
+    m_statsTimer.setInterval(250);
+    connect(&m_statsTimer, &QTimer::timeout, this, &VisStimDialog::updateTimingInfo);
+    updateTimingInfo();
 }
 
 
@@ -69,6 +78,7 @@ void VisStimDialog::syncFrequency(double hz)
     if (!m_freqOverrideCb->isChecked()) {
         updateBandLabel(hz);
     }
+    updateTimingInfo();
 }
 
 void VisStimDialog::syncWaveType(int type)
@@ -89,6 +99,7 @@ void VisStimDialog::onFreqOverrideToggled(bool checked)
         m_freqSpin->setValue(m_syncedFreq);
         m_flicker->setFrequency(m_syncedFreq);
         updateBandLabel(m_syncedFreq);
+        updateTimingInfo();
     }
 }
 
@@ -105,6 +116,78 @@ void VisStimDialog::onFreqSpinChanged(double hz)
 {
     updateBandLabel(hz);
     m_flicker->setFrequency(hz);
+    updateTimingInfo();
+}
+
+void VisStimDialog::onLockRefreshToggled(bool checked)
+{
+    m_flicker->setQuantizeToRefresh(checked);
+    updateTimingInfo();
+}
+
+// A cycle can only be drawn identically every time when it spans a
+// whole number of refreshes; otherwise cycles alternate between two
+// lengths and the flicker visibly beats against the display
+void VisStimDialog::updateTimingInfo()
+{
+    if (!m_flicker)
+        return;
+
+    const FlickerWidget::FrameStats stats = m_flicker->frameStats();
+    const double frames = m_flicker->framesPerCycle();
+    m_refreshLabel->setText(
+        QString("Display %1 Hz (%2) · %3 frames per cycle")
+            .arg(stats.refreshHz, 0, 'f', 2)
+            .arg(stats.refreshMeasured ? "measured" : "nominal")
+            .arg(frames, 0, 'f', 2));
+
+    QString warning;
+    if (frames < 2.0) {
+        warning = m_flicker->quantizeToRefresh()
+                ? QString("Above half the refresh rate; shown at %1 Hz.")
+                      .arg(m_flicker->displayedFrequency(), 0, 'f', 2)
+                : QString("%1 Hz is above half the refresh rate and cannot be shown; "
+                          "it aliases to a slower flicker.")
+                      .arg(m_flicker->frequency(), 0, 'f', 2);
+    } else if (!m_flicker->isFrequencyAccurate()) {
+        const double whole = std::round(frames);
+        warning = m_flicker->quantizeToRefresh()
+                ? QString("Shown at %1 Hz, %2 frames per cycle.")
+                      .arg(m_flicker->displayedFrequency(), 0, 'f', 2)
+                      .arg(whole, 0, 'f', 0)
+                : QString("Cycles alternate between %1 and %2 frames, so the flicker "
+                          "beats against the display. Lock to the refresh rate to show "
+                          "%3 Hz instead.")
+                      .arg(std::floor(frames), 0, 'f', 0)
+                      .arg(std::ceil(frames), 0, 'f', 0)
+                      .arg(stats.refreshHz / whole, 0, 'f', 2);
+    }
+    m_timingWarning->setText(warning);
+    m_timingWarning->setVisible(!warning.isEmpty());
+
+    if (!stats.audioLocked) {
+        m_avSyncLabel->setText("Display clock (audio stopped)");
+    } else if (!stats.beatLocked) {
+        m_avSyncLabel->setText("Locked to the audio clock · the sound's beat is at another "
+                               "frequency, no A/V offset");
+    } else if (!stats.avOffsetValid) {
+        m_avSyncLabel->setText("Locked to the audio beat");
+    } else {
+        m_avSyncLabel->setText(QString("Locked to the audio beat · A/V offset %1 ms")
+            .arg(stats.avOffsetMs, 0, 'f', 2));
+    }
+
+    if (stats.frames == 0) {
+        m_frameStatsLabel->setText("No frames drawn yet");
+        return;
+    }
+    m_frameStatsLabel->setText(
+        QString("%1 frames, %2 dropped · frame time %3 ms avg, %4 max, %5 jitter")
+            .arg(stats.frames)
+            .arg(stats.droppedFrames)
+            .arg(stats.meanFrameMs, 0, 'f', 2)
+            .arg(stats.maxFrameMs, 0, 'f', 1)
+            .arg(stats.jitterMs, 0, 'f', 2));
 }
 
 void VisStimDialog::onIntensityChanged(int value)
@@ -318,6 +401,39 @@ void VisStimDialog::buildUi()
         flickerLayout->addLayout(row);
     }
 
+    {
+        auto *row = new QVBoxLayout();
+
+        m_lockRefreshCb = new QCheckBox("Lock to refresh rate");
+        m_lockRefreshCb->setToolTip("Round the frequency to a whole number of display frames per cycle");
+        connect(m_lockRefreshCb, &QCheckBox::toggled,
+                this, &VisStimDialog::onLockRefreshToggled);
+
+        m_refreshLabel = new QLabel();
+        m_refreshLabel->setStyleSheet("font-size:11px;");
+
+        m_timingWarning = new QLabel();
+        m_timingWarning->setWordWrap(true);
+        m_timingWarning->setStyleSheet(
+            "color: #8a5a00; background: #fff4e0;"
+            "border-radius:4px; padding:2px 8px; font-size:11px;");
+        m_timingWarning->hide();
+
+        m_frameStatsLabel = new QLabel();
+        m_frameStatsLabel->setStyleSheet("color:#777; font-size:11px;");
+
+        m_avSyncLabel = new QLabel();
+        m_avSyncLabel->setStyleSheet("color:#777; font-size:11px;");
+        m_avSyncLabel->setToolTip("Light minus sound; positive when the light leads");
+
+        row->addWidget(m_lockRefreshCb);
+        row->addWidget(m_refreshLabel);
+        row->addWidget(m_timingWarning);
+        row->addWidget(m_frameStatsLabel);
+        row->addWidget(m_avSyncLabel);
+        flickerLayout->addLayout(row);
+    }
+
     flickerLayout->addWidget(hline());
 
     {
@@ -531,6 +647,8 @@ void VisStimDialog::onReset()
     m_freqSpin->setValue(m_syncedFreq);
     m_freqSpin->setEnabled(false);
 
+    m_lockRefreshCb->setChecked(false);
+
     m_envOverrideCb->setChecked(false);
     for (auto *btn : m_envGroup->buttons())
         btn->setEnabled(false);
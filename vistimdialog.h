@@ -2,6 +2,7 @@
 
 #include <QDialog>
 #include <QColor>
+#include <QTimer>
 #include "flickerwidget.h"
 
 class QCheckBox;
@@ -35,6 +36,8 @@ private slots:
     void onPickTextColor();
     void onPickTextBgColor();
     void onStartStop();
+    void onLockRefreshToggled(bool checked);
+    void updateTimingInfo();
 
 private:
     void buildUi();
@@ -54,6 +57,13 @@ private:
     QDoubleSpinBox *m_freqSpin        = nullptr;
     QLabel         *m_bandLabel       = nullptr;
 
+    QCheckBox      *m_lockRefreshCb   = nullptr;
+    QLabel         *m_refreshLabel    = nullptr;
+    QLabel         *m_timingWarning   = nullptr;
+    QLabel         *m_frameStatsLabel = nullptr;
+    QLabel         *m_avSyncLabel     = nullptr;
+    QTimer          m_statsTimer;
+
     QLabel         *m_envSyncBadge    = nullptr;
     QCheckBox      *m_envOverrideCb   = nullptr;
     QButtonGroup   *m_envGroup        = nullptr;   // square/sine/sawtooth
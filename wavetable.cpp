@@ -0,0 +1,44 @@
+#include "wavetable.h"
+
+#include <algorithm>
+
+namespace Wavetable {
+
+namespace {
+
+struct SineTable {
+    float values[TABLE_SIZE + 1];
+
+    SineTable()
+    {
+        for (int i = 0; i < TABLE_SIZE; ++i) {
+            values[i] = static_cast<float>(std::sin(TWO_PI * i / TABLE_SIZE));
+        }
+        values[TABLE_SIZE] = values[0]; // Guard point for interpolation
+    }
+};
+
+} // namespace
+
+const float *sineTable()
+{
+    static const SineTable table;
+    return table.values;
+}
+
+double measuredSineError()
+{
+    static const double error = [] {
+        const float *table = sineTable();
+        const int probes = TABLE_SIZE * 64;
+        double maxError = 0.0;
+        for (int i = 0; i < probes; ++i) {
+            const double cycles = static_cast<double>(i) / probes;
+            maxError = std::max(maxError, std::abs(sine(table, cycles) - exactSine(cycles)));
+        }
+        return maxError;
+    }();
+    return error;
+}
+
+} // namespace Wavetable